@@ -6,6 +6,12 @@
 #include <time.h>          // 时间相关函数
 #include <HTTPClient.h>     // HTTP客户端库
 #include "globals.h"       // 全局变量和函数声明
+#include "mqtt_qos1.h"     // QoS 1 发布层
+#include "sensor_sample.h" // 传感器数据结构
+#include "report_policy.h" // 死区/心跳上报策略
+#include "window_aggregator.h" // 边缘窗口聚合
+#include "stm32_link.h"        // STM32二进制帧解码
+#include "backfill.h"          // STM32历史记录补传
 
 //
 // WARNING!!! PSRAM IC required for UXGA resolution and high JPEG quality
@@ -77,18 +83,71 @@ PubSubClient mqttClient(espClient);
 HardwareSerial stm32Serial(1); // 使用UART1与STM32通信
 Preferences preferences;       // 持久化存储 (新代码，实际定义对象)
 
-// 数据解析缓冲区
-String dataBuffer = "";
+// 数据解析缓冲区（二进制帧以0x00结尾，ASCII行以'\n'结尾）
+uint8_t dataBuffer[STM32_LINK_RX_BUFFER];
+size_t dataLength = 0;
 unsigned long lastDataTime = 0;
 unsigned long lastConnectAttempt = 0;
+unsigned long lastTimeSyncAt = 0;     // 上次向STM32发送校时帧的时间
+bool timeSyncSent = false;
+unsigned long ledBlinkAt = 0;         // 提交数据时熄灭指示灯的时间
+bool ledBlinking = false;
 const int connectInterval = 5000; // 重连间隔5秒
 
+// 等待STM32应答的云端命令：收到应答帧或超时后才回复response
+#define STM32_PENDING_MAX 4
+struct PendingStm32Command {
+  bool used;
+  uint16_t seq;           // 命令帧序号，应答帧带回同一序号
+  unsigned long sentAt;
+  String requestId;
+  String command;
+  String timestamp;
+};
+PendingStm32Command pendingStm32[STM32_PENDING_MAX];
+
+// QoS 1发布吞吐量测试：回调里只记录请求，由loop()依次以各窗口运行，
+// 期间照常调用mqttClient.loop()和读取STM32串口，不会让命令连接保活超时或串口溢出
+#define BENCH_WINDOW_NUM 3
+#define BENCH_TIMEOUT_MS 30000
+const uint8_t benchWindows[BENCH_WINDOW_NUM] = { 1, 4, 16 };
+struct BenchmarkRequest {
+  bool active;
+  uint8_t index;          // 正在运行的窗口序号
+  bool started;           // 当前窗口已调用mqttQos1BenchStart
+  uint16_t count;
+  float msgsPerSec[BENCH_WINDOW_NUM];
+  bool ok[BENCH_WINDOW_NUM];
+  String requestId;
+  String timestamp;
+};
+BenchmarkRequest benchRequest;
+
 // 函数声明
 void startCameraServer();
 void setupLedFlash(int pin);
 void connectToMQTT();
 void mqttCallback(char* topic, byte* payload, unsigned int length);
 void processSTM32Data(String data);
+void processSTM32Frame(const uint8_t* data, size_t len);
+void handleSensorSample(const SensorSample& sample);
+bool isSTM32AsciiLine(const uint8_t* data, size_t len);
+bool parseSTM32Line(const String& data, SensorSample& sample);
+bool publishSensorSample(const SensorSample& sample);
+void sampleFieldsToJson(const SensorSample& sample, JsonDocument& jsonDoc);
+bool publishWindowSummary(const WindowSummary& summary);
+bool publishSensorDoc(JsonDocument& jsonDoc);
+void syncSTM32Time(const SensorSample& sample);
+void requestSTM32Backfill();
+bool sendSTM32Command(const uint8_t* frame, size_t len, uint16_t seq, const String& command,
+                      const String& requestId, const String& timestamp);
+void handleSTM32Ack(const Stm32Frame& frame);
+void expireSTM32Commands();
+void publishCommandResponse(const String& requestId, const String& timestamp, bool ok, const String& message);
+void serviceBenchmark();
+bool publishBackfillRecord(const SensorSample& sample, uint16_t seq);
+void setSourceTimestamp(JsonDocument& jsonDoc, uint32_t unixTime);
+void serviceStatusLed();
 String getDeviceId();  // 新增：获取设备ID的函数声明
 void handleTakePhotoCommand();  // 新增：拍照命令处理函数
 
@@ -147,6 +206,11 @@ void setup() {
   // 关闭Preferences
   preferences.end();
 
+  // 加载死区/心跳上报策略和窗口聚合配置
+  reportPolicyLoad();
+  aggregatorLoad();
+  backfillLoad();
+
   // 检查重启标志
   preferences.begin("system", false);
   bool shouldRestart = preferences.getBool("restart_flag", false);
@@ -278,6 +342,9 @@ void setup() {
   // 连接MQTT服务器
   connectToMQTT();
 
+  // 传感器数据走独立的QoS 1发布连接，客户端ID加后缀避免与命令连接冲突
+  mqttQos1Begin(mqttServer, mqttPort, mqttClientId + "-pub", mqttUser, mqttPassword);
+
   // 配置NTP服务器，同步时间
   configTime(8 * 3600, 0, "pool.ntp.org", "time.nist.gov");
   Serial.println("正在同步时间...");
@@ -329,21 +396,49 @@ void loop() {
     // MQTT保持连接
     mqttClient.loop();
   }
+
+  // QoS 1发布连接：收PUBACK、重传超时消息、断线重连
+  mqttQos1Loop();
+
+  // 推进正在进行的吞吐量测试
+  serviceBenchmark();
+  
+  // 数据提交时的短闪烁到时后恢复指示灯
+  serviceStatusLed();
+  
+  // 聚合窗口到期时发布汇总（即使STM32暂时没有新数据）
+  WindowSummary summary;
+  if (aggregatorPoll(millis(), summary)) {
+    publishWindowSummary(summary);
+  }
+
+  // 云端缺失的历史记录按块向STM32请求补传
+  requestSTM32Backfill();
+
+  // 发给STM32的命令超时未应答时回复错误
+  expireSTM32Commands();
   
   // 从STM32读取数据
   while (stm32Serial.available()) {
-    char c = stm32Serial.read();
+    uint8_t c = stm32Serial.read();
     
-    // 找到数据帧结束符
-    if (c == '\n') {
-      // 如果有完整的数据帧，进行处理
-      if (dataBuffer.length() > 0) {
-        // 处理数据帧
-        processSTM32Data(dataBuffer);
-        dataBuffer = ""; // 清空缓冲区
+    if (c == 0x00) {
+      // 二进制帧结束符（COBS编码后帧内不会出现0x00）
+      if (dataLength > 0) {
+        processSTM32Frame(dataBuffer, dataLength);
       }
-    } else if (c != '\r') { // 忽略回车符
-      dataBuffer += c;
+      dataLength = 0;
+    } else if (c == '\n' && isSTM32AsciiLine(dataBuffer, dataLength)) {
+      // ASCII行结束符；二进制帧中也可能出现0x0A，所以先确认缓冲区是文本行
+      processSTM32Data(String((const char*)dataBuffer));
+      dataLength = 0;
+    } else if (dataLength < sizeof(dataBuffer) - 1) {
+      dataBuffer[dataLength++] = c;
+      dataBuffer[dataLength] = 0;
+    } else {
+      // 超长数据，丢弃并等待下一个结束符重新同步
+      stm32LinkCountOverflow();
+      dataLength = 0;
     }
   }
   
@@ -425,7 +520,7 @@ void mqttCallback(char* topic, byte* payload, unsigned int length) {
   String responseTopic = "armdetector/device/" + mqttClientId + "/response";
   
   // 创建响应JSON
-  StaticJsonDocument<256> response;
+  StaticJsonDocument<384> response;
   response["request_id"] = requestId;
   response["timestamp"] = doc["timestamp"].as<String>();
   
@@ -490,6 +585,126 @@ void mqttCallback(char* topic, byte* payload, unsigned int length) {
     serializeJson(response, responseStr);
     mqttClient.publish(responseTopic.c_str(), responseStr.c_str());
   }
+  else if (command == "set_report_policy") {
+    // 设置死区/心跳上报策略，未给出的参数保持不变
+    String error;
+    if (reportPolicyApply(doc["parameters"], error)) {
+      response["status"] = "success";
+      response["message"] = "上报策略已更新";
+    } else {
+      response["status"] = "error";
+      response["message"] = error;
+    }
+    reportPolicyToJson(response.createNestedObject("data"));
+    
+    String responseStr;
+    serializeJson(response, responseStr);
+    mqttClient.publish(responseTopic.c_str(), responseStr.c_str());
+  }
+  else if (command == "set_aggregation") {
+    // 设置窗口聚合：enabled / window_s / raw_on_alarm
+    String error;
+    if (aggregatorApply(doc["parameters"], error)) {
+      response["status"] = "success";
+      response["message"] = "聚合配置已更新";
+    } else {
+      response["status"] = "error";
+      response["message"] = error;
+    }
+    aggregatorConfigToJson(response.createNestedObject("data"));
+    
+    String responseStr;
+    serializeJson(response, responseStr);
+    mqttClient.publish(responseTopic.c_str(), responseStr.c_str());
+  }
+  else if (command == "get_link_stats") {
+    // STM32串口链路统计：帧数、CRC错误、序号缺口等
+    const Stm32LinkStats& link = stm32LinkGetStats();
+    JsonObject data = response.createNestedObject("data");
+    data["frames"] = link.frames;
+    data["ascii_lines"] = link.asciiLines;
+    data["crc_errors"] = link.crcErrors;
+    data["format_errors"] = link.formatErrors;
+    data["seq_gaps"] = link.seqGaps;
+    data["lost_frames"] = link.lostFrames;
+    data["overflows"] = link.overflows;
+    data["time_syncs"] = link.timeSyncs;
+    data["records"] = link.records;
+    data["acks"] = link.acks;
+    backfillToJson(data.createNestedObject("backfill"));
+    response["status"] = "success";
+    
+    String responseStr;
+    serializeJson(response, responseStr);
+    mqttClient.publish(responseTopic.c_str(), responseStr.c_str());
+  }
+  else if (command == "set_report_period" || command == "set_threshold" || command == "set_alarm_rule") {
+    // 转发给STM32，收到应答帧后再回复response
+    uint8_t frame[STM32_FRAME_MAX_ENCODED];
+    size_t len = 0;
+    uint16_t seq = 0;
+    const char* error = NULL;
+
+    if (command == "set_report_period") {
+      // STM32发送样本帧的周期，传感器的测量周期不变
+      uint32_t periodMs = doc["parameters"]["report_period_ms"] | 0;
+      if (periodMs < STM32_REPORT_PERIOD_MIN_MS || periodMs > STM32_REPORT_PERIOD_MAX_MS) {
+        error = "report_period_ms超出范围(200~60000)";
+      } else {
+        len = stm32LinkEncodeSetReportPeriod((uint16_t)periodMs, frame, seq);
+      }
+    } else {
+      uint8_t alarm = stm32LinkAlarmType(doc["parameters"]["alarm"].as<String>());
+      float value = doc["parameters"]["value"] | NAN;
+      if (alarm == 0) {
+        error = "未知的报警类型";
+      } else if (!(value >= -3276.8f && value <= 3276.7f)) {
+        error = "缺少阈值或阈值超出范围";
+      } else if (command == "set_threshold") {
+        len = stm32LinkEncodeSetThreshold(alarm, (int16_t)lroundf(value * 10), frame, seq);
+      } else {
+        // 报警规则：阈值、回差和消抖时间一起设置
+        float hysteresis = doc["parameters"]["hysteresis"] | NAN;
+        uint32_t debounceMs = doc["parameters"]["debounce_ms"] | 0;
+        if (!(hysteresis >= 0 && hysteresis <= 3276.7f) || debounceMs > 65535) {
+          error = "缺少回差或回差/消抖时间超出范围";
+        } else {
+          len = stm32LinkEncodeSetAlarmRule(alarm, (int16_t)lroundf(value * 10), (int16_t)lroundf(hysteresis * 10),
+                                            (uint16_t)debounceMs, frame, seq);
+        }
+      }
+    }
+
+    if (error == NULL && !sendSTM32Command(frame, len, seq, command, requestId, doc["timestamp"].as<String>())) {
+      error = "等待STM32应答的命令过多";
+    }
+    if (error != NULL) {
+      response["status"] = "error";
+      response["message"] = error;
+
+      String responseStr;
+      serializeJson(response, responseStr);
+      mqttClient.publish(responseTopic.c_str(), responseStr.c_str());
+    }
+  }
+  else if (command == "benchmark_publish") {
+    // QoS 1发布吞吐量测试：这里只记录请求，测试在loop()中进行，完成后回复
+    if (benchRequest.active) {
+      response["status"] = "error";
+      response["message"] = "吞吐量测试正在进行";
+
+      String responseStr;
+      serializeJson(response, responseStr);
+      mqttClient.publish(responseTopic.c_str(), responseStr.c_str());
+    } else {
+      benchRequest.active = true;
+      benchRequest.index = 0;
+      benchRequest.started = false;
+      benchRequest.count = doc["parameters"]["count"] | 200;
+      benchRequest.requestId = requestId;
+      benchRequest.timestamp = doc["timestamp"].as<String>();
+    }
+  }
   else {
     // 未知命令
     Serial.print("未知命令: ");
@@ -504,32 +719,258 @@ void mqttCallback(char* topic, byte* payload, unsigned int length) {
   }
 }
 
-// 处理从STM32接收的数据
+// 判断缓冲区是否为ASCII数据行（以"T:"开头且全部为可打印字符）
+bool isSTM32AsciiLine(const uint8_t* data, size_t len) {
+  if (len < 2 || data[0] != 'T' || data[1] != ':') {
+    return false;
+  }
+  for (size_t i = 0; i < len; i++) {
+    if ((data[i] < 0x20 || data[i] > 0x7E) && data[i] != '\r') {
+      return false;
+    }
+  }
+  return true;
+}
+
+// 处理从STM32接收的ASCII数据行
 void processSTM32Data(String data) {
+  data.trim();
   Serial.print("收到STM32数据: ");
   Serial.println(data);
   
+  SensorSample sample;
+  if (!parseSTM32Line(data, sample)) {
+    Serial.println("数据格式错误");
+    return;
+  }
+  
+  stm32LinkCountAsciiLine();
+  handleSensorSample(sample);
+}
+
+// 处理从STM32接收的二进制帧
+void processSTM32Frame(const uint8_t* data, size_t len) {
+  Stm32Frame frame;
+  if (!stm32LinkDecodeFrame(data, len, frame)) {
+    Serial.println("STM32数据帧校验失败");
+    return;
+  }
+
+  if (frame.type == STM32_FRAME_TYPE_ACK) {
+    handleSTM32Ack(frame);
+    return;
+  }
+
+  const SensorSample& sample = frame.sample;
+
+  // 记录帧：实时记录只跟踪序号（样本帧已经覆盖了实时数据），补传记录逐条发布
+  if (frame.type == STM32_FRAME_TYPE_RECORD) {
+    if (backfillOnRecord(frame.seq, frame.bootId) == BACKFILL_RECORD_FILL) {
+      publishBackfillRecord(sample, frame.seq);
+    }
+    return;
+  }
+  
+  Serial.printf("收到STM32数据帧: T:%d,H:%d,CO:%.1f,DUST:%.1f,ALARM:%s,TS:%lu,VALID:0x%X\n",
+                sample.temperature, sample.humidity, sample.co_ppm,
+                sample.dust_density, sample.alarm_status.c_str(),
+                (unsigned long)sample.timestamp, sample.valid);
+  syncSTM32Time(sample);
+  handleSensorSample(sample);
+}
+
+// 发送一条需要应答的命令帧，记录序号等待应答；等待队列满时不发送，返回false
+bool sendSTM32Command(const uint8_t* frame, size_t len, uint16_t seq, const String& command,
+                      const String& requestId, const String& timestamp) {
+  for (uint8_t i = 0; i < STM32_PENDING_MAX; i++) {
+    PendingStm32Command& p = pendingStm32[i];
+    if (!p.used) {
+      p.used = true;
+      p.seq = seq;
+      p.sentAt = millis();
+      p.requestId = requestId;
+      p.command = command;
+      p.timestamp = timestamp;
+      stm32Serial.write(frame, len);
+      Serial.printf("向STM32发送命令%s, 序号%u\n", command.c_str(), seq);
+      return true;
+    }
+  }
+  return false;
+}
+
+// 收到应答帧：找到对应的云端请求并回复；校时、补传等自动发出的帧没有等待项，直接忽略
+void handleSTM32Ack(const Stm32Frame& frame) {
+  static const char* const messages[] = {
+    "STM32已执行", "STM32: 命令长度错误", "STM32: 参数超出范围", "STM32不支持该命令",
+  };
+
+  for (uint8_t i = 0; i < STM32_PENDING_MAX; i++) {
+    PendingStm32Command& p = pendingStm32[i];
+    if (p.used && p.seq == frame.seq) {
+      p.used = false;
+      const char* message = frame.ackStatus < sizeof(messages) / sizeof(messages[0])
+                            ? messages[frame.ackStatus] : "STM32返回未知结果";
+      publishCommandResponse(p.requestId, p.timestamp, frame.ackStatus == STM32_CMD_OK, message);
+      return;
+    }
+  }
+}
+
+// 超过STM32_CMD_TIMEOUT_MS没有应答的命令回复超时
+void expireSTM32Commands() {
+  for (uint8_t i = 0; i < STM32_PENDING_MAX; i++) {
+    PendingStm32Command& p = pendingStm32[i];
+    if (p.used && millis() - p.sentAt >= STM32_CMD_TIMEOUT_MS) {
+      p.used = false;
+      Serial.printf("STM32命令%s应答超时\n", p.command.c_str());
+      publishCommandResponse(p.requestId, p.timestamp, false, "STM32应答超时");
+    }
+  }
+}
+
+// 依次以窗口1/4/16运行吞吐量测试，每次loop()只推进一步，全部完成后回复
+void serviceBenchmark() {
+  if (!benchRequest.active) {
+    return;
+  }
+
+  uint8_t i = benchRequest.index;
+  if (!benchRequest.started) {
+    String benchTopic = "armdetector/device/" + mqttClientId + "/bench";
+    benchRequest.msgsPerSec[i] = 0;
+    benchRequest.ok[i] = false;
+    benchRequest.started = mqttQos1BenchStart(benchTopic.c_str(), benchRequest.count,
+                                              benchWindows[i], BENCH_TIMEOUT_MS);
+    if (benchRequest.started) {
+      return;
+    }
+  } else {
+    uint8_t result = mqttQos1BenchPoll(&benchRequest.msgsPerSec[i]);
+    if (result == MQTT_QOS1_BENCH_BUSY) {
+      return;
+    }
+    benchRequest.ok[i] = result == MQTT_QOS1_BENCH_DONE;
+  }
+
+  Serial.printf("QoS1吞吐量 窗口=%u: %.1f msg/s%s\n", benchWindows[i], benchRequest.msgsPerSec[i],
+                benchRequest.ok[i] ? "" : " (失败)");
+  benchRequest.started = false;
+  if (++benchRequest.index < BENCH_WINDOW_NUM) {
+    return;
+  }
+
+  String responseTopic = "armdetector/device/" + mqttClientId + "/response";
+  StaticJsonDocument<384> response;
+  bool allOk = true;
+  response["request_id"] = benchRequest.requestId;
+  response["timestamp"] = benchRequest.timestamp;
+  for (i = 0; i < BENCH_WINDOW_NUM; i++) {
+    String key = "window_" + String(benchWindows[i]);
+    if (benchRequest.ok[i]) {
+      response["data"][key] = benchRequest.msgsPerSec[i];
+    } else {
+      response["data"][key] = nullptr;
+      allOk = false;
+    }
+  }
+  response["data"]["count"] = benchRequest.count;
+  response["status"] = allOk ? "success" : "error";
+  response["message"] = allOk ? "吞吐量测试完成" : "吞吐量测试未完成，请检查发布连接";
+
+  String responseStr;
+  serializeJson(response, responseStr);
+  mqttClient.publish(responseTopic.c_str(), responseStr.c_str());
+  benchRequest.active = false;
+}
+
+// 回复一个云端命令
+void publishCommandResponse(const String& requestId, const String& timestamp, bool ok, const String& message) {
+  String responseTopic = "armdetector/device/" + mqttClientId + "/response";
+  StaticJsonDocument<256> response;
+  response["request_id"] = requestId;
+  response["timestamp"] = timestamp;
+  response["status"] = ok ? "success" : "error";
+  response["message"] = message;
+
+  String responseStr;
+  serializeJson(response, responseStr);
+  mqttClient.publish(responseTopic.c_str(), responseStr.c_str());
+}
+
+// 把NTP时间推送给STM32的RTC：定期推送，STM32未校时(时间戳为0)时尽快推送
+void syncSTM32Time(const SensorSample& sample) {
+  time_t now = time(nullptr);
+  if (now < (time_t)STM32_TIME_VALID_MIN) {
+    return;  // ESP32自己还没有有效时间
+  }
+
+  unsigned long elapsed = millis() - lastTimeSyncAt;
+  bool due = !timeSyncSent || elapsed >= STM32_TIME_SYNC_INTERVAL_MS ||
+             (sample.timestamp == 0 && elapsed >= STM32_TIME_SYNC_RETRY_MS);
+  if (!due) {
+    return;
+  }
+
+  uint8_t frame[STM32_FRAME_MAX_ENCODED];
+  size_t len = stm32LinkEncodeTimeSync((uint32_t)now, frame);
+  stm32Serial.write(frame, len);
+  lastTimeSyncAt = millis();
+  timeSyncSent = true;
+  Serial.printf("向STM32校时: %lu\n", (unsigned long)now);
+}
+
+// 有待补记录且发布队列有余量时，向STM32请求下一块
+void requestSTM32Backfill() {
+  uint16_t first, count;
+  if (!backfillPoll(millis(), first, count)) {
+    return;
+  }
+
+  uint8_t frame[STM32_FRAME_MAX_ENCODED];
+  size_t len = stm32LinkEncodeBackfill(first, count, frame);
+  stm32Serial.write(frame, len);
+  Serial.printf("请求STM32补传记录: %u起%u条\n", first, count);
+}
+
+// 按聚合/死区策略处理一条传感器数据
+void handleSensorSample(const SensorSample& sample) {
   // 记录收到数据的时间
   lastDataTime = millis();
   
-  // 解析数据帧格式: "T:[temperature],H:[humidity],CO:[co_ppm],DUST:[dust_density],ALARM:[alarm_status]\r\n"
-  // 例如: "T:25,H:60,CO:15.2,DUST:30.5,ALARM:None\r\n"
-  
-  // 创建JSON文档
-  StaticJsonDocument<256> jsonDoc;
+  // 聚合模式：样本只进入窗口，窗口结束时统一发布汇总
+  if (aggregatorGetConfig().enabled) {
+    WindowSummary summary;
+    if (aggregatorPoll(lastDataTime, summary)) {
+      publishWindowSummary(summary);
+    }
+    aggregatorAdd(sample, lastDataTime);
+    
+    // 报警期间额外发布原始样本，保留短时尖峰
+    if (aggregatorGetConfig().rawOnAlarm && sample.alarm_status != "None") {
+      Serial.println("报警中，发布原始样本");
+      publishSensorSample(sample);
+    }
+    return;
+  }
   
-  // 格式化时间戳为ISO 8601格式
-  time_t now;
-  struct tm timeinfo;
-  if (!getLocalTime(&timeinfo)) {
-    // 如果获取时间失败，使用毫秒时间戳
-    jsonDoc["timestamp"] = millis();
-  } else {
-    char timeStr[30];
-    strftime(timeStr, sizeof(timeStr), "%Y-%m-%dT%H:%M:%S+08:00", &timeinfo);
-    jsonDoc["timestamp"] = timeStr;
+  // 死区/心跳策略：变化不大的数据不上报
+  const char* reason = NULL;
+  if (!reportPolicyShouldPublish(sample, lastDataTime, &reason)) {
+    Serial.println("数据变化未超过死区，本次不上报");
+    return;
   }
   
+  Serial.print("上报原因: ");
+  Serial.println(reason);
+  if (publishSensorSample(sample)) {
+    reportPolicyMarkPublished(sample, lastDataTime);
+  }
+}
+
+// 解析数据帧格式: "T:[temperature],H:[humidity],CO:[co_ppm],DUST:[dust_density],ALARM:[alarm_status]\r\n"
+// 例如: "T:25,H:60,CO:15.2,DUST:30.5,ALARM:None\r\n"
+bool parseSTM32Line(const String& data, SensorSample& sample) {
   // 提取各个参数
   int tIndex = data.indexOf("T:");
   int hIndex = data.indexOf(",H:");
@@ -537,55 +978,129 @@ void processSTM32Data(String data) {
   int dustIndex = data.indexOf(",DUST:");
   int alarmIndex = data.indexOf(",ALARM:");
   
-  if (tIndex >= 0 && hIndex >= 0 && coIndex >= 0 && dustIndex >= 0 && alarmIndex >= 0) {
-    // 提取温度
-    String tempStr = data.substring(tIndex + 2, hIndex);
-    jsonDoc["temperature"] = tempStr.toInt();
-    
-    // 提取湿度
-    String humidStr = data.substring(hIndex + 3, coIndex);
-    jsonDoc["humidity"] = humidStr.toInt();
-    
-    // 提取CO浓度
-    String coStr = data.substring(coIndex + 4, dustIndex);
-    jsonDoc["co_ppm"] = coStr.toFloat();
-    
-    // 提取粉尘浓度
-    String dustStr = data.substring(dustIndex + 6, alarmIndex);
-    jsonDoc["dust_density"] = dustStr.toFloat();
-    
-    // 提取报警状态
-    String alarmStr = data.substring(alarmIndex + 7);
-    jsonDoc["alarm_status"] = alarmStr;
-    
-    // 添加设备ID（确保格式一致）
-    jsonDoc["device_id"] = mqttClientId;
-    
-    // 将JSON转换为字符串
-    String jsonString;
-    serializeJson(jsonDoc, jsonString);
-    
-    // 通过MQTT发送
-    if (mqttClient.connected()) {
-      Serial.print("发送MQTT数据: ");
-      Serial.println(jsonString);
-      Serial.print("使用主题: ");
-      Serial.println(mqttTopic);
-      
-      if (mqttClient.publish(mqttTopic, jsonString.c_str())) {
-        Serial.println("MQTT消息发送成功");
-        // 短闪烁指示灯表示数据发送成功
-        digitalWrite(STATUS_LED, LOW);
-        delay(100);
-        digitalWrite(STATUS_LED, HIGH);
-      } else {
-        Serial.println("MQTT消息发送失败");
-      }
+  if (tIndex < 0 || hIndex < 0 || coIndex < 0 || dustIndex < 0 || alarmIndex < 0) {
+    return false;
+  }
+  
+  sample.temperature = data.substring(tIndex + 2, hIndex).toInt();          // 温度
+  sample.humidity = data.substring(hIndex + 3, coIndex).toInt();            // 湿度
+  sample.co_ppm = data.substring(coIndex + 4, dustIndex).toFloat();         // CO浓度
+  sample.dust_density = data.substring(dustIndex + 6, alarmIndex).toFloat(); // 粉尘浓度
+  sample.alarm_status = data.substring(alarmIndex + 7);                     // 报警状态
+  sample.alarm_mask = stm32LinkAlarmMask(sample.alarm_status);              // 文本格式只有一个报警
+  sample.valid = SAMPLE_VALID_ALL;                                          // STM32在全部传感器出结果后才发文本行
+  sample.timestamp = 0;                                                     // 文本格式不带采集时间
+  return true;
+}
+
+// 样本的测量值和报警字段；还没有测量结果的字段（STM32上电后的前几秒，CO为第一个加热周期）不写入
+void sampleFieldsToJson(const SensorSample& sample, JsonDocument& jsonDoc) {
+  if (sample.valid & SAMPLE_VALID_TEMP) jsonDoc["temperature"] = sample.temperature;
+  if (sample.valid & SAMPLE_VALID_HUMI) jsonDoc["humidity"] = sample.humidity;
+  if (sample.valid & SAMPLE_VALID_CO) jsonDoc["co_ppm"] = sample.co_ppm;
+  if (sample.valid & SAMPLE_VALID_DUST) jsonDoc["dust_density"] = sample.dust_density;
+  jsonDoc["alarm_status"] = sample.alarm_status;
+  jsonDoc["alarm_mask"] = sample.alarm_mask;   // 同时存在的全部报警，alarm_status只是其中优先级最高的一个
+}
+
+// 将一条传感器数据转换为JSON并放入QoS 1发布队列
+bool publishSensorSample(const SensorSample& sample) {
+  // 创建JSON文档
+  StaticJsonDocument<256> jsonDoc;
+  
+  sampleFieldsToJson(sample, jsonDoc);
+  setSourceTimestamp(jsonDoc, sample.timestamp);
+  
+  return publishSensorDoc(jsonDoc);
+}
+
+// 发布一条补传的历史记录，时间戳为STM32采集时间，不经过聚合和死区策略
+bool publishBackfillRecord(const SensorSample& sample, uint16_t seq) {
+  StaticJsonDocument<256> jsonDoc;
+  
+  sampleFieldsToJson(sample, jsonDoc);
+  jsonDoc["backfill"] = true;
+  jsonDoc["record_seq"] = seq;
+  setSourceTimestamp(jsonDoc, sample.timestamp);
+  
+  return publishSensorDoc(jsonDoc);
+}
+
+// 发布一个窗口的汇总，顶层字段取均值，时间戳为窗口结束时间
+bool publishWindowSummary(const WindowSummary& summary) {
+  StaticJsonDocument<768> jsonDoc;
+  
+  aggregatorSummaryToJson(summary, jsonDoc.to<JsonObject>());
+  setSourceTimestamp(jsonDoc, summary.lastTimestamp);
+  Serial.print("窗口汇总: 样本数 ");
+  Serial.println(summary.count);
+  
+  return publishSensorDoc(jsonDoc);
+}
+
+// 用STM32的采集时间作为时间戳（ISO 8601，东八区），0表示没有，由publishSensorDoc补当前时间
+void setSourceTimestamp(JsonDocument& jsonDoc, uint32_t unixTime) {
+  if (unixTime == 0) {
+    return;
+  }
+  time_t t = (time_t)unixTime;
+  struct tm timeinfo;
+  char timeStr[30];
+  localtime_r(&t, &timeinfo);
+  strftime(timeStr, sizeof(timeStr), "%Y-%m-%dT%H:%M:%S+08:00", &timeinfo);
+  jsonDoc["timestamp"] = timeStr;
+  jsonDoc["time_source"] = "stm32";
+}
+
+// 补齐时间戳和设备ID后放入QoS 1发布队列
+bool publishSensorDoc(JsonDocument& jsonDoc) {
+  // 格式化时间戳为ISO 8601格式；已有STM32采集时间时不覆盖
+  if (!jsonDoc.containsKey("timestamp")) {
+    struct tm timeinfo;
+    if (!getLocalTime(&timeinfo)) {
+      // 如果获取时间失败，使用毫秒时间戳
+      jsonDoc["timestamp"] = millis();
     } else {
-      Serial.println("MQTT未连接，无法发送数据");
+      char timeStr[30];
+      strftime(timeStr, sizeof(timeStr), "%Y-%m-%dT%H:%M:%S+08:00", &timeinfo);
+      jsonDoc["timestamp"] = timeStr;
     }
-  } else {
-    Serial.println("数据格式错误");
+  }
+  
+  // 添加设备ID（确保格式一致）
+  jsonDoc["device_id"] = mqttClientId;
+  
+  // 将JSON转换为字符串
+  String jsonString;
+  serializeJson(jsonDoc, jsonString);
+  
+  // 通过QoS 1发布队列发送，断线期间消息保留在队列中，重连后补发
+  Serial.print("发送MQTT数据: ");
+  Serial.println(jsonString);
+  Serial.print("使用主题: ");
+  Serial.println(mqttTopic);
+  
+  if (!mqttQos1Publish(mqttTopic, jsonString.c_str())) {
+    Serial.println("MQTT发送队列已满，消息被丢弃");
+    return false;
+  }
+  
+  Serial.print("MQTT消息已入队，在途/待发: ");
+  Serial.print(mqttQos1InFlight());
+  Serial.print("/");
+  Serial.println(mqttQos1Pending());
+  // 短闪烁指示灯表示数据已提交，由loop()在100ms后恢复，不阻塞MQTT和串口接收
+  digitalWrite(STATUS_LED, LOW);
+  ledBlinkAt = millis();
+  ledBlinking = true;
+  return true;
+}
+
+// 闪烁结束后按MQTT连接状态恢复指示灯（期间断线时保持熄灭）
+void serviceStatusLed() {
+  if (ledBlinking && millis() - ledBlinkAt >= 100) {
+    ledBlinking = false;
+    digitalWrite(STATUS_LED, mqttClient.connected() ? HIGH : LOW);
   }
 }
 
@@ -0,0 +1,180 @@
+#include "backfill.h"
+#include <Preferences.h>
+
+extern Preferences preferences;
+
+static BackfillStats stats = {0, 0, 0, 0, 0};
+
+static bool hasCovered = false;   // 是否有已覆盖的记录
+static uint16_t coveredSeq = 0;   // 云端已覆盖的最新实时记录
+static uint16_t bootId = 0;       // coveredSeq所属的STM32启动号，0表示未知
+static uint16_t savedSeq = 0;     // 上次保存到Preferences的值
+static uint16_t sinceSave = 0;
+
+// 待补范围[fillNext, fillEnd)，两者相等表示没有缺口
+static uint16_t fillNext = 0;
+static uint16_t fillEnd = 0;
+
+// 当前请求
+static bool requestActive = false;
+static uint16_t requestEnd = 0;   // 请求范围的结束序号(不含)
+static uint16_t requestNext = 0;  // 发出请求时的fillNext，用于判断是否有应答
+static uint8_t retries = 0;
+static unsigned long requestedAt = 0;
+
+static uint16_t fillRemaining() {
+  return (uint16_t)(fillEnd - fillNext);
+}
+
+// 真正覆盖到的位置：有缺口时为缺口之前一条，保存这个值，重启后缺口会被重新发现
+static uint16_t persistentSeq() {
+  return fillRemaining() > 0 ? (uint16_t)(fillNext - 1) : coveredSeq;
+}
+
+static void saveProgress(bool force) {
+  uint16_t seq = persistentSeq();
+  if (!force && (sinceSave < BACKFILL_SAVE_EVERY || seq == savedSeq)) {
+    return;
+  }
+  preferences.begin("backfill", false);
+  preferences.putBool("valid", true);
+  preferences.putUShort("seq", seq);
+  preferences.putUShort("boot", bootId);
+  preferences.end();
+  savedSeq = seq;
+  sinceSave = 0;
+}
+
+static void abandonRange() {
+  stats.abandoned += fillRemaining();
+  fillNext = fillEnd;
+  requestActive = false;
+  retries = 0;
+  saveProgress(true);
+}
+
+// STM32复位：旧历史已经没有了，放弃没补完的缺口；新历史从记录0开始，
+// 把已覆盖序号放在记录0之前，复位后云端没收到的记录按普通缺口补传
+static void restartHistory(uint16_t newBootId) {
+  Serial.printf("STM32已复位(启动号%u -> %u)\n", bootId, newBootId);
+  stats.resets++;
+  bootId = newBootId;
+  hasCovered = true;
+  coveredSeq = 0xFFFF;
+  abandonRange();   // 同时保存新的进度
+}
+
+void backfillLoad() {
+  preferences.begin("backfill", true);
+  hasCovered = preferences.getBool("valid", false);
+  coveredSeq = preferences.getUShort("seq", 0);
+  bootId = preferences.getUShort("boot", 0);
+  preferences.end();
+  savedSeq = coveredSeq;
+}
+
+BackfillRecordKind backfillOnRecord(uint16_t seq, uint16_t recordBootId) {
+  // 启动号变化说明STM32复位过，要在匹配待补范围之前处理，新历史的序号可能落在旧缺口里
+  if (recordBootId != 0 && recordBootId != bootId) {
+    if (bootId != 0 && hasCovered) {
+      restartHistory(recordBootId);
+    } else {
+      bootId = recordBootId;   // 第一次见到启动号（新ESP32或旧固件升级后）
+    }
+  }
+
+  // 落在待补范围内的是补传记录；STM32跳过已被覆盖的记录，序号可能跳跃
+  if (fillRemaining() > 0 && (uint16_t)(seq - fillNext) < fillRemaining()) {
+    fillNext = seq + 1;
+    stats.filled++;
+    sinceSave++;
+    if (requestActive && (uint16_t)(fillNext - requestNext) >= (uint16_t)(requestEnd - requestNext)) {
+      requestActive = false;   // 本块收齐，可以请求下一块
+      retries = 0;
+    }
+    saveProgress(false);
+    return BACKFILL_RECORD_FILL;
+  }
+
+  // 实时记录：云端不通时不推进，恢复后整段作为缺口补传
+  if (!mqttQos1Connected()) {
+    return BACKFILL_RECORD_LIVE;
+  }
+
+  uint16_t gap = hasCovered ? (uint16_t)(seq - coveredSeq - 1) : 0;
+  if (gap >= 0x8000) {
+    // 同一次启动中实时记录的序号只会前进；启动号没有变化却倒退，只能是复位
+    restartHistory(bootId);
+    gap = seq;
+  }
+  if (gap > 0) {
+    if (gap > BACKFILL_HISTORY_DEPTH - BACKFILL_EDGE_MARGIN) {
+      stats.abandoned += gap - (BACKFILL_HISTORY_DEPTH - BACKFILL_EDGE_MARGIN);
+      gap = BACKFILL_HISTORY_DEPTH - BACKFILL_EDGE_MARGIN;
+    }
+    if (fillRemaining() == 0) {
+      fillNext = seq - gap;
+    }
+    fillEnd = seq;   // 已有缺口时向后延长
+    stats.gaps++;
+    Serial.printf("记录缺口: %u..%u\n", fillNext, (uint16_t)(fillEnd - 1));
+  }
+
+  hasCovered = true;
+  coveredSeq = seq;
+  sinceSave++;
+  saveProgress(false);
+  return BACKFILL_RECORD_LIVE;
+}
+
+bool backfillPoll(unsigned long now, uint16_t& first, uint16_t& count) {
+  if (fillRemaining() == 0) {
+    requestActive = false;
+    return false;
+  }
+
+  if (requestActive) {
+    if (now - requestedAt < BACKFILL_TIMEOUT_MS) {
+      return false;
+    }
+    // 超时：有进展时从断点继续，连续无应答时放弃剩余缺口
+    if (fillNext != requestNext) {
+      retries = 0;
+    } else if (++retries > BACKFILL_MAX_RETRIES) {
+      Serial.printf("补传无应答，放弃%u条记录\n", fillRemaining());
+      abandonRange();
+      return false;
+    }
+    requestActive = false;
+  }
+
+  // 补传记录逐条发布，只在发布连接正常且队列有余量时请求，不挤占实时数据
+  if (!mqttQos1Connected() ||
+      mqttQos1Pending() + BACKFILL_CHUNK > MQTT_QOS1_QUEUE_SIZE - BACKFILL_QUEUE_RESERVE) {
+    return false;
+  }
+
+  first = fillNext;
+  count = fillRemaining() < BACKFILL_CHUNK ? fillRemaining() : BACKFILL_CHUNK;
+  requestNext = fillNext;
+  requestEnd = first + count;
+  requestActive = true;
+  requestedAt = now;
+  stats.requests++;
+  return true;
+}
+
+const BackfillStats& backfillGetStats() {
+  return stats;
+}
+
+void backfillToJson(JsonObject obj) {
+  obj["covered_seq"] = coveredSeq;
+  obj["boot_id"] = bootId;
+  obj["pending"] = fillRemaining();
+  obj["gaps"] = stats.gaps;
+  obj["requests"] = stats.requests;
+  obj["filled"] = stats.filled;
+  obj["abandoned"] = stats.abandoned;
+  obj["resets"] = stats.resets;
+}
@@ -0,0 +1,51 @@
+#ifndef BACKFILL_H
+#define BACKFILL_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include "mqtt_qos1.h"
+
+// ===========================
+// 历史记录补传
+// ===========================
+// STM32每5秒记录一个样本(记录帧，序号连续)，SRAM中保留最近约4小时。
+// ESP32只在云端发布连接正常时推进"已覆盖"的记录序号；重启或断线后第一条
+// 实时记录与已覆盖序号之间的缺口，就是云端缺失的数据，按小块向STM32请求补传，
+// 补传的记录逐条发布并带"backfill": true。已覆盖序号定期保存到Preferences，
+// 重启后最多重复补传BACKFILL_SAVE_EVERY条。
+// STM32复位后历史记录清空、序号从0重新开始。记录帧带STM32启动号，启动号变化即为复位：
+// 放弃旧历史中没补完的缺口，新历史从记录0开始算覆盖，复位后云端没收到的记录照常补传。
+// 旧固件不带启动号(0)，或者STM32后备域掉电后启动号恰好重复时，只能按序号倒退判断复位。
+#define BACKFILL_HISTORY_DEPTH   2880   // 与STM32端SENSOR_HISTORY_DEPTH一致
+#define BACKFILL_EDGE_MARGIN     60     // 缺口按深度截断时留出的余量，避免请求即将被覆盖的记录
+#define BACKFILL_CHUNK           8      // 每次请求的记录数
+#define BACKFILL_TIMEOUT_MS      3000   // 一次请求没有收齐时的重发间隔
+#define BACKFILL_MAX_RETRIES     3      // 一块连续无应答的次数上限，超过后放弃剩余缺口
+#define BACKFILL_SAVE_EVERY      60     // 每覆盖这么多条记录保存一次进度(5分钟)
+#define BACKFILL_QUEUE_RESERVE   (MQTT_QOS1_QUEUE_SIZE / 2)  // 发布队列至少留这么多给实时数据
+
+// 记录帧分类
+enum BackfillRecordKind {
+  BACKFILL_RECORD_LIVE,   // 新产生的记录，只用于跟踪进度
+  BACKFILL_RECORD_FILL,   // 补传的记录，需要发布
+};
+
+struct BackfillStats {
+  uint32_t gaps;          // 发现的缺口数
+  uint32_t requests;      // 发出的请求帧（含重发）
+  uint32_t filled;        // 收到的补传记录
+  uint32_t abandoned;     // 放弃的记录数（STM32已覆盖或复位）
+  uint32_t resets;        // 发现的STM32复位次数
+};
+
+// 从Preferences加载已覆盖的记录序号和启动号
+void backfillLoad();
+// 收到一条记录帧，返回它是实时记录还是补传记录；bootId为记录帧中的启动号，0表示未知
+BackfillRecordKind backfillOnRecord(uint16_t seq, uint16_t bootId);
+// 需要发请求时返回true，并给出起始序号和条数
+bool backfillPoll(unsigned long now, uint16_t& first, uint16_t& count);
+const BackfillStats& backfillGetStats();
+// 将进度和统计写入JSON（get_link_stats用）
+void backfillToJson(JsonObject obj);
+
+#endif // BACKFILL_H
@@ -0,0 +1,542 @@
+#include "mqtt_qos1.h"
+#include <WiFi.h>
+
+// MQTT 3.1.1 控制报文类型
+#define MQTT_PKT_CONNECT    0x10
+#define MQTT_PKT_CONNACK    0x20
+#define MQTT_PKT_PUBLISH    0x30
+#define MQTT_PKT_PUBACK     0x40
+#define MQTT_PKT_PINGREQ    0xC0
+#define MQTT_PKT_PINGRESP   0xD0
+
+#define MQTT_PUBLISH_DUP    0x08
+#define MQTT_PUBLISH_QOS1   0x02
+
+// 队列槽状态
+enum {
+  SLOT_FREE = 0,      // 已确认，等待从队头移除
+  SLOT_QUEUED,        // 排队中，尚未发送
+  SLOT_INFLIGHT       // 已发送，等待PUBACK
+};
+
+// 连接状态
+enum {
+  LINK_IDLE = 0,      // 未连接
+  LINK_CONNECTING,    // 已发送CONNECT，等待CONNACK
+  LINK_CONNECTED      // 可以发布
+};
+
+// 接收解析状态
+enum {
+  RX_HEADER = 0,
+  RX_LENGTH,
+  RX_BODY
+};
+
+// 吞吐量测试阶段
+enum {
+  BENCH_IDLE = 0,
+  BENCH_DRAIN,        // 等待业务消息发送完毕
+  BENCH_RUN           // 发布测试消息并等待确认
+};
+
+struct PubSlot {
+  uint8_t state;
+  bool bench;         // 吞吐量测试消息，只计入测试结果，中止时清除
+  uint16_t packetId;
+  uint16_t payloadLen;
+  uint32_t sentAt;
+  char topic[MQTT_QOS1_MAX_TOPIC];
+  char payload[MQTT_QOS1_MAX_PAYLOAD];
+};
+
+static WiFiClient pubNet;
+static PubSlot slots[MQTT_QOS1_QUEUE_SIZE];
+static uint8_t queueHead = 0;           // 最早入队的槽
+static uint8_t queueCount = 0;          // 队头到队尾的槽数（含已确认未移除的槽）
+static uint8_t inFlight = 0;
+static uint8_t pubWindow = MQTT_QOS1_DEFAULT_WINDOW;
+static uint16_t nextPacketId = 1;
+static MqttQos1Stats stats;
+
+// 连接参数
+static const char* brokerHost = NULL;
+static int brokerPort = 1883;
+static String pubClientId;
+static const char* brokerUser = NULL;
+static const char* brokerPassword = NULL;
+
+static uint8_t linkState = LINK_IDLE;
+static unsigned long lastConnectAttempt = 0;
+static unsigned long connectStartedAt = 0;
+static unsigned long lastTxAt = 0;
+static unsigned long lastRxAt = 0;
+static bool pingOutstanding = false;
+
+// 吞吐量测试
+static uint8_t benchState = BENCH_IDLE;
+static char benchTopic[MQTT_QOS1_MAX_TOPIC];
+static uint16_t benchCount = 0;
+static uint16_t benchEnqueued = 0;
+static uint16_t benchAcked = 0;
+static uint8_t benchWindow = MQTT_QOS1_DEFAULT_WINDOW;
+static uint8_t benchSavedWindow = MQTT_QOS1_DEFAULT_WINDOW;
+static uint32_t benchTimeoutMs = 0;
+static unsigned long benchPhaseAt = 0;   // 当前阶段开始时间
+
+// 接收解析
+static uint8_t rxState = RX_HEADER;
+static uint8_t rxType = 0;
+static uint32_t rxRemaining = 0;
+static uint32_t rxMultiplier = 1;
+static uint8_t rxBody[4];
+static uint8_t rxBodyLen = 0;
+
+// 编码剩余长度字段，返回占用的字节数
+static uint8_t encodeRemainingLength(uint8_t* buf, uint32_t len) {
+  uint8_t n = 0;
+  do {
+    uint8_t digit = len % 128;
+    len /= 128;
+    if (len > 0) {
+      digit |= 0x80;
+    }
+    buf[n++] = digit;
+  } while (len > 0 && n < 4);
+  return n;
+}
+
+// 写入带2字节长度前缀的UTF-8字符串
+static uint16_t putString(uint8_t* buf, uint16_t pos, const char* str) {
+  uint16_t len = strlen(str);
+  buf[pos++] = len >> 8;
+  buf[pos++] = len & 0xFF;
+  memcpy(buf + pos, str, len);
+  return pos + len;
+}
+
+static void dropConnection() {
+  pubNet.stop();
+  linkState = LINK_IDLE;
+  rxState = RX_HEADER;
+  pingOutstanding = false;
+}
+
+static bool sendConnect() {
+  uint8_t body[256];
+  uint16_t pos = 0;
+  bool hasUser = brokerUser != NULL && brokerUser[0] != '\0';
+  bool hasPassword = hasUser && brokerPassword != NULL && brokerPassword[0] != '\0';
+
+  pos = putString(body, pos, "MQTT");
+  body[pos++] = 4;                          // 协议级别 3.1.1
+  // clean session=0: 代理保留会话，重连后重发的DUP消息仍按原报文ID确认
+  body[pos++] = (hasUser ? 0x80 : 0) | (hasPassword ? 0x40 : 0);
+  body[pos++] = MQTT_QOS1_KEEPALIVE_S >> 8;
+  body[pos++] = MQTT_QOS1_KEEPALIVE_S & 0xFF;
+
+  if (10 + pubClientId.length() + (hasUser ? 2 + strlen(brokerUser) : 0) +
+      (hasPassword ? 2 + strlen(brokerPassword) : 0) > sizeof(body)) {
+    Serial.println("QoS1发布连接参数过长");
+    return false;
+  }
+
+  pos = putString(body, pos, pubClientId.c_str());
+  if (hasUser) {
+    pos = putString(body, pos, brokerUser);
+  }
+  if (hasPassword) {
+    pos = putString(body, pos, brokerPassword);
+  }
+
+  uint8_t header[5];
+  header[0] = MQTT_PKT_CONNECT;
+  uint8_t hlen = 1 + encodeRemainingLength(header + 1, pos);
+  if (pubNet.write(header, hlen) != hlen || pubNet.write(body, pos) != pos) {
+    return false;
+  }
+  lastTxAt = millis();
+  return true;
+}
+
+static bool sendPublish(PubSlot& slot, bool dup) {
+  uint16_t topicLen = strlen(slot.topic);
+  uint8_t header[5 + 2 + MQTT_QOS1_MAX_TOPIC + 2];
+  uint8_t pos = 0;
+
+  header[pos++] = MQTT_PKT_PUBLISH | MQTT_PUBLISH_QOS1 | (dup ? MQTT_PUBLISH_DUP : 0);
+  pos += encodeRemainingLength(header + pos, 2 + topicLen + 2 + slot.payloadLen);
+  header[pos++] = topicLen >> 8;
+  header[pos++] = topicLen & 0xFF;
+  memcpy(header + pos, slot.topic, topicLen);
+  pos += topicLen;
+  header[pos++] = slot.packetId >> 8;
+  header[pos++] = slot.packetId & 0xFF;
+
+  if (pubNet.write(header, pos) != pos ||
+      pubNet.write((const uint8_t*)slot.payload, slot.payloadLen) != slot.payloadLen) {
+    dropConnection();
+    return false;
+  }
+
+  slot.sentAt = millis();
+  lastTxAt = slot.sentAt;
+  return true;
+}
+
+// 移除队头已确认的槽
+static void compactQueue() {
+  while (queueCount > 0 && slots[queueHead].state == SLOT_FREE) {
+    queueHead = (queueHead + 1) % MQTT_QOS1_QUEUE_SIZE;
+    queueCount--;
+  }
+}
+
+static void handlePuback(uint16_t packetId) {
+  for (uint8_t i = 0; i < queueCount; i++) {
+    PubSlot& slot = slots[(queueHead + i) % MQTT_QOS1_QUEUE_SIZE];
+    if (slot.state == SLOT_INFLIGHT && slot.packetId == packetId) {
+      slot.state = SLOT_FREE;
+      inFlight--;
+      stats.acked++;
+      if (slot.bench) {
+        benchAcked++;
+      }
+      compactQueue();
+      return;
+    }
+  }
+}
+
+// 重连后按原顺序重发全部在途消息
+static void resendInFlight() {
+  for (uint8_t i = 0; i < queueCount && linkState == LINK_CONNECTED; i++) {
+    PubSlot& slot = slots[(queueHead + i) % MQTT_QOS1_QUEUE_SIZE];
+    if (slot.state == SLOT_INFLIGHT && sendPublish(slot, true)) {
+      stats.retransmits++;
+    }
+  }
+}
+
+static void handlePacket(uint8_t type, const uint8_t* body, uint8_t len) {
+  switch (type & 0xF0) {
+    case MQTT_PKT_CONNACK:
+      if (linkState == LINK_CONNECTING && len >= 2 && body[1] == 0) {
+        linkState = LINK_CONNECTED;
+        stats.reconnects++;
+        Serial.println("QoS1发布连接成功");
+        resendInFlight();
+      } else if (linkState == LINK_CONNECTING) {
+        Serial.print("QoS1发布连接被拒绝，返回码: ");
+        Serial.println(len >= 2 ? body[1] : -1);
+        dropConnection();
+      }
+      break;
+
+    case MQTT_PKT_PUBACK:
+      if (len >= 2) {
+        handlePuback(((uint16_t)body[0] << 8) | body[1]);
+      }
+      break;
+
+    case MQTT_PKT_PINGRESP:
+      pingOutstanding = false;
+      break;
+
+    default:
+      // 该连接不订阅任何主题，其他报文直接忽略
+      break;
+  }
+}
+
+static void readIncoming() {
+  while (pubNet.available() > 0) {
+    uint8_t b = pubNet.read();
+    lastRxAt = millis();
+
+    switch (rxState) {
+      case RX_HEADER:
+        rxType = b;
+        rxRemaining = 0;
+        rxMultiplier = 1;
+        rxBodyLen = 0;
+        rxState = RX_LENGTH;
+        break;
+
+      case RX_LENGTH:
+        rxRemaining += (b & 0x7F) * rxMultiplier;
+        rxMultiplier *= 128;
+        if ((b & 0x80) == 0) {
+          if (rxRemaining == 0) {
+            handlePacket(rxType, rxBody, 0);
+            rxState = RX_HEADER;
+          } else {
+            rxState = RX_BODY;
+          }
+        } else if (rxMultiplier > 128UL * 128 * 128) {
+          dropConnection();   // 剩余长度字段非法
+          return;
+        }
+        break;
+
+      case RX_BODY:
+        if (rxBodyLen < sizeof(rxBody)) {
+          rxBody[rxBodyLen++] = b;    // 只关心前4字节，更长的报文体直接丢弃
+        }
+        if (--rxRemaining == 0) {
+          handlePacket(rxType, rxBody, rxBodyLen);
+          rxState = RX_HEADER;
+        }
+        break;
+    }
+  }
+}
+
+// 在窗口允许的范围内发送排队中的消息，并重发超时的在途消息
+static void pumpQueue() {
+  unsigned long now = millis();
+
+  for (uint8_t i = 0; i < queueCount && linkState == LINK_CONNECTED; i++) {
+    PubSlot& slot = slots[(queueHead + i) % MQTT_QOS1_QUEUE_SIZE];
+
+    if (slot.state == SLOT_INFLIGHT && now - slot.sentAt >= MQTT_QOS1_RETRY_MS) {
+      if (sendPublish(slot, true)) {
+        stats.retransmits++;
+      }
+    } else if (slot.state == SLOT_QUEUED && inFlight < pubWindow) {
+      slot.state = SLOT_INFLIGHT;
+      inFlight++;
+      if (sendPublish(slot, false)) {
+        stats.sent++;
+      }
+    }
+  }
+}
+
+void mqttQos1Begin(const char* host, int port, const String& clientId, const char* user, const char* password) {
+  brokerHost = host;
+  brokerPort = port;
+  pubClientId = clientId;
+  brokerUser = user;
+  brokerPassword = password;
+  pubNet.setNoDelay(true);
+}
+
+void mqttQos1SetWindow(uint8_t window) {
+  if (window < 1) window = 1;
+  if (window > MQTT_QOS1_MAX_WINDOW) window = MQTT_QOS1_MAX_WINDOW;
+  pubWindow = window;
+}
+
+uint8_t mqttQos1GetWindow() {
+  return pubWindow;
+}
+
+static bool enqueue(const char* topic, const char* payload, bool bench) {
+  size_t topicLen = strlen(topic);
+  size_t payloadLen = strlen(payload);
+
+  if (topicLen >= MQTT_QOS1_MAX_TOPIC || payloadLen > MQTT_QOS1_MAX_PAYLOAD) {
+    Serial.println("QoS1消息过长，已丢弃");
+    stats.dropped++;
+    return false;
+  }
+  if (queueCount >= MQTT_QOS1_QUEUE_SIZE) {
+    stats.dropped++;
+    return false;
+  }
+
+  PubSlot& slot = slots[(queueHead + queueCount) % MQTT_QOS1_QUEUE_SIZE];
+  memcpy(slot.topic, topic, topicLen + 1);
+  memcpy(slot.payload, payload, payloadLen);
+  slot.payloadLen = payloadLen;
+  slot.packetId = nextPacketId;
+  slot.state = SLOT_QUEUED;
+  slot.bench = bench;
+  nextPacketId = nextPacketId == 0xFFFF ? 1 : nextPacketId + 1;
+  queueCount++;
+  stats.queued++;
+
+  // 立即尝试发送，减少一个loop周期的延迟
+  pumpQueue();
+  return true;
+}
+
+bool mqttQos1Publish(const char* topic, const char* payload) {
+  return enqueue(topic, payload, false);
+}
+
+void mqttQos1Loop() {
+  unsigned long now = millis();
+
+  if (brokerHost == NULL) {
+    return;
+  }
+
+  if (WiFi.status() != WL_CONNECTED) {
+    if (linkState != LINK_IDLE) {
+      dropConnection();
+    }
+    return;
+  }
+
+  if (linkState != LINK_IDLE && !pubNet.connected()) {
+    Serial.println("QoS1发布连接断开，未确认消息将在重连后重发");
+    dropConnection();
+  }
+
+  if (linkState == LINK_IDLE) {
+    if (now - lastConnectAttempt < MQTT_QOS1_CONNECT_MS) {
+      return;
+    }
+    lastConnectAttempt = now;
+    if (!pubNet.connect(brokerHost, brokerPort) || !sendConnect()) {
+      dropConnection();
+      return;
+    }
+    linkState = LINK_CONNECTING;
+    connectStartedAt = now;
+    lastRxAt = now;
+  }
+
+  readIncoming();
+
+  if (linkState == LINK_CONNECTING) {
+    if (now - connectStartedAt >= MQTT_QOS1_CONNECT_MS) {
+      Serial.println("QoS1发布连接等待CONNACK超时");
+      dropConnection();
+    }
+    return;
+  }
+
+  if (linkState != LINK_CONNECTED) {
+    return;
+  }
+
+  pumpQueue();
+
+  // 保活：空闲超过一半保活时间发送PINGREQ，超过保活时间仍无响应则断开
+  if (pingOutstanding && now - lastRxAt >= MQTT_QOS1_KEEPALIVE_S * 1000UL) {
+    Serial.println("QoS1发布连接保活超时");
+    dropConnection();
+  } else if (!pingOutstanding && now - lastTxAt >= MQTT_QOS1_KEEPALIVE_S * 500UL) {
+    uint8_t ping[2] = { MQTT_PKT_PINGREQ, 0 };
+    if (pubNet.write(ping, 2) == 2) {
+      lastTxAt = now;
+      pingOutstanding = true;
+    } else {
+      dropConnection();
+    }
+  }
+}
+
+bool mqttQos1Connected() {
+  return linkState == LINK_CONNECTED;
+}
+
+uint8_t mqttQos1InFlight() {
+  return inFlight;
+}
+
+uint8_t mqttQos1Pending() {
+  uint8_t pending = 0;
+  for (uint8_t i = 0; i < queueCount; i++) {
+    if (slots[(queueHead + i) % MQTT_QOS1_QUEUE_SIZE].state != SLOT_FREE) {
+      pending++;
+    }
+  }
+  return pending;
+}
+
+const MqttQos1Stats& mqttQos1GetStats() {
+  return stats;
+}
+
+// 清除尚未确认的测试消息；之后迟到的PUBACK找不到对应的槽，直接忽略
+static void purgeBench() {
+  for (uint8_t i = 0; i < queueCount; i++) {
+    PubSlot& slot = slots[(queueHead + i) % MQTT_QOS1_QUEUE_SIZE];
+    if (slot.bench && slot.state != SLOT_FREE) {
+      if (slot.state == SLOT_INFLIGHT) {
+        inFlight--;
+      }
+      slot.state = SLOT_FREE;
+    }
+  }
+  compactQueue();
+}
+
+static void endBench() {
+  pubWindow = benchSavedWindow;
+  benchState = BENCH_IDLE;
+}
+
+bool mqttQos1BenchStart(const char* topic, uint16_t count, uint8_t window, uint32_t timeoutMs) {
+  if (benchState != BENCH_IDLE || count == 0 || strlen(topic) >= MQTT_QOS1_MAX_TOPIC) {
+    return false;
+  }
+
+  strcpy(benchTopic, topic);
+  benchCount = count;
+  benchEnqueued = 0;
+  benchAcked = 0;
+  benchWindow = window;
+  benchSavedWindow = pubWindow;
+  benchTimeoutMs = timeoutMs;
+  benchPhaseAt = millis();
+  benchState = BENCH_DRAIN;
+  return true;
+}
+
+uint8_t mqttQos1BenchPoll(float* msgsPerSec) {
+  unsigned long now = millis();
+
+  switch (benchState) {
+    case BENCH_DRAIN:
+      // 先等业务消息发送完毕，避免测试开始时窗口被占用
+      if (now - benchPhaseAt >= benchTimeoutMs) {
+        endBench();
+        return MQTT_QOS1_BENCH_FAILED;
+      }
+      if (!mqttQos1Connected() || mqttQos1Pending() > 0) {
+        return MQTT_QOS1_BENCH_BUSY;
+      }
+      mqttQos1SetWindow(benchWindow);
+      benchPhaseAt = now;
+      benchState = BENCH_RUN;
+      // fall through
+
+    case BENCH_RUN: {
+      if (linkState != LINK_CONNECTED || now - benchPhaseAt >= benchTimeoutMs) {
+        purgeBench();
+        endBench();
+        return MQTT_QOS1_BENCH_FAILED;
+      }
+
+      char payload[48];
+      while (benchEnqueued < benchCount && queueCount < MQTT_QOS1_QUEUE_SIZE) {
+        snprintf(payload, sizeof(payload), "{\"bench_seq\":%u,\"window\":%u}", benchEnqueued, benchWindow);
+        enqueue(benchTopic, payload, true);
+        benchEnqueued++;
+      }
+
+      if (benchAcked < benchCount) {
+        return MQTT_QOS1_BENCH_BUSY;
+      }
+      unsigned long elapsed = now - benchPhaseAt;
+      *msgsPerSec = benchCount * 1000.0f / (elapsed > 0 ? elapsed : 1);
+      endBench();
+      return MQTT_QOS1_BENCH_DONE;
+    }
+
+    default:
+      return MQTT_QOS1_BENCH_FAILED;
+  }
+}
+
+void mqttQos1BenchAbort() {
+  if (benchState != BENCH_IDLE) {
+    purgeBench();
+    endBench();
+  }
+}
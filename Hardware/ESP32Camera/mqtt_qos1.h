@@ -0,0 +1,56 @@
+#ifndef MQTT_QOS1_H
+#define MQTT_QOS1_H
+
+#include <Arduino.h>
+
+// ===========================
+// QoS 1 发布层配置
+// ===========================
+// PubSubClient只支持QoS 0发布，这里用独立的TCP连接实现一个只负责发布的
+// 轻量MQTT 3.1.1客户端：消息先进入队列，最多window条同时在途等待PUBACK，
+// 超时重发(DUP)，断线期间未确认的消息保留在队列中，重连后按原顺序重发。
+#define MQTT_QOS1_MAX_WINDOW      16     // 在途窗口上限
+#define MQTT_QOS1_DEFAULT_WINDOW  4      // 默认在途窗口
+#define MQTT_QOS1_QUEUE_SIZE      24     // 发送队列长度（含在途消息）
+#define MQTT_QOS1_MAX_TOPIC       96     // 主题最大长度
+#define MQTT_QOS1_MAX_PAYLOAD     768    // 单条消息最大负载（窗口汇总约500字节）
+#define MQTT_QOS1_RETRY_MS        3000   // PUBACK超时重发间隔
+#define MQTT_QOS1_CONNECT_MS      5000   // 连接重试间隔 / CONNACK等待超时
+#define MQTT_QOS1_KEEPALIVE_S     30     // 保活时间(秒)
+
+// 发布统计
+struct MqttQos1Stats {
+  uint32_t queued;        // 入队消息数
+  uint32_t sent;          // 首次发送数
+  uint32_t acked;         // 收到PUBACK数
+  uint32_t retransmits;   // 重发次数（超时或重连）
+  uint32_t dropped;       // 队列满被丢弃的消息数
+  uint32_t reconnects;    // 成功建立连接次数
+};
+
+// 初始化发布连接参数（clientId需与PubSubClient的不同，否则两个连接会互相踢下线）
+void mqttQos1Begin(const char* host, int port, const String& clientId, const char* user, const char* password);
+// 设置在途窗口大小(1~MQTT_QOS1_MAX_WINDOW)
+void mqttQos1SetWindow(uint8_t window);
+uint8_t mqttQos1GetWindow();
+// 将消息放入发送队列，队列满时返回false
+bool mqttQos1Publish(const char* topic, const char* payload);
+// 驱动连接、收发与重传，需要在loop()中周期调用
+void mqttQos1Loop();
+bool mqttQos1Connected();
+uint8_t mqttQos1InFlight();
+uint8_t mqttQos1Pending();
+const MqttQos1Stats& mqttQos1GetStats();
+
+// 吞吐量测试（非阻塞）：先等已入队的业务消息发完，再以指定窗口发布count条测试消息并等待全部确认。
+// 启动后在loop()中调用mqttQos1BenchPoll()推进，期间调用者照常处理其他连接和串口；
+// 测试失败或中止时，尚未确认的测试消息从队列中清除，不会在重连后继续重发。
+#define MQTT_QOS1_BENCH_BUSY      0      // 进行中
+#define MQTT_QOS1_BENCH_DONE      1      // 完成，结果为每秒确认的测试消息数
+#define MQTT_QOS1_BENCH_FAILED    2      // 排空/测试超时、连接断开或未启动
+
+bool mqttQos1BenchStart(const char* topic, uint16_t count, uint8_t window, uint32_t timeoutMs);
+uint8_t mqttQos1BenchPoll(float* msgsPerSec);
+void mqttQos1BenchAbort();
+
+#endif // MQTT_QOS1_H
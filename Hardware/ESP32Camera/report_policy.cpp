@@ -0,0 +1,117 @@
+#include "report_policy.h"
+#include <Preferences.h>
+
+extern Preferences preferences;
+
+static ReportPolicy policy = {
+  true,
+  REPORT_DEFAULT_TEMP_DELTA,
+  REPORT_DEFAULT_HUMI_DELTA,
+  REPORT_DEFAULT_CO_DELTA,
+  REPORT_DEFAULT_DUST_DELTA,
+  REPORT_DEFAULT_HEARTBEAT_S
+};
+
+// 上次上报的数据，作为死区比较的基准
+static bool hasPublished = false;
+static SensorSample lastPublished;
+static unsigned long lastPublishedAt = 0;
+
+void reportPolicyLoad() {
+  preferences.begin("report", true);
+  policy.enabled = preferences.getBool("enabled", true);
+  policy.tempDelta = preferences.getFloat("temp_d", REPORT_DEFAULT_TEMP_DELTA);
+  policy.humiDelta = preferences.getFloat("humi_d", REPORT_DEFAULT_HUMI_DELTA);
+  policy.coDelta = preferences.getFloat("co_d", REPORT_DEFAULT_CO_DELTA);
+  policy.dustDelta = preferences.getFloat("dust_d", REPORT_DEFAULT_DUST_DELTA);
+  policy.heartbeatS = preferences.getUInt("heartbeat", REPORT_DEFAULT_HEARTBEAT_S);
+  preferences.end();
+}
+
+const ReportPolicy& reportPolicyGet() {
+  return policy;
+}
+
+// 字段在本条和上次上报中都有测量结果时才比较变化量
+static bool fieldChanged(const SensorSample& sample, uint8_t bit, float value, float last, float delta) {
+  return (sample.valid & lastPublished.valid & bit) && fabsf(value - last) > delta;
+}
+
+bool reportPolicyShouldPublish(const SensorSample& sample, unsigned long now, const char** reason) {
+  const char* why = NULL;
+
+  if (!policy.enabled) {
+    why = "policy_disabled";
+  } else if (!hasPublished) {
+    why = "first_sample";
+  } else if (sample.alarm_mask != lastPublished.alarm_mask || sample.alarm_status != lastPublished.alarm_status) {
+    why = "alarm_changed";
+  } else if (sample.valid & ~lastPublished.valid) {
+    why = "measured";
+  } else if (fieldChanged(sample, SAMPLE_VALID_TEMP, sample.temperature, lastPublished.temperature, policy.tempDelta)) {
+    why = "temperature";
+  } else if (fieldChanged(sample, SAMPLE_VALID_HUMI, sample.humidity, lastPublished.humidity, policy.humiDelta)) {
+    why = "humidity";
+  } else if (fieldChanged(sample, SAMPLE_VALID_CO, sample.co_ppm, lastPublished.co_ppm, policy.coDelta)) {
+    why = "co_ppm";
+  } else if (fieldChanged(sample, SAMPLE_VALID_DUST, sample.dust_density, lastPublished.dust_density, policy.dustDelta)) {
+    why = "dust_density";
+  } else if (now - lastPublishedAt >= policy.heartbeatS * 1000UL) {
+    why = "heartbeat";
+  }
+
+  if (reason != NULL) {
+    *reason = why;
+  }
+  return why != NULL;
+}
+
+void reportPolicyMarkPublished(const SensorSample& sample, unsigned long now) {
+  lastPublished = sample;
+  lastPublishedAt = now;
+  hasPublished = true;
+}
+
+bool reportPolicyApply(JsonVariantConst params, String& error) {
+  ReportPolicy next = policy;
+
+  if (params.containsKey("enabled")) next.enabled = params["enabled"].as<bool>();
+  if (params.containsKey("temperature_delta")) next.tempDelta = params["temperature_delta"].as<float>();
+  if (params.containsKey("humidity_delta")) next.humiDelta = params["humidity_delta"].as<float>();
+  if (params.containsKey("co_delta")) next.coDelta = params["co_delta"].as<float>();
+  if (params.containsKey("dust_delta")) next.dustDelta = params["dust_delta"].as<float>();
+  if (params.containsKey("heartbeat_s")) next.heartbeatS = params["heartbeat_s"].as<uint32_t>();
+
+  if (next.tempDelta < 0 || next.humiDelta < 0 || next.coDelta < 0 || next.dustDelta < 0) {
+    error = "死区不能为负数";
+    return false;
+  }
+  if (next.heartbeatS < 5 || next.heartbeatS > 86400) {
+    error = "心跳间隔需在5~86400秒之间";
+    return false;
+  }
+
+  policy = next;
+
+  preferences.begin("report", false);
+  preferences.putBool("enabled", policy.enabled);
+  preferences.putFloat("temp_d", policy.tempDelta);
+  preferences.putFloat("humi_d", policy.humiDelta);
+  preferences.putFloat("co_d", policy.coDelta);
+  preferences.putFloat("dust_d", policy.dustDelta);
+  preferences.putUInt("heartbeat", policy.heartbeatS);
+  preferences.end();
+
+  // 策略变化后强制下一条数据上报，让云端尽快看到新策略下的基准值
+  hasPublished = false;
+  return true;
+}
+
+void reportPolicyToJson(JsonObject obj) {
+  obj["enabled"] = policy.enabled;
+  obj["temperature_delta"] = policy.tempDelta;
+  obj["humidity_delta"] = policy.humiDelta;
+  obj["co_delta"] = policy.coDelta;
+  obj["dust_delta"] = policy.dustDelta;
+  obj["heartbeat_s"] = policy.heartbeatS;
+}
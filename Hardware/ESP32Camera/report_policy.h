@@ -0,0 +1,40 @@
+#ifndef REPORT_POLICY_H
+#define REPORT_POLICY_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include "sensor_sample.h"
+
+// ===========================
+// 上报策略：死区 + 心跳
+// ===========================
+// 某个字段相对上次上报值的变化超过死区、报警状态变化、或距离上次上报超过
+// 心跳间隔时才发布一条数据；否则本次采样只在本地丢弃。
+#define REPORT_DEFAULT_TEMP_DELTA     0.5f     // 温度死区(°C)，DHT11为整数，任意变化都会上报
+#define REPORT_DEFAULT_HUMI_DELTA     2.0f     // 湿度死区(%)
+#define REPORT_DEFAULT_CO_DELTA       2.0f     // CO死区(ppm)
+#define REPORT_DEFAULT_DUST_DELTA     5.0f     // 粉尘死区(ug/m3)
+#define REPORT_DEFAULT_HEARTBEAT_S    60       // 心跳间隔(秒)
+
+struct ReportPolicy {
+  bool enabled;           // false时每条数据都上报（旧行为）
+  float tempDelta;
+  float humiDelta;
+  float coDelta;
+  float dustDelta;
+  uint32_t heartbeatS;
+};
+
+// 从Preferences加载策略，没有保存过时使用默认值
+void reportPolicyLoad();
+const ReportPolicy& reportPolicyGet();
+// 判断本条数据是否需要上报，reason返回触发原因（用于串口日志）
+bool reportPolicyShouldPublish(const SensorSample& sample, unsigned long now, const char** reason);
+// 上报成功后记录基准值
+void reportPolicyMarkPublished(const SensorSample& sample, unsigned long now);
+// 应用MQTT命令中的参数并持久化，参数非法时返回false并给出原因
+bool reportPolicyApply(JsonVariantConst params, String& error);
+// 将当前策略写入JSON（命令响应用）
+void reportPolicyToJson(JsonObject obj);
+
+#endif // REPORT_POLICY_H
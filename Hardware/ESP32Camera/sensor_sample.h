@@ -0,0 +1,27 @@
+#ifndef SENSOR_SAMPLE_H
+#define SENSOR_SAMPLE_H
+
+#include <Arduino.h>
+
+// 测量标志，与STM32端SENSOR_VALID_xxx一致：上电后传感器第一次出结果之前，对应字段为0，不是测量值
+#define SAMPLE_VALID_TEMP   0x01
+#define SAMPLE_VALID_HUMI   0x02
+#define SAMPLE_VALID_CO     0x04
+#define SAMPLE_VALID_DUST   0x08
+#define SAMPLE_VALID_ALL    0x0F
+#define SAMPLE_VALID_FLAGS  0x80    // 帧中带测量标志；旧固件此字节为0，按全部有效处理
+
+// 从STM32解析出的一条传感器数据
+struct SensorSample {
+  int temperature;        // 温度(°C)
+  int humidity;           // 湿度(%)
+  float co_ppm;           // 一氧化碳浓度(ppm)
+  float dust_density;     // 粉尘浓度(ug/m3)
+  String alarm_status;    // 报警状态字符串，如 "None"、"CO Danger"，多个报警同时存在时只是优先级最高的一个
+  uint16_t alarm_mask;    // 报警位图，bit(n-1)对应STM32报警类型n，包含同时存在的全部报警；
+                          // ASCII格式只有报警字符串，由字符串推出一位
+  uint8_t valid;          // 已有测量结果的字段，SAMPLE_VALID_xxx；没有置位的字段不发布、不参与统计
+  uint32_t timestamp;     // STM32采集时间(Unix秒, UTC)，0表示未知（ASCII格式或STM32未校时）
+};
+
+#endif // SENSOR_SAMPLE_H
@@ -0,0 +1,268 @@
+#include "stm32_link.h"
+
+static Stm32LinkStats stats = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+static bool hasSeq = false;
+static uint16_t lastSeq = 0;
+static uint16_t txSeq = 0;      // ESP32->STM32方向的帧序号
+
+// CRC-16/CCITT-FALSE，帧很短，逐位计算即可
+static uint16_t crc16(const uint8_t* data, size_t len) {
+  uint16_t crc = 0xFFFF;
+
+  for (size_t i = 0; i < len; i++) {
+    crc ^= (uint16_t)data[i] << 8;
+    for (uint8_t b = 0; b < 8; b++) {
+      crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+    }
+  }
+  return crc;
+}
+
+// COBS解码，返回解码后的长度，格式错误返回0
+static size_t cobsDecode(const uint8_t* src, size_t len, uint8_t* dst, size_t dstSize) {
+  size_t in = 0;
+  size_t out = 0;
+
+  while (in < len) {
+    uint8_t code = src[in++];
+    if (code == 0 || in + code - 1 > len) {
+      return 0;
+    }
+    for (uint8_t i = 1; i < code; i++) {
+      if (out >= dstSize) return 0;
+      dst[out++] = src[in++];
+    }
+    // 码值小于0xFF且不是最后一个块时，代表一个被编码掉的0x00
+    if (code < 0xFF && in < len) {
+      if (out >= dstSize) return 0;
+      dst[out++] = 0;
+    }
+  }
+  return out;
+}
+
+// COBS编码，返回编码后的长度（不含结束符）
+static size_t cobsEncode(const uint8_t* src, size_t len, uint8_t* dst) {
+  size_t write = 1;
+  size_t codePos = 0;
+  uint8_t code = 1;
+
+  for (size_t read = 0; read < len; read++) {
+    if (src[read] == 0) {
+      dst[codePos] = code;
+      codePos = write++;
+      code = 1;
+    } else {
+      dst[write++] = src[read];
+      if (++code == 0xFF) {
+        dst[codePos] = code;
+        codePos = write++;
+        code = 1;
+      }
+    }
+  }
+  dst[codePos] = code;
+  return write;
+}
+
+static uint16_t readU16(const uint8_t* p) {
+  return (uint16_t)p[0] | ((uint16_t)p[1] << 8);
+}
+
+static uint32_t readU32(const uint8_t* p) {
+  return (uint32_t)readU16(p) | ((uint32_t)readU16(p + 2) << 16);
+}
+
+bool stm32LinkDecodeFrame(const uint8_t* data, size_t len, Stm32Frame& frame) {
+  uint8_t raw[STM32_FRAME_MAX_RAW];
+  size_t rawLen = cobsDecode(data, len, raw, sizeof(raw));
+
+  if (rawLen < STM32_FRAME_HEADER_LEN + STM32_FRAME_CRC_LEN) {
+    stats.formatErrors++;
+    return false;
+  }
+
+  size_t bodyLen = rawLen - STM32_FRAME_CRC_LEN;
+  if (crc16(raw, bodyLen) != readU16(raw + bodyLen)) {
+    stats.crcErrors++;
+    return false;
+  }
+
+  const uint8_t* payload = raw + STM32_FRAME_HEADER_LEN;
+  size_t payloadLen = bodyLen - STM32_FRAME_HEADER_LEN;
+  uint8_t type = raw[1];
+  bool isData = type == STM32_FRAME_TYPE_SAMPLE || type == STM32_FRAME_TYPE_RECORD;
+  if (raw[0] != STM32_FRAME_VERSION ||
+      !((isData && payloadLen >= 8) || (type == STM32_FRAME_TYPE_ACK && payloadLen >= 2))) {
+    stats.formatErrors++;
+    return false;
+  }
+
+  frame.type = type;
+  frame.seq = readU16(raw + 2);
+  frame.bootId = 0;
+  stats.frames++;
+
+  if (type == STM32_FRAME_TYPE_ACK) {
+    stats.acks++;
+    frame.ackCommand = payload[0];
+    frame.ackStatus = payload[1];
+    return true;
+  }
+
+  if (type == STM32_FRAME_TYPE_RECORD) {
+    stats.records++;   // 记录序号的连续性由backfill跟踪
+    frame.bootId = payloadLen >= 14 ? readU16(payload + 12) : 0;
+  } else {
+    // 序号检查：只统计，不丢弃数据
+    if (hasSeq && frame.seq != (uint16_t)(lastSeq + 1)) {
+      stats.seqGaps++;
+      stats.lostFrames += (uint16_t)(frame.seq - lastSeq - 1);
+    }
+    hasSeq = true;
+    lastSeq = frame.seq;
+  }
+
+  SensorSample& sample = frame.sample;
+  sample.temperature = (int8_t)payload[0];
+  sample.humidity = payload[1];
+  sample.co_ppm = readU16(payload + 2) / 10.0f;
+  sample.dust_density = readU16(payload + 4) / 10.0f;
+  sample.alarm_mask = payload[6];
+  sample.valid = (payload[7] & SAMPLE_VALID_FLAGS) ? (payload[7] & SAMPLE_VALID_ALL) : SAMPLE_VALID_ALL;
+  sample.alarm_status = stm32LinkAlarmString(sample.alarm_mask);
+  sample.timestamp = payloadLen >= 12 ? readU32(payload + 8) : 0;
+  return true;
+}
+
+// 组一个ESP32->STM32方向的帧（含结束符0x00），返回长度
+static size_t encodeFrame(uint8_t type, const uint8_t* payload, size_t payloadLen, uint8_t* out) {
+  uint8_t raw[STM32_FRAME_MAX_RAW];
+  size_t n = 0;
+
+  raw[n++] = STM32_FRAME_VERSION;
+  raw[n++] = type;
+  raw[n++] = txSeq & 0xFF;
+  raw[n++] = txSeq >> 8;
+  for (size_t i = 0; i < payloadLen; i++) {
+    raw[n++] = payload[i];
+  }
+  uint16_t crc = crc16(raw, n);
+  raw[n++] = crc & 0xFF;
+  raw[n++] = crc >> 8;
+  txSeq++;
+
+  n = cobsEncode(raw, n, out);
+  out[n++] = 0x00;
+  return n;
+}
+
+size_t stm32LinkEncodeTimeSync(uint32_t unixTime, uint8_t* out) {
+  uint8_t payload[4];
+
+  for (uint8_t i = 0; i < 4; i++) {
+    payload[i] = (unixTime >> (8 * i)) & 0xFF;
+  }
+  stats.timeSyncs++;
+  return encodeFrame(STM32_FRAME_TYPE_TIME_SYNC, payload, sizeof(payload), out);
+}
+
+size_t stm32LinkEncodeBackfill(uint16_t first, uint16_t count, uint8_t* out) {
+  uint8_t payload[4] = {
+    (uint8_t)(first & 0xFF), (uint8_t)(first >> 8),
+    (uint8_t)(count & 0xFF), (uint8_t)(count >> 8),
+  };
+
+  return encodeFrame(STM32_FRAME_TYPE_BACKFILL, payload, sizeof(payload), out);
+}
+
+size_t stm32LinkEncodeSetReportPeriod(uint16_t periodMs, uint8_t* out, uint16_t& seq) {
+  uint8_t payload[2] = { (uint8_t)(periodMs & 0xFF), (uint8_t)(periodMs >> 8) };
+
+  seq = txSeq;
+  return encodeFrame(STM32_FRAME_TYPE_SET_REPORT_PERIOD, payload, sizeof(payload), out);
+}
+
+size_t stm32LinkEncodeSetThreshold(uint8_t alarm, int16_t valueX10, uint8_t* out, uint16_t& seq) {
+  uint16_t v = (uint16_t)valueX10;
+  uint8_t payload[3] = { alarm, (uint8_t)(v & 0xFF), (uint8_t)(v >> 8) };
+
+  seq = txSeq;
+  return encodeFrame(STM32_FRAME_TYPE_SET_THRESHOLD, payload, sizeof(payload), out);
+}
+
+size_t stm32LinkEncodeSetAlarmRule(uint8_t alarm, int16_t thresholdX10, int16_t hysteresisX10,
+                                   uint16_t debounceMs, uint8_t* out, uint16_t& seq) {
+  uint16_t t = (uint16_t)thresholdX10;
+  uint16_t h = (uint16_t)hysteresisX10;
+  uint8_t payload[7] = {
+    alarm,
+    (uint8_t)(t & 0xFF), (uint8_t)(t >> 8),
+    (uint8_t)(h & 0xFF), (uint8_t)(h >> 8),
+    (uint8_t)(debounceMs & 0xFF), (uint8_t)(debounceMs >> 8),
+  };
+
+  seq = txSeq;
+  return encodeFrame(STM32_FRAME_TYPE_SET_ALARM_RULE, payload, sizeof(payload), out);
+}
+
+uint8_t stm32LinkAlarmType(const String& name) {
+  // 顺序与STM32端BEEP_ALARM_xxx编号一致（从1开始）
+  static const char* const names[] = {
+    "temp_high", "temp_low", "humi_high", "humi_low",
+    "co_normal", "co_danger", "dust_low", "dust_high",
+  };
+
+  for (uint8_t i = 0; i < sizeof(names) / sizeof(names[0]); i++) {
+    if (name == names[i]) {
+      return i + 1;
+    }
+  }
+  return 0;
+}
+
+// 报警位与报警字符串，按STM32端报警优先级排列
+static const struct {
+  uint16_t bit;
+  const char* name;
+} alarmNames[] = {
+  {1 << 5, "CO Danger"},
+  {1 << 4, "CO Normal"},
+  {1 << 7, "Dust High"},
+  {1 << 6, "Dust Low"},
+  {1 << 0, "Temp High"},
+  {1 << 1, "Temp Low"},
+  {1 << 2, "Humi High"},
+  {1 << 3, "Humi Low"},
+};
+
+String stm32LinkAlarmString(uint16_t mask) {
+  // 同时有多个报警时取最高优先级的一个
+  for (size_t i = 0; i < sizeof(alarmNames) / sizeof(alarmNames[0]); i++) {
+    if (mask & alarmNames[i].bit) {
+      return alarmNames[i].name;
+    }
+  }
+  return mask ? "Unknown" : "None";
+}
+
+uint16_t stm32LinkAlarmMask(const String& status) {
+  for (size_t i = 0; i < sizeof(alarmNames) / sizeof(alarmNames[0]); i++) {
+    if (status == alarmNames[i].name) {
+      return alarmNames[i].bit;
+    }
+  }
+  return 0;
+}
+
+void stm32LinkCountAsciiLine() {
+  stats.asciiLines++;
+}
+
+void stm32LinkCountOverflow() {
+  stats.overflows++;
+}
+
+const Stm32LinkStats& stm32LinkGetStats() {
+  return stats;
+}
@@ -0,0 +1,101 @@
+#ifndef STM32_LINK_H
+#define STM32_LINK_H
+
+#include <Arduino.h>
+#include "sensor_sample.h"
+
+// ===========================
+// STM32二进制帧解码
+// ===========================
+// 帧格式与STM32端sensor_frame.h一致：
+//   COBS( [版本 1B][类型 1B][序号 2B 小端][负载 NB][CRC16 2B 小端] ) + 0x00
+// CRC16为CRC-16/CCITT-FALSE。旧的ASCII文本行仍然支持，由接收循环自动区分。
+// 样本帧负载的第8~11字节是STM32的RTC采集时间，旧固件只发8字节时时间戳为0。
+// 记录帧负载是样本帧的12字节加2字节启动号，序号是STM32历史记录的序号（见backfill.h）；
+// 启动号每次STM32复位加1，0表示未知（旧固件没有这两个字节时也为0）。
+// 校时帧由ESP32发给STM32，负载为4字节Unix时间(秒, UTC)。
+// 补传请求帧由ESP32发给STM32，负载为[起始记录序号 2B][条数 2B]。
+// 设置上报周期帧负载为[样本帧发送周期 2B ms]（不改变STM32的测量周期），设置阈值帧负载为[报警类型 1B][阈值 2B 有符号, 0.1个单位]，
+// 设置报警规则帧负载为[报警类型 1B][阈值 2B][回差 2B][消抖时间 2B ms]，阈值和回差为0.1个单位。
+// 样本帧第6字节是报警位图，包含同时存在的全部报警；第7字节是测量标志（见sensor_sample.h）。
+// STM32对ESP32发出的每一帧回一个应答帧，序号与命令帧相同，负载为[命令类型 1B][结果 1B]。
+#define STM32_FRAME_VERSION       1
+#define STM32_FRAME_TYPE_SAMPLE   0x01
+#define STM32_FRAME_TYPE_RECORD   0x02
+#define STM32_FRAME_TYPE_ACK      0x03
+#define STM32_FRAME_TYPE_TIME_SYNC 0x81
+#define STM32_FRAME_TYPE_BACKFILL 0x82
+#define STM32_FRAME_TYPE_SET_REPORT_PERIOD 0x83
+#define STM32_FRAME_TYPE_SET_THRESHOLD 0x84
+#define STM32_FRAME_TYPE_SET_ALARM_RULE 0x85
+#define STM32_FRAME_HEADER_LEN    4
+#define STM32_FRAME_CRC_LEN       2
+#define STM32_FRAME_MAX_PAYLOAD   32
+#define STM32_FRAME_MAX_RAW       (STM32_FRAME_HEADER_LEN + STM32_FRAME_MAX_PAYLOAD + STM32_FRAME_CRC_LEN)
+#define STM32_FRAME_MAX_ENCODED   (STM32_FRAME_MAX_RAW + STM32_FRAME_MAX_RAW / 254 + 2)
+#define STM32_LINK_RX_BUFFER      96     // 接收缓冲区（ASCII行与编码后的帧共用）
+
+// 校时：NTP时间有效时，每隔STM32_TIME_SYNC_INTERVAL_MS推送一次；
+// 收到未校时(时间戳为0)的样本时，最快每STM32_TIME_SYNC_RETRY_MS补发一次
+#define STM32_TIME_SYNC_INTERVAL_MS  600000UL
+#define STM32_TIME_SYNC_RETRY_MS     5000UL
+#define STM32_TIME_VALID_MIN         1600000000UL  // 早于此值说明ESP32自己还没有同步NTP
+
+// 应答帧中的结果，与STM32端sensor_cmd.h一致
+#define STM32_CMD_OK              0
+#define STM32_CMD_ERR_LEN         1   // 负载长度不对
+#define STM32_CMD_ERR_VALUE       2   // 参数超出范围
+#define STM32_CMD_ERR_UNKNOWN     3   // STM32不认识的命令
+#define STM32_CMD_TIMEOUT_MS      2000UL   // 等待应答的时间，旧固件不回应答
+#define STM32_REPORT_PERIOD_MIN_MS 200     // STM32发送样本帧的周期范围
+#define STM32_REPORT_PERIOD_MAX_MS 60000
+
+// 链路统计
+struct Stm32LinkStats {
+  uint32_t frames;        // 校验通过的二进制帧
+  uint32_t records;       // 其中的记录帧（实时 + 补传）
+  uint32_t acks;          // 其中的应答帧
+  uint32_t asciiLines;    // ASCII文本行
+  uint32_t crcErrors;     // CRC错误
+  uint32_t formatErrors;  // COBS解码失败、长度/版本/类型不对
+  uint32_t seqGaps;       // 样本帧序号不连续的次数
+  uint32_t lostFrames;    // 按序号推算丢失的帧数
+  uint32_t overflows;     // 接收缓冲区溢出
+  uint32_t timeSyncs;     // 发给STM32的校时帧
+};
+
+// 解码后的STM32帧
+struct Stm32Frame {
+  uint8_t type;           // STM32_FRAME_TYPE_xxx
+  uint16_t seq;           // 帧序号（记录帧为记录序号，应答帧为命令帧的序号）
+  uint16_t bootId;        // 记录帧：STM32启动号，0表示未知
+  SensorSample sample;    // 样本帧和记录帧的数据
+  uint8_t ackCommand;     // 应答帧：被应答的命令类型
+  uint8_t ackStatus;      // 应答帧：STM32_CMD_xxx
+};
+
+// 解码一帧（不含结束符0x00），成功时填充frame并返回true
+// 只接受样本帧、记录帧和应答帧
+bool stm32LinkDecodeFrame(const uint8_t* data, size_t len, Stm32Frame& frame);
+// 把报警位图转换为与ASCII格式一致的报警字符串（只取优先级最高的一个）
+String stm32LinkAlarmString(uint16_t mask);
+// ASCII格式的报警字符串转换为报警位，"None"或不认识的返回0
+uint16_t stm32LinkAlarmMask(const String& status);
+// 编码一个校时帧（含结束符0x00），out至少STM32_FRAME_MAX_ENCODED字节，返回长度
+size_t stm32LinkEncodeTimeSync(uint32_t unixTime, uint8_t* out);
+// 编码一个补传请求帧，请求记录序号[first, first + count)
+size_t stm32LinkEncodeBackfill(uint16_t first, uint16_t count, uint8_t* out);
+// 编码一个设置上报周期（样本帧发送周期）的帧，seq返回帧序号，用于匹配应答
+size_t stm32LinkEncodeSetReportPeriod(uint16_t periodMs, uint8_t* out, uint16_t& seq);
+// 编码一个设置报警阈值的帧，alarm为STM32端BEEP_ALARM_xxx编号
+size_t stm32LinkEncodeSetThreshold(uint8_t alarm, int16_t valueX10, uint8_t* out, uint16_t& seq);
+// 编码一个设置报警规则的帧：阈值、回差（0.1个单位）和消抖时间
+size_t stm32LinkEncodeSetAlarmRule(uint8_t alarm, int16_t thresholdX10, int16_t hysteresisX10,
+                                   uint16_t debounceMs, uint8_t* out, uint16_t& seq);
+// 报警名（"co_danger"等）转换为STM32端报警类型编号，不认识返回0
+uint8_t stm32LinkAlarmType(const String& name);
+void stm32LinkCountAsciiLine();
+void stm32LinkCountOverflow();
+const Stm32LinkStats& stm32LinkGetStats();
+
+#endif // STM32_LINK_H
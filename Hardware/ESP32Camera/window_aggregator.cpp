@@ -0,0 +1,158 @@
+#include "window_aggregator.h"
+#include <Preferences.h>
+
+extern Preferences preferences;
+
+static AggregateConfig config = {
+  AGGREGATE_DEFAULT_ENABLED,
+  AGGREGATE_DEFAULT_WINDOW_S,
+  AGGREGATE_DEFAULT_RAW_ON_ALARM
+};
+
+static WindowSummary current;
+static unsigned long windowStartedAt = 0;
+
+static void fieldReset(FieldStats& f) {
+  f.count = 0;
+  f.min = 0;
+  f.max = 0;
+  f.sum = 0;
+  f.last = 0;
+}
+
+// 只加入有测量结果的值
+static void fieldAdd(FieldStats& f, float value, bool valid) {
+  if (!valid) {
+    return;
+  }
+  if (f.count == 0 || value < f.min) f.min = value;
+  if (f.count == 0 || value > f.max) f.max = value;
+  f.sum += value;
+  f.last = value;
+  f.count++;
+}
+
+// 均值写到顶层，统计写到stats下；窗口内没有测量结果的字段都不写
+static void fieldToJson(const FieldStats& f, const char* name, JsonObject obj, JsonObject stats) {
+  if (f.count == 0) {
+    return;
+  }
+  obj[name] = f.sum / f.count;
+  JsonObject s = stats.createNestedObject(name);
+  s["min"] = f.min;
+  s["max"] = f.max;
+  s["mean"] = f.sum / f.count;
+  s["last"] = f.last;
+}
+
+static void windowReset() {
+  current.durationMs = 0;
+  current.count = 0;
+  current.alarmCount = 0;
+  fieldReset(current.temperature);
+  fieldReset(current.humidity);
+  fieldReset(current.co_ppm);
+  fieldReset(current.dust_density);
+  current.lastAlarm = "None";
+  current.lastAlarmMask = 0;
+  current.alarmMaskAny = 0;
+  current.firstTimestamp = 0;
+  current.lastTimestamp = 0;
+}
+
+void aggregatorLoad() {
+  preferences.begin("aggregate", true);
+  config.enabled = preferences.getBool("enabled", AGGREGATE_DEFAULT_ENABLED);
+  config.windowS = preferences.getUInt("window", AGGREGATE_DEFAULT_WINDOW_S);
+  config.rawOnAlarm = preferences.getBool("raw_alarm", AGGREGATE_DEFAULT_RAW_ON_ALARM);
+  preferences.end();
+  windowReset();
+}
+
+const AggregateConfig& aggregatorGetConfig() {
+  return config;
+}
+
+void aggregatorAdd(const SensorSample& sample, unsigned long now) {
+  bool first = current.count == 0;
+
+  if (first) {
+    windowStartedAt = now;
+  }
+
+  fieldAdd(current.temperature, sample.temperature, sample.valid & SAMPLE_VALID_TEMP);
+  fieldAdd(current.humidity, sample.humidity, sample.valid & SAMPLE_VALID_HUMI);
+  fieldAdd(current.co_ppm, sample.co_ppm, sample.valid & SAMPLE_VALID_CO);
+  fieldAdd(current.dust_density, sample.dust_density, sample.valid & SAMPLE_VALID_DUST);
+  current.lastAlarm = sample.alarm_status;
+  current.lastAlarmMask = sample.alarm_mask;
+  current.alarmMaskAny |= sample.alarm_mask;
+  if (sample.timestamp != 0) {
+    if (current.firstTimestamp == 0) current.firstTimestamp = sample.timestamp;
+    current.lastTimestamp = sample.timestamp;
+  }
+  if (sample.alarm_status != "None") {
+    current.alarmCount++;
+  }
+  current.count++;
+}
+
+bool aggregatorPoll(unsigned long now, WindowSummary& summary) {
+  if (current.count == 0 || now - windowStartedAt < config.windowS * 1000UL) {
+    return false;
+  }
+
+  current.durationMs = now - windowStartedAt;
+  summary = current;
+  windowReset();
+  return true;
+}
+
+void aggregatorSummaryToJson(const WindowSummary& summary, JsonObject obj) {
+  uint16_t n = summary.count;
+
+  JsonObject stats = obj.createNestedObject("stats");
+  fieldToJson(summary.temperature, "temperature", obj, stats);
+  fieldToJson(summary.humidity, "humidity", obj, stats);
+  fieldToJson(summary.co_ppm, "co_ppm", obj, stats);
+  fieldToJson(summary.dust_density, "dust_density", obj, stats);
+  obj["alarm_status"] = summary.lastAlarm;
+  obj["alarm_mask"] = summary.lastAlarmMask;
+  obj["alarm_mask_any"] = summary.alarmMaskAny;
+  obj["window_s"] = (summary.durationMs + 500) / 1000;
+  obj["count"] = n;
+  obj["alarm_count"] = summary.alarmCount;
+  if (summary.lastTimestamp != 0) {
+    // 样本在STM32端的采集时间范围，不受串口缓冲和批量发送影响
+    obj["window_start"] = summary.firstTimestamp;
+    obj["window_end"] = summary.lastTimestamp;
+  }
+}
+
+bool aggregatorApply(JsonVariantConst params, String& error) {
+  AggregateConfig next = config;
+
+  if (params.containsKey("enabled")) next.enabled = params["enabled"].as<bool>();
+  if (params.containsKey("window_s")) next.windowS = params["window_s"].as<uint32_t>();
+  if (params.containsKey("raw_on_alarm")) next.rawOnAlarm = params["raw_on_alarm"].as<bool>();
+
+  if (next.windowS < 5 || next.windowS > 3600) {
+    error = "窗口长度需在5~3600秒之间";
+    return false;
+  }
+
+  config = next;
+
+  preferences.begin("aggregate", false);
+  preferences.putBool("enabled", config.enabled);
+  preferences.putUInt("window", config.windowS);
+  preferences.putBool("raw_alarm", config.rawOnAlarm);
+  preferences.end();
+  return true;
+}
+
+void aggregatorConfigToJson(JsonObject obj) {
+  obj["enabled"] = config.enabled;
+  obj["window_s"] = config.windowS;
+  obj["raw_on_alarm"] = config.rawOnAlarm;
+}
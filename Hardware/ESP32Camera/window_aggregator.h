@@ -0,0 +1,59 @@
+#ifndef WINDOW_AGGREGATOR_H
+#define WINDOW_AGGREGATOR_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include "sensor_sample.h"
+
+// ===========================
+// 边缘窗口聚合
+// ===========================
+// STM32以较高频率上报，ESP32把样本折叠进固定长度的翻滚窗口，窗口结束时
+// 只发布一条包含每个字段min/max/mean/last/count的汇总。报警期间可选择额外
+// 发布原始样本，保证短时的CO尖峰不会只体现在汇总里。
+#define AGGREGATE_DEFAULT_ENABLED       true
+#define AGGREGATE_DEFAULT_WINDOW_S      60     // 窗口长度(秒)
+#define AGGREGATE_DEFAULT_RAW_ON_ALARM  true   // 报警期间是否同时发布原始样本
+
+struct AggregateConfig {
+  bool enabled;
+  uint32_t windowS;
+  bool rawOnAlarm;
+};
+
+// 单个字段的窗口统计
+struct FieldStats {
+  uint16_t count;         // 有测量结果的样本数，STM32上电后传感器出结果之前的样本不计入
+  float min;
+  float max;
+  float sum;
+  float last;
+};
+
+struct WindowSummary {
+  uint32_t durationMs;    // 窗口实际覆盖时长
+  uint16_t count;         // 样本数
+  uint16_t alarmCount;    // 处于报警状态的样本数
+  FieldStats temperature;
+  FieldStats humidity;
+  FieldStats co_ppm;
+  FieldStats dust_density;
+  String lastAlarm;       // 窗口内最后一个样本的报警状态
+  uint16_t lastAlarmMask; // 窗口内最后一个样本的报警位图
+  uint16_t alarmMaskAny;  // 窗口内出现过的全部报警
+  uint32_t firstTimestamp; // 窗口内第一个/最后一个样本的STM32采集时间(Unix秒)，0表示未知
+  uint32_t lastTimestamp;
+};
+
+void aggregatorLoad();
+const AggregateConfig& aggregatorGetConfig();
+// 把样本加入当前窗口
+void aggregatorAdd(const SensorSample& sample, unsigned long now);
+// 窗口到期时输出汇总并开始新窗口，返回true表示summary有效
+bool aggregatorPoll(unsigned long now, WindowSummary& summary);
+// 汇总写入JSON：顶层字段为均值（兼容现有数据表），stats中为完整统计
+void aggregatorSummaryToJson(const WindowSummary& summary, JsonObject obj);
+bool aggregatorApply(JsonVariantConst params, String& error);
+void aggregatorConfigToJson(JsonObject obj);
+
+#endif // WINDOW_AGGREGATOR_H
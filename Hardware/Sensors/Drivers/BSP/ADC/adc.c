@@ -0,0 +1,300 @@
+/**
+ ****************************************************************************************************
+ * @file        adc.c
+ * @author      正点原子团队(ALIENTEK)
+ * @version     V1.0
+ * @date        2023-06-05
+ * @brief       ADC1定时器触发扫描 + DMA循环采样(粉尘PA0, MQ-7 PA1)
+ * @license     Copyright (c) 2020-2032, 广州市星翼电子科技有限公司
+ ****************************************************************************************************
+ * @attention
+ *
+ * 实验平台:正点原子 STM32F103开发板
+ * 在线视频:www.yuanzige.com
+ * 技术论坛:www.openedv.com
+ * 公司网址:www.alientek.com
+ * 购买地址:openedv.taobao.com
+ *
+ * 修改说明
+ * V1.0 20230605
+ * 第一次发布
+ *
+ ****************************************************************************************************
+ */
+
+#include "./BSP/ADC/adc.h"
+#include "./BSP/GP2Y1014AU/gp2y1014au.h"
+#include "./SYSTEM/prof/prof.h"
+
+
+ADC_HandleTypeDef g_adc_handle;                 /* ADC句柄 */
+DMA_HandleTypeDef g_dma_adc_handle;             /* 与ADC关联的DMA句柄 */
+TIM_HandleTypeDef g_adc_tim_handle;             /* 触发定时器句柄 */
+
+uint16_t g_adc_dma_buf[ADC_DMA_FRAMES * ADC_CH_NUM];
+
+/* 过采样累加器, 只在DMA中断中修改 */
+static uint32_t g_adc_ovs_acc[ADC_CH_NUM];
+static uint16_t g_adc_ovs_num = 0;                          /* 累加器中的扫描次数 */
+static volatile uint16_t g_adc_ovs_result[ADC_CH_NUM];      /* 最近一次过采样结果 */
+static volatile uint32_t g_adc_ovs_count = 0;               /* 已产生的结果个数 */
+
+/**
+ * @brief       初始化ADC触发定时器
+ * @note        TIM3计数频率1MHz, 周期ADC_TRIG_PERIOD_US
+ *              CH1工作在PWM2模式, OC1REF在ADC_TRIG_OFFSET_US处变为有效, 作为TRGO触发ADC
+ *              CH2工作在PWM1模式, 低电平有效, 输出GP2Y1014AU的LED脉冲
+ * @param       无
+ * @retval      无
+ */
+static void adc_tim_init(void)
+{
+    TIM_OC_InitTypeDef tim_oc_init = {0};
+    TIM_MasterConfigTypeDef master_config = {0};
+
+    ADC_TIMX_CLK_ENABLE();
+
+    g_adc_tim_handle.Instance = ADC_TIMX;
+    g_adc_tim_handle.Init.Prescaler = 72 - 1;                       /* 72MHz / 72 = 1MHz */
+    g_adc_tim_handle.Init.CounterMode = TIM_COUNTERMODE_UP;
+    g_adc_tim_handle.Init.Period = ADC_TRIG_PERIOD_US - 1;
+    g_adc_tim_handle.Init.ClockDivision = TIM_CLOCKDIVISION_DIV1;
+    g_adc_tim_handle.Init.AutoReloadPreload = TIM_AUTORELOAD_PRELOAD_ENABLE;
+    HAL_TIM_PWM_Init(&g_adc_tim_handle);
+
+    tim_oc_init.OCMode = TIM_OCMODE_PWM2;                           /* CNT >= CCR1时OC1REF有效 */
+    tim_oc_init.Pulse = ADC_TRIG_OFFSET_US;
+    tim_oc_init.OCPolarity = TIM_OCPOLARITY_HIGH;
+    HAL_TIM_PWM_ConfigChannel(&g_adc_tim_handle, &tim_oc_init, TIM_CHANNEL_1);
+
+    tim_oc_init.OCMode = TIM_OCMODE_PWM1;                           /* CNT < CCR2时有效 */
+    tim_oc_init.Pulse = ADC_TRIG_PULSE_US;
+    tim_oc_init.OCPolarity = TIM_OCPOLARITY_LOW;                    /* 有效电平为低, 点亮LED */
+    HAL_TIM_PWM_ConfigChannel(&g_adc_tim_handle, &tim_oc_init, GP2Y1014AU_LED_TIM_CHANNEL);
+
+    master_config.MasterOutputTrigger = TIM_TRGO_OC1REF;
+    master_config.MasterSlaveMode = TIM_MASTERSLAVEMODE_DISABLE;
+    HAL_TIMEx_MasterConfigSynchronization(&g_adc_tim_handle, &master_config);
+}
+
+/**
+ * @brief       初始化ADC1扫描, DMA循环传输及触发定时器
+ * @note        ADCCLK = PCLK2 / 6 = 12MHz, 每通道239.5周期采样, 两通道扫描约40us
+ * @param       无
+ * @retval      无
+ */
+void adc_init(void)
+{
+    GPIO_InitTypeDef gpio_init_struct;
+    ADC_ChannelConfTypeDef adc_ch_conf;
+    RCC_PeriphCLKInitTypeDef adc_clk_init = {0};
+
+    ADC_ADCX_CHY_CLK_ENABLE();
+    ADC_ADCX_CHY_GPIO_CLK_ENABLE();
+    ADC_ADCX_DMACX_CLK_ENABLE();
+
+    /* ADC时钟不能超过14MHz */
+    adc_clk_init.PeriphClockSelection = RCC_PERIPHCLK_ADC;
+    adc_clk_init.AdcClockSelection = RCC_ADCPCLK2_DIV6;
+    HAL_RCCEx_PeriphCLKConfig(&adc_clk_init);
+
+    gpio_init_struct.Pin = ADC_ADCX_CHY_GPIO_PIN;
+    gpio_init_struct.Mode = GPIO_MODE_ANALOG;
+    gpio_init_struct.Pull = GPIO_NOPULL;
+    HAL_GPIO_Init(ADC_ADCX_CHY_GPIO_PORT, &gpio_init_struct);
+
+    /* DMA: ADC1->DR到g_adc_dma_buf, 半字, 循环模式 */
+    g_dma_adc_handle.Instance = ADC_ADCX_DMACX;
+    g_dma_adc_handle.Init.Direction = DMA_PERIPH_TO_MEMORY;
+    g_dma_adc_handle.Init.PeriphInc = DMA_PINC_DISABLE;
+    g_dma_adc_handle.Init.MemInc = DMA_MINC_ENABLE;
+    g_dma_adc_handle.Init.PeriphDataAlignment = DMA_PDATAALIGN_HALFWORD;
+    g_dma_adc_handle.Init.MemDataAlignment = DMA_MDATAALIGN_HALFWORD;
+    g_dma_adc_handle.Init.Mode = DMA_CIRCULAR;
+    g_dma_adc_handle.Init.Priority = DMA_PRIORITY_HIGH;
+    HAL_DMA_Init(&g_dma_adc_handle);
+    __HAL_LINKDMA(&g_adc_handle, DMA_Handle, g_dma_adc_handle);
+
+    g_adc_handle.Instance = ADC_ADCX;
+    g_adc_handle.Init.DataAlign = ADC_DATAALIGN_RIGHT;
+    g_adc_handle.Init.ScanConvMode = ADC_SCAN_ENABLE;
+    g_adc_handle.Init.ContinuousConvMode = DISABLE;
+    g_adc_handle.Init.NbrOfConversion = ADC_CH_NUM;
+    g_adc_handle.Init.DiscontinuousConvMode = DISABLE;
+    g_adc_handle.Init.NbrOfDiscConversion = 0;
+    g_adc_handle.Init.ExternalTrigConv = ADC_EXTERNALTRIGCONV_T3_TRGO;
+    HAL_ADC_Init(&g_adc_handle);
+
+    adc_ch_conf.Channel = ADC_CHANNEL_0;
+    adc_ch_conf.Rank = ADC_REGULAR_RANK_1;
+    adc_ch_conf.SamplingTime = ADC_SAMPLETIME_239CYCLES_5;
+    HAL_ADC_ConfigChannel(&g_adc_handle, &adc_ch_conf);
+
+    adc_ch_conf.Channel = ADC_CHANNEL_1;
+    adc_ch_conf.Rank = ADC_REGULAR_RANK_2;
+    HAL_ADC_ConfigChannel(&g_adc_handle, &adc_ch_conf);
+
+    HAL_ADCEx_Calibration_Start(&g_adc_handle);
+
+    /* DMA半满/全满中断做过采样累加, 每80ms一次 */
+    HAL_NVIC_SetPriority(ADC_ADCX_DMACX_IRQn, 3, 2);
+    HAL_NVIC_EnableIRQ(ADC_ADCX_DMACX_IRQn);
+    HAL_ADC_Start_DMA(&g_adc_handle, (uint32_t *)g_adc_dma_buf, ADC_DMA_FRAMES * ADC_CH_NUM);
+
+    adc_tim_init();
+    HAL_TIM_PWM_Start(&g_adc_tim_handle, GP2Y1014AU_LED_TIM_CHANNEL);
+
+    /* 定时器输出已经有效, 再把LED引脚切换为TIM3_CH2复用输出, 避免切换瞬间误点亮 */
+    GP2Y1014AU_LED_TIM_REMAP();
+    gpio_init_struct.Pin = GP2Y1014AU_LED_GPIO_PIN;
+    gpio_init_struct.Mode = GPIO_MODE_AF_PP;
+    gpio_init_struct.Pull = GPIO_PULLUP;
+    gpio_init_struct.Speed = GPIO_SPEED_FREQ_HIGH;
+    HAL_GPIO_Init(GP2Y1014AU_LED_GPIO_PORT, &gpio_init_struct);
+}
+
+/**
+ * @brief       ADC DMA中断服务函数
+ * @param       无
+ * @retval      无
+ */
+void ADC_ADCX_DMACX_IRQHandler(void)
+{
+    HAL_DMA_IRQHandler(&g_dma_adc_handle);
+}
+
+/**
+ * @brief       把半个DMA缓冲区累加到过采样累加器, 累计ADC_OVS_RATIO次后输出
+ * @note        累加后右移ADC_OVS_BITS位(而不是除以ADC_OVS_RATIO), 保留多出的分辨率
+ * @param       buf: 已经写满的半个缓冲区
+ * @retval      无
+ */
+static void adc_ovs_accumulate(const uint16_t *buf)
+{
+    uint8_t i, ch;
+
+    PROF_START(PROF_ZONE_ADC);
+
+    for (i = 0; i < ADC_DMA_FRAMES / 2; i++)
+    {
+        for (ch = 0; ch < ADC_CH_NUM; ch++)
+        {
+            g_adc_ovs_acc[ch] += *buf++;
+        }
+    }
+
+    g_adc_ovs_num += ADC_DMA_FRAMES / 2;
+
+    if (g_adc_ovs_num >= ADC_OVS_RATIO)
+    {
+        for (ch = 0; ch < ADC_CH_NUM; ch++)
+        {
+            g_adc_ovs_result[ch] = g_adc_ovs_acc[ch] >> ADC_OVS_BITS;
+            g_adc_ovs_acc[ch] = 0;
+        }
+
+        g_adc_ovs_num = 0;
+        g_adc_ovs_count++;
+    }
+
+    PROF_STOP(PROF_ZONE_ADC);
+}
+
+/**
+ * @brief       DMA半满回调: 前半个缓冲区写满
+ * @param       hadc: ADC句柄
+ * @retval      无
+ */
+void HAL_ADC_ConvHalfCpltCallback(ADC_HandleTypeDef *hadc)
+{
+    if (hadc->Instance == ADC_ADCX)
+    {
+        adc_ovs_accumulate(&g_adc_dma_buf[0]);
+    }
+}
+
+/**
+ * @brief       DMA全满回调: 后半个缓冲区写满
+ * @param       hadc: ADC句柄
+ * @retval      无
+ */
+void HAL_ADC_ConvCpltCallback(ADC_HandleTypeDef *hadc)
+{
+    if (hadc->Instance == ADC_ADCX)
+    {
+        adc_ovs_accumulate(&g_adc_dma_buf[ADC_DMA_FRAMES / 2 * ADC_CH_NUM]);
+    }
+}
+
+/**
+ * @brief       获取最近一次完整扫描在缓冲区中的位置
+ * @note        由DMA剩余传输数推算, 不依赖中断
+ * @param       无
+ * @retval      扫描序号(0 ~ ADC_DMA_FRAMES - 1)
+ */
+static uint16_t adc_latest_frame(void)
+{
+    uint16_t written = ADC_DMA_FRAMES * ADC_CH_NUM - __HAL_DMA_GET_COUNTER(&g_dma_adc_handle);
+    uint16_t frame = written / ADC_CH_NUM;
+
+    return (frame + ADC_DMA_FRAMES - 1) % ADC_DMA_FRAMES;
+}
+
+/**
+ * @brief       获取某通道最近一次转换结果
+ * @param       ch: ADC_CH_DUST / ADC_CH_MQ7
+ * @retval      12位ADC值
+ */
+uint16_t adc_get_latest(uint8_t ch)
+{
+    return g_adc_dma_buf[adc_latest_frame() * ADC_CH_NUM + ch];
+}
+
+/**
+ * @brief       获取某通道最近frames次转换的平均值
+ * @param       ch: ADC_CH_DUST / ADC_CH_MQ7
+ * @param       frames: 平均次数, 1 ~ ADC_DMA_FRAMES
+ * @retval      12位ADC平均值
+ */
+uint16_t adc_get_average(uint8_t ch, uint8_t frames)
+{
+    uint32_t sum = 0;
+    uint16_t frame;
+    uint8_t i;
+
+    frame = adc_latest_frame();
+
+    if (frames == 0) frames = 1;
+    if (frames > ADC_DMA_FRAMES) frames = ADC_DMA_FRAMES;
+
+    for (i = 0; i < frames; i++)
+    {
+        sum += g_adc_dma_buf[frame * ADC_CH_NUM + ch];
+        frame = (frame + ADC_DMA_FRAMES - 1) % ADC_DMA_FRAMES;
+    }
+
+    sum /= frames;
+    return sum;
+}
+
+/**
+ * @brief       获取某通道最近一次过采样结果
+ * @note        每4^ADC_OVS_BITS次转换(默认640ms)更新一次, 启动后第一个结果出来之前返回0
+ * @param       ch: ADC_CH_DUST / ADC_CH_MQ7
+ * @retval      12 + ADC_OVS_BITS位ADC值, 0 ~ ADC_OVS_MAX
+ */
+uint16_t adc_get_oversampled(uint8_t ch)
+{
+    return g_adc_ovs_result[ch];
+}
+
+/**
+ * @brief       获取已经产生的过采样结果个数
+ * @note        调用者可以据此判断是否已经有结果, 或者结果是否已经更新
+ * @param       无
+ * @retval      结果个数
+ */
+uint32_t adc_get_oversampled_count(void)
+{
+    return g_adc_ovs_count;
+}
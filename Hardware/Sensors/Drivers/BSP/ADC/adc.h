@@ -0,0 +1,93 @@
+/**
+ ****************************************************************************************************
+ * @file        adc.h
+ * @author      正点原子团队(ALIENTEK)
+ * @version     V1.0
+ * @date        2023-06-05
+ * @brief       ADC1定时器触发扫描 + DMA循环采样(粉尘PA0, MQ-7 PA1)
+ * @license     Copyright (c) 2020-2032, 广州市星翼电子科技有限公司
+ ****************************************************************************************************
+ * @attention
+ *
+ * 实验平台:正点原子 STM32F103开发板
+ * 在线视频:www.yuanzige.com
+ * 技术论坛:www.openedv.com
+ * 公司网址:www.alientek.com
+ * 购买地址:openedv.taobao.com
+ *
+ * 采样时序(每个周期10ms):
+ *   0us    TIM3_CH2(PB5)输出低电平, GP2Y1014AU LED点亮
+ *   280us  TIM3 OC1REF上升沿经TRGO触发ADC1扫描: 通道0(粉尘) -> 通道1(MQ-7)
+ *   320us  TIM3_CH2恢复高电平, GP2Y1014AU LED熄灭
+ * LED脉冲, 转换触发和结果搬运都由硬件完成. 转换结果由DMA1通道1循环写入g_adc_dma_buf.
+ *
+ * 过采样: DMA半满/全满中断(每80ms)把半个缓冲区累加到各通道的累加器, 累计4^ADC_OVS_BITS次
+ * 转换后右移ADC_OVS_BITS位, 得到12 + ADC_OVS_BITS位的结果. 分辨率每增加1位需要4倍的转换次数,
+ * 并且要求输入噪声不小于1LSB(两路传感器输出本身的噪声已经足够). 输出速率 = 100Hz / 4^ADC_OVS_BITS:
+ *   ADC_OVS_BITS = 2: 14位, 16次,  160ms
+ *   ADC_OVS_BITS = 3: 15位, 64次,  640ms (默认)
+ *   ADC_OVS_BITS = 4: 16位, 256次, 2.56s
+ * GP2Y1014AU的LED脉冲周期固定为10ms, 不能靠提高触发频率缩短输出间隔.
+ *
+ * 修改说明
+ * V1.0 20230605
+ * 第一次发布
+ *
+ ****************************************************************************************************
+ */
+
+#ifndef __ADC_H
+#define __ADC_H
+
+#include "./SYSTEM/sys/sys.h"
+
+
+/******************************************************************************************/
+/* ADC及引脚 定义 */
+
+#define ADC_ADCX                            ADC1
+#define ADC_ADCX_CHY_CLK_ENABLE()           do{ __HAL_RCC_ADC1_CLK_ENABLE(); }while(0)   /* ADC1 时钟使能 */
+#define ADC_ADCX_CHY_GPIO_PORT              GPIOA
+#define ADC_ADCX_CHY_GPIO_PIN               (GPIO_PIN_0 | GPIO_PIN_1)
+#define ADC_ADCX_CHY_GPIO_CLK_ENABLE()      do{ __HAL_RCC_GPIOA_CLK_ENABLE(); }while(0)  /* PA口时钟使能 */
+
+#define ADC_ADCX_DMACX                      DMA1_Channel1
+#define ADC_ADCX_DMACX_IRQn                 DMA1_Channel1_IRQn
+#define ADC_ADCX_DMACX_IRQHandler           DMA1_Channel1_IRQHandler
+#define ADC_ADCX_DMACX_CLK_ENABLE()         do{ __HAL_RCC_DMA1_CLK_ENABLE(); }while(0)   /* DMA1 时钟使能 */
+
+/* 触发定时器 */
+#define ADC_TIMX                            TIM3
+#define ADC_TIMX_CLK_ENABLE()               do{ __HAL_RCC_TIM3_CLK_ENABLE(); }while(0)   /* TIM3 时钟使能 */
+
+/******************************************************************************************/
+
+#define ADC_TRIG_PERIOD_US          10000       /* 采样周期, 100Hz */
+#define ADC_TRIG_OFFSET_US          280         /* LED点亮后启动转换的时间(GP2Y1014AU数据手册) */
+#define ADC_TRIG_PULSE_US           320         /* GP2Y1014AU LED脉冲宽度 */
+
+/* 扫描序列中各通道的位置 */
+#define ADC_CH_DUST                 0           /* PA0, ADC通道0, GP2Y1014AU */
+#define ADC_CH_MQ7                  1           /* PA1, ADC通道1, MQ-7 */
+#define ADC_CH_NUM                  2
+
+#define ADC_DMA_FRAMES              16          /* 缓冲区保存的扫描次数, 16次 = 160ms */
+
+#define ADC_OVS_BITS                3           /* 过采样增加的分辨率位数, 2 ~ 4 */
+#define ADC_OVS_RATIO               (1 << (2 * ADC_OVS_BITS))           /* 每个输出累加的转换次数 */
+#define ADC_OVS_MAX                 ((4096 << ADC_OVS_BITS) - 1)        /* 过采样结果的满量程 */
+
+#if ADC_OVS_BITS < 2 || ADC_OVS_BITS > 4
+#error "ADC_OVS_BITS must be 2 ~ 4: the ratio must be a multiple of half the DMA buffer and the sum must fit 32 bits"
+#endif
+
+extern uint16_t g_adc_dma_buf[ADC_DMA_FRAMES * ADC_CH_NUM];   /* DMA循环缓冲区 */
+
+/* 函数声明 */
+void adc_init(void);                                        /* 初始化ADC1, DMA及触发定时器 */
+uint16_t adc_get_latest(uint8_t ch);                        /* 最近一次转换结果 */
+uint16_t adc_get_average(uint8_t ch, uint8_t frames);       /* 最近frames次转换的平均值 */
+uint16_t adc_get_oversampled(uint8_t ch);                   /* 最近一次过采样结果(12 + ADC_OVS_BITS位) */
+uint32_t adc_get_oversampled_count(void);                   /* 已经产生的过采样结果个数 */
+
+#endif
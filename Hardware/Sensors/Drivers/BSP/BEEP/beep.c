@@ -23,6 +23,7 @@
  */
 
 #include "./BSP/BEEP/beep.h"
+#include "./BSP/SENSOR_UART/sensor_frame.h"
 #include "./SYSTEM/delay/delay.h"
 
 /* 定时器句柄 */
@@ -31,6 +32,27 @@ static TIM_HandleTypeDef g_tim_handle;
 static TIM_OC_InitTypeDef g_tim_oc_handle;
 /* 当前报警类型 */
 uint8_t g_current_alarm = BEEP_ALARM_NONE;
+/* 同时存在的全部报警 */
+uint16_t g_current_alarm_mask = 0;
+
+#define BEEP_RULE_NUM                   (BEEP_ALARM_NUM - 1)
+
+/* 报警规则表, 顺序即优先级: CO > 粉尘 > 温度 > 湿度 */
+static beep_rule_t g_beep_rules[BEEP_RULE_NUM] =
+{
+    {BEEP_ALARM_CO_DANGER, BEEP_INPUT_CO,   1, 3000, CO_DANGER_THRESHOLD * 10,   CO_HYSTERESIS * 10,   BEEP_DEBOUNCE_CO_MS},
+    {BEEP_ALARM_CO_NORMAL, BEEP_INPUT_CO,   1, 2500, CO_NORMAL_THRESHOLD * 10,   CO_HYSTERESIS * 10,   BEEP_DEBOUNCE_CO_MS},
+    {BEEP_ALARM_DUST_HIGH, BEEP_INPUT_DUST, 1, 2700, DUST_HIGH_THRESHOLD * 10,   DUST_HYSTERESIS * 10, BEEP_DEBOUNCE_DUST_MS},
+    {BEEP_ALARM_DUST_LOW,  BEEP_INPUT_DUST, 1, 2200, DUST_LOW_THRESHOLD * 10,    DUST_HYSTERESIS * 10, BEEP_DEBOUNCE_DUST_MS},
+    {BEEP_ALARM_TEMP_HIGH, BEEP_INPUT_TEMP, 1, 2000, TEMP_HIGH_THRESHOLD * 10,   TEMP_HYSTERESIS * 10, BEEP_DEBOUNCE_DHT11_MS},
+    {BEEP_ALARM_TEMP_LOW,  BEEP_INPUT_TEMP, 0, 1800, TEMP_LOW_THRESHOLD * 10,    TEMP_HYSTERESIS * 10, BEEP_DEBOUNCE_DHT11_MS},
+    {BEEP_ALARM_HUMI_HIGH, BEEP_INPUT_HUMI, 1, 1600, HUMI_HIGH_THRESHOLD * 10,   HUMI_HYSTERESIS * 10, BEEP_DEBOUNCE_DHT11_MS},
+    {BEEP_ALARM_HUMI_LOW,  BEEP_INPUT_HUMI, 0, 1400, HUMI_LOW_THRESHOLD * 10,    HUMI_HYSTERESIS * 10, BEEP_DEBOUNCE_DHT11_MS},
+};
+
+/* 各规则的消抖状态: 条件与当前报警状态不一致时开始计时 */
+static uint8_t g_beep_pending[BEEP_RULE_NUM];       /* 1: 正在计时 */
+static uint32_t g_beep_pending_since[BEEP_RULE_NUM];
 
 /**
  * @brief       初始化蜂鸣器相关IO口, 并使能时钟
@@ -125,111 +147,166 @@ void beep_off(void)
 }
 
 /**
- * @brief       报警处理函数
- * @param       temp: 温度值(°C)
- * @param       humi: 湿度值(%)
- * @param       co_ppm: 一氧化碳浓度(ppm)
- * @param       dust_density: 粉尘浓度(mg/m³)
- * @retval      无
+ * @brief       按报警类型查找规则
+ * @param       type: 报警类型
+ * @retval      规则下标, BEEP_RULE_NUM表示没有
  */
-void beep_alarm_handler(uint8_t temp, uint8_t humi, float co_ppm, float dust_density)
+static uint8_t beep_find_rule(uint8_t type)
 {
-    uint8_t alarm_type = BEEP_ALARM_NONE;
-    
-    /* 检查各传感器数据是否超过阈值，按优先级顺序检查 */
-    
-    /* 1. 检查一氧化碳浓度 - 最高优先级 */
-    if (co_ppm >= CO_DANGER_THRESHOLD)
-    {
-        alarm_type = BEEP_ALARM_CO_DANGER;
-    }
-    else if (co_ppm >= CO_NORMAL_THRESHOLD)
-    {
-        alarm_type = BEEP_ALARM_CO_NORMAL;
-    }
-    /* 2. 检查粉尘浓度 */
-    else if (dust_density >= DUST_HIGH_THRESHOLD)
-    {
-        alarm_type = BEEP_ALARM_DUST_HIGH;
-    }
-    else if (dust_density >= DUST_LOW_THRESHOLD)
-    {
-        alarm_type = BEEP_ALARM_DUST_LOW;
-    }
-    /* 3. 检查温度 */
-    else if (temp >= TEMP_HIGH_THRESHOLD)
+    uint8_t i;
+
+    for (i = 0; i < BEEP_RULE_NUM; i++)
     {
-        alarm_type = BEEP_ALARM_TEMP_HIGH;
+        if (g_beep_rules[i].type == type)
+        {
+            break;
+        }
     }
-    else if (temp <= TEMP_LOW_THRESHOLD)
+
+    return i;
+}
+
+/**
+ * @brief       修改一种报警的阈值
+ * @note        回差和消抖时间不变, 新阈值在下一次beep_alarm_handler时生效; 不保存, 复位后恢复默认值
+ * @param       type: 报警类型, BEEP_ALARM_TEMP_HIGH ~ BEEP_ALARM_DUST_HIGH
+ * @param       value_x10: 阈值(0.1个单位), 单位同beep.h中对应的默认值
+ * @retval      0, 成功; 1, 类型错误
+ */
+uint8_t beep_set_threshold(uint8_t type, int16_t value_x10)
+{
+    uint8_t i = beep_find_rule(type);
+
+    if (i >= BEEP_RULE_NUM)
     {
-        alarm_type = BEEP_ALARM_TEMP_LOW;
+        return 1;
     }
-    /* 4. 检查湿度 */
-    else if (humi >= HUMI_HIGH_THRESHOLD)
+
+    g_beep_rules[i].threshold_x10 = value_x10;
+    g_beep_pending[i] = 0;
+    return 0;
+}
+
+/**
+ * @brief       修改一条报警规则
+ * @note        当前报警状态保留, 按新规则重新消抖; 不保存, 复位后恢复默认值
+ * @param       type: 报警类型
+ * @param       threshold_x10: 阈值(0.1个单位)
+ * @param       hysteresis_x10: 回差(0.1个单位), 不能为负
+ * @param       debounce_ms: 消抖时间
+ * @retval      0, 成功; 1, 参数错误
+ */
+uint8_t beep_set_rule(uint8_t type, int16_t threshold_x10, int16_t hysteresis_x10, uint16_t debounce_ms)
+{
+    uint8_t i = beep_find_rule(type);
+
+    if (i >= BEEP_RULE_NUM || hysteresis_x10 < 0)
     {
-        alarm_type = BEEP_ALARM_HUMI_HIGH;
+        return 1;
     }
-    else if (humi <= HUMI_LOW_THRESHOLD)
+
+    g_beep_rules[i].threshold_x10 = threshold_x10;
+    g_beep_rules[i].hysteresis_x10 = hysteresis_x10;
+    g_beep_rules[i].debounce_ms = debounce_ms;
+    g_beep_pending[i] = 0;
+    return 0;
+}
+
+/**
+ * @brief       读取一条报警规则
+ * @param       type: 报警类型
+ * @retval      规则, 类型错误时返回0
+ */
+const beep_rule_t *beep_get_rule(uint8_t type)
+{
+    uint8_t i = beep_find_rule(type);
+
+    return i < BEEP_RULE_NUM ? &g_beep_rules[i] : 0;
+}
+
+/**
+ * @brief       报警处理函数
+ * @note        逐条规则判断, 每条规则独立报警, 结果放在g_current_alarm_mask中:
+ *              未报警时数值越过阈值, 已报警时数值回到阈值另一侧超过回差, 且持续消抖时间后状态才改变.
+ *              蜂鸣器按报警中优先级最高(规则表中最靠前)的一条发声
+ * @param       temp: 温度值(°C)
+ * @param       humi: 湿度值(%)
+ * @param       co_x10: 一氧化碳浓度(0.1ppm)
+ * @param       dust_x10: 粉尘浓度(0.1ug/m³)
+ * @retval      无
+ */
+void beep_alarm_handler(int8_t temp, uint8_t humi, uint16_t co_x10, uint16_t dust_x10)
+{
+    int32_t input[BEEP_INPUT_NUM];
+    const beep_rule_t *rule;
+    uint32_t now = HAL_GetTick();
+    uint16_t mask = g_current_alarm_mask;
+    uint16_t bit;
+    uint8_t alarm_type = BEEP_ALARM_NONE;
+    uint8_t active, want;
+    uint8_t i;
+
+    input[BEEP_INPUT_TEMP] = temp * 10;
+    input[BEEP_INPUT_HUMI] = humi * 10;
+    input[BEEP_INPUT_CO] = co_x10;
+    input[BEEP_INPUT_DUST] = dust_x10;
+
+    for (i = 0; i < BEEP_RULE_NUM; i++)
     {
-        alarm_type = BEEP_ALARM_HUMI_LOW;
+        rule = &g_beep_rules[i];
+        bit = SENSOR_ALARM_BIT(rule->type);
+        active = (mask & bit) != 0;
+
+        /* 高于阈值报警的规则: 报警中只要还高于(阈值 - 回差)就保持; 低于阈值报警的规则反过来 */
+        if (rule->above)
+        {
+            want = active ? input[rule->input] > rule->threshold_x10 - rule->hysteresis_x10
+                          : input[rule->input] >= rule->threshold_x10;
+        }
+        else
+        {
+            want = active ? input[rule->input] < rule->threshold_x10 + rule->hysteresis_x10
+                          : input[rule->input] <= rule->threshold_x10;
+        }
+
+        if (want == active)
+        {
+            g_beep_pending[i] = 0;
+        }
+        else if (g_beep_pending[i] == 0)
+        {
+            g_beep_pending[i] = 1;
+            g_beep_pending_since[i] = now;
+        }
+
+        if (g_beep_pending[i] && now - g_beep_pending_since[i] >= rule->debounce_ms)
+        {
+            g_beep_pending[i] = 0;
+            mask ^= bit;
+            active = want;
+        }
+
+        if (active && alarm_type == BEEP_ALARM_NONE)
+        {
+            alarm_type = rule->type;
+        }
     }
-    
-    /* 如果报警类型发生变化，更新蜂鸣器状态 */
+
+    g_current_alarm_mask = mask;
+
+    /* 最高优先级的报警变化时，更新蜂鸣器状态 */
     if (alarm_type != g_current_alarm)
     {
         g_current_alarm = alarm_type;
-        
-        /* 根据报警类型设置不同的蜂鸣器频率 */
-        switch (alarm_type)
+
+        if (alarm_type == BEEP_ALARM_NONE)
+        {
+            beep_off();
+        }
+        else
         {
-            case BEEP_ALARM_NONE:
-                beep_off();
-                break;
-                
-            case BEEP_ALARM_TEMP_HIGH:
-                beep_set_freq(2000);  /* 温度过高报警：2000Hz */
-                beep_on();
-                break;
-                
-            case BEEP_ALARM_TEMP_LOW:
-                beep_set_freq(1800);  /* 温度过低报警：1800Hz */
-                beep_on();
-                break;
-                
-            case BEEP_ALARM_HUMI_HIGH:
-                beep_set_freq(1600);  /* 湿度过高报警：1600Hz */
-                beep_on();
-                break;
-                
-            case BEEP_ALARM_HUMI_LOW:
-                beep_set_freq(1400);  /* 湿度过低报警：1400Hz */
-                beep_on();
-                break;
-                
-            case BEEP_ALARM_CO_NORMAL:
-                beep_set_freq(2500);  /* CO一般报警：2500Hz */
-                beep_on();
-                break;
-                
-            case BEEP_ALARM_CO_DANGER:
-                beep_set_freq(3000);  /* CO危险报警：3000Hz */
-                beep_on();
-                break;
-                
-            case BEEP_ALARM_DUST_LOW:
-                beep_set_freq(2200);  /* 粉尘低浓度报警：2200Hz */
-                beep_on();
-                break;
-                
-            case BEEP_ALARM_DUST_HIGH:
-                beep_set_freq(2700);  /* 粉尘高浓度报警：2700Hz */
-                beep_on();
-                break;
-                
-            default:
-                beep_off();
-                break;
+            beep_set_freq(g_beep_rules[beep_find_rule(alarm_type)].freq);
+            beep_on();
         }
     }
-}
\ No newline at end of file
+}
@@ -43,26 +43,62 @@
 #define BEEP_ALARM_CO_DANGER            6   /* CO浓度危险报警 */
 #define BEEP_ALARM_DUST_LOW             7   /* 粉尘浓度低报警 */
 #define BEEP_ALARM_DUST_HIGH            8   /* 粉尘浓度高报警 */
+#define BEEP_ALARM_NUM                  9   /* 类型数(含BEEP_ALARM_NONE), 样本中的报警位图为8位, 不能再增加 */
 
-/* 传感器阈值定义 */
+/* 报警规则默认值, 上电时装入规则表, 运行中可用beep_set_threshold / beep_set_rule修改
+ * 回差: 报警后数值要回到阈值另一侧超过回差才解除, 避免数值在阈值附近时蜂鸣器反复响停
+ * 消抖: 报警或解除的条件要持续这么久才生效; CO阈值不消抖, 一超过就报警
+ */
 #define TEMP_HIGH_THRESHOLD             35  /* 温度高阈值 (°C) */
 #define TEMP_LOW_THRESHOLD              20  /* 温度低阈值 (°C) */
 #define HUMI_HIGH_THRESHOLD             80  /* 湿度高阈值 (%) */
 #define HUMI_LOW_THRESHOLD              10  /* 湿度低阈值 (%) */
 #define CO_NORMAL_THRESHOLD             50  /* CO一般报警阈值 (ppm) */
 #define CO_DANGER_THRESHOLD             200 /* CO危险报警阈值 (ppm) */
-#define DUST_LOW_THRESHOLD              0.2 /* 粉尘低浓度阈值 (mg/m³) */
-#define DUST_HIGH_THRESHOLD             0.5 /* 粉尘高浓度阈值 (mg/m³) */
+#define DUST_LOW_THRESHOLD              200 /* 粉尘低浓度阈值 (ug/m³), 即0.2mg/m³ */
+#define DUST_HIGH_THRESHOLD             500 /* 粉尘高浓度阈值 (ug/m³), 即0.5mg/m³ */
+
+#define TEMP_HYSTERESIS                 1   /* 温度回差 (°C) */
+#define HUMI_HYSTERESIS                 3   /* 湿度回差 (%) */
+#define CO_HYSTERESIS                   5   /* CO回差 (ppm) */
+#define DUST_HYSTERESIS                 20  /* 粉尘回差 (ug/m³) */
+
+#define BEEP_DEBOUNCE_DHT11_MS          3000    /* 温湿度消抖, DHT11每秒更新一次 */
+#define BEEP_DEBOUNCE_DUST_MS           2000    /* 粉尘消抖, 滤掉短时尖峰 */
+#define BEEP_DEBOUNCE_CO_MS             0       /* CO不消抖, MQ-7每个加热周期才出一个结果 */
+
+/* 规则的输入量 */
+#define BEEP_INPUT_TEMP                 0   /* 温度(0.1°C) */
+#define BEEP_INPUT_HUMI                 1   /* 湿度(0.1%) */
+#define BEEP_INPUT_CO                   2   /* CO(0.1ppm) */
+#define BEEP_INPUT_DUST                 3   /* 粉尘(0.1ug/m³) */
+#define BEEP_INPUT_NUM                  4
+
+/* 报警规则, 规则表的顺序即优先级, 多个报警同时存在时蜂鸣器按优先级最高的一个发声 */
+typedef struct
+{
+    uint8_t type;               /* 报警类型BEEP_ALARM_xxx, 报警位图中为bit(type - 1) */
+    uint8_t input;              /* 输入量BEEP_INPUT_xxx */
+    uint8_t above;              /* 1: 高于阈值报警; 0: 低于阈值报警 */
+    uint16_t freq;              /* 蜂鸣器频率(Hz) */
+    int16_t threshold_x10;      /* 阈值(0.1个单位) */
+    int16_t hysteresis_x10;     /* 回差(0.1个单位) */
+    uint16_t debounce_ms;       /* 消抖时间 */
+} beep_rule_t;
 
 /******************************************************************************************/
 /* 外部接口函数*/
 void beep_init(void);                                /* 初始化 */
 void beep_set_freq(uint16_t freq);                  /* 设置蜂鸣器频率 */
-void beep_alarm_handler(uint8_t temp, uint8_t humi, float co_ppm, float dust_density); /* 报警处理函数 */
+void beep_alarm_handler(int8_t temp, uint8_t humi, uint16_t co_x10, uint16_t dust_x10); /* 报警处理函数 */
 void beep_on(void);                                 /* 开启蜂鸣器 */
 void beep_off(void);                                /* 关闭蜂鸣器 */
+uint8_t beep_set_threshold(uint8_t type, int16_t value_x10);  /* 修改一种报警的阈值 */
+uint8_t beep_set_rule(uint8_t type, int16_t threshold_x10, int16_t hysteresis_x10, uint16_t debounce_ms); /* 修改一条报警规则 */
+const beep_rule_t *beep_get_rule(uint8_t type);     /* 读取一条报警规则 */
 
 /* 外部变量声明 */
-extern uint8_t g_current_alarm;                     /* 当前报警类型 */
+extern uint8_t g_current_alarm;                     /* 优先级最高的当前报警类型 */
+extern uint16_t g_current_alarm_mask;               /* 同时存在的全部报警, bit(n-1)对应类型n */
 
 #endif
\ No newline at end of file
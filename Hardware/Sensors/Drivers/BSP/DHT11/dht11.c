@@ -2,8 +2,8 @@
  ****************************************************************************************************
  * @file        dht11.c
  * @author      正点原子团队(ALIENTEK)
- * @version     V1.0
- * @date        2020-04-26
+ * @version     V1.1
+ * @date        2023-06-05
  * @brief       DHT11数字温湿度传感器 驱动代码
  * @license     Copyright (c) 2020-2032, 广州市星翼电子科技有限公司
  ****************************************************************************************************
@@ -18,12 +18,15 @@
  * 修改说明
  * V1.0 20200426
  * 第一次发布
+ * V1.1 20230605
+ * 读取改为异步: TIM7产生18ms起始信号并为EXTI下降沿打时间戳, 主循环查询结果, 不再阻塞
  *
  ****************************************************************************************************
  */
 
 #include "./BSP/DHT11/dht11.h"
 #include "./SYSTEM/delay/delay.h"
+#include "./SYSTEM/prof/prof.h"
 
 
 /**
@@ -75,91 +78,238 @@ uint8_t dht11_check(void)
     return rval;
 }
 
+/* 异步读取过程 */
+#define DHT11_PHASE_IDLE        0           /* 空闲 */
+#define DHT11_PHASE_START       1           /* 输出18ms起始信号 */
+#define DHT11_PHASE_RECEIVE     2           /* 记录下降沿时间戳 */
+#define DHT11_PHASE_DONE        3           /* 收齐下降沿或超时, 等待主循环解码 */
+
+static TIM_HandleTypeDef g_dht11_tim_handle;
+static volatile uint8_t g_dht11_phase = DHT11_PHASE_IDLE;
+static volatile uint8_t g_dht11_edge_cnt = 0;
+static volatile uint16_t g_dht11_edges[DHT11_EDGE_NUM];   /* 各下降沿的TIM7计数值(us) */
+static uint8_t g_dht11_status = DHT11_IDLE;
+static uint8_t g_dht11_temp = 0;
+static uint8_t g_dht11_humi = 0;
+
+dht11_stats_t g_dht11_stats;
+
+/**
+ * @brief       TIM7从0开始计时, 到达us后产生更新中断
+ * @param       us: 定时时间
+ * @retval      无
+ */
+static void dht11_timer_start(uint16_t us)
+{
+    __HAL_TIM_DISABLE(&g_dht11_tim_handle);
+    __HAL_TIM_SET_COUNTER(&g_dht11_tim_handle, 0);
+    __HAL_TIM_SET_AUTORELOAD(&g_dht11_tim_handle, us);
+    __HAL_TIM_CLEAR_FLAG(&g_dht11_tim_handle, TIM_FLAG_UPDATE);
+    __HAL_TIM_ENABLE(&g_dht11_tim_handle);
+}
+
 /**
- * @brief       从DHT11读取一个位
+ * @brief       结束接收, 关闭EXTI和TIM7
  * @param       无
- * @retval      读取到的位值: 0 / 1
+ * @retval      无
  */
-uint8_t dht11_read_bit(void)
+static void dht11_rx_finish(void)
 {
-    uint8_t retry = 0;
+    EXTI->IMR &= ~DHT11_DQ_EXTI_LINE;
+    __HAL_TIM_DISABLE(&g_dht11_tim_handle);
+    g_dht11_phase = DHT11_PHASE_DONE;
+}
 
-    while (DHT11_DQ_IN && retry < 100)  /* 等待变为低电平 */
+/**
+ * @brief       解码下降沿时间戳
+ * @note        第0个下降沿是DHT11应答, 第i+1到第i+2个下降沿的间隔为第i位:
+ *              50us低电平 + 26~28us(0)或70us(1)高电平
+ * @param       无
+ * @retval      DHT11_OK / DHT11_ERR_TIMEOUT / DHT11_ERR_CHECKSUM
+ */
+static uint8_t dht11_decode(void)
+{
+    uint8_t buf[5] = {0};
+    uint8_t i;
+    uint16_t width;
+
+    if (g_dht11_edge_cnt < DHT11_EDGE_NUM)
     {
-        retry++;
-        delay_us(1);
+        g_dht11_stats.timeout++;
+        return DHT11_ERR_TIMEOUT;
     }
 
-    retry = 0;
+    for (i = 0; i < 40; i++)
+    {
+        width = g_dht11_edges[i + 2] - g_dht11_edges[i + 1];
+        buf[i / 8] <<= 1;
 
-    while (!DHT11_DQ_IN && retry < 100) /* 等待变高电平 */
+        if (width > DHT11_BIT_THRESHOLD_US)
+        {
+            buf[i / 8] |= 1;
+        }
+    }
+
+    if ((uint8_t)(buf[0] + buf[1] + buf[2] + buf[3]) != buf[4])
     {
-        retry++;
-        delay_us(1);
+        g_dht11_stats.checksum++;
+        return DHT11_ERR_CHECKSUM;
     }
 
-    delay_us(40);       /* 等待40us */
+    g_dht11_humi = buf[0];
+    g_dht11_temp = buf[2];
+    g_dht11_stats.ok++;
+    return DHT11_OK;
+}
 
-    if (DHT11_DQ_IN)    /* 根据引脚状态返回 bit */
+/**
+ * @brief       启动一次异步读取
+ * @note        拉低DQ并启动TIM7, 18ms后在中断中释放DQ并开始记录下降沿
+ *              DHT11两次读取间隔应不小于1s
+ * @param       无
+ * @retval      0, 已启动
+ *              1, 上一次读取尚未结束
+ */
+uint8_t dht11_start(void)
+{
+    if (g_dht11_phase == DHT11_PHASE_START || g_dht11_phase == DHT11_PHASE_RECEIVE)
     {
         return 1;
     }
-    else 
-    {
-        return 0;
-    }
+
+    g_dht11_edge_cnt = 0;
+    g_dht11_status = DHT11_BUSY;
+    g_dht11_phase = DHT11_PHASE_START;
+
+    DHT11_DQ_OUT(0);                        /* 拉低DQ */
+    dht11_timer_start(DHT11_START_US);      /* 拉低至少18ms */
+
+    return 0;
 }
 
 /**
- * @brief       从DHT11读取一个字节
+ * @brief       查询读取状态
+ * @note        帧接收完成后在这里解码, 中断中只记录时间戳
  * @param       无
- * @retval      读到的数据
+ * @retval      DHT11_IDLE / DHT11_BUSY / DHT11_OK / DHT11_ERR_TIMEOUT / DHT11_ERR_CHECKSUM
  */
-static uint8_t dht11_read_byte(void)
+uint8_t dht11_poll(void)
 {
-    uint8_t i, data = 0;
+    if (g_dht11_phase == DHT11_PHASE_DONE)
+    {
+        PROF_START(PROF_ZONE_DHT11);
+        g_dht11_status = dht11_decode();
+        g_dht11_phase = DHT11_PHASE_IDLE;
+        PROF_STOP(PROF_ZONE_DHT11);
+    }
+
+    return g_dht11_status;
+}
 
-    for (i = 0; i < 8; i++)         /* 循环读取8位数据 */
+/**
+ * @brief       获取最近一次读取的结果
+ * @param       temp: 温度值(范围:-20~60°)
+ * @param       humi: 湿度值(范围:5%~95%)
+ * @retval      0, 最近一次读取成功, 结果已写入
+ *              1, 最近一次读取失败或尚未完成, 结果不变
+ */
+uint8_t dht11_get_result(uint8_t *temp, uint8_t *humi)
+{
+    if (dht11_poll() != DHT11_OK)
     {
-        data <<= 1;                 /* 高位数据先输出, 先左移一位 */
-        data |= dht11_read_bit();   /* 读取1bit数据 */
+        return 1;
     }
 
-    return data;
+    *temp = g_dht11_temp;
+    *humi = g_dht11_humi;
+    return 0;
 }
 
 /**
  * @brief       从DHT11读取一次数据
+ * @note        启动异步读取并等待完成, 约23ms, 仅在不在意阻塞的场合使用
  * @param       temp: 温度值(范围:-20~60°)
  * @param       humi: 湿度值(范围:5%~95%)
  * @retval      0, 正常.
- *              1, 失败
+ *              1, 失败(无应答或校验和错误)
  */
 uint8_t dht11_read_data(uint8_t *temp, uint8_t *humi)
 {
-    uint8_t buf[5];
-    uint8_t i;
-    dht11_reset();
+    uint32_t start_time = HAL_GetTick();
 
-    if (dht11_check() == 0)
+    if (dht11_start())
     {
-        for (i = 0; i < 5; i++)     /* 读取40位数据 */
-        {
-            buf[i] = dht11_read_byte();
-        }
+        return 1;
+    }
 
-        if ((buf[0] + buf[1] + buf[2] + buf[3]) == buf[4])
+    while (dht11_poll() == DHT11_BUSY)
+    {
+        if (HAL_GetTick() - start_time > 50)
         {
-            *humi = buf[0];
-            *temp = buf[2];
+            return 1;
         }
     }
-    else
+
+    return dht11_get_result(temp, humi);
+}
+
+/**
+ * @brief       TIM7中断服务函数
+ * @note        起始信号结束时释放DQ并打开EXTI; 接收阶段到期说明帧不完整
+ * @param       无
+ * @retval      无
+ */
+void DHT11_TIMX_IRQHandler(void)
+{
+    if (__HAL_TIM_GET_FLAG(&g_dht11_tim_handle, TIM_FLAG_UPDATE) == RESET)
     {
-        return 1;
+        return;
+    }
+
+    __HAL_TIM_CLEAR_FLAG(&g_dht11_tim_handle, TIM_FLAG_UPDATE);
+
+    if (g_dht11_phase == DHT11_PHASE_START)
+    {
+        EXTI->PR = DHT11_DQ_EXTI_LINE;      /* 清除之前的挂起标志 */
+        EXTI->IMR |= DHT11_DQ_EXTI_LINE;
+        g_dht11_phase = DHT11_PHASE_RECEIVE;
+        dht11_timer_start(DHT11_RX_TIMEOUT_US);
+        DHT11_DQ_OUT(1);                    /* 释放DQ, 等待DHT11应答 */
+    }
+    else if (g_dht11_phase == DHT11_PHASE_RECEIVE)
+    {
+        dht11_rx_finish();
+    }
+}
+
+/**
+ * @brief       DQ下降沿中断服务函数
+ * @note        只记录TIM7计数值, 时间戳由硬件计数器给出, 中断延迟只影响读数时刻不累积
+ * @param       无
+ * @retval      无
+ */
+void DHT11_DQ_EXTI_IRQHandler(void)
+{
+    uint16_t now = __HAL_TIM_GET_COUNTER(&g_dht11_tim_handle);
+
+    if ((EXTI->PR & DHT11_DQ_EXTI_LINE) == 0)
+    {
+        return;
+    }
+
+    EXTI->PR = DHT11_DQ_EXTI_LINE;
+
+    if (g_dht11_phase != DHT11_PHASE_RECEIVE)
+    {
+        return;
+    }
+
+    g_dht11_edges[g_dht11_edge_cnt++] = now;
+
+    if (g_dht11_edge_cnt >= DHT11_EDGE_NUM)
+    {
+        dht11_rx_finish();
     }
-    
-    return 0;
 }
 
 /**
@@ -181,6 +331,28 @@ uint8_t dht11_init(void)
     HAL_GPIO_Init(DHT11_DQ_GPIO_PORT, &gpio_init_struct);   /* 初始化DHT11_DQ引脚 */
     /* DHT11_DQ引脚模式设置,开漏输出,上拉, 这样就不用再设置IO方向了, 开漏输出的时候(=1), 也可以读取外部信号的高低电平 */
 
+    /* TIM7: 1MHz计数, 用于起始信号定时和下降沿时间戳 */
+    DHT11_TIMX_CLK_ENABLE();
+    g_dht11_tim_handle.Instance = DHT11_TIMX;
+    g_dht11_tim_handle.Init.Prescaler = 72 - 1;
+    g_dht11_tim_handle.Init.CounterMode = TIM_COUNTERMODE_UP;
+    g_dht11_tim_handle.Init.Period = DHT11_START_US;
+    g_dht11_tim_handle.Init.AutoReloadPreload = TIM_AUTORELOAD_PRELOAD_DISABLE;
+    HAL_TIM_Base_Init(&g_dht11_tim_handle);
+    __HAL_TIM_CLEAR_FLAG(&g_dht11_tim_handle, TIM_FLAG_UPDATE);
+    __HAL_TIM_ENABLE_IT(&g_dht11_tim_handle, TIM_IT_UPDATE);
+    HAL_NVIC_SetPriority(DHT11_TIMX_IRQn, 1, 0);
+    HAL_NVIC_EnableIRQ(DHT11_TIMX_IRQn);
+
+    /* EXTI11映射到PG11, 下降沿触发, 读取时才打开屏蔽 */
+    __HAL_RCC_AFIO_CLK_ENABLE();
+    AFIO->EXTICR[2] = (AFIO->EXTICR[2] & ~AFIO_EXTICR3_EXTI11) | AFIO_EXTICR3_EXTI11_PG;
+    EXTI->IMR &= ~DHT11_DQ_EXTI_LINE;
+    EXTI->RTSR &= ~DHT11_DQ_EXTI_LINE;
+    EXTI->FTSR |= DHT11_DQ_EXTI_LINE;
+    HAL_NVIC_SetPriority(DHT11_DQ_EXTI_IRQn, 0, 0);     /* 时间戳精度依赖于中断延迟, 设为最高优先级 */
+    HAL_NVIC_EnableIRQ(DHT11_DQ_EXTI_IRQn);
+
     dht11_reset();
     return dht11_check();
 }
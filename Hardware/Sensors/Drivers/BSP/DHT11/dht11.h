@@ -2,8 +2,8 @@
  ****************************************************************************************************
  * @file        dht11.h
  * @author      正点原子团队(ALIENTEK)
- * @version     V1.0
- * @date        2020-04-26
+ * @version     V1.1
+ * @date        2023-06-05
  * @brief       DHT11数字温湿度传感器 驱动代码
  * @license     Copyright (c) 2020-2032, 广州市星翼电子科技有限公司
  ****************************************************************************************************
@@ -18,6 +18,8 @@
  * 修改说明
  * V1.0 20200426
  * 第一次发布
+ * V1.1 20230605
+ * 读取改为异步: TIM7产生18ms起始信号并为EXTI下降沿打时间戳, 主循环查询结果, 不再阻塞
  *
  ****************************************************************************************************
  */
@@ -35,8 +37,40 @@
 #define DHT11_DQ_GPIO_PIN                   GPIO_PIN_11
 #define DHT11_DQ_GPIO_CLK_ENABLE()          do{ __HAL_RCC_GPIOG_CLK_ENABLE(); }while(0)   /* PG口时钟使能 */
 
+/* PG11没有定时器输入捕获通道, 用EXTI下降沿中断 + TIM7自由计数打时间戳代替 */
+#define DHT11_DQ_EXTI_LINE                  GPIO_PIN_11
+#define DHT11_DQ_EXTI_IRQn                  EXTI15_10_IRQn
+#define DHT11_DQ_EXTI_IRQHandler            EXTI15_10_IRQHandler
+
+#define DHT11_TIMX                          TIM7
+#define DHT11_TIMX_IRQn                     TIM7_IRQn
+#define DHT11_TIMX_IRQHandler               TIM7_IRQHandler
+#define DHT11_TIMX_CLK_ENABLE()             do{ __HAL_RCC_TIM7_CLK_ENABLE(); }while(0)    /* TIM7 时钟使能 */
+
 /******************************************************************************************/
 
+#define DHT11_START_US          18000       /* 主机起始信号低电平时间 */
+#define DHT11_RX_TIMEOUT_US     6000        /* 接收超时, 完整一帧约4.9ms */
+#define DHT11_BIT_THRESHOLD_US  100         /* 相邻下降沿间隔: 0约78us, 1约120us */
+#define DHT11_EDGE_NUM          42          /* 应答1个 + 数据40个 + 结束1个下降沿 */
+
+/* 读取状态 */
+#define DHT11_IDLE              0           /* 未开始 */
+#define DHT11_BUSY              1           /* 正在读取 */
+#define DHT11_OK                2           /* 读取成功 */
+#define DHT11_ERR_TIMEOUT       3           /* 无应答或数据位不全 */
+#define DHT11_ERR_CHECKSUM      4           /* 校验和错误 */
+
+/* 读取统计 */
+typedef struct
+{
+    uint32_t ok;                /* 成功次数 */
+    uint32_t timeout;           /* 超时次数 */
+    uint32_t checksum;          /* 校验和错误次数 */
+} dht11_stats_t;
+
+extern dht11_stats_t g_dht11_stats;
+
 /* IO操作函数 */
 #define DHT11_DQ_OUT(x)     do{ x ? \
                                 HAL_GPIO_WritePin(DHT11_DQ_GPIO_PORT, DHT11_DQ_GPIO_PIN, GPIO_PIN_SET) : \
@@ -47,7 +81,10 @@
 
 uint8_t dht11_init(void);   /* 初始化DHT11 */
 uint8_t dht11_check(void);  /* 检测是否存在DHT11 */
-uint8_t dht11_read_data(uint8_t *temp,uint8_t *humi);   /* 读取温湿度 */
+uint8_t dht11_read_data(uint8_t *temp,uint8_t *humi);   /* 读取温湿度(阻塞等待异步读取完成) */
+uint8_t dht11_start(void);                              /* 启动一次异步读取 */
+uint8_t dht11_poll(void);                               /* 查询读取状态 */
+uint8_t dht11_get_result(uint8_t *temp, uint8_t *humi); /* 获取最近一次成功读取的结果 */
 
 #endif
 
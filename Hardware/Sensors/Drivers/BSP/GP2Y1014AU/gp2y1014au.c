@@ -23,22 +23,20 @@
  */
 
  #include "./BSP/GP2Y1014AU/gp2y1014au.h"
- #include "./SYSTEM/delay/delay.h"
- 
- static ADC_HandleTypeDef g_adc_handle;
+ #include "./BSP/GP2Y1014AU/gp2y1014au_curve.h"
  
  /**
   * @brief       初始化GP2Y1014AU
+  * @note        ADC由adc_init()统一配置, LED脉冲由ADC触发定时器的PWM输出产生,
+  *              这里先把LED引脚配置为输出高电平, 定时器启动后再切换为复用输出
   * @param       无
   * @retval      0: 成功
   */
  uint8_t gp2y1014au_init(void)
  {
      GPIO_InitTypeDef gpio_init_struct;
-     ADC_ChannelConfTypeDef adc_ch_conf;
      
      /* 使能时钟 */
-     __HAL_RCC_ADC1_CLK_ENABLE();
      __HAL_RCC_GPIOA_CLK_ENABLE();
      GP2Y1014AU_LED_GPIO_CLK_ENABLE();
      
@@ -58,88 +56,79 @@
      /* 默认关闭LED */
      HAL_GPIO_WritePin(GP2Y1014AU_LED_GPIO_PORT, GP2Y1014AU_LED_GPIO_PIN, GPIO_PIN_SET);
      
-     /* 配置ADC */
-     g_adc_handle.Instance = ADC1;
-     g_adc_handle.Init.DataAlign = ADC_DATAALIGN_RIGHT;
-     g_adc_handle.Init.ScanConvMode = ADC_SCAN_DISABLE;
-     g_adc_handle.Init.ContinuousConvMode = DISABLE;
-     g_adc_handle.Init.NbrOfConversion = 1;
-     g_adc_handle.Init.DiscontinuousConvMode = DISABLE;
-     g_adc_handle.Init.NbrOfDiscConversion = 0;
-     g_adc_handle.Init.ExternalTrigConv = ADC_SOFTWARE_START;
-     HAL_ADC_Init(&g_adc_handle);
-     
-     adc_ch_conf.Channel = GP2Y1014AU_ADC_CHANNEL;
-     adc_ch_conf.Rank = ADC_REGULAR_RANK_1;
-     adc_ch_conf.SamplingTime = ADC_SAMPLETIME_239CYCLES_5;
-     HAL_ADC_ConfigChannel(&g_adc_handle, &adc_ch_conf);
-     
-     HAL_ADCEx_Calibration_Start(&g_adc_handle);
-     
      return 0;
  }
  
  /**
   * @brief       获取GP2Y1014AU的ADC值
+  * @note        测量时序全部由硬件完成: TIM3_CH2输出320us低电平脉冲点亮LED,
+  *              OC1REF在280us处触发ADC转换, DMA搬运结果, 周期10ms
   * @param       无
-  * @retval      ADC值
+  * @retval      最近一次转换的ADC值
   */
  uint16_t gp2y1014au_get_adc_value(void)
  {
-     uint16_t adc_value;
-     
-     /* GP2Y1014AU测量时序：
-      * 1. LED脉冲：先拉低LED引脚0.32ms
-      * 2. 延时0.28ms后开始ADC采样
-      * 3. 采样完成后，恢复LED引脚为高电平
-      */
-     
-     /* 拉低LED引脚 */
-     HAL_GPIO_WritePin(GP2Y1014AU_LED_GPIO_PORT, GP2Y1014AU_LED_GPIO_PIN, GPIO_PIN_RESET);
-     delay_us(320);  /* 延时0.32ms */
-     
-     /* 延时0.28ms后开始ADC采样 */
-     delay_us(280);
-     
-     /* 启动ADC转换 */
-     HAL_ADC_Start(&g_adc_handle);
-     HAL_ADC_PollForConversion(&g_adc_handle, 10);
-     
-     /* 获取ADC值 */
-     if (HAL_IS_BIT_SET(HAL_ADC_GetState(&g_adc_handle), HAL_ADC_STATE_REG_EOC))
-     {
-         adc_value = HAL_ADC_GetValue(&g_adc_handle);
-     }
-     else
-     {
-         adc_value = 0;
-     }
-     
-     /* 恢复LED引脚为高电平 */
-     HAL_GPIO_WritePin(GP2Y1014AU_LED_GPIO_PORT, GP2Y1014AU_LED_GPIO_PIN, GPIO_PIN_SET);
-     
-     /* 等待一段时间再进行下一次测量 */
-     delay_ms(10);
-     
-     return adc_value;
+     return adc_get_latest(ADC_CH_DUST);
  }
  
  /**
   * @brief       获取多次ADC采样的平均值
-  * @param       times: 采样次数
+  * @param       times: 采样次数(最多ADC_DMA_FRAMES次)
   * @retval      ADC平均值
   */
  uint16_t gp2y1014au_get_adc_average(uint8_t times)
  {
-     uint32_t temp_val = 0;
-     uint8_t t;
+     return adc_get_average(ADC_CH_DUST, times);
+ }
+ 
+ /**
+  * @brief       ADC值换算为粉尘浓度
+  * @note        公式ug/m3 = (adc * 3300 / 4096 - 600) / 10 (600mV为无尘时的偏置电压),
+  *              插值表由Tools/gen_curve_tables.py离线生成, 运行时只做整数插值
+  * @param       adc_value: 12位ADC值
+  * @retval      粉尘浓度(0.1ug/m3), 限制在0~500ug/m3
+  */
+ int16_t gp2y1014au_adc_to_density_x10(uint16_t adc_value)
+ {
+     if (adc_value > 4095) adc_value = 4095;
+     
+     return gp2y1014au_ovs_to_density_x10(adc_value << ADC_OVS_BITS);
+ }
+ 
+ /**
+  * @brief       过采样ADC值换算为粉尘浓度
+  * @note        插值表仍按12位码值取点, 多出的ADC_OVS_BITS位并入插值的小数部分
+  * @param       ovs_value: 12 + ADC_OVS_BITS位ADC值
+  * @retval      粉尘浓度(0.1ug/m3), 限制在0~500ug/m3
+  */
+ int16_t gp2y1014au_ovs_to_density_x10(uint16_t ovs_value)
+ {
+     uint16_t i, frac;
+     int32_t density_x10;
      
-     for (t = 0; t < times; t++)
-     {
-         temp_val += gp2y1014au_get_adc_value();
-     }
+     if (ovs_value > ADC_OVS_MAX) ovs_value = ADC_OVS_MAX;
      
-     return temp_val / times;
+     i = ovs_value >> (GP2Y1014AU_CURVE_SHIFT + ADC_OVS_BITS);
+     frac = ovs_value & ((1 << (GP2Y1014AU_CURVE_SHIFT + ADC_OVS_BITS)) - 1);
+     density_x10 = g_gp2y1014au_curve[i] +
+                   ((((int32_t)g_gp2y1014au_curve[i + 1] - g_gp2y1014au_curve[i]) * frac) >> (GP2Y1014AU_CURVE_SHIFT + ADC_OVS_BITS));
+     
+     /* 限制输出范围, GP2Y1014AU的测量范围通常为0-500ug/m3 */
+     if (density_x10 < GP2Y1014AU_CURVE_MIN) density_x10 = GP2Y1014AU_CURVE_MIN;
+     if (density_x10 > GP2Y1014AU_CURVE_MAX) density_x10 = GP2Y1014AU_CURVE_MAX;
+     
+     return density_x10;
+ }
+ 
+ /**
+  * @brief       获取粉尘浓度(0.1ug/m3)
+  * @note        使用ADC过采样结果(默认64次转换, 640ms更新一次)
+  * @param       无
+  * @retval      粉尘浓度值(0.1ug/m3)
+  */
+ int16_t gp2y1014au_get_dust_density_x10(void)
+ {
+     return gp2y1014au_ovs_to_density_x10(adc_get_oversampled(ADC_CH_DUST));
  }
  
  /**
@@ -149,30 +138,5 @@
   */
  float gp2y1014au_get_dust_density(void)
  {
-     float voltage, dust_density;
-     uint16_t adc_value;
-     
-     /* 获取多次采样的平均值 */
-     adc_value = gp2y1014au_get_adc_average(5);
-     
-     /* 将ADC值转换为电压值(mV) */
-     voltage = (float)adc_value * (3300.0 / 4096.0);  /* 3.3V参考电压，12位ADC */
-     
-     /* 根据GP2Y1014AU数据手册，将电压值转换为粉尘浓度(ug/m3) */
-     /* 公式: ug/m3 = (voltage - 600) / 10.0 */
-     /* 注意: 600mV是无尘时的电压输出(偏置电压) */
-     if (voltage > 600.0)
-     {
-         dust_density = (voltage - 600.0) / 10.0;
-     }
-     else
-     {
-         dust_density = 0.0;
-     }
-     
-     /* 限制输出范围 */
-     if (dust_density < 0.0) dust_density = 0.0;
-     if (dust_density > 500.0) dust_density = 500.0;  /* GP2Y1014AU的测量范围通常为0-500ug/m3 */
-     
-     return dust_density;
- }
\ No newline at end of file
+     return gp2y1014au_get_dust_density_x10() / 10.0f;
+ }
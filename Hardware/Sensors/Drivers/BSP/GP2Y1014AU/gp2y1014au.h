@@ -27,13 +27,17 @@
  
  #include "./SYSTEM/sys/sys.h"
  #include "stm32f1xx_hal.h"
- #include <math.h>
+ #include "./BSP/ADC/adc.h"
  
  /* GP2Y1014AU引脚定义 */
  #define GP2Y1014AU_LED_GPIO_PORT        GPIOB
  #define GP2Y1014AU_LED_GPIO_PIN         GPIO_PIN_5
  #define GP2Y1014AU_LED_GPIO_CLK_ENABLE() do{ __HAL_RCC_GPIOB_CLK_ENABLE(); }while(0)  /* PB口时钟使能 */
  
+ /* LED脉冲由TIM3_CH2 PWM输出, PB5需要TIM3部分重映射 */
+ #define GP2Y1014AU_LED_TIM_CHANNEL      TIM_CHANNEL_2
+ #define GP2Y1014AU_LED_TIM_REMAP()      do{ __HAL_RCC_AFIO_CLK_ENABLE(); __HAL_AFIO_REMAP_TIM3_PARTIAL(); }while(0)
+ 
  /* GP2Y1014AU ADC通道定义 */
  #define GP2Y1014AU_ADC_CHANNEL          ADC_CHANNEL_0  /* PA0对应ADC通道0 */
  
@@ -41,6 +45,9 @@
  uint8_t gp2y1014au_init(void);                      /* 初始化GP2Y1014AU */
  uint16_t gp2y1014au_get_adc_value(void);            /* 获取ADC值 */
  uint16_t gp2y1014au_get_adc_average(uint8_t times); /* 获取多次ADC平均值 */
+ int16_t gp2y1014au_adc_to_density_x10(uint16_t adc_value); /* ADC值换算粉尘浓度(0.1ug/m3) */
+ int16_t gp2y1014au_ovs_to_density_x10(uint16_t ovs_value); /* 过采样ADC值换算粉尘浓度(0.1ug/m3) */
+ int16_t gp2y1014au_get_dust_density_x10(void);     /* 获取粉尘浓度(0.1ug/m3) */
  float gp2y1014au_get_dust_density(void);            /* 获取粉尘浓度(ug/m3) */
  
  #endif
\ No newline at end of file
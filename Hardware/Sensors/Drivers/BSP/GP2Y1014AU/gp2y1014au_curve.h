@@ -0,0 +1,39 @@
+/**
+ ****************************************************************************************************
+ * @file        gp2y1014au_curve.h
+ * @author      正点原子团队(ALIENTEK)
+ * @version     V1.0
+ * @date        2023-06-05
+ * @brief       GP2Y1014AU ADC码值到粉尘浓度(0.1ug/m3)插值表
+ * @license     Copyright (c) 2020-2032, 广州市星翼电子科技有限公司
+ ****************************************************************************************************
+ * @attention
+ *
+ * 本文件由Tools/gen_curve_tables.py生成, 请勿手工修改.
+ * 公式: ug/m3 = (adc * 3300 / 4096 - 600) / 10
+ * 每64个ADC码值取一个点, 共65个点, 线性插值后与公式的误差不超过0.15或0.5%.
+ *
+ ****************************************************************************************************
+ */
+
+#ifndef __GP2Y1014AU_CURVE_H
+#define __GP2Y1014AU_CURVE_H
+
+#define GP2Y1014AU_CURVE_SHIFT  6
+#define GP2Y1014AU_CURVE_MIN    0
+#define GP2Y1014AU_CURVE_MAX    5000
+
+static const int16_t g_gp2y1014au_curve[65] =
+{
+      -600,   -548,   -497,   -445,   -394,   -342,   -291,   -239,
+      -188,   -136,    -84,    -33,     19,     70,    122,    173,
+       225,    277,    328,    380,    431,    483,    534,    586,
+       638,    689,    741,    792,    844,    895,    947,    998,
+      1050,   1102,   1153,   1205,   1256,   1308,   1359,   1411,
+      1462,   1514,   1566,   1617,   1669,   1720,   1772,   1823,
+      1875,   1927,   1978,   2030,   2081,   2133,   2184,   2236,
+      2288,   2339,   2391,   2442,   2494,   2545,   2597,   2648,
+      2700
+};
+
+#endif
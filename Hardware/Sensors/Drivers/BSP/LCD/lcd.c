@@ -2,7 +2,7 @@
  ****************************************************************************************************
  * @file        lcd.c
  * @author      正点原子团队(ALIENTEK)
- * @version     V1.2
+ * @version     V1.3
  * @date        2023-05-31
  * @brief       2.8寸/3.5寸/4.3寸/7寸 TFTLCD(MCU屏) 驱动代码
  *              支持驱动IC型号包括:ILI9341/NT35310/NT35510/SSD1963/ST7789/ST7796/ILI9806 等
@@ -25,6 +25,9 @@
  * 2, 简化部分代码, 避免长判定
  * V1.2 20230531
  * 1, 新增对ST7796和ILI9806 IC支持
+ * V1.3 20230605
+ * 1, 非叠加方式显示字符时, 每个字符只开一次窗口, 连续写入前景/背景像素
+ * 2, lcd_clear/lcd_fill/lcd_color_fill开窗后由DMA2存储器到存储器方式写入GRAM, 不等待完成
  *
  ****************************************************************************************************
  */
@@ -45,6 +48,15 @@
 
 SRAM_HandleTypeDef g_sram_handle;    /* SRAM句柄(用于控制LCD) */
 
+#if LCD_DMA_ENABLE
+static DMA_HandleTypeDef g_lcd_dma_handle;      /* 矩形填充DMA句柄 */
+static volatile uint8_t g_lcd_dma_busy = 0;     /* 1: DMA正在写GRAM, 窗口在传输结束后恢复 */
+static uint32_t g_lcd_dma_src;                  /* 下一段的源地址 */
+static uint32_t g_lcd_dma_remain;               /* 还没有启动传输的像素数 */
+static uint8_t g_lcd_dma_inc;                   /* 1: 源地址递增 */
+static uint16_t g_lcd_dma_color;                /* 纯色填充的源数据 */
+#endif
+
 /* LCD的画笔颜色和背景色 */
 uint32_t g_point_color = 0XF800;    /* 画笔颜色 */
 uint32_t g_back_color  = 0XFFFF;    /* 背景色 */
@@ -71,6 +83,7 @@ void lcd_wr_data(volatile uint16_t data)
 void lcd_wr_regno(volatile uint16_t regno)
 {
     regno = regno;          /* 使用-O2优化的时候,必须插入的延时 */
+    lcd_dma_wait();         /* DMA填充期间不能插入命令 */
     LCD->LCD_REG = regno;   /* 写入要写的寄存器序号 */
 }
 
@@ -82,6 +95,7 @@ void lcd_wr_regno(volatile uint16_t regno)
  */
 void lcd_write_reg(uint16_t regno, uint16_t data)
 {
+    lcd_dma_wait();
     LCD->LCD_REG = regno;   /* 写入要写的寄存器序号 */
     LCD->LCD_RAM = data;    /* 写入数据 */
 }
@@ -116,6 +130,7 @@ static uint16_t lcd_rd_data(void)
  */
 void lcd_write_ram_prepare(void)
 {
+    lcd_dma_wait();
     LCD->LCD_REG = lcddev.wramcmd;
 }
 
@@ -594,6 +609,176 @@ void lcd_set_window(uint16_t sx, uint16_t sy, uint16_t width, uint16_t height)
     }
 }
 
+/**
+ * @brief       恢复全屏窗口
+ * @note        lcd_set_cursor只设置起始坐标, 开过小窗口后必须恢复, 否则lcd_draw_point等函数会在小窗口内折行
+ * @param       无
+ * @retval      无
+ */
+static void lcd_restore_window(void)
+{
+    lcd_set_window(0, 0, lcddev.width, lcddev.height);
+}
+
+#if LCD_DMA_ENABLE
+
+/**
+ * @brief       启动下一段DMA传输
+ * @note        DMA单次最多传输65535个数据, 全屏清除需要分段
+ * @param       无
+ * @retval      HAL_OK, 已启动; 其他, 启动失败
+ */
+static HAL_StatusTypeDef lcd_dma_next(void)
+{
+    uint32_t len = g_lcd_dma_remain > 0xFFFF ? 0xFFFF : g_lcd_dma_remain;
+    HAL_StatusTypeDef ret;
+
+    ret = HAL_DMA_Start_IT(&g_lcd_dma_handle, g_lcd_dma_src, (uint32_t)&LCD->LCD_RAM, len);
+
+    if (ret == HAL_OK)
+    {
+        g_lcd_dma_remain -= len;
+
+        if (g_lcd_dma_inc)
+        {
+            g_lcd_dma_src += len * 2;
+        }
+    }
+
+    return ret;
+}
+
+/**
+ * @brief       DMA传输完成回调
+ * @note        还有剩余像素时启动下一段, 否则恢复全屏窗口. 先清忙标志, 恢复窗口时才能写命令;
+ *              此时主循环被中断打断, 不会在窗口恢复前访问LCD
+ * @param       hdma: DMA句柄
+ * @retval      无
+ */
+static void lcd_dma_cplt(DMA_HandleTypeDef *hdma)
+{
+    uint16_t *src;
+
+    if (g_lcd_dma_remain && lcd_dma_next() == HAL_OK)
+    {
+        return;
+    }
+
+    /* 下一段启动失败时由CPU写完(正常情况下不会发生) */
+    src = (uint16_t *)g_lcd_dma_src;
+
+    while (g_lcd_dma_remain)
+    {
+        LCD->LCD_RAM = *src;
+        src += g_lcd_dma_inc;
+        g_lcd_dma_remain--;
+    }
+
+    g_lcd_dma_busy = 0;
+    lcd_restore_window();
+}
+
+/**
+ * @brief       DMA中断服务函数
+ * @param       无
+ * @retval      无
+ */
+void LCD_DMA_IRQHandler(void)
+{
+    HAL_DMA_IRQHandler(&g_lcd_dma_handle);
+}
+
+/**
+ * @brief       初始化矩形填充DMA
+ * @note        存储器到存储器模式下"外设"端为源(CPAR), "存储器"端为目标(CMAR, 固定为LCD_RAM)
+ * @param       无
+ * @retval      无
+ */
+static void lcd_dma_init(void)
+{
+    LCD_DMA_CLK_ENABLE();
+
+    g_lcd_dma_handle.Instance = LCD_DMA_CHANNEL;
+    g_lcd_dma_handle.Init.Direction = DMA_MEMORY_TO_MEMORY;
+    g_lcd_dma_handle.Init.PeriphInc = DMA_PINC_DISABLE;                 /* 源地址是否递增在每次启动时设置 */
+    g_lcd_dma_handle.Init.MemInc = DMA_MINC_DISABLE;                    /* 目标LCD_RAM地址不变 */
+    g_lcd_dma_handle.Init.PeriphDataAlignment = DMA_PDATAALIGN_HALFWORD;
+    g_lcd_dma_handle.Init.MemDataAlignment = DMA_MDATAALIGN_HALFWORD;
+    g_lcd_dma_handle.Init.Mode = DMA_NORMAL;
+    g_lcd_dma_handle.Init.Priority = DMA_PRIORITY_LOW;                  /* 低于ADC和串口 */
+    HAL_DMA_Init(&g_lcd_dma_handle);
+    g_lcd_dma_handle.XferCpltCallback = lcd_dma_cplt;
+
+    HAL_NVIC_SetPriority(LCD_DMA_IRQn, 3, 3);
+    HAL_NVIC_EnableIRQ(LCD_DMA_IRQn);
+}
+
+/**
+ * @brief       用DMA把像素写入当前窗口
+ * @note        调用前已经开好窗口并执行lcd_write_ram_prepare, 函数不等待传输结束,
+ *              传输结束后在中断里恢复全屏窗口
+ * @param       src: 源地址(纯色填充时指向g_lcd_dma_color)
+ * @param       total: 像素数
+ * @param       inc: 1, 源地址递增; 0, 源地址不变
+ * @retval      0, 已启动; 1, 像素太少或DMA忙, 由调用者用CPU写入
+ */
+static uint8_t lcd_dma_start(uint32_t src, uint32_t total, uint8_t inc)
+{
+    if (total < LCD_DMA_MIN_PIXELS || HAL_DMA_GetState(&g_lcd_dma_handle) != HAL_DMA_STATE_READY)
+    {
+        return 1;
+    }
+
+    if (inc)
+    {
+        g_lcd_dma_handle.Instance->CCR |= DMA_CCR_PINC;
+    }
+    else
+    {
+        g_lcd_dma_handle.Instance->CCR &= ~DMA_CCR_PINC;
+    }
+
+    g_lcd_dma_src = src;
+    g_lcd_dma_remain = total;
+    g_lcd_dma_inc = inc;
+    g_lcd_dma_busy = 1;
+
+    if (lcd_dma_next() != HAL_OK)
+    {
+        g_lcd_dma_busy = 0;
+        return 1;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief       查询DMA填充是否进行中
+ * @note        任务可以据此跳过本次刷新, 而不是在LCD函数里等待
+ * @param       无
+ * @retval      1, 进行中; 0, 空闲
+ */
+uint8_t lcd_dma_busy(void)
+{
+    return g_lcd_dma_busy;
+}
+
+/**
+ * @brief       等待DMA填充结束
+ * @note        所有写命令的LCD函数都会先调用本函数; 不能在关中断状态或优先级高于LCD_DMA_IRQn的中断里调用
+ * @param       无
+ * @retval      无
+ */
+void lcd_dma_wait(void)
+{
+    while (g_lcd_dma_busy)
+    {
+        __NOP();    /* 主机仿真在这里推进时间 */
+    }
+}
+
+#endif
+
 /**
  * @brief       SRAM底层驱动，时钟使能，引脚分配
  * @note        此函数会被HAL_SRAM_Init()调用,初始化读写总线引脚
@@ -813,75 +998,91 @@ void lcd_init(void)
 
     lcd_display_dir(0); /* 默认为竖屏 */
     LCD_BL(1);          /* 点亮背光 */
-    lcd_clear(WHITE);
+
+#if LCD_DMA_ENABLE
+    lcd_dma_init();
+#endif
+
+    lcd_clear(WHITE);   /* 使用DMA时在后台进行 */
 }
 
 /**
  * @brief       清屏函数
+ * @note        使用DMA时函数立即返回, 清屏在后台进行
  * @param       color: 要清屏的颜色
  * @retval      无
  */
 void lcd_clear(uint16_t color)
 {
-    uint32_t index = 0;
-    uint32_t totalpoint = lcddev.width;
-    totalpoint *= lcddev.height;    /* 得到总点数 */
-    lcd_set_cursor(0x00, 0x0000);   /* 设置光标位置 */
-    lcd_write_ram_prepare();        /* 开始写入GRAM */
-
-    for (index = 0; index < totalpoint; index++)
-    {
-        LCD->LCD_RAM = color;
-   }
+    lcd_fill(0, 0, lcddev.width - 1, lcddev.height - 1, color);
 }
 
 /**
  * @brief       在指定区域内填充单个颜色
+ * @note        开一个窗口后连续写入, 不再逐行设置光标; 像素较多时由DMA写入, 函数立即返回
  * @param       (sx,sy),(ex,ey):填充矩形对角坐标,区域大小为:(ex - sx + 1) * (ey - sy + 1)
  * @param       color:要填充的颜色(32位颜色,方便兼容LTDC)
  * @retval      无
  */
 void lcd_fill(uint16_t sx, uint16_t sy, uint16_t ex, uint16_t ey, uint32_t color)
 {
-    uint16_t i, j;
-    uint16_t xlen = 0;
-    xlen = ex - sx + 1;
+    uint32_t i;
+    uint32_t total;
+    uint16_t width = ex - sx + 1;
+    uint16_t height = ey - sy + 1;
+    total = (uint32_t)width * height;
 
-    for (i = sy; i <= ey; i++)
+    lcd_set_window(sx, sy, width, height);  /* 会等待上一次DMA填充结束 */
+    lcd_write_ram_prepare();                /* 开始写入GRAM */
+
+#if LCD_DMA_ENABLE
+    g_lcd_dma_color = color;
+
+    if (lcd_dma_start((uint32_t)&g_lcd_dma_color, total, 0) == 0)
     {
-        lcd_set_cursor(sx, i);      /* 设置光标位置 */
-        lcd_write_ram_prepare();    /* 开始写入GRAM */
+        return;
+    }
+#endif
 
-        for (j = 0; j < xlen; j++)
-        {
-            LCD->LCD_RAM = color;   /* 显示颜色 */
-        }
+    for (i = 0; i < total; i++)
+    {
+        LCD->LCD_RAM = color;   /* 显示颜色 */
     }
+
+    lcd_restore_window();
 }
 
 /**
  * @brief       在指定区域内填充指定颜色块
+ * @note        像素较多时由DMA写入, 函数立即返回, color数组在lcd_dma_wait返回前不能释放或修改
  * @param       (sx,sy),(ex,ey):填充矩形对角坐标,区域大小为:(ex - sx + 1) * (ey - sy + 1)
  * @param       color: 要填充的颜色数组首地址
  * @retval      无
  */
 void lcd_color_fill(uint16_t sx, uint16_t sy, uint16_t ex, uint16_t ey, uint16_t *color)
 {
-    uint16_t height, width;
-    uint16_t i, j;
-    width = ex - sx + 1;            /* 得到填充的宽度 */
-    height = ey - sy + 1;           /* 高度 */
+    uint32_t i;
+    uint32_t total;
+    uint16_t width = ex - sx + 1;   /* 得到填充的宽度 */
+    uint16_t height = ey - sy + 1;  /* 高度 */
+    total = (uint32_t)width * height;
+
+    lcd_set_window(sx, sy, width, height);
+    lcd_write_ram_prepare();
 
-    for (i = 0; i < height; i++)
+#if LCD_DMA_ENABLE
+    if (lcd_dma_start((uint32_t)color, total, 1) == 0)
     {
-        lcd_set_cursor(sx, sy + i); /* 设置光标位置 */
-        lcd_write_ram_prepare();    /* 开始写入GRAM */
+        return;
+    }
+#endif
 
-        for (j = 0; j < width; j++)
-        {
-            LCD->LCD_RAM = color[i * width + j]; /* 写入数据 */
-        }
+    for (i = 0; i < total; i++)
+    {
+        LCD->LCD_RAM = color[i];    /* 写入数据 */
     }
+
+    lcd_restore_window();
 }
 
 /**
@@ -1046,15 +1247,18 @@ void lcd_fill_circle(uint16_t x, uint16_t y, uint16_t r, uint16_t color)
 }
 
 /**
- * @brief       在指定位置显示一个字符
+ * @brief       在指定位置显示一个字符(不恢复窗口)
+ * @note        字库按列取模: 每列(size + 7) / 8个字节, 高位在上.
+ *              非叠加方式且字符完整落在屏幕内时, 开一个(size / 2) x size的窗口, 按行展开点阵连续写入GRAM;
+ *              否则逐点绘制
  * @param       x,y  : 坐标
  * @param       chr  : 要显示的字符:" "--->"~"
  * @param       size : 字体大小 12/16/24/32
  * @param       mode : 叠加方式(1); 非叠加方式(0);
  * @param       color : 字符的颜色;
- * @retval      无
+ * @retval      1, 开过窗口, 调用者需要执行lcd_restore_window; 0, 没有改变窗口
  */
-void lcd_show_char(uint16_t x, uint16_t y, char chr, uint8_t size, uint8_t mode, uint16_t color)
+static uint8_t lcd_put_char(uint16_t x, uint16_t y, char chr, uint8_t size, uint8_t mode, uint16_t color)
 {
     uint8_t temp, t1, t;
     uint16_t y0 = y;
@@ -1067,25 +1271,51 @@ void lcd_show_char(uint16_t x, uint16_t y, char chr, uint8_t size, uint8_t mode,
     switch (size)
     {
         case 12:
-            pfont = (uint8_t *)asc2_1206[chr];  /* 调用1206字体 */
+            pfont = (uint8_t *)asc2_1206[(uint8_t)chr];  /* 调用1206字体 */
             break;
 
         case 16:
-            pfont = (uint8_t *)asc2_1608[chr];  /* 调用1608字体 */
+            pfont = (uint8_t *)asc2_1608[(uint8_t)chr];  /* 调用1608字体 */
             break;
 
         case 24:
-            pfont = (uint8_t *)asc2_2412[chr];  /* 调用2412字体 */
+            pfont = (uint8_t *)asc2_2412[(uint8_t)chr];  /* 调用2412字体 */
             break;
 
         case 32:
-            pfont = (uint8_t *)asc2_3216[chr];  /* 调用3216字体 */
+            pfont = (uint8_t *)asc2_3216[(uint8_t)chr];  /* 调用3216字体 */
             break;
 
         default:
-            return ;
+            return 0;
     }
 
+#if LCD_FAST_CHAR
+    if (mode == 0 && x + size / 2 <= lcddev.width && y + size <= lcddev.height)
+    {
+        uint8_t width = size / 2;
+        uint8_t col_bytes = csize / width;  /* 每列字节数 */
+        uint8_t row, col, mask;
+        uint8_t *prow;
+
+        lcd_set_window(x, y, width, size);
+        lcd_write_ram_prepare();
+
+        for (row = 0; row < size; row++)
+        {
+            prow = pfont + row / 8;
+            mask = 0x80 >> (row % 8);
+
+            for (col = 0; col < width; col++)
+            {
+                LCD->LCD_RAM = (prow[col * col_bytes] & mask) ? color : g_back_color;
+            }
+        }
+
+        return 1;
+    }
+#endif
+
     for (t = 0; t < csize; t++)
     {
         temp = pfont[t];    /* 获取字符的点阵数据 */
@@ -1104,19 +1334,38 @@ void lcd_show_char(uint16_t x, uint16_t y, char chr, uint8_t size, uint8_t mode,
             temp <<= 1; /* 移位, 以便获取下一个位的状态 */
             y++;
 
-            if (y >= lcddev.height)return;  /* 超区域了 */
+            if (y >= lcddev.height)return 0;    /* 超区域了 */
 
             if ((y - y0) == size)   /* 显示完一列了? */
             {
                 y = y0; /* y坐标复位 */
                 x++;    /* x坐标递增 */
 
-                if (x >= lcddev.width)return;   /* x坐标超区域了 */
+                if (x >= lcddev.width)return 0; /* x坐标超区域了 */
 
                 break;
             }
         }
     }
+
+    return 0;
+}
+
+/**
+ * @brief       在指定位置显示一个字符
+ * @param       x,y  : 坐标
+ * @param       chr  : 要显示的字符:" "--->"~"
+ * @param       size : 字体大小 12/16/24/32
+ * @param       mode : 叠加方式(1); 非叠加方式(0);
+ * @param       color : 字符的颜色;
+ * @retval      无
+ */
+void lcd_show_char(uint16_t x, uint16_t y, char chr, uint8_t size, uint8_t mode, uint16_t color)
+{
+    if (lcd_put_char(x, y, chr, size, mode, color))
+    {
+        lcd_restore_window();
+    }
 }
 
 /**
@@ -1147,6 +1396,7 @@ void lcd_show_num(uint16_t x, uint16_t y, uint32_t num, uint8_t len, uint8_t siz
 {
     uint8_t t, temp;
     uint8_t enshow = 0;
+    uint8_t windowed = 0;
 
     for (t = 0; t < len; t++)   /* 按总显示位数循环 */
     {
@@ -1156,7 +1406,7 @@ void lcd_show_num(uint16_t x, uint16_t y, uint32_t num, uint8_t len, uint8_t siz
         {
             if (temp == 0)
             {
-                lcd_show_char(x + (size / 2)*t, y, ' ', size, 0, color);/* 显示空格,占位 */
+                windowed |= lcd_put_char(x + (size / 2)*t, y, ' ', size, 0, color);/* 显示空格,占位 */
                 continue;   /* 继续下个一位 */
             }
             else
@@ -1166,7 +1416,12 @@ void lcd_show_num(uint16_t x, uint16_t y, uint32_t num, uint8_t len, uint8_t siz
 
         }
 
-        lcd_show_char(x + (size / 2)*t, y, temp + '0', size, 0, color); /* 显示字符 */
+        windowed |= lcd_put_char(x + (size / 2)*t, y, temp + '0', size, 0, color); /* 显示字符 */
+    }
+
+    if (windowed)
+    {
+        lcd_restore_window();   /* 整串显示完后恢复一次窗口 */
     }
 }
 
@@ -1187,6 +1442,7 @@ void lcd_show_xnum(uint16_t x, uint16_t y, uint32_t num, uint8_t len, uint8_t si
 {
     uint8_t t, temp;
     uint8_t enshow = 0;
+    uint8_t windowed = 0;
 
     for (t = 0; t < len; t++)   /* 按总显示位数循环 */
     {
@@ -1198,11 +1454,11 @@ void lcd_show_xnum(uint16_t x, uint16_t y, uint32_t num, uint8_t len, uint8_t si
             {
                 if (mode & 0X80)   /* 高位需要填充0 */
                 {
-                    lcd_show_char(x + (size / 2)*t, y, '0', size, mode & 0X01, color);  /* 用0占位 */
+                    windowed |= lcd_put_char(x + (size / 2)*t, y, '0', size, mode & 0X01, color);  /* 用0占位 */
                 }
                 else
                 {
-                    lcd_show_char(x + (size / 2)*t, y, ' ', size, mode & 0X01, color);  /* 用空格占位 */
+                    windowed |= lcd_put_char(x + (size / 2)*t, y, ' ', size, mode & 0X01, color);  /* 用空格占位 */
                 }
 
                 continue;
@@ -1214,7 +1470,12 @@ void lcd_show_xnum(uint16_t x, uint16_t y, uint32_t num, uint8_t len, uint8_t si
 
         }
 
-        lcd_show_char(x + (size / 2)*t, y, temp + '0', size, mode & 0X01, color);
+        windowed |= lcd_put_char(x + (size / 2)*t, y, temp + '0', size, mode & 0X01, color);
+    }
+
+    if (windowed)
+    {
+        lcd_restore_window();
     }
 }
 
@@ -1230,6 +1491,7 @@ void lcd_show_xnum(uint16_t x, uint16_t y, uint32_t num, uint8_t len, uint8_t si
 void lcd_show_string(uint16_t x, uint16_t y, uint16_t width, uint16_t height, uint8_t size, char *p, uint16_t color)
 {
     uint8_t x0 = x;
+    uint8_t windowed = 0;
     width += x;
     height += y;
 
@@ -1243,10 +1505,15 @@ void lcd_show_string(uint16_t x, uint16_t y, uint16_t width, uint16_t height, ui
 
         if (y >= height)break;  /* 退出 */
 
-        lcd_show_char(x, y, *p, size, 0, color);
+        windowed |= lcd_put_char(x, y, *p, size, 0, color);
         x += size / 2;
         p++;
     }
+
+    if (windowed)
+    {
+        lcd_restore_window();   /* 整串显示完后恢复一次窗口 */
+    }
 }
 
 
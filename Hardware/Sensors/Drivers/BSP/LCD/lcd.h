@@ -2,7 +2,7 @@
  ****************************************************************************************************
  * @file        lcd.h
  * @author      正点原子团队(ALIENTEK)
- * @version     V1.2
+ * @version     V1.3
  * @date        2023-05-31
  * @brief       2.8寸/3.5寸/4.3寸/7寸 TFTLCD(MCU屏) 驱动代码
  *              支持驱动IC型号包括:ILI9341/NT35310/NT35510/SSD1963/ST7789/ST7796/ILI9806 等
@@ -25,6 +25,9 @@
  * 2, 简化部分代码, 避免长判定
  * V1.2 20230531
  * 1, 新增对ST7796和ILI9806 IC支持
+ * V1.3 20230605
+ * 1, 非叠加方式显示字符时, 每个字符只开一次窗口, 连续写入前景/背景像素
+ * 2, lcd_clear/lcd_fill/lcd_color_fill开窗后由DMA2存储器到存储器方式写入GRAM, 不等待完成
  *
  ****************************************************************************************************
  */
@@ -81,6 +84,23 @@
 #define LCD_FSMC_BTRX        FSMC_Bank1->BTCR[(LCD_FSMC_NEX - 1) * 2 + 1]   /* BTR寄存器,根据LCD_FSMC_NEX自动计算 */
 #define LCD_FSMC_BWTRX       FSMC_Bank1E->BWTR[(LCD_FSMC_NEX - 1) * 2]      /* BWTR寄存器,根据LCD_FSMC_NEX自动计算 */
 
+/* 字符显示方式
+ * 1: 非叠加显示时按字符开窗, 连续写入size * size / 2个像素(16号字约139次总线写)
+ * 0: 每个像素调用lcd_draw_point(ILI9341上每像素8次总线写, 16号字约1024次), 用于对比测试
+ */
+#define LCD_FAST_CHAR        1
+
+/* 矩形填充DMA, 使用DMA2通道1的存储器到存储器模式, 目标地址固定为LCD_RAM
+ * 纯色填充源地址不增, 颜色块填充源地址递增. 传输期间所有LCD函数在写命令前等待传输结束
+ */
+#define LCD_DMA_ENABLE              1               /* 0: 全部由CPU写入 */
+#define LCD_DMA_MIN_PIXELS          256             /* 像素数小于此值时CPU写入更快 */
+
+#define LCD_DMA_CHANNEL             DMA2_Channel1
+#define LCD_DMA_IRQn                DMA2_Channel1_IRQn
+#define LCD_DMA_IRQHandler          DMA2_Channel1_IRQHandler
+#define LCD_DMA_CLK_ENABLE()        do{ __HAL_RCC_DMA2_CLK_ENABLE(); }while(0)
+
 /******************************************************************************************/
 
 /* LCD重要参数集 */
@@ -140,7 +160,9 @@ typedef struct
  *          LCD_BASE = (0X6000 0000 + (0X400 0000 * (x - 1))) | ((1 << y) * 2 -2)
  */
 #define LCD_BASE        (uint32_t)((0X60000000 + (0X4000000 * (LCD_FSMC_NEX - 1))) | (((1 << LCD_FSMC_AX) * 2) -2))
+#ifndef LCD                             /* 主机仿真(Host/sim)预先定义为仿真寄存器 */
 #define LCD             ((LCD_TypeDef *) LCD_BASE)
+#endif
 
 /******************************************************************************************/
 /* LCD扫描方向和颜色 定义 */
@@ -228,10 +250,18 @@ void lcd_draw_circle(uint16_t x0, uint16_t y0, uint8_t r, uint16_t color);
 void lcd_draw_hline(uint16_t x, uint16_t y, uint16_t len, uint16_t color);                  /* 画水平线 */
 void lcd_set_window(uint16_t sx, uint16_t sy, uint16_t width, uint16_t height);             /* 设置窗口 */
 void lcd_fill(uint16_t sx, uint16_t sy, uint16_t ex, uint16_t ey, uint32_t color);          /* 纯色填充矩形(32位颜色,兼容LTDC) */
-void lcd_color_fill(uint16_t sx, uint16_t sy, uint16_t ex, uint16_t ey, uint16_t *color);   /* 彩色填充矩形 */
+void lcd_color_fill(uint16_t sx, uint16_t sy, uint16_t ex, uint16_t ey, uint16_t *color);   /* 彩色填充矩形, 返回后color须保持到lcd_dma_wait */
 void lcd_draw_line(uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2, uint16_t color);     /* 画直线 */
 void lcd_draw_rectangle(uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2, uint16_t color);/* 画矩形 */
 
+#if LCD_DMA_ENABLE
+uint8_t lcd_dma_busy(void);                 /* 查询DMA填充是否进行中 */
+void lcd_dma_wait(void);                    /* 等待DMA填充结束 */
+#else
+#define lcd_dma_busy()              0
+#define lcd_dma_wait()              ((void)0)
+#endif
+
 
 void lcd_show_char(uint16_t x, uint16_t y, char chr, uint8_t size, uint8_t mode, uint16_t color);                       /* 显示一个字符 */
 void lcd_show_num(uint16_t x, uint16_t y, uint32_t num, uint8_t len, uint8_t size, uint16_t color);                     /* 显示数字 */
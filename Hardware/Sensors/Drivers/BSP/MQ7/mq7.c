@@ -1,13 +1,57 @@
 #include "./BSP/MQ7/mq7.h"
+#include "./BSP/MQ7/mq7_curve.h"
 
-static ADC_HandleTypeDef g_adc_handle;
+static TIM_HandleTypeDef g_mq7_heater_handle;   /* 加热PWM定时器句柄 */
+
+static uint8_t g_mq7_phase = MQ7_PHASE_HIGH;    /* 当前加热阶段 */
+static uint32_t g_mq7_phase_start = 0;          /* 当前阶段开始时间(ms) */
+static uint8_t g_mq7_status = MQ7_IDLE;
+static uint16_t g_mq7_co_x10 = 0;               /* 最近一次低温阶段结束时的CO浓度 */
+
+/* 切换加热阶段, 只改变PWM占空比, 波形由TIM2产生 */
+static void mq7_heater_set(uint8_t phase, uint32_t now)
+{
+    g_mq7_phase = phase;
+    g_mq7_phase_start = now;
+    __HAL_TIM_SET_COMPARE(&g_mq7_heater_handle, MQ7_HEATER_TIMX_CHY,
+                          phase == MQ7_PHASE_HIGH ? MQ7_HEATER_HIGH_DUTY : MQ7_HEATER_LOW_DUTY);
+}
+
+static void mq7_heater_init(void)
+{
+    GPIO_InitTypeDef gpio_init_struct;
+    TIM_OC_InitTypeDef tim_oc_init = {0};
+    
+    MQ7_HEATER_TIMX_CLK_ENABLE();
+    MQ7_HEATER_GPIO_CLK_ENABLE();
+    
+    g_mq7_heater_handle.Instance = MQ7_HEATER_TIMX;
+    g_mq7_heater_handle.Init.Prescaler = 72 - 1;                    /* 72MHz / 72 = 1MHz */
+    g_mq7_heater_handle.Init.CounterMode = TIM_COUNTERMODE_UP;
+    g_mq7_heater_handle.Init.Period = MQ7_HEATER_PWM_PERIOD - 1;
+    g_mq7_heater_handle.Init.ClockDivision = TIM_CLOCKDIVISION_DIV1;
+    g_mq7_heater_handle.Init.AutoReloadPreload = TIM_AUTORELOAD_PRELOAD_ENABLE;
+    HAL_TIM_PWM_Init(&g_mq7_heater_handle);
+    
+    tim_oc_init.OCMode = TIM_OCMODE_PWM1;
+    tim_oc_init.Pulse = MQ7_HEATER_HIGH_DUTY;                       /* 上电先进入高温阶段 */
+    tim_oc_init.OCPolarity = TIM_OCPOLARITY_HIGH;
+    HAL_TIM_PWM_ConfigChannel(&g_mq7_heater_handle, &tim_oc_init, MQ7_HEATER_TIMX_CHY);
+    
+    gpio_init_struct.Pin = MQ7_HEATER_GPIO_PIN;
+    gpio_init_struct.Mode = GPIO_MODE_AF_PP;
+    gpio_init_struct.Pull = GPIO_NOPULL;
+    gpio_init_struct.Speed = GPIO_SPEED_FREQ_LOW;
+    HAL_GPIO_Init(MQ7_HEATER_GPIO_PORT, &gpio_init_struct);
+    
+    HAL_TIM_PWM_Start(&g_mq7_heater_handle, MQ7_HEATER_TIMX_CHY);
+    mq7_heater_set(MQ7_PHASE_HIGH, HAL_GetTick());
+}
 
 uint8_t mq7_init(void)
 {
     GPIO_InitTypeDef gpio_init_struct;
-    ADC_ChannelConfTypeDef adc_ch_conf;
     
-    __HAL_RCC_ADC1_CLK_ENABLE();
     __HAL_RCC_GPIOA_CLK_ENABLE();
     
     gpio_init_struct.Pin = GPIO_PIN_1;
@@ -15,71 +59,119 @@ uint8_t mq7_init(void)
     gpio_init_struct.Pull = GPIO_NOPULL;
     HAL_GPIO_Init(GPIOA, &gpio_init_struct);
     
-    g_adc_handle.Instance = ADC1;
-    g_adc_handle.Init.DataAlign = ADC_DATAALIGN_RIGHT;
-    g_adc_handle.Init.ScanConvMode = ADC_SCAN_DISABLE;
-    g_adc_handle.Init.ContinuousConvMode = DISABLE;
-    g_adc_handle.Init.NbrOfConversion = 1;
-    g_adc_handle.Init.DiscontinuousConvMode = DISABLE;
-    g_adc_handle.Init.NbrOfDiscConversion = 0;
-    g_adc_handle.Init.ExternalTrigConv = ADC_SOFTWARE_START;
-    HAL_ADC_Init(&g_adc_handle);
-    
-    adc_ch_conf.Channel = MQ7_ADC_CHANNEL;
-    adc_ch_conf.Rank = ADC_REGULAR_RANK_1;
-    adc_ch_conf.SamplingTime = ADC_SAMPLETIME_239CYCLES_5;
-    HAL_ADC_ConfigChannel(&g_adc_handle, &adc_ch_conf);
-    
-    HAL_ADCEx_Calibration_Start(&g_adc_handle);
-    
+    /* ADC由adc_init()统一配置, PA1在ADC1扫描序列中 */
+    mq7_heater_init();
     return 0;
 }
 
-uint16_t mq7_get_adc_value(void)
+/* 启动一次测量, 结果在当前(或下一个)低温阶段结束时得到 */
+uint8_t mq7_start(void)
 {
-    HAL_ADC_Start(&g_adc_handle);
-    HAL_ADC_PollForConversion(&g_adc_handle, 10);
-    
-    if (HAL_IS_BIT_SET(HAL_ADC_GetState(&g_adc_handle), HAL_ADC_STATE_REG_EOC))
+    if (g_mq7_status == MQ7_BUSY)
     {
-        return HAL_ADC_GetValue(&g_adc_handle);
+        return 1;
     }
     
+    g_mq7_status = MQ7_BUSY;
     return 0;
 }
 
-uint16_t mq7_get_adc_average(uint8_t times)
+/* 推进加热周期并查询测量状态, 需要周期调用
+ * 低温阶段结束时先取结果再切到高温, 此时最近一次过采样结果来自低温阶段最后4^ADC_OVS_BITS次转换(默认640ms)
+ */
+uint8_t mq7_poll(void)
 {
-    uint32_t temp_val = 0;
-    uint8_t t;
+    uint32_t now = HAL_GetTick();
+    uint32_t elapsed = now - g_mq7_phase_start;
     
-    for (t = 0; t < times; t++)
+    if (g_mq7_phase == MQ7_PHASE_HIGH)
+    {
+        if (elapsed >= MQ7_HEATER_HIGH_MS)
+        {
+            mq7_heater_set(MQ7_PHASE_LOW, now);
+        }
+    }
+    else if (elapsed >= MQ7_HEATER_LOW_MS)
     {
-        temp_val += mq7_get_adc_value();
-        delay_ms(5);
+        if (g_mq7_status == MQ7_BUSY)
+        {
+            g_mq7_co_x10 = mq7_ovs_to_ppm_x10(adc_get_oversampled(ADC_CH_MQ7));
+            g_mq7_status = MQ7_OK;
+        }
+        
+        mq7_heater_set(MQ7_PHASE_HIGH, now);
     }
     
-    return temp_val / times;
+    return g_mq7_status;
 }
 
-float mq7_get_co_ppm(void)
+/* 获取最近一次测量结果, 返回0成功, 1表示还没有结果 */
+uint8_t mq7_get_result(uint16_t *co_x10)
 {
-    float rs_r0, ppm;
-    uint16_t adc_value;
+    if (g_mq7_status != MQ7_OK)
+    {
+        return 1;
+    }
     
-    adc_value = mq7_get_adc_average(10);
+    *co_x10 = g_mq7_co_x10;
+    return 0;
+}
+
+uint8_t mq7_get_phase(void)
+{
+    return g_mq7_phase;
+}
+
+uint16_t mq7_get_adc_value(void)
+{
+    return adc_get_latest(ADC_CH_MQ7);
+}
+
+uint16_t mq7_get_adc_average(uint8_t times)
+{
+    /* 定时器每10ms触发一次转换, 直接取DMA缓冲区中最近times次的结果 */
+    return adc_get_average(ADC_CH_MQ7, times);
+}
+
+/* 查表换算CO浓度, 单位0.1ppm
+ * 曲线ppm = 98.322 * pow((4095 - adc) / adc, -1.458)由Tools/gen_curve_tables.py离线生成,
+ * 运行时只做一次整数线性插值, 不再调用软件浮点pow
+ */
+uint16_t mq7_adc_to_ppm_x10(uint16_t adc_value)
+{
+    if (adc_value > 4095) adc_value = 4095;
     
-    if (adc_value == 0) adc_value = 1;
+    return mq7_ovs_to_ppm_x10(adc_value << ADC_OVS_BITS);
+}
+
+/* 过采样ADC值(12 + ADC_OVS_BITS位)换算CO浓度, 单位0.1ppm
+ * 插值表仍按12位码值取点, 多出的ADC_OVS_BITS位并入插值的小数部分
+ */
+uint16_t mq7_ovs_to_ppm_x10(uint16_t ovs_value)
+{
+    uint16_t i, frac;
+    int32_t ppm_x10;
     
-    rs_r0 = (4095.0 - adc_value) / adc_value;
+    if (ovs_value > ADC_OVS_MAX) ovs_value = ADC_OVS_MAX;
     
-    // 修正的MQ-7一氧化碳浓度计算公式
-    // 根据MQ-7数据手册，CO浓度与Rs/R0的关系更接近于ppm = 98.322 * pow(rs_r0, -1.458)
-    ppm = 98.322 * pow(rs_r0, -1.458);
+    i = ovs_value >> (MQ7_CURVE_SHIFT + ADC_OVS_BITS);
+    frac = ovs_value & ((1 << (MQ7_CURVE_SHIFT + ADC_OVS_BITS)) - 1);
+    ppm_x10 = g_mq7_curve[i] + ((((int32_t)g_mq7_curve[i + 1] - g_mq7_curve[i]) * frac) >> (MQ7_CURVE_SHIFT + ADC_OVS_BITS));
     
     // 限制输出范围在10-1000ppm之间，这是MQ-7的典型测量范围
-    if (ppm < 10.0) ppm = 10.0;
-    if (ppm > 1000.0) ppm = 1000.0;
+    if (ppm_x10 < MQ7_CURVE_MIN) ppm_x10 = MQ7_CURVE_MIN;
+    if (ppm_x10 > MQ7_CURVE_MAX) ppm_x10 = MQ7_CURVE_MAX;
     
-    return ppm;
-}
\ No newline at end of file
+    return ppm_x10;
+}
+
+/* 立即读取当前CO浓度, 不考虑加热阶段, 正常测量应使用mq7_start/mq7_poll */
+uint16_t mq7_get_co_ppm_x10(void)
+{
+    return mq7_ovs_to_ppm_x10(adc_get_oversampled(ADC_CH_MQ7));
+}
+
+float mq7_get_co_ppm(void)
+{
+    return mq7_get_co_ppm_x10() / 10.0f;
+}
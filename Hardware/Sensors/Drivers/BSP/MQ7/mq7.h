@@ -3,13 +3,44 @@
 
 #include "./SYSTEM/sys/sys.h"
 #include "stm32f1xx_hal.h"
-#include <math.h>
+#include "./BSP/ADC/adc.h"
 
 #define MQ7_ADC_CHANNEL    ADC_CHANNEL_1
 
+/* 加热控制: TIM2_CH3(PA2)输出PWM, 经MOS管驱动加热丝 */
+#define MQ7_HEATER_TIMX                 TIM2
+#define MQ7_HEATER_TIMX_CLK_ENABLE()    do{ __HAL_RCC_TIM2_CLK_ENABLE(); }while(0)   /* TIM2 时钟使能 */
+#define MQ7_HEATER_TIMX_CHY             TIM_CHANNEL_3
+#define MQ7_HEATER_GPIO_PORT            GPIOA
+#define MQ7_HEATER_GPIO_PIN             GPIO_PIN_2
+#define MQ7_HEATER_GPIO_CLK_ENABLE()    do{ __HAL_RCC_GPIOA_CLK_ENABLE(); }while(0)  /* PA口时钟使能 */
+
+/* 加热周期(数据手册): 5V加热60s, 1.4V加热90s, 在低温阶段结束时读取CO浓度 */
+#define MQ7_HEATER_PWM_PERIOD   1000        /* PWM周期, 1MHz计数, 1kHz */
+#define MQ7_HEATER_HIGH_DUTY    1000        /* 高温阶段: 100%, 相当于5V */
+#define MQ7_HEATER_LOW_DUTY     78          /* 低温阶段: 1.4V有效值, (1.4 / 5)^2 = 7.8% */
+#define MQ7_HEATER_HIGH_MS      60000
+#define MQ7_HEATER_LOW_MS       90000
+
+/* 加热阶段 */
+#define MQ7_PHASE_HIGH          0
+#define MQ7_PHASE_LOW           1
+
+/* 测量状态 */
+#define MQ7_IDLE                0           /* 未开始 */
+#define MQ7_BUSY                1           /* 等待低温阶段结束 */
+#define MQ7_OK                  2           /* 已得到结果 */
+
 uint8_t mq7_init(void);
+uint8_t mq7_start(void);
+uint8_t mq7_poll(void);
+uint8_t mq7_get_result(uint16_t *co_x10);
+uint8_t mq7_get_phase(void);
 uint16_t mq7_get_adc_value(void);
 uint16_t mq7_get_adc_average(uint8_t times);
+uint16_t mq7_adc_to_ppm_x10(uint16_t adc_value);
+uint16_t mq7_ovs_to_ppm_x10(uint16_t ovs_value);
+uint16_t mq7_get_co_ppm_x10(void);
 float mq7_get_co_ppm(void);
 
 #endif
\ No newline at end of file
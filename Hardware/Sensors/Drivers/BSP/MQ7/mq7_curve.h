@@ -0,0 +1,39 @@
+/**
+ ****************************************************************************************************
+ * @file        mq7_curve.h
+ * @author      正点原子团队(ALIENTEK)
+ * @version     V1.0
+ * @date        2023-06-05
+ * @brief       MQ-7 ADC码值到CO浓度(0.1ppm)插值表
+ * @license     Copyright (c) 2020-2032, 广州市星翼电子科技有限公司
+ ****************************************************************************************************
+ * @attention
+ *
+ * 本文件由Tools/gen_curve_tables.py生成, 请勿手工修改.
+ * 公式: ppm = 98.322 * pow((4095 - adc) / adc, -1.458)
+ * 每64个ADC码值取一个点, 共65个点, 线性插值后与公式的误差不超过0.15或0.5%.
+ *
+ ****************************************************************************************************
+ */
+
+#ifndef __MQ7_CURVE_H
+#define __MQ7_CURVE_H
+
+#define MQ7_CURVE_SHIFT         6
+#define MQ7_CURVE_MIN           100
+#define MQ7_CURVE_MAX           10000
+
+static const uint16_t g_mq7_curve[65] =
+{
+         0,      2,      7,     12,     19,     27,     36,     46,
+        58,     70,     84,     99,    116,    134,    154,    175,
+       198,    223,    250,    280,    312,    346,    383,    423,
+       467,    514,    566,    621,    682,    748,    820,    898,
+       984,   1078,   1181,   1294,   1420,   1558,   1711,   1882,
+      2073,   2286,   2527,   2798,   3107,   3460,   3866,   4337,
+      4886,   5532,   6301,   7226,   8355,   9754,  11520,  13801,
+     16828,  20988,  26967,  36094,  51271,  65535,  65535,  65535,
+     65535
+};
+
+#endif
@@ -0,0 +1,178 @@
+/**
+ ****************************************************************************************************
+ * @file        pwr.c
+ * @author      正点原子团队(ALIENTEK)
+ * @version     V1.1
+ * @date        2023-06-05
+ * @brief       空闲低功耗(SLEEP)及功耗统计
+ * @license     Copyright (c) 2020-2032, 广州市星翼电子科技有限公司
+ ****************************************************************************************************
+ * @attention
+ *
+ * 实验平台:正点原子 STM32F103开发板
+ * 在线视频:www.yuanzige.com
+ * 技术论坛:www.openedv.com
+ * 公司网址:www.alientek.com
+ * 购买地址:openedv.taobao.com
+ *
+ * 修改说明
+ * V1.0 20230605
+ * 第一次发布
+ * V1.1 20230605
+ * 1, 去掉从未进入过的STOP模式(RTC闹钟唤醒), 只保留SLEEP
+ *
+ ****************************************************************************************************
+ */
+
+#include <string.h>
+#include "./BSP/PWR/pwr.h"
+#include "./SYSTEM/fmt/fmt.h"
+
+
+pwr_mode_stats_t g_pwr_stats[PWR_MODE_NUM];
+
+static uint32_t g_pwr_window_start = 0;         /* 统计窗口开始时间(ms) */
+
+/**
+ * @brief       记录一次唤醒延迟
+ * @param       st: 模式统计
+ * @param       ns: 延迟(ns)
+ * @retval      无
+ */
+static void pwr_record_wake(pwr_mode_stats_t *st, uint32_t ns)
+{
+    st->wake_sum_ns += ns;
+    st->wake_samples++;
+
+    if (ns > st->wake_max_ns)
+    {
+        st->wake_max_ns = ns;
+    }
+}
+
+/**
+ * @brief       初始化
+ * @param       无
+ * @retval      无
+ */
+void pwr_init(void)
+{
+    __HAL_RCC_PWR_CLK_ENABLE();
+    pwr_reset_stats();
+}
+
+/**
+ * @brief       进入SLEEP模式
+ * @note        在关中断(PRIMASK)状态下调用, 有中断挂起时WFI立即返回, 中断在开中断后执行.
+ *              时间和唤醒延迟由SysTick计数值计算: SysTick唤醒时, 重装后经过的周期数就是唤醒延迟
+ * @param       无
+ * @retval      无
+ */
+void pwr_enter_sleep(void)
+{
+    pwr_mode_stats_t *st = &g_pwr_stats[PWR_MODE_SLEEP];
+    uint32_t reload = SysTick->LOAD + 1;
+    uint32_t cycles_per_us = SystemCoreClock / 1000000;
+    uint32_t val0, val1, cycles;
+
+    if (SCB->ICSR & SCB_ICSR_PENDSTSET_Msk)
+    {
+        return;                                 /* 节拍已经到了, 先回去处理 */
+    }
+
+    val0 = SysTick->VAL;
+    HAL_PWR_EnterSLEEPMode(PWR_MAINREGULATOR_ON, PWR_SLEEPENTRY_WFI);
+    val1 = SysTick->VAL;
+
+    if (SCB->ICSR & SCB_ICSR_PENDSTSET_Msk)
+    {
+        cycles = val0 + (reload - val1);        /* 期间SysTick重装过一次 */
+        pwr_record_wake(st, (reload - val1) * 1000 / cycles_per_us);
+    }
+    else
+    {
+        cycles = val0 - val1;                   /* 其他中断唤醒 */
+    }
+
+    st->count++;
+    st->time_us += cycles / cycles_per_us;
+}
+
+/**
+ * @brief       输出各模式统计中的唤醒延迟, 格式" wake_xxx=平均/最大us"
+ * @param       p: 写入位置
+ * @param       name: 模式名
+ * @param       st: 模式统计
+ * @retval      指向结尾'\0'的指针
+ */
+static char *pwr_put_wake(char *p, const char *name, const pwr_mode_stats_t *st)
+{
+    uint32_t mean_ns = st->wake_samples ? st->wake_sum_ns / st->wake_samples : 0;
+
+    p = fmt_put_str(p, " wake_");
+    p = fmt_put_str(p, name);
+    p = fmt_put_str(p, "=");
+    p = fmt_put_x10(p, mean_ns / 100);
+    p = fmt_put_str(p, "/");
+    p = fmt_put_x10(p, st->wake_max_ns / 100);
+    return fmt_put_str(p, "us");
+}
+
+/**
+ * @brief       生成功耗报告
+ * @note        格式"PWR t=窗口ms run=x% sleep=x% avg=xmA wake_sleep=平均/最大us\r\n"
+ *              RUN时间 = 窗口 - SLEEP, 平均电流按PWR_xxx_UA加权
+ * @param       buf: 输出缓冲区, 至少PWR_REPORT_MAX字节
+ * @retval      长度
+ */
+uint16_t pwr_format_report(char *buf)
+{
+    static const char *const names[PWR_MODE_NUM] = {"run", "sleep"};
+    static const uint32_t current_ua[PWR_MODE_NUM] = {PWR_RUN_UA, PWR_SLEEP_UA};
+    uint32_t window_ms = HAL_GetTick() - g_pwr_window_start;
+    uint32_t idle_us = g_pwr_stats[PWR_MODE_SLEEP].time_us;
+    uint64_t charge = 0;
+    char *p = buf;
+    uint8_t i;
+
+    if (window_ms == 0)
+    {
+        window_ms = 1;
+    }
+
+    g_pwr_stats[PWR_MODE_RUN].time_us = window_ms * 1000 > idle_us ? window_ms * 1000 - idle_us : 0;
+
+    p = fmt_put_str(p, "PWR t=");
+    p = fmt_put_uint(p, window_ms);
+    p = fmt_put_str(p, "ms");
+
+    for (i = 0; i < PWR_MODE_NUM; i++)
+    {
+        p = fmt_put_str(p, " ");
+        p = fmt_put_str(p, names[i]);
+        p = fmt_put_str(p, "=");
+        p = fmt_put_x10(p, g_pwr_stats[i].time_us / window_ms);    /* us / (ms * 1000) * 1000 */
+        p = fmt_put_str(p, "%");
+        charge += (uint64_t)g_pwr_stats[i].time_us * current_ua[i];
+    }
+
+    p = fmt_put_str(p, " avg=");
+    p = fmt_put_x10(p, (uint32_t)(charge / window_ms / 1000 / 100));   /* uA -> 0.1mA */
+    p = fmt_put_str(p, "mA");
+
+    p = pwr_put_wake(p, names[PWR_MODE_SLEEP], &g_pwr_stats[PWR_MODE_SLEEP]);
+    p = fmt_put_str(p, "\r\n");
+
+    return p - buf;
+}
+
+/**
+ * @brief       清除统计, 开始新的统计窗口
+ * @param       无
+ * @retval      无
+ */
+void pwr_reset_stats(void)
+{
+    memset(g_pwr_stats, 0, sizeof(g_pwr_stats));
+    g_pwr_window_start = HAL_GetTick();
+}
@@ -0,0 +1,70 @@
+/**
+ ****************************************************************************************************
+ * @file        pwr.h
+ * @author      正点原子团队(ALIENTEK)
+ * @version     V1.1
+ * @date        2023-06-05
+ * @brief       空闲低功耗(SLEEP)及功耗统计
+ * @license     Copyright (c) 2020-2032, 广州市星翼电子科技有限公司
+ ****************************************************************************************************
+ * @attention
+ *
+ * 实验平台:正点原子 STM32F103开发板
+ * 在线视频:www.yuanzige.com
+ * 技术论坛:www.openedv.com
+ * 公司网址:www.alientek.com
+ * 购买地址:openedv.taobao.com
+ *
+ * 调度器没有就绪任务时进入SLEEP: WFI, 内核停止, 外设(TIM3触发ADC, DMA, 串口, MQ-7加热PWM)照常运行,
+ * SysTick每1ms唤醒. 不使用STOP模式:
+ *   - 10ms的传感器任务和20ms的USART3接收任务之间没有足够长的空闲, 进不了STOP
+ *   - STOP期间ADC采样和MQ-7加热PWM停止, 测量结果失真
+ *   - USART3接收停止, PB11所在的EXTI11已被DHT11(PG11)占用, ESP32发来的命令无法唤醒, 会丢失
+ * 平均电流按各模式的时间占比和PWR_xxx_UA估算, 只包含MCU, 不含LCD背光和传感器.
+ *
+ * 修改说明
+ * V1.0 20230605
+ * 第一次发布
+ * V1.1 20230605
+ * 1, 去掉从未进入过的STOP模式(RTC闹钟唤醒), 只保留SLEEP
+ *
+ ****************************************************************************************************
+ */
+
+#ifndef __PWR_H
+#define __PWR_H
+
+#include "./SYSTEM/sys/sys.h"
+
+
+#define PWR_REPORT_PERIOD_MS        60000       /* 功耗报告周期 */
+#define PWR_REPORT_MAX              128         /* 一条报告的最大长度 */
+
+/* MCU各模式电流典型值(uA), STM32F103xE数据手册, 72MHz, 使用的外设打开; 有实测值时替换 */
+#define PWR_RUN_UA                  50000
+#define PWR_SLEEP_UA                30000
+
+/* 模式 */
+#define PWR_MODE_RUN                0
+#define PWR_MODE_SLEEP              1
+#define PWR_MODE_NUM                2
+
+/* 各模式统计(RUN的时间由统计窗口减去其他模式得到) */
+typedef struct
+{
+    uint32_t count;             /* 进入次数 */
+    uint32_t time_us;           /* 累计时间 */
+    uint32_t wake_max_ns;       /* 唤醒源产生到恢复执行的最大延迟 */
+    uint32_t wake_sum_ns;       /* 唤醒延迟累计, 用于求平均 */
+    uint32_t wake_samples;      /* 唤醒延迟样本数 */
+} pwr_mode_stats_t;
+
+extern pwr_mode_stats_t g_pwr_stats[PWR_MODE_NUM];
+
+/* 函数声明 */
+void pwr_init(void);                                /* 初始化 */
+void pwr_enter_sleep(void);                         /* 进入SLEEP, 下一个中断唤醒 */
+uint16_t pwr_format_report(char *buf);              /* 生成功耗报告, 返回长度 */
+void pwr_reset_stats(void);                         /* 开始新的统计窗口 */
+
+#endif
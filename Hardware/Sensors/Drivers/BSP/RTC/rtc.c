@@ -0,0 +1,212 @@
+/**
+ ****************************************************************************************************
+ * @file        rtc.c
+ * @author      正点原子团队(ALIENTEK)
+ * @version     V1.2
+ * @date        2023-06-05
+ * @brief       RTC计数器(LSE, 1024Hz)及Unix时间
+ * @license     Copyright (c) 2020-2032, 广州市星翼电子科技有限公司
+ ****************************************************************************************************
+ * @attention
+ *
+ * 实验平台:正点原子 STM32F103开发板
+ * 在线视频:www.yuanzige.com
+ * 技术论坛:www.openedv.com
+ * 公司网址:www.alientek.com
+ * 购买地址:openedv.taobao.com
+ *
+ * 修改说明
+ * V1.0 20230605
+ * 第一次发布
+ * V1.1 20230605
+ * 1, 新增Unix时间(rtc_get_time/rtc_set_time)
+ * V1.2 20230605
+ * 1, 去掉闹钟唤醒(rtc_set_alarm/rtc_get_divider), 不再使用STOP模式, 见pwr.h
+ * V1.3 20230605
+ * 1, 新增启动号(rtc_get_boot_id)
+ *
+ ****************************************************************************************************
+ */
+
+#include "./BSP/RTC/rtc.h"
+
+
+static uint8_t g_rtc_ok = 0;                        /* 1: RTC在运行 */
+static uint16_t g_rtc_boot_id = 0;                  /* 本次启动的启动号 */
+
+/**
+ * @brief       进入配置模式
+ * @note        等待上一次写操作完成后置位CNF
+ */
+static void rtc_enter_config(void)
+{
+    while ((RTC->CRL & RTC_CRL_RTOFF) == 0);
+    RTC->CRL |= RTC_CRL_CNF;
+}
+
+/**
+ * @brief       退出配置模式并等待写入完成
+ */
+static void rtc_exit_config(void)
+{
+    RTC->CRL &= ~RTC_CRL_CNF;
+    while ((RTC->CRL & RTC_CRL_RTOFF) == 0);
+}
+
+/**
+ * @brief       等待寄存器同步
+ * @note        APB1复位后, 必须等RSF置位才能读到正确的计数器值
+ * @param       无
+ * @retval      无
+ */
+void rtc_wait_sync(void)
+{
+    RTC->CRL &= ~RTC_CRL_RSF;
+    while ((RTC->CRL & RTC_CRL_RSF) == 0);
+}
+
+/**
+ * @brief       初始化RTC
+ * @note        后备域已经配置过(有RTC_BKP_MARK)时只等待同步, 计数器继续运行;
+ *              启动号在LSE起振之前更新, LSE起振失败时也有效
+ * @param       无
+ * @retval      0, 成功; 1, LSE起振失败
+ */
+uint8_t rtc_init(void)
+{
+    RCC_OscInitTypeDef rcc_osc_init = {0};
+    RCC_PeriphCLKInitTypeDef rcc_periph_init = {0};
+
+    __HAL_RCC_PWR_CLK_ENABLE();
+    __HAL_RCC_BKP_CLK_ENABLE();
+    HAL_PWR_EnableBkUpAccess();
+
+    g_rtc_boot_id = (uint16_t)(RTC_BKP_BOOT + 1);
+
+    if (g_rtc_boot_id == 0)
+    {
+        g_rtc_boot_id = 1;                          /* 0表示未知 */
+    }
+
+    RTC_BKP_BOOT = g_rtc_boot_id;
+
+    if (RTC_BKP_MARK_REG != RTC_BKP_MARK)
+    {
+        rcc_osc_init.OscillatorType = RCC_OSCILLATORTYPE_LSE;
+        rcc_osc_init.LSEState = RCC_LSE_ON;
+        rcc_osc_init.PLL.PLLState = RCC_PLL_NONE;
+
+        if (HAL_RCC_OscConfig(&rcc_osc_init) != HAL_OK)
+        {
+            return 1;
+        }
+
+        rcc_periph_init.PeriphClockSelection = RCC_PERIPHCLK_RTC;
+        rcc_periph_init.RTCClockSelection = RCC_RTCCLKSOURCE_LSE;
+        HAL_RCCEx_PeriphCLKConfig(&rcc_periph_init);
+        __HAL_RCC_RTC_ENABLE();
+
+        rtc_wait_sync();
+        rtc_enter_config();
+        RTC->PRLH = 0;
+        RTC->PRLL = RTC_PRESCALER - 1;
+        RTC->CNTH = 0;
+        RTC->CNTL = 0;
+        rtc_exit_config();
+
+        RTC_BKP_MARK_REG = RTC_BKP_MARK;
+    }
+    else
+    {
+        rtc_wait_sync();
+    }
+
+    g_rtc_ok = 1;
+    return 0;
+}
+
+/**
+ * @brief       读取计数器
+ * @note        高低16位分两次读, 读低位期间高位变化时重读
+ * @param       无
+ * @retval      计数值(1/RTC_TICK_HZ秒)
+ */
+uint32_t rtc_get_counter(void)
+{
+    uint16_t high, low;
+
+    do
+    {
+        high = RTC->CNTH;
+        low = RTC->CNTL;
+    } while (high != RTC->CNTH);
+
+    return ((uint32_t)high << 16) | low;
+}
+
+/**
+ * @brief       写校时基准
+ * @param       unix_time: 基准时间
+ * @param       cnt: 基准时间对应的计数器值
+ * @retval      无
+ */
+static void rtc_write_base(uint32_t unix_time, uint32_t cnt)
+{
+    RTC_BKP_TIME_L = unix_time & 0xFFFF;
+    RTC_BKP_TIME_H = unix_time >> 16;
+    RTC_BKP_CNT_L = cnt & 0xFFFF;
+    RTC_BKP_CNT_H = cnt >> 16;
+}
+
+/**
+ * @brief       读取Unix时间
+ * @note        距基准超过计数器半程(约24天)时, 把整秒部分移入基准, 计数差始终不会回绕
+ * @param       无
+ * @retval      Unix时间(秒, UTC), 0表示RTC没有运行或还没有校时
+ */
+uint32_t rtc_get_time(void)
+{
+    uint32_t base, base_cnt, elapsed, secs;
+
+    base = ((uint32_t)RTC_BKP_TIME_H << 16) | RTC_BKP_TIME_L;
+
+    if (g_rtc_ok == 0 || base == 0)
+    {
+        return 0;
+    }
+
+    base_cnt = ((uint32_t)RTC_BKP_CNT_H << 16) | RTC_BKP_CNT_L;
+    elapsed = rtc_get_counter() - base_cnt;
+    secs = elapsed / RTC_TICK_HZ;
+
+    if (elapsed >= 0x80000000)
+    {
+        rtc_write_base(base + secs, base_cnt + secs * RTC_TICK_HZ);
+    }
+
+    return base + secs;
+}
+
+/**
+ * @brief       校时
+ * @note        只记录基准, 不修改计数器
+ * @param       unix_time: Unix时间(秒, UTC)
+ * @retval      无
+ */
+void rtc_set_time(uint32_t unix_time)
+{
+    if (g_rtc_ok)
+    {
+        rtc_write_base(unix_time, rtc_get_counter());
+    }
+}
+
+/**
+ * @brief       读取启动号
+ * @param       无
+ * @retval      启动号, 每次复位加1; 0表示rtc_init没有调用
+ */
+uint16_t rtc_get_boot_id(void)
+{
+    return g_rtc_boot_id;
+}
@@ -0,0 +1,70 @@
+/**
+ ****************************************************************************************************
+ * @file        rtc.h
+ * @author      正点原子团队(ALIENTEK)
+ * @version     V1.2
+ * @date        2023-06-05
+ * @brief       RTC计数器(LSE, 1024Hz)及Unix时间
+ * @license     Copyright (c) 2020-2032, 广州市星翼电子科技有限公司
+ ****************************************************************************************************
+ * @attention
+ *
+ * 实验平台:正点原子 STM32F103开发板
+ * 在线视频:www.yuanzige.com
+ * 技术论坛:www.openedv.com
+ * 公司网址:www.alientek.com
+ * 购买地址:openedv.taobao.com
+ *
+ * RTC时钟为LSE(32.768kHz), 预分频32, 计数器每秒RTC_TICK_HZ次, 约0.98ms一次,
+ * 计数器约48天回绕一次, 只用于求差.
+ * 绝对时间: ESP32校时时把Unix时间和当时的计数器值存入后备寄存器, 之后
+ *   时间 = 基准时间 + (计数器 - 基准计数) / RTC_TICK_HZ
+ * 有VBAT时复位后时间仍然有效; 距上次校时超过计数器半程时自动前移基准, 不受回绕影响.
+ * 启动号: 后备寄存器中的计数, rtc_init每次加1(跳过0), 后备域掉电后从1重新开始.
+ * 直接操作寄存器, 不依赖stm32f1xx_hal_rtc.c的日历接口.
+ *
+ * 修改说明
+ * V1.0 20230605
+ * 第一次发布
+ * V1.1 20230605
+ * 1, 新增Unix时间(rtc_get_time/rtc_set_time)
+ * V1.2 20230605
+ * 1, 去掉闹钟唤醒(rtc_set_alarm/rtc_get_divider), 不再使用STOP模式, 见pwr.h
+ * V1.3 20230605
+ * 1, 新增启动号(rtc_get_boot_id), 记录帧用它标识历史记录属于哪一次启动
+ *
+ ****************************************************************************************************
+ */
+
+#ifndef __RTC_H
+#define __RTC_H
+
+#include "./SYSTEM/sys/sys.h"
+
+
+#define RTC_LSE_HZ              32768
+#define RTC_PRESCALER           32                          /* LSE / 32 = 1024Hz */
+#define RTC_TICK_HZ             (RTC_LSE_HZ / RTC_PRESCALER)
+
+/* 后备寄存器标志, 用于判断RTC是否已经配置过(复位后不用重新等待LSE起振) */
+#define RTC_BKP_MARK_REG        (BKP->DR1)
+#define RTC_BKP_MARK            0x5051
+
+/* 校时基准: Unix时间(秒, UTC)和对应的计数器值, 各占两个16位后备寄存器; 基准时间为0表示未校时 */
+#define RTC_BKP_TIME_L          (BKP->DR2)
+#define RTC_BKP_TIME_H          (BKP->DR3)
+#define RTC_BKP_CNT_L           (BKP->DR4)
+#define RTC_BKP_CNT_H           (BKP->DR5)
+
+/* 启动号 */
+#define RTC_BKP_BOOT            (BKP->DR6)
+
+/* 函数声明 */
+uint8_t rtc_init(void);                                 /* 初始化RTC, 0成功, 1 LSE起振失败 */
+uint32_t rtc_get_counter(void);                         /* 读取计数器 */
+void rtc_wait_sync(void);                               /* 等待寄存器同步, APB1复位后读取前必须调用 */
+uint32_t rtc_get_time(void);                            /* 读取Unix时间(秒), 0表示未校时 */
+void rtc_set_time(uint32_t unix_time);                  /* 校时 */
+uint16_t rtc_get_boot_id(void);                         /* 读取启动号, 0表示rtc_init没有调用 */
+
+#endif
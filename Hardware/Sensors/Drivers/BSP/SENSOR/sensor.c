@@ -0,0 +1,227 @@
+/**
+ ****************************************************************************************************
+ * @file        sensor.c
+ * @author      正点原子团队(ALIENTEK)
+ * @version     V1.0
+ * @date        2023-06-05
+ * @brief       传感器统一接口(init/start/poll/result)及按传感器的采样调度
+ * @license     Copyright (c) 2020-2032, 广州市星翼电子科技有限公司
+ ****************************************************************************************************
+ * @attention
+ *
+ * 实验平台:正点原子 STM32F103开发板
+ * 在线视频:www.yuanzige.com
+ * 技术论坛:www.openedv.com
+ * 公司网址:www.alientek.com
+ * 购买地址:openedv.taobao.com
+ *
+ * 修改说明
+ * V1.0 20230605
+ * 第一次发布
+ *
+ ****************************************************************************************************
+ */
+
+#include "./BSP/SENSOR/sensor.h"
+#include "./BSP/DHT11/dht11.h"
+#include "./BSP/MQ7/mq7.h"
+#include "./BSP/GP2Y1014AU/gp2y1014au.h"
+#include "./BSP/RTC/rtc.h"
+#include "./SYSTEM/sched/sched.h"
+#include "./SYSTEM/prof/prof.h"
+
+
+sensor_stats_t g_sensor_stats[SENSOR_NUM];
+
+static sensor_sample_t g_sensor_sample;         /* 各传感器最近一次成功测量的结果, valid标出已有结果的字段 */
+
+/******************************************************************************************/
+/* DHT11: 异步读取, 约25ms完成 */
+
+static uint8_t sensor_dht11_poll(void)
+{
+    switch (dht11_poll())
+    {
+        case DHT11_OK:
+            return SENSOR_OK;
+
+        case DHT11_ERR_TIMEOUT:
+        case DHT11_ERR_CHECKSUM:
+            return SENSOR_ERR;
+
+        default:
+            return SENSOR_BUSY;
+    }
+}
+
+static void sensor_dht11_result(sensor_sample_t *sample)
+{
+    uint8_t temp, humi;
+
+    if (dht11_get_result(&temp, &humi) == 0)
+    {
+        sample->temperature = temp;
+        sample->humidity = humi;
+        sample->valid |= SENSOR_VALID_TEMP | SENSOR_VALID_HUMI;
+    }
+}
+
+/******************************************************************************************/
+/* GP2Y1014AU: 转换由TIM3硬件定时完成, 过采样结果默认每640ms更新, 启动后立即取最近一次结果 */
+
+static uint8_t sensor_dust_start(void)
+{
+    return 0;
+}
+
+static uint8_t sensor_dust_poll(void)
+{
+    return adc_get_oversampled_count() ? SENSOR_OK : SENSOR_BUSY;  /* 上电后第一个结果出来之前 */
+}
+
+static void sensor_dust_result(sensor_sample_t *sample)
+{
+    sample->dust_x10 = gp2y1014au_get_dust_density_x10();
+    sample->valid |= SENSOR_VALID_DUST;
+}
+
+/******************************************************************************************/
+/* MQ-7: 结果在低温阶段结束时得到 */
+
+static uint8_t sensor_mq7_poll(void)
+{
+    return mq7_poll() == MQ7_OK ? SENSOR_OK : SENSOR_BUSY;
+}
+
+static void sensor_mq7_result(sensor_sample_t *sample)
+{
+    if (mq7_get_result(&sample->co_x10) == 0)
+    {
+        sample->valid |= SENSOR_VALID_CO;
+    }
+}
+
+/******************************************************************************************/
+
+/* 驱动表, 顺序与SENSOR_xxx编号一致
+ * DHT11的上电检测带复位重试, 由main在启动时单独完成, 这里不再初始化
+ */
+static const sensor_driver_t g_sensor_drivers[SENSOR_NUM] =
+{
+    {"dht11", 1000, 0,               dht11_start,       sensor_dht11_poll, sensor_dht11_result},
+    {"dust",  1000, gp2y1014au_init, sensor_dust_start, sensor_dust_poll,  sensor_dust_result},
+    {"mq7",   0,    mq7_init,        mq7_start,         sensor_mq7_poll,   sensor_mq7_result},
+};
+
+/**
+ * @brief       初始化所有传感器
+ * @note        需要在adc_init之前调用
+ * @param       无
+ * @retval      初始化失败的传感器位图, bit n对应SENSOR_xxx编号n
+ */
+uint8_t sensor_init(void)
+{
+    uint8_t fail = 0;
+    uint8_t i;
+
+    g_sensor_sample.valid = SENSOR_VALID_FLAGS;     /* 第一次出结果之前各字段为0, 不是测量值 */
+
+    for (i = 0; i < SENSOR_NUM; i++)
+    {
+        g_sensor_stats[i].state = SENSOR_IDLE;
+        g_sensor_stats[i].next_start = HAL_GetTick();
+
+        if (g_sensor_drivers[i].init && g_sensor_drivers[i].init())
+        {
+            fail |= 1 << i;
+        }
+    }
+
+    return fail;
+}
+
+/**
+ * @brief       传感器服务
+ * @note        每SENSOR_SERVICE_PERIOD_MS调用一次; 到期的传感器start, 测量中的传感器poll,
+ *              得到结果后写入样本. 启动时刻按固定周期推进, 不随服务调用的抖动漂移
+ * @param       无
+ * @retval      无
+ */
+void sensor_service(void)
+{
+    const sensor_driver_t *drv;
+    sensor_stats_t *st;
+    uint32_t now = HAL_GetTick();
+    uint32_t t0, elapsed;
+    uint8_t ret;
+    uint8_t i;
+
+    PROF_START(PROF_ZONE_SENSOR);
+
+    for (i = 0; i < SENSOR_NUM; i++)
+    {
+        drv = &g_sensor_drivers[i];
+        st = &g_sensor_stats[i];
+
+        if (st->state != SENSOR_BUSY && (int32_t)(now - st->next_start) < 0)
+        {
+            continue;                           /* 未到期, 不访问传感器 */
+        }
+
+        t0 = sched_time_us();
+
+        if (st->state != SENSOR_BUSY)
+        {
+            if (drv->start())
+            {
+                continue;                       /* 传感器忙, 下次再试 */
+            }
+
+            st->state = SENSOR_BUSY;
+            st->starts++;
+            st->next_start += drv->period_ms;
+
+            if ((int32_t)(now - st->next_start) >= 0)
+            {
+                st->next_start = now + drv->period_ms;  /* 落后超过一个周期, 重新对齐 */
+            }
+        }
+
+        ret = drv->poll();
+
+        if (ret == SENSOR_OK)
+        {
+            drv->result(&g_sensor_sample);
+            g_sensor_sample.timestamp = rtc_get_time();     /* 采集时刻打时间戳, 不受后续发送延迟影响 */
+            st->state = SENSOR_OK;
+            st->ok++;
+        }
+        else if (ret == SENSOR_ERR)
+        {
+            st->state = SENSOR_ERR;
+            st->errors++;
+        }
+
+        elapsed = sched_time_us() - t0;
+        st->cpu_us += elapsed;
+
+        if (elapsed > st->cpu_max_us)
+        {
+            st->cpu_max_us = elapsed;
+        }
+    }
+
+    PROF_STOP(PROF_ZONE_SENSOR);
+}
+
+/**
+ * @brief       获取传感器样本
+ * @note        各字段是对应传感器最近一次成功测量的结果, 测量失败时保持旧值;
+ *              valid中没有置位的字段还没有测量过, 值为0
+ * @param       无
+ * @retval      样本指针
+ */
+const sensor_sample_t *sensor_get_sample(void)
+{
+    return &g_sensor_sample;
+}
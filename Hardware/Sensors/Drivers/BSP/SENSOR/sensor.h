@@ -0,0 +1,84 @@
+/**
+ ****************************************************************************************************
+ * @file        sensor.h
+ * @author      正点原子团队(ALIENTEK)
+ * @version     V1.0
+ * @date        2023-06-05
+ * @brief       传感器统一接口(init/start/poll/result)及按传感器的采样调度
+ * @license     Copyright (c) 2020-2032, 广州市星翼电子科技有限公司
+ ****************************************************************************************************
+ * @attention
+ *
+ * 实验平台:正点原子 STM32F103开发板
+ * 在线视频:www.yuanzige.com
+ * 技术论坛:www.openedv.com
+ * 公司网址:www.alientek.com
+ * 购买地址:openedv.taobao.com
+ *
+ * 各传感器的采样策略:
+ *   DHT11       每1000ms启动一次异步读取(器件最高1Hz)
+ *   GP2Y1014AU  每1000ms取一次ADC缓冲区平均值(LED脉冲和转换由TIM3硬件完成)
+ *   MQ-7        跟随60s高温/90s低温加热周期, 只在低温阶段结束时采样, 每150s一个结果
+ * sensor_service需要周期调用(SENSOR_SERVICE_PERIOD_MS), 每个传感器到期时start, 之后poll直到有结果.
+ * g_sensor_stats记录每个传感器的启动/成功/失败次数和在驱动中花费的CPU时间,
+ * 用于和原来每100ms读取全部传感器的方式对比.
+ *
+ * 修改说明
+ * V1.0 20230605
+ * 第一次发布
+ *
+ ****************************************************************************************************
+ */
+
+#ifndef __SENSOR_H
+#define __SENSOR_H
+
+#include "./SYSTEM/sys/sys.h"
+#include "./BSP/SENSOR_UART/sensor_frame.h"
+
+
+#define SENSOR_SERVICE_PERIOD_MS    10          /* sensor_service调用周期 */
+
+/* 传感器编号 */
+#define SENSOR_DHT11                0
+#define SENSOR_DUST                 1
+#define SENSOR_MQ7                  2
+#define SENSOR_NUM                  3
+
+/* 测量状态 */
+#define SENSOR_IDLE                 0           /* 未开始 */
+#define SENSOR_BUSY                 1           /* 测量中 */
+#define SENSOR_OK                   2           /* 得到结果 */
+#define SENSOR_ERR                  3           /* 测量失败 */
+
+/* 传感器驱动接口 */
+typedef struct
+{
+    const char *name;
+    uint32_t period_ms;                         /* 两次测量的间隔, 0表示得到结果后立即开始下一次 */
+    uint8_t (*init)(void);                      /* 初始化, 返回0成功; 可以为空 */
+    uint8_t (*start)(void);                     /* 启动一次测量, 返回0成功 */
+    uint8_t (*poll)(void);                      /* 查询状态: SENSOR_BUSY / SENSOR_OK / SENSOR_ERR */
+    void (*result)(sensor_sample_t *sample);    /* 把结果写入样本中对应的字段 */
+} sensor_driver_t;
+
+/* 各传感器的运行状态和统计 */
+typedef struct
+{
+    uint8_t state;                              /* SENSOR_IDLE / BUSY / OK / ERR */
+    uint32_t next_start;                        /* 下一次启动时间(ms) */
+    uint32_t starts;                            /* 启动次数 */
+    uint32_t ok;                                /* 成功次数 */
+    uint32_t errors;                            /* 失败次数 */
+    uint32_t cpu_us;                            /* 在start/poll/result中花费的总时间 */
+    uint32_t cpu_max_us;                        /* 单次调用的最长时间 */
+} sensor_stats_t;
+
+extern sensor_stats_t g_sensor_stats[SENSOR_NUM];
+
+/* 函数声明 */
+uint8_t sensor_init(void);                                  /* 初始化所有传感器, 返回失败传感器的位图 */
+void sensor_service(void);                                  /* 按各传感器的周期启动测量并收集结果 */
+const sensor_sample_t *sensor_get_sample(void);             /* 各传感器最近一次成功测量组成的样本, valid标出已有结果的字段 */
+
+#endif
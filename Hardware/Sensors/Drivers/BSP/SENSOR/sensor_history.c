@@ -0,0 +1,79 @@
+/**
+ ****************************************************************************************************
+ * @file        sensor_history.c
+ * @author      正点原子团队(ALIENTEK)
+ * @version     V1.0
+ * @date        2023-06-05
+ * @brief       SRAM中的样本历史环形缓冲区, 供ESP32断线/重启后补传
+ * @license     Copyright (c) 2020-2032, 广州市星翼电子科技有限公司
+ ****************************************************************************************************
+ * @attention
+ *
+ * 实验平台:正点原子 STM32F103开发板
+ * 在线视频:www.yuanzige.com
+ * 技术论坛:www.openedv.com
+ * 公司网址:www.alientek.com
+ * 购买地址:openedv.taobao.com
+ *
+ * 修改说明
+ * V1.0 20230605
+ * 第一次发布
+ *
+ ****************************************************************************************************
+ */
+
+#include "./BSP/SENSOR/sensor_history.h"
+
+
+static sensor_sample_t g_history[SENSOR_HISTORY_DEPTH];
+static uint16_t g_history_head = 0;             /* 下一条记录的位置 */
+static uint16_t g_history_count = 0;            /* 现有记录数 */
+static uint16_t g_history_seq = 0;              /* 下一条记录的序号 */
+
+/**
+ * @brief       记录一个样本
+ * @param       sample: 样本
+ * @retval      记录序号
+ */
+uint16_t sensor_history_add(const sensor_sample_t *sample)
+{
+    g_history[g_history_head] = *sample;
+    g_history_head = (g_history_head + 1) % SENSOR_HISTORY_DEPTH;
+
+    if (g_history_count < SENSOR_HISTORY_DEPTH)
+    {
+        g_history_count++;
+    }
+
+    return g_history_seq++;
+}
+
+/**
+ * @brief       按序号读取记录
+ * @note        最新记录的序号为g_history_seq - 1, 与它的距离即在环形缓冲区中往回数的条数
+ * @param       seq: 记录序号
+ * @param       sample: 输出
+ * @retval      0, 成功; 1, 已被覆盖或还没有产生
+ */
+uint8_t sensor_history_get(uint16_t seq, sensor_sample_t *sample)
+{
+    uint16_t back = (uint16_t)(g_history_seq - 1 - seq);   /* 比最新记录早几条 */
+
+    if (back >= g_history_count)
+    {
+        return 1;
+    }
+
+    *sample = g_history[(g_history_head + SENSOR_HISTORY_DEPTH - 1 - back) % SENSOR_HISTORY_DEPTH];
+    return 0;
+}
+
+/**
+ * @brief       现有记录数
+ * @param       无
+ * @retval      记录数
+ */
+uint16_t sensor_history_count(void)
+{
+    return g_history_count;
+}
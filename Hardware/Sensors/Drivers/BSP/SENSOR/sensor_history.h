@@ -0,0 +1,46 @@
+/**
+ ****************************************************************************************************
+ * @file        sensor_history.h
+ * @author      正点原子团队(ALIENTEK)
+ * @version     V1.0
+ * @date        2023-06-05
+ * @brief       SRAM中的样本历史环形缓冲区, 供ESP32断线/重启后补传
+ * @license     Copyright (c) 2020-2032, 广州市星翼电子科技有限公司
+ ****************************************************************************************************
+ * @attention
+ *
+ * 实验平台:正点原子 STM32F103开发板
+ * 在线视频:www.yuanzige.com
+ * 技术论坛:www.openedv.com
+ * 公司网址:www.alientek.com
+ * 购买地址:openedv.taobao.com
+ *
+ * 每SENSOR_HISTORY_PERIOD_MS记录一个定点样本(12字节, 含RTC时间戳), 记录序号16位递增.
+ * 缓冲区满后覆盖最旧的记录, 2880条 * 5s = 4小时, 约34KB.
+ * 新记录同时以记录帧(SENSOR_FRAME_TYPE_RECORD)发给ESP32, ESP32按序号发现缺口后
+ * 发补传请求帧, 由sensor_uart3按发送队列空闲情况逐条回送.
+ * 历史在SRAM中, MCU复位后清空, 序号从0重新开始.
+ *
+ * 修改说明
+ * V1.0 20230605
+ * 第一次发布
+ *
+ ****************************************************************************************************
+ */
+
+#ifndef __SENSOR_HISTORY_H
+#define __SENSOR_HISTORY_H
+
+#include "./SYSTEM/sys/sys.h"
+#include "./BSP/SENSOR_UART/sensor_frame.h"
+
+
+#define SENSOR_HISTORY_PERIOD_MS    5000        /* 记录间隔 */
+#define SENSOR_HISTORY_DEPTH        2880        /* 记录条数, 4小时; 必须小于32768 */
+
+/* 函数声明 */
+uint16_t sensor_history_add(const sensor_sample_t *sample);             /* 记录一个样本, 返回记录序号 */
+uint8_t sensor_history_get(uint16_t seq, sensor_sample_t *sample);      /* 按序号读取, 0成功, 1已被覆盖或还没有 */
+uint16_t sensor_history_count(void);                                    /* 现有记录数 */
+
+#endif
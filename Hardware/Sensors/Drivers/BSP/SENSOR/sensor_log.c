@@ -0,0 +1,416 @@
+/**
+ ****************************************************************************************************
+ * @file        sensor_log.c
+ * @author      正点原子团队(ALIENTEK)
+ * @version     V1.0
+ * @date        2023-06-05
+ * @brief       SPI NOR FLASH上的追加式样本日志, 掉电不丢, 磨损均衡
+ * @license     Copyright (c) 2020-2032, 广州市星翼电子科技有限公司
+ ****************************************************************************************************
+ * @attention
+ *
+ * 实验平台:正点原子 STM32F103开发板
+ * 在线视频:www.yuanzige.com
+ * 技术论坛:www.openedv.com
+ * 公司网址:www.alientek.com
+ * 购买地址:openedv.taobao.com
+ *
+ * 修改说明
+ * V1.0 20230605
+ * 第一次发布
+ *
+ ****************************************************************************************************
+ */
+
+#include <string.h>
+#include "./BSP/SENSOR/sensor_log.h"
+#include "./BSP/NORFLASH/norflash.h"
+
+
+sensor_log_stats_t g_sensor_log_stats;
+
+static uint32_t g_log_head_sector = 0;          /* 正在写的扇区(日志区内的编号) */
+static uint32_t g_log_head_seq = 0;             /* 正在写的扇区序号, 0表示日志为空 */
+static uint16_t g_log_head_used = 0;            /* 正在写的扇区已用的记录位置 */
+static uint32_t g_log_first_seq = 1;            /* 最旧的有效扇区序号 */
+static uint32_t g_log_head_erase_count = 0;     /* 正在写的扇区的擦除次数, 下一个扇区头损坏时用它估计 */
+static uint32_t g_log_next_erase_count = 0;     /* 下一个扇区擦除后的擦除次数 */
+static uint8_t g_log_next_erased = 0;           /* 1: 下一个扇区已擦除, 可以直接写扇区头 */
+static uint8_t g_log_erasing = 0;               /* 1: 下一个扇区正在后台擦除 */
+
+/**
+ * @brief       小端读写
+ */
+static void log_put_u16(uint8_t *p, uint16_t v)
+{
+    p[0] = v & 0xFF;
+    p[1] = v >> 8;
+}
+
+static void log_put_u32(uint8_t *p, uint32_t v)
+{
+    log_put_u16(p, v & 0xFFFF);
+    log_put_u16(p + 2, v >> 16);
+}
+
+static uint16_t log_get_u16(const uint8_t *p)
+{
+    return p[0] | ((uint16_t)p[1] << 8);
+}
+
+static uint32_t log_get_u32(const uint8_t *p)
+{
+    return log_get_u16(p) | ((uint32_t)log_get_u16(p + 2) << 16);
+}
+
+/**
+ * @brief       扇区内某个位置的FLASH地址
+ * @param       sector: 日志区内的扇区编号
+ * @param       offset: 扇区内偏移
+ * @retval      地址
+ */
+static uint32_t log_addr(uint32_t sector, uint16_t offset)
+{
+    return (SENSOR_LOG_BASE_SECTOR + sector) * NORFLASH_SECTOR_SIZE + offset;
+}
+
+/**
+ * @brief       记录位置的扇区内偏移
+ */
+static uint16_t log_slot_offset(uint16_t slot)
+{
+    return SENSOR_LOG_HEADER_SIZE + slot * SENSOR_LOG_RECORD_SIZE;
+}
+
+/**
+ * @brief       等待后台擦除结束
+ * @note        擦除期间FLASH不能读写, 每次访问前调用
+ * @param       无
+ * @retval      无
+ */
+static void log_wait_idle(void)
+{
+    if (g_log_erasing)
+    {
+        while (norflash_busy());
+
+        g_log_erasing = 0;
+        g_log_next_erased = 1;
+    }
+}
+
+/**
+ * @brief       读扇区头
+ * @param       sector: 日志区内的扇区编号
+ * @param       seq: 扇区序号
+ * @param       erase_count: 擦除次数
+ * @retval      0, 有效; 1, 空闲或损坏
+ */
+static uint8_t log_read_header(uint32_t sector, uint32_t *seq, uint32_t *erase_count)
+{
+    uint8_t buf[SENSOR_LOG_HEADER_SIZE];
+
+    norflash_read(buf, log_addr(sector, 0), sizeof(buf));
+
+    if (log_get_u32(buf) != SENSOR_LOG_MAGIC ||
+        sensor_frame_crc16(buf, SENSOR_LOG_HEADER_SIZE - 2) != log_get_u16(buf + SENSOR_LOG_HEADER_SIZE - 2))
+    {
+        return 1;
+    }
+
+    *seq = log_get_u32(buf + 4);
+    *erase_count = log_get_u32(buf + 8);
+    return 0;
+}
+
+/**
+ * @brief       记录位置是否已被使用(不全为0xFF, 包括写了一半的记录)
+ * @param       slot: 正在写的扇区内的位置
+ * @retval      1, 已使用; 0, 空闲
+ */
+static uint8_t log_slot_used(uint16_t slot)
+{
+    uint8_t buf[SENSOR_LOG_RECORD_SIZE];
+    uint8_t i;
+
+    norflash_read(buf, log_addr(g_log_head_sector, log_slot_offset(slot)), sizeof(buf));
+
+    for (i = 0; i < sizeof(buf); i++)
+    {
+        if (buf[i] != 0xFF)
+        {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * @brief       读下一个扇区的擦除次数, 并在后台开始擦除
+ * @note        下一个扇区存放最旧的数据, 开始擦除前先把它移出有效范围
+ * @param       无
+ * @retval      无
+ */
+static void log_start_pre_erase(void)
+{
+    uint32_t next = (g_log_head_sector + 1) % SENSOR_LOG_SECTORS;
+    uint32_t seq, count;
+
+    if (log_read_header(next, &seq, &count))
+    {
+        /* 从未使用或头已损坏: 环形写入时相邻扇区的擦除次数最多差1, 按比当前扇区少一次估计 */
+        count = g_log_head_erase_count ? g_log_head_erase_count - 1 : 0;
+    }
+
+    g_log_next_erase_count = count + 1;
+    g_log_next_erased = 0;
+
+    norflash_erase_sector_start(SENSOR_LOG_BASE_SECTOR + next);
+    g_log_erasing = 1;
+    g_sensor_log_stats.erases++;
+}
+
+/**
+ * @brief       打开下一个扇区: 确保已擦除, 写扇区头
+ * @note        再下一个扇区的预擦除由调用者在写完本次记录后开始, 本次追加不用等它
+ * @param       无
+ * @retval      无
+ */
+static void log_open_next(void)
+{
+    uint8_t buf[SENSOR_LOG_HEADER_SIZE];
+    uint32_t next = (g_log_head_sector + 1) % SENSOR_LOG_SECTORS;
+
+    if (g_log_next_erased == 0)
+    {
+        /* 刚挂载, 或上次预擦除前掉电: 同步擦除 */
+        log_start_pre_erase();
+        log_wait_idle();
+    }
+
+    g_log_head_sector = next;
+    g_log_head_seq++;
+    g_log_head_used = 0;
+
+    log_put_u32(buf, SENSOR_LOG_MAGIC);
+    log_put_u32(buf + 4, g_log_head_seq);
+    log_put_u32(buf + 8, g_log_next_erase_count);
+    log_put_u16(buf + 12, 0xFFFF);
+    log_put_u16(buf + 14, sensor_frame_crc16(buf, SENSOR_LOG_HEADER_SIZE - 2));
+    norflash_write_page(buf, log_addr(next, 0), sizeof(buf));
+
+    g_log_head_erase_count = g_log_next_erase_count;
+
+    /* 有效范围最多SENSOR_LOG_SECTORS - 1个扇区, 下一个扇区马上要擦除 */
+    if (g_log_head_seq - g_log_first_seq > SENSOR_LOG_SECTORS - 2)
+    {
+        g_log_first_seq = g_log_head_seq - (SENSOR_LOG_SECTORS - 2);
+    }
+}
+
+/**
+ * @brief       挂载日志
+ * @note        第一遍读全部扇区头找出序号最大的扇区; 第二遍从它往回走, 序号连续的扇区构成有效范围;
+ *              最后在最新扇区内二分查找第一个全0xFF的位置. 已使用的位置总是前缀, 二分查找成立
+ * @param       无
+ * @retval      无
+ */
+void sensor_log_mount(void)
+{
+    uint32_t seq, count;
+    uint32_t best_seq = 0;
+    uint32_t best_sector = 0;
+    uint32_t sector, i;
+    uint16_t lo, hi, mid;
+
+    memset(&g_sensor_log_stats, 0, sizeof(g_sensor_log_stats));
+    g_sensor_log_stats.erase_min = 0xFFFFFFFF;
+    g_log_head_erase_count = 0;
+    g_log_erasing = 0;
+    g_log_next_erased = 0;
+
+    for (sector = 0; sector < SENSOR_LOG_SECTORS; sector++)
+    {
+        if (log_read_header(sector, &seq, &count))
+        {
+            continue;
+        }
+
+        if (seq > best_seq)
+        {
+            best_seq = seq;
+            best_sector = sector;
+            g_log_head_erase_count = count;
+        }
+
+        if (count > g_sensor_log_stats.erase_max)
+        {
+            g_sensor_log_stats.erase_max = count;
+        }
+
+        if (count < g_sensor_log_stats.erase_min)
+        {
+            g_sensor_log_stats.erase_min = count;
+        }
+    }
+
+    if (best_seq == 0)
+    {
+        /* 空日志: 第一次追加时打开0号扇区, 序号为1 */
+        g_sensor_log_stats.erase_min = 0;
+        g_log_head_sector = SENSOR_LOG_SECTORS - 1;
+        g_log_head_seq = 0;
+        g_log_head_used = SENSOR_LOG_SLOTS;
+        g_log_first_seq = 1;
+        return;
+    }
+
+    g_log_head_sector = best_sector;
+    g_log_head_seq = best_seq;
+
+    for (i = 1; i < SENSOR_LOG_SECTORS - 1 && i < best_seq; i++)
+    {
+        sector = (best_sector + SENSOR_LOG_SECTORS - i) % SENSOR_LOG_SECTORS;
+
+        if (log_read_header(sector, &seq, &count) || seq != best_seq - i)
+        {
+            break;
+        }
+    }
+
+    g_log_first_seq = best_seq - i + 1;
+
+    lo = 0;
+    hi = SENSOR_LOG_SLOTS;
+
+    while (lo < hi)
+    {
+        mid = (lo + hi) / 2;
+
+        if (log_slot_used(mid))
+        {
+            lo = mid + 1;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+
+    g_log_head_used = lo;
+}
+
+/**
+ * @brief       追加一条记录
+ * @note        扇区写满时打开下一个扇区; 下一个扇区已在后台擦除完, 正常情况下不需要等待擦除.
+ *              打开扇区后先写记录再开始预擦除再下一个扇区, 擦除在两次追加之间完成
+ *              (只有挂载后第一次打开扇区需要同步擦除)
+ * @param       sample: 样本
+ * @retval      SENSOR_LOG_OK / SENSOR_LOG_ERR_WRITE
+ */
+uint8_t sensor_log_append(const sensor_sample_t *sample)
+{
+    uint8_t rec[SENSOR_LOG_RECORD_SIZE];
+    uint8_t chk[SENSOR_LOG_RECORD_SIZE];
+    uint8_t opened = 0;
+    uint32_t addr;
+
+    log_wait_idle();
+
+    if (g_log_head_used >= SENSOR_LOG_SLOTS)
+    {
+        log_open_next();
+        opened = 1;
+    }
+
+    rec[0] = (uint8_t)sample->temperature;
+    rec[1] = sample->humidity;
+    log_put_u16(rec + 2, sample->co_x10);
+    log_put_u16(rec + 4, sample->dust_x10);
+    rec[6] = sample->alarm_mask;
+    rec[7] = sample->valid;
+    log_put_u32(rec + 8, sample->timestamp);
+    log_put_u16(rec + 12, (uint16_t)sensor_log_end());
+    log_put_u16(rec + 14, sensor_frame_crc16(rec, SENSOR_LOG_RECORD_SIZE - 2));
+
+    addr = log_addr(g_log_head_sector, log_slot_offset(g_log_head_used));
+    norflash_write_page(rec, addr, sizeof(rec));
+    g_log_head_used++;                          /* 失败也占用这个位置, NOR不能原地重写 */
+
+    norflash_read(chk, addr, sizeof(chk));
+
+    if (opened)
+    {
+        log_start_pre_erase();
+    }
+
+    if (memcmp(rec, chk, sizeof(rec)) != 0)
+    {
+        g_sensor_log_stats.write_errors++;
+        return SENSOR_LOG_ERR_WRITE;
+    }
+
+    g_sensor_log_stats.appended++;
+    return SENSOR_LOG_OK;
+}
+
+/**
+ * @brief       按记录号读取
+ * @param       index: 记录号, sensor_log_first() ~ sensor_log_end() - 1
+ * @param       sample: 输出
+ * @retval      SENSOR_LOG_OK / SENSOR_LOG_ERR_EMPTY / SENSOR_LOG_ERR_CRC
+ */
+uint8_t sensor_log_read(uint32_t index, sensor_sample_t *sample)
+{
+    uint8_t rec[SENSOR_LOG_RECORD_SIZE];
+    uint32_t seq = index / SENSOR_LOG_SLOTS;
+    uint16_t slot = index % SENSOR_LOG_SLOTS;
+    uint32_t sector;
+
+    if (index < sensor_log_first() || index >= sensor_log_end())
+    {
+        return SENSOR_LOG_ERR_EMPTY;
+    }
+
+    log_wait_idle();
+
+    sector = (g_log_head_sector + SENSOR_LOG_SECTORS - (g_log_head_seq - seq)) % SENSOR_LOG_SECTORS;
+    norflash_read(rec, log_addr(sector, log_slot_offset(slot)), sizeof(rec));
+
+    if (sensor_frame_crc16(rec, SENSOR_LOG_RECORD_SIZE - 2) != log_get_u16(rec + 14) ||
+        log_get_u16(rec + 12) != (uint16_t)index)
+    {
+        g_sensor_log_stats.crc_errors++;
+        return SENSOR_LOG_ERR_CRC;
+    }
+
+    sample->temperature = (int8_t)rec[0];
+    sample->humidity = rec[1];
+    sample->co_x10 = log_get_u16(rec + 2);
+    sample->dust_x10 = log_get_u16(rec + 4);
+    sample->alarm_mask = rec[6];
+    sample->valid = rec[7] & SENSOR_VALID_FLAGS ? rec[7] : SENSOR_VALID_FLAGS | SENSOR_VALID_ALL;  /* 旧记录没有测量标志 */
+    sample->timestamp = log_get_u32(rec + 8);
+    return SENSOR_LOG_OK;
+}
+
+/**
+ * @brief       最旧记录的记录号
+ * @param       无
+ * @retval      记录号, 日志为空时等于sensor_log_end()
+ */
+uint32_t sensor_log_first(void)
+{
+    return g_log_first_seq * SENSOR_LOG_SLOTS;
+}
+
+/**
+ * @brief       下一条记录的记录号
+ * @param       无
+ * @retval      记录号
+ */
+uint32_t sensor_log_end(void)
+{
+    return g_log_head_seq * SENSOR_LOG_SLOTS + g_log_head_used;
+}
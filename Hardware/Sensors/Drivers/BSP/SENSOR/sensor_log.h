@@ -0,0 +1,87 @@
+/**
+ ****************************************************************************************************
+ * @file        sensor_log.h
+ * @author      正点原子团队(ALIENTEK)
+ * @version     V1.0
+ * @date        2023-06-05
+ * @brief       SPI NOR FLASH上的追加式样本日志, 掉电不丢, 磨损均衡
+ * @license     Copyright (c) 2020-2032, 广州市星翼电子科技有限公司
+ ****************************************************************************************************
+ * @attention
+ *
+ * 实验平台:正点原子 STM32F103开发板
+ * 在线视频:www.yuanzige.com
+ * 技术论坛:www.openedv.com
+ * 公司网址:www.alientek.com
+ * 购买地址:openedv.taobao.com
+ *
+ * 日志区由SENSOR_LOG_SECTORS个4KB扇区组成一个环, 只追加写, 写满后擦除最旧的扇区继续,
+ * 每个扇区每圈只擦除一次, 擦写次数天然均衡. 扇区格式(多字节字段均为小端):
+ *   扇区头 16B: [魔数 uint32][扇区序号 uint32][擦除次数 uint32][保留 0xFFFF][CRC16]
+ *   记录   16B: [样本 12B, 与样本帧负载相同][记录号低16位 uint16][CRC16] * 255
+ * 扇区序号从1开始递增, 记录号 = 扇区序号 * 255 + 扇区内位置, 读取时按记录号直接定位扇区.
+ *
+ * 掉电一致性:
+ *   写记录: 编程中掉电的记录CRC错误, 读取时报SENSOR_LOG_ERR_CRC, 挂载后从下一个位置继续写
+ *   开新扇区: 先擦除再写扇区头, 扇区头不完整时该扇区视为空闲, 下次使用前重新擦除
+ *   预擦除: 打开新扇区的同时在后台擦除下一个扇区(最旧的数据), 挂载时不把它算进有效范围
+ * 挂载只读每个扇区的16字节头(18MHz下1024个扇区约20ms), 再在最新扇区内二分查找写入位置.
+ *
+ * 容量: 默认占用W25Q128的8MB~12MB(12MB以后存放字库), (1024 - 1) * 255条记录,
+ * 每SENSOR_LOG_PERIOD_MS记录一条约30天; 每个扇区每圈擦除一次, 10万次寿命远超产品寿命.
+ *
+ * 修改说明
+ * V1.0 20230605
+ * 第一次发布
+ *
+ ****************************************************************************************************
+ */
+
+#ifndef __SENSOR_LOG_H
+#define __SENSOR_LOG_H
+
+#include "./SYSTEM/sys/sys.h"
+#include "./BSP/SENSOR_UART/sensor_frame.h"
+
+
+#define SENSOR_LOG_PERIOD_MS        10000       /* 记录间隔 */
+
+#ifndef SENSOR_LOG_BASE_SECTOR
+#define SENSOR_LOG_BASE_SECTOR      2048        /* 日志区起始扇区号(8MB) */
+#endif
+#ifndef SENSOR_LOG_SECTORS
+#define SENSOR_LOG_SECTORS          1024        /* 日志区扇区数(4MB), 至少3个 */
+#endif
+
+#define SENSOR_LOG_MAGIC            0x474F4C53  /* "SLOG" */
+#define SENSOR_LOG_HEADER_SIZE      16
+#define SENSOR_LOG_RECORD_SIZE      16          /* 页大小的约数, 一条记录不会跨页 */
+#define SENSOR_LOG_SLOTS            ((4096 - SENSOR_LOG_HEADER_SIZE) / SENSOR_LOG_RECORD_SIZE)  /* 每扇区记录数 */
+
+/* 返回值 */
+#define SENSOR_LOG_OK               0
+#define SENSOR_LOG_ERR_EMPTY        1           /* 记录不存在(还没写或已被覆盖) */
+#define SENSOR_LOG_ERR_CRC          2           /* 记录损坏(写入时掉电) */
+#define SENSOR_LOG_ERR_WRITE        3           /* 写入后读回不一致 */
+
+/* 统计 */
+typedef struct
+{
+    uint32_t appended;          /* 成功写入的记录 */
+    uint32_t write_errors;      /* 读回校验失败 */
+    uint32_t crc_errors;        /* 读取时CRC错误 */
+    uint32_t erases;            /* 扇区擦除次数(本次上电) */
+    uint32_t erase_min;         /* 挂载时各扇区擦除次数的最小/最大值, 用于观察磨损是否均衡 */
+    uint32_t erase_max;
+} sensor_log_stats_t;
+
+extern sensor_log_stats_t g_sensor_log_stats;
+
+/* 函数声明 */
+void sensor_log_mount(void);                                            /* 扫描扇区头, 恢复写入位置, 需要先执行norflash_init */
+uint8_t sensor_log_append(const sensor_sample_t *sample);               /* 追加一条记录 */
+uint8_t sensor_log_read(uint32_t index, sensor_sample_t *sample);       /* 按记录号读取 */
+uint32_t sensor_log_first(void);                                        /* 最旧记录的记录号 */
+uint32_t sensor_log_end(void);                                          /* 下一条记录的记录号 */
+
+#endif
@@ -0,0 +1,144 @@
+/**
+ ****************************************************************************************************
+ * @file        sensor_cmd.c
+ * @author      正点原子团队(ALIENTEK)
+ * @version     V1.0
+ * @date        2023-06-05
+ * @brief       ESP32->STM32命令分发
+ * @license     Copyright (c) 2020-2032, 广州市星翼电子科技有限公司
+ ****************************************************************************************************
+ * @attention
+ *
+ * 实验平台:正点原子 STM32F103开发板
+ * 在线视频:www.yuanzige.com
+ * 技术论坛:www.openedv.com
+ * 公司网址:www.alientek.com
+ * 购买地址:openedv.taobao.com
+ *
+ * 修改说明
+ * V1.0 20230605
+ * 第一次发布
+ *
+ ****************************************************************************************************
+ */
+
+#include "./BSP/SENSOR_UART/sensor_cmd.h"
+#include "./BSP/SENSOR_UART/sensor_frame.h"
+#include "./BSP/SENSOR_UART/sensor_uart3.h"
+#include "./BSP/BEEP/beep.h"
+#include "./BSP/RTC/rtc.h"
+#include "./SYSTEM/sched/sched.h"
+
+
+/* 命令表项 */
+typedef struct
+{
+    uint8_t type;                               /* 帧类型 */
+    uint8_t min_len;                            /* 最小负载长度, 多出的字节留给以后扩展 */
+    uint8_t (*handler)(const uint8_t *payload); /* 处理函数, 返回SENSOR_CMD_xxx */
+} sensor_cmd_t;
+
+static uint8_t g_cmd_report_task = SCHED_INVALID_ID;    /* 样本发送任务号, 即上报周期 */
+
+/* 小端读取 */
+#define CMD_U16(p)                      ((uint16_t)((p)[0] | ((uint16_t)(p)[1] << 8)))
+#define CMD_U32(p)                      ((p)[0] | ((uint32_t)(p)[1] << 8) | ((uint32_t)(p)[2] << 16) | ((uint32_t)(p)[3] << 24))
+
+/**
+ * @brief       校时: [Unix时间 uint32]
+ */
+static uint8_t sensor_cmd_time_sync(const uint8_t *payload)
+{
+    rtc_set_time(CMD_U32(payload));
+    g_uart3_rx_stats.time_syncs++;
+    return SENSOR_CMD_OK;
+}
+
+/**
+ * @brief       补传: [起始记录序号 uint16][条数 uint16]
+ */
+static uint8_t sensor_cmd_backfill(const uint8_t *payload)
+{
+    sensor_uart3_start_backfill(CMD_U16(payload), CMD_U16(payload + 2));
+    return SENSOR_CMD_OK;
+}
+
+/**
+ * @brief       设置上报周期: [样本帧发送周期 uint16 ms]
+ * @note        只修改样本发送任务的周期, 传感器按各自的周期测量, 不受影响
+ */
+static uint8_t sensor_cmd_set_report_period(const uint8_t *payload)
+{
+    uint16_t period = CMD_U16(payload);
+
+    if (period < SENSOR_CMD_REPORT_PERIOD_MIN_MS || period > SENSOR_CMD_REPORT_PERIOD_MAX_MS)
+    {
+        return SENSOR_CMD_ERR_VALUE;
+    }
+
+    return sched_set_period(g_cmd_report_task, period) ? SENSOR_CMD_ERR_VALUE : SENSOR_CMD_OK;
+}
+
+/**
+ * @brief       设置报警阈值: [报警类型 uint8][阈值 int16, 0.1个单位]
+ */
+static uint8_t sensor_cmd_set_threshold(const uint8_t *payload)
+{
+    return beep_set_threshold(payload[0], (int16_t)CMD_U16(payload + 1)) ? SENSOR_CMD_ERR_VALUE : SENSOR_CMD_OK;
+}
+
+/**
+ * @brief       设置报警规则: [报警类型 uint8][阈值 int16][回差 int16][消抖时间 uint16 ms]
+ */
+static uint8_t sensor_cmd_set_alarm_rule(const uint8_t *payload)
+{
+    return beep_set_rule(payload[0], (int16_t)CMD_U16(payload + 1), (int16_t)CMD_U16(payload + 3),
+                         CMD_U16(payload + 5)) ? SENSOR_CMD_ERR_VALUE : SENSOR_CMD_OK;
+}
+
+/* 命令表 */
+static const sensor_cmd_t g_sensor_cmds[] =
+{
+    {SENSOR_FRAME_TYPE_TIME_SYNC,     SENSOR_FRAME_TIME_PAYLOAD_LEN,      sensor_cmd_time_sync},
+    {SENSOR_FRAME_TYPE_BACKFILL_REQ,  SENSOR_FRAME_BACKFILL_PAYLOAD_LEN,  sensor_cmd_backfill},
+    {SENSOR_FRAME_TYPE_SET_REPORT_PERIOD, SENSOR_FRAME_REPORT_PERIOD_PAYLOAD_LEN, sensor_cmd_set_report_period},
+    {SENSOR_FRAME_TYPE_SET_THRESHOLD, SENSOR_FRAME_THRESHOLD_PAYLOAD_LEN, sensor_cmd_set_threshold},
+    {SENSOR_FRAME_TYPE_SET_ALARM_RULE, SENSOR_FRAME_ALARM_RULE_PAYLOAD_LEN, sensor_cmd_set_alarm_rule},
+};
+
+/**
+ * @brief       初始化
+ * @param       report_task: 样本发送任务的调度器任务号, 设置上报周期命令修改它的周期
+ * @retval      无
+ */
+void sensor_cmd_init(uint8_t report_task)
+{
+    g_cmd_report_task = report_task;
+}
+
+/**
+ * @brief       执行一条命令
+ * @param       type: 帧类型
+ * @param       payload: 负载
+ * @param       len: 负载长度
+ * @retval      SENSOR_CMD_xxx
+ */
+uint8_t sensor_cmd_dispatch(uint8_t type, const uint8_t *payload, uint16_t len)
+{
+    uint8_t i;
+
+    for (i = 0; i < sizeof(g_sensor_cmds) / sizeof(g_sensor_cmds[0]); i++)
+    {
+        if (g_sensor_cmds[i].type == type)
+        {
+            if (len < g_sensor_cmds[i].min_len)
+            {
+                return SENSOR_CMD_ERR_LEN;
+            }
+
+            return g_sensor_cmds[i].handler(payload);
+        }
+    }
+
+    return SENSOR_CMD_ERR_UNKNOWN;
+}
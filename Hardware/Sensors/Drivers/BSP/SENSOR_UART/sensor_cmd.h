@@ -0,0 +1,47 @@
+/**
+ ****************************************************************************************************
+ * @file        sensor_cmd.h
+ * @author      正点原子团队(ALIENTEK)
+ * @version     V1.0
+ * @date        2023-06-05
+ * @brief       ESP32->STM32命令分发
+ * @license     Copyright (c) 2020-2032, 广州市星翼电子科技有限公司
+ ****************************************************************************************************
+ * @attention
+ *
+ * 实验平台:正点原子 STM32F103开发板
+ * 在线视频:www.yuanzige.com
+ * 技术论坛:www.openedv.com
+ * 公司网址:www.alientek.com
+ * 购买地址:openedv.taobao.com
+ *
+ * sensor_uart3收到一帧后按帧类型查命令表, 检查负载长度后调用处理函数, 处理结果通过应答帧
+ * 回给ESP32(帧格式见sensor_frame.h). 增加命令只需在sensor_cmd.c的命令表里加一行.
+ *
+ * 修改说明
+ * V1.0 20230605
+ * 第一次发布
+ *
+ ****************************************************************************************************
+ */
+
+#ifndef __SENSOR_CMD_H
+#define __SENSOR_CMD_H
+
+#include "./SYSTEM/sys/sys.h"
+
+/* 命令处理结果, 原样放入应答帧 */
+#define SENSOR_CMD_OK                   0
+#define SENSOR_CMD_ERR_LEN              1       /* 负载长度不对 */
+#define SENSOR_CMD_ERR_VALUE            2       /* 参数超出范围 */
+#define SENSOR_CMD_ERR_UNKNOWN          3       /* 不认识的命令 */
+
+/* 上报周期(样本帧发送周期)的允许范围(ms) */
+#define SENSOR_CMD_REPORT_PERIOD_MIN_MS 200
+#define SENSOR_CMD_REPORT_PERIOD_MAX_MS 60000
+
+/* 函数声明 */
+void sensor_cmd_init(uint8_t report_task);      /* 传入样本发送任务的调度器任务号 */
+uint8_t sensor_cmd_dispatch(uint8_t type, const uint8_t *payload, uint16_t len);   /* 执行一条命令, 返回SENSOR_CMD_xxx */
+
+#endif /* __SENSOR_CMD_H */
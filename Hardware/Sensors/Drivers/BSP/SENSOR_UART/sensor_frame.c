@@ -0,0 +1,316 @@
+/**
+ ****************************************************************************************************
+ * @file        sensor_frame.c
+ * @author      正点原子团队(ALIENTEK)
+ * @version     V1.0
+ * @date        2023-06-05
+ * @brief       STM32与ESP32之间的二进制帧协议(COBS + CRC16)
+ * @license     Copyright (c) 2020-2032, 广州市星翼电子科技有限公司
+ ****************************************************************************************************
+ * @attention
+ *
+ * 实验平台:正点原子 STM32F103开发板
+ * 在线视频:www.yuanzige.com
+ * 技术论坛:www.openedv.com
+ * 公司网址:www.alientek.com
+ * 购买地址:openedv.taobao.com
+ *
+ * 修改说明
+ * V1.0 20230605
+ * 第一次发布
+ *
+ ****************************************************************************************************
+ */
+
+#include "./BSP/SENSOR_UART/sensor_frame.h"
+
+/* CRC-16/CCITT-FALSE查表, 多项式0x1021
+ * F1的硬件CRC单元固定为CRC-32且按字计算, 无法产生CRC16, 这里用查表法, 每字节一次查表
+ */
+static const uint16_t g_crc16_table[256] =
+{
+    0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+    0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF,
+    0x1231, 0x0210, 0x3273, 0x2252, 0x52B5, 0x4294, 0x72F7, 0x62D6,
+    0x9339, 0x8318, 0xB37B, 0xA35A, 0xD3BD, 0xC39C, 0xF3FF, 0xE3DE,
+    0x2462, 0x3443, 0x0420, 0x1401, 0x64E6, 0x74C7, 0x44A4, 0x5485,
+    0xA56A, 0xB54B, 0x8528, 0x9509, 0xE5EE, 0xF5CF, 0xC5AC, 0xD58D,
+    0x3653, 0x2672, 0x1611, 0x0630, 0x76D7, 0x66F6, 0x5695, 0x46B4,
+    0xB75B, 0xA77A, 0x9719, 0x8738, 0xF7DF, 0xE7FE, 0xD79D, 0xC7BC,
+    0x48C4, 0x58E5, 0x6886, 0x78A7, 0x0840, 0x1861, 0x2802, 0x3823,
+    0xC9CC, 0xD9ED, 0xE98E, 0xF9AF, 0x8948, 0x9969, 0xA90A, 0xB92B,
+    0x5AF5, 0x4AD4, 0x7AB7, 0x6A96, 0x1A71, 0x0A50, 0x3A33, 0x2A12,
+    0xDBFD, 0xCBDC, 0xFBBF, 0xEB9E, 0x9B79, 0x8B58, 0xBB3B, 0xAB1A,
+    0x6CA6, 0x7C87, 0x4CE4, 0x5CC5, 0x2C22, 0x3C03, 0x0C60, 0x1C41,
+    0xEDAE, 0xFD8F, 0xCDEC, 0xDDCD, 0xAD2A, 0xBD0B, 0x8D68, 0x9D49,
+    0x7E97, 0x6EB6, 0x5ED5, 0x4EF4, 0x3E13, 0x2E32, 0x1E51, 0x0E70,
+    0xFF9F, 0xEFBE, 0xDFDD, 0xCFFC, 0xBF1B, 0xAF3A, 0x9F59, 0x8F78,
+    0x9188, 0x81A9, 0xB1CA, 0xA1EB, 0xD10C, 0xC12D, 0xF14E, 0xE16F,
+    0x1080, 0x00A1, 0x30C2, 0x20E3, 0x5004, 0x4025, 0x7046, 0x6067,
+    0x83B9, 0x9398, 0xA3FB, 0xB3DA, 0xC33D, 0xD31C, 0xE37F, 0xF35E,
+    0x02B1, 0x1290, 0x22F3, 0x32D2, 0x4235, 0x5214, 0x6277, 0x7256,
+    0xB5EA, 0xA5CB, 0x95A8, 0x8589, 0xF56E, 0xE54F, 0xD52C, 0xC50D,
+    0x34E2, 0x24C3, 0x14A0, 0x0481, 0x7466, 0x6447, 0x5424, 0x4405,
+    0xA7DB, 0xB7FA, 0x8799, 0x97B8, 0xE75F, 0xF77E, 0xC71D, 0xD73C,
+    0x26D3, 0x36F2, 0x0691, 0x16B0, 0x6657, 0x7676, 0x4615, 0x5634,
+    0xD94C, 0xC96D, 0xF90E, 0xE92F, 0x99C8, 0x89E9, 0xB98A, 0xA9AB,
+    0x5844, 0x4865, 0x7806, 0x6827, 0x18C0, 0x08E1, 0x3882, 0x28A3,
+    0xCB7D, 0xDB5C, 0xEB3F, 0xFB1E, 0x8BF9, 0x9BD8, 0xABBB, 0xBB9A,
+    0x4A75, 0x5A54, 0x6A37, 0x7A16, 0x0AF1, 0x1AD0, 0x2AB3, 0x3A92,
+    0xFD2E, 0xED0F, 0xDD6C, 0xCD4D, 0xBDAA, 0xAD8B, 0x9DE8, 0x8DC9,
+    0x7C26, 0x6C07, 0x5C64, 0x4C45, 0x3CA2, 0x2C83, 0x1CE0, 0x0CC1,
+    0xEF1F, 0xFF3E, 0xCF5D, 0xDF7C, 0xAF9B, 0xBFBA, 0x8FD9, 0x9FF8,
+    0x6E17, 0x7E36, 0x4E55, 0x5E74, 0x2E93, 0x3EB2, 0x0ED1, 0x1EF0
+};
+
+/**
+ * @brief       计算CRC-16/CCITT-FALSE
+ * @param       data: 数据
+ * @param       len: 数据长度
+ * @retval      CRC值
+ */
+uint16_t sensor_frame_crc16(const uint8_t *data, uint16_t len)
+{
+    uint16_t crc = 0xFFFF;
+
+    while (len--)
+    {
+        crc = (crc << 8) ^ g_crc16_table[(crc >> 8) ^ *data++];
+    }
+
+    return crc;
+}
+
+/**
+ * @brief       COBS编码
+ * @note        输出中不含0x00, dst至少需要 len + len / 254 + 1 字节
+ * @param       src: 原始数据
+ * @param       len: 原始数据长度
+ * @param       dst: 编码输出
+ * @retval      编码后长度(不含0x00结束符)
+ */
+uint16_t sensor_frame_cobs_encode(const uint8_t *src, uint16_t len, uint8_t *dst)
+{
+    uint16_t read = 0;
+    uint16_t write = 1;
+    uint16_t code_pos = 0;
+    uint8_t code = 1;
+
+    while (read < len)
+    {
+        if (src[read] == 0)
+        {
+            dst[code_pos] = code;
+            code_pos = write++;
+            code = 1;
+        }
+        else
+        {
+            dst[write++] = src[read];
+            code++;
+
+            if (code == 0xFF)       /* 满254个非零字节, 开始新的分组 */
+            {
+                dst[code_pos] = code;
+                code_pos = write++;
+                code = 1;
+            }
+        }
+
+        read++;
+    }
+
+    dst[code_pos] = code;
+    return write;
+}
+
+/**
+ * @brief       组帧: 加帧头和CRC, COBS编码后追加0x00结束符
+ * @param       type: 帧类型
+ * @param       seq: 帧序号
+ * @param       payload: 负载
+ * @param       len: 负载长度(不超过SENSOR_FRAME_MAX_PAYLOAD)
+ * @param       out: 输出缓冲, 至少SENSOR_FRAME_MAX_ENCODED字节
+ * @retval      输出长度, 0表示负载过长
+ */
+uint16_t sensor_frame_pack(uint8_t type, uint16_t seq, const uint8_t *payload, uint16_t len, uint8_t *out)
+{
+    uint8_t raw[SENSOR_FRAME_MAX_RAW];
+    uint16_t crc;
+    uint16_t n;
+    uint16_t i;
+
+    if (len > SENSOR_FRAME_MAX_PAYLOAD)
+    {
+        return 0;
+    }
+
+    raw[0] = SENSOR_FRAME_VERSION;
+    raw[1] = type;
+    raw[2] = seq & 0xFF;
+    raw[3] = seq >> 8;
+
+    for (i = 0; i < len; i++)
+    {
+        raw[SENSOR_FRAME_HEADER_LEN + i] = payload[i];
+    }
+
+    n = SENSOR_FRAME_HEADER_LEN + len;
+    crc = sensor_frame_crc16(raw, n);
+    raw[n++] = crc & 0xFF;
+    raw[n++] = crc >> 8;
+
+    n = sensor_frame_cobs_encode(raw, n, out);
+    out[n++] = 0x00;
+
+    return n;
+}
+
+/**
+ * @brief       样本写入负载(SENSOR_FRAME_SAMPLE_PAYLOAD_LEN字节)
+ * @param       sample: 定点样本
+ * @param       payload: 负载输出
+ * @retval      无
+ */
+static void sensor_frame_put_sample(const sensor_sample_t *sample, uint8_t *payload)
+{
+    payload[0] = (uint8_t)sample->temperature;
+    payload[1] = sample->humidity;
+    payload[2] = sample->co_x10 & 0xFF;
+    payload[3] = sample->co_x10 >> 8;
+    payload[4] = sample->dust_x10 & 0xFF;
+    payload[5] = sample->dust_x10 >> 8;
+    payload[6] = sample->alarm_mask;
+    payload[7] = sample->valid;
+    payload[8] = sample->timestamp & 0xFF;
+    payload[9] = (sample->timestamp >> 8) & 0xFF;
+    payload[10] = (sample->timestamp >> 16) & 0xFF;
+    payload[11] = sample->timestamp >> 24;
+}
+
+/**
+ * @brief       组样本帧
+ * @param       type: SENSOR_FRAME_TYPE_SAMPLE
+ * @param       seq: 帧序号
+ * @param       sample: 定点样本
+ * @param       out: 输出缓冲, 至少SENSOR_FRAME_MAX_ENCODED字节
+ * @retval      输出长度
+ */
+uint16_t sensor_frame_pack_sample(uint8_t type, uint16_t seq, const sensor_sample_t *sample, uint8_t *out)
+{
+    uint8_t payload[SENSOR_FRAME_SAMPLE_PAYLOAD_LEN];
+
+    sensor_frame_put_sample(sample, payload);
+    return sensor_frame_pack(type, seq, payload, sizeof(payload), out);
+}
+
+/**
+ * @brief       组记录帧: 样本后面附加启动号
+ * @param       seq: 记录序号
+ * @param       boot_id: 启动号(见rtc_get_boot_id), 0表示未知
+ * @param       sample: 定点样本
+ * @param       out: 输出缓冲, 至少SENSOR_FRAME_MAX_ENCODED字节
+ * @retval      输出长度
+ */
+uint16_t sensor_frame_pack_record(uint16_t seq, uint16_t boot_id, const sensor_sample_t *sample, uint8_t *out)
+{
+    uint8_t payload[SENSOR_FRAME_RECORD_PAYLOAD_LEN];
+
+    sensor_frame_put_sample(sample, payload);
+    payload[12] = boot_id & 0xFF;
+    payload[13] = boot_id >> 8;
+
+    return sensor_frame_pack(SENSOR_FRAME_TYPE_RECORD, seq, payload, sizeof(payload), out);
+}
+
+/**
+ * @brief       COBS解码
+ * @param       src: 编码数据(不含0x00结束符)
+ * @param       len: 编码数据长度
+ * @param       dst: 解码输出
+ * @param       size: 输出缓冲区大小
+ * @retval      解码后长度, 0表示格式错误或输出缓冲区不够
+ */
+uint16_t sensor_frame_cobs_decode(const uint8_t *src, uint16_t len, uint8_t *dst, uint16_t size)
+{
+    uint16_t read = 0;
+    uint16_t write = 0;
+    uint8_t code;
+    uint8_t i;
+
+    while (read < len)
+    {
+        code = src[read++];
+
+        if (code == 0 || read + code - 1 > len)
+        {
+            return 0;
+        }
+
+        for (i = 1; i < code; i++)
+        {
+            if (write >= size)
+            {
+                return 0;
+            }
+
+            dst[write++] = src[read++];
+        }
+
+        /* 码值小于0xFF且不是最后一组时, 代表一个被编码掉的0x00 */
+        if (code < 0xFF && read < len)
+        {
+            if (write >= size)
+            {
+                return 0;
+            }
+
+            dst[write++] = 0;
+        }
+    }
+
+    return write;
+}
+
+/**
+ * @brief       拆帧: COBS解码, 检查版本和CRC, 取出类型, 序号和负载
+ * @param       data: 编码后的一帧(不含0x00结束符)
+ * @param       len: 长度
+ * @param       type: 帧类型
+ * @param       seq: 帧序号
+ * @param       payload: 负载输出, 至少SENSOR_FRAME_MAX_PAYLOAD字节
+ * @param       payload_len: 负载长度
+ * @retval      SENSOR_FRAME_OK / SENSOR_FRAME_ERR_FORMAT / SENSOR_FRAME_ERR_CRC
+ */
+uint8_t sensor_frame_unpack(const uint8_t *data, uint16_t len, uint8_t *type, uint16_t *seq,
+                            uint8_t *payload, uint16_t *payload_len)
+{
+    uint8_t raw[SENSOR_FRAME_MAX_RAW];
+    uint16_t n;
+    uint16_t i;
+
+    n = sensor_frame_cobs_decode(data, len, raw, sizeof(raw));
+
+    if (n < SENSOR_FRAME_HEADER_LEN + SENSOR_FRAME_CRC_LEN || raw[0] != SENSOR_FRAME_VERSION)
+    {
+        return SENSOR_FRAME_ERR_FORMAT;
+    }
+
+    n -= SENSOR_FRAME_CRC_LEN;
+
+    if (sensor_frame_crc16(raw, n) != (raw[n] | ((uint16_t)raw[n + 1] << 8)))
+    {
+        return SENSOR_FRAME_ERR_CRC;
+    }
+
+    *type = raw[1];
+    *seq = raw[2] | ((uint16_t)raw[3] << 8);
+    *payload_len = n - SENSOR_FRAME_HEADER_LEN;
+
+    for (i = 0; i < *payload_len; i++)
+    {
+        payload[i] = raw[SENSOR_FRAME_HEADER_LEN + i];
+    }
+
+    return SENSOR_FRAME_OK;
+}
@@ -0,0 +1,127 @@
+/**
+ ****************************************************************************************************
+ * @file        sensor_frame.h
+ * @author      正点原子团队(ALIENTEK)
+ * @version     V1.0
+ * @date        2023-06-05
+ * @brief       STM32与ESP32之间的二进制帧协议(COBS + CRC16)
+ * @license     Copyright (c) 2020-2032, 广州市星翼电子科技有限公司
+ ****************************************************************************************************
+ * @attention
+ *
+ * 帧格式(COBS编码前, 多字节字段均为小端):
+ *   [版本 1B][类型 1B][序号 2B][负载 NB][CRC16 2B]
+ * CRC16为CRC-16/CCITT-FALSE(多项式0x1021, 初值0xFFFF), 覆盖版本到负载的全部字节.
+ * 整帧经COBS编码后以0x00结尾, 接收端遇到0x00即可重新同步.
+ *
+ * 样本帧(类型0x01, STM32->ESP32)负载, 共12字节:
+ *   [温度 int8 °C][湿度 uint8 %][CO uint16 0.1ppm][粉尘 uint16 0.1ug/m3][报警位图 uint8, 同时存在的全部报警]
+ *   [测量标志 uint8, SENSOR_VALID_xxx][采集时间 uint32]
+ * 采集时间为RTC的Unix时间(秒, UTC), 0表示STM32还没有校时. 只认前8字节的旧接收端不受影响.
+ * 测量标志: 上电后每个传感器第一次出结果之前(DHT11约1s, 粉尘约0.6s, MQ-7一个加热周期150s),
+ * 对应字段为0, 不是测量值, 接收端应忽略. 该字节原为报警位图的高字节(总是0), 新固件总是置SENSOR_VALID_FLAGS,
+ * 没有这一位时按全部字段有效处理.
+ *
+ * 记录帧(类型0x02, STM32->ESP32)负载, 共14字节:
+ *   [与样本帧相同的12字节][启动号 uint16]
+ * 序号为历史记录序号(见sensor_history.h), 与样本帧的序号相互独立. 新记录产生时发送一次, 收到补传请求后重发.
+ * 历史记录在SRAM中, STM32复位后记录序号从0重新开始; 启动号每次复位加1(见rtc.h), ESP32据此判断复位,
+ * 不必靠序号倒退来猜. 0表示启动号未知(RTC没有初始化).
+ *
+ * 校时帧(类型0x81, ESP32->STM32)负载, 共4字节:
+ *   [Unix时间 uint32 秒, UTC]
+ *
+ * 补传请求帧(类型0x82, ESP32->STM32)负载, 共4字节:
+ *   [起始记录序号 uint16][条数 uint16]
+ * 已被覆盖的记录跳过不发, 条数为0表示取消尚未发完的补传.
+ *
+ * 设置上报周期帧(类型0x83, ESP32->STM32)负载, 共2字节:
+ *   [样本帧发送周期 uint16 ms], 范围见sensor_cmd.h
+ * 只改变样本帧的发送间隔; 各传感器的测量周期(sensor.h)和历史记录周期不变.
+ *
+ * 设置阈值帧(类型0x84, ESP32->STM32)负载, 共3字节:
+ *   [报警类型 uint8, BEEP_ALARM_xxx][阈值 int16, 0.1个单位, 单位同beep.h中对应的阈值]
+ *
+ * 设置报警规则帧(类型0x85, ESP32->STM32)负载, 共7字节:
+ *   [报警类型 uint8][阈值 int16][回差 int16][消抖时间 uint16 ms], 阈值和回差为0.1个单位
+ *
+ * 应答帧(类型0x03, STM32->ESP32)负载, 共2字节:
+ *   [命令类型 uint8][结果 uint8, SENSOR_CMD_xxx]
+ * ESP32->STM32的每一帧都有应答, 应答的序号与命令帧相同, ESP32据此匹配请求.
+ *
+ ****************************************************************************************************
+ */
+
+#ifndef __SENSOR_FRAME_H
+#define __SENSOR_FRAME_H
+
+#include "./SYSTEM/sys/sys.h"
+
+/* 协议版本 */
+#define SENSOR_FRAME_VERSION            1
+
+/* 帧类型 */
+#define SENSOR_FRAME_TYPE_SAMPLE        0x01    /* 传感器样本 STM32->ESP32 */
+#define SENSOR_FRAME_TYPE_RECORD        0x02    /* 历史记录 STM32->ESP32 */
+#define SENSOR_FRAME_TYPE_ACK           0x03    /* 命令应答 STM32->ESP32 */
+#define SENSOR_FRAME_TYPE_TIME_SYNC     0x81    /* 校时 ESP32->STM32 */
+#define SENSOR_FRAME_TYPE_BACKFILL_REQ  0x82    /* 补传请求 ESP32->STM32 */
+#define SENSOR_FRAME_TYPE_SET_REPORT_PERIOD 0x83 /* 设置上报周期 ESP32->STM32 */
+#define SENSOR_FRAME_TYPE_SET_THRESHOLD 0x84    /* 设置报警阈值 ESP32->STM32 */
+#define SENSOR_FRAME_TYPE_SET_ALARM_RULE 0x85   /* 设置报警规则 ESP32->STM32 */
+
+/* 帧长度 */
+#define SENSOR_FRAME_HEADER_LEN         4       /* 版本 + 类型 + 序号 */
+#define SENSOR_FRAME_CRC_LEN            2
+#define SENSOR_FRAME_MAX_PAYLOAD        32
+#define SENSOR_FRAME_MAX_RAW            (SENSOR_FRAME_HEADER_LEN + SENSOR_FRAME_MAX_PAYLOAD + SENSOR_FRAME_CRC_LEN)
+#define SENSOR_FRAME_MAX_ENCODED        (SENSOR_FRAME_MAX_RAW + SENSOR_FRAME_MAX_RAW / 254 + 2)  /* COBS开销 + 0x00结束符 */
+
+#define SENSOR_FRAME_SAMPLE_PAYLOAD_LEN 12
+#define SENSOR_FRAME_RECORD_PAYLOAD_LEN 14
+#define SENSOR_FRAME_TIME_PAYLOAD_LEN   4
+#define SENSOR_FRAME_BACKFILL_PAYLOAD_LEN 4
+#define SENSOR_FRAME_REPORT_PERIOD_PAYLOAD_LEN 2
+#define SENSOR_FRAME_THRESHOLD_PAYLOAD_LEN 3
+#define SENSOR_FRAME_ALARM_RULE_PAYLOAD_LEN 7
+#define SENSOR_FRAME_ACK_PAYLOAD_LEN    2
+
+/* sensor_frame_unpack返回值 */
+#define SENSOR_FRAME_OK                 0
+#define SENSOR_FRAME_ERR_FORMAT         1       /* COBS解码失败, 长度或版本不对 */
+#define SENSOR_FRAME_ERR_CRC            2       /* CRC错误 */
+
+/* 测量标志: 样本中哪些字段已经有测量结果 */
+#define SENSOR_VALID_TEMP               0x01
+#define SENSOR_VALID_HUMI               0x02
+#define SENSOR_VALID_CO                 0x04
+#define SENSOR_VALID_DUST               0x08
+#define SENSOR_VALID_ALL                0x0F
+#define SENSOR_VALID_FLAGS              0x80    /* 本字节是测量标志(旧固件为0) */
+
+/* 报警位图, 与BEEP_ALARM_xxx类型一一对应: bit(n-1)表示类型n */
+#define SENSOR_ALARM_BIT(type)          ((type) ? (uint16_t)(1u << ((type) - 1)) : 0)
+
+/* 定点格式的传感器样本 */
+typedef struct
+{
+    int8_t temperature;     /* 温度(°C) */
+    uint8_t humidity;       /* 湿度(%) */
+    uint16_t co_x10;        /* CO浓度(0.1ppm) */
+    uint16_t dust_x10;      /* 粉尘浓度(0.1ug/m3) */
+    uint8_t alarm_mask;     /* 报警位图 */
+    uint8_t valid;          /* 测量标志, SENSOR_VALID_xxx */
+    uint32_t timestamp;     /* 采集时间(Unix秒, UTC), 0表示未校时 */
+} sensor_sample_t;
+
+/* 函数声明 */
+uint16_t sensor_frame_crc16(const uint8_t *data, uint16_t len);                          /* 计算CRC16 */
+uint16_t sensor_frame_cobs_encode(const uint8_t *src, uint16_t len, uint8_t *dst);       /* COBS编码(不含结束符) */
+uint16_t sensor_frame_pack(uint8_t type, uint16_t seq, const uint8_t *payload, uint16_t len, uint8_t *out); /* 组帧, 返回含结束符的长度 */
+uint16_t sensor_frame_pack_sample(uint8_t type, uint16_t seq, const sensor_sample_t *sample, uint8_t *out); /* 组样本帧 */
+uint16_t sensor_frame_pack_record(uint16_t seq, uint16_t boot_id, const sensor_sample_t *sample, uint8_t *out); /* 组记录帧 */
+uint16_t sensor_frame_cobs_decode(const uint8_t *src, uint16_t len, uint8_t *dst, uint16_t size);         /* COBS解码, 失败返回0 */
+uint8_t sensor_frame_unpack(const uint8_t *data, uint16_t len, uint8_t *type, uint16_t *seq,
+                            uint8_t *payload, uint16_t *payload_len);                                    /* 拆帧(不含结束符) */
+
+#endif /* __SENSOR_FRAME_H */
@@ -25,75 +25,126 @@
 #include "./BSP/SENSOR_UART/sensor_uart.h"
 #include "./SYSTEM/delay/delay.h"
 #include "./BSP/BEEP/beep.h"
-#include <stdio.h>
-#include <string.h>
+#include "./SYSTEM/fmt/fmt.h"
+
+/* USART1 DMA发送队列 */
+uart_tx_t g_uart1_tx;
+static uint8_t g_uart1_tx_buf[SENSOR_UART_TX_BUF_SIZE];
 
 /**
- * @brief       格式化并发送传感器数据到串口
- * @param       temperature: 温度值
- * @param       humidity: 湿度值
- * @param       co_ppm: 一氧化碳浓度(ppm)
- * @param       dust_density: 粉尘浓度(ug/m3)
+ * @brief       为USART1挂接DMA发送队列
+ * @note        需在usart_init()之后调用
+ * @param       无
  * @retval      无
  */
-void sensor_uart_send_data(uint8_t temperature, uint8_t humidity, float co_ppm, float dust_density)
+void sensor_uart_init(void)
 {
-    char buffer[150];
-    int len;
-    char alarm_str[20] = "None";
-    
-    /* 根据当前报警类型设置报警字符串 */
-    switch(g_current_alarm)
+    uart_tx_init(&g_uart1_tx, &g_uart1_handle, DMA1_Channel4, DMA1_Channel4_IRQn,
+                 g_uart1_tx_buf, sizeof(g_uart1_tx_buf));
+}
+
+/**
+ * @brief       USART1 TX DMA中断服务函数
+ * @param       无
+ * @retval      无
+ */
+void DMA1_Channel4_IRQHandler(void)
+{
+    HAL_DMA_IRQHandler(&g_uart1_tx.hdma);
+}
+
+/**
+ * @brief       获取报警类型对应的字符串
+ * @param       alarm: BEEP_ALARM_xxx
+ * @retval      报警字符串
+ */
+static const char *sensor_uart_alarm_str(uint8_t alarm)
+{
+    switch(alarm)
     {
         case BEEP_ALARM_NONE:
-            strcpy(alarm_str, "None");
-            break;
+            return "None";
         case BEEP_ALARM_TEMP_HIGH:
-            strcpy(alarm_str, "Temp High");
-            break;
+            return "Temp High";
         case BEEP_ALARM_TEMP_LOW:
-            strcpy(alarm_str, "Temp Low");
-            break;
+            return "Temp Low";
         case BEEP_ALARM_HUMI_HIGH:
-            strcpy(alarm_str, "Humi High");
-            break;
+            return "Humi High";
         case BEEP_ALARM_HUMI_LOW:
-            strcpy(alarm_str, "Humi Low");
-            break;
+            return "Humi Low";
         case BEEP_ALARM_CO_NORMAL:
-            strcpy(alarm_str, "CO Normal");
-            break;
+            return "CO Normal";
         case BEEP_ALARM_CO_DANGER:
-            strcpy(alarm_str, "CO Danger");
-            break;
+            return "CO Danger";
         case BEEP_ALARM_DUST_LOW:
-            strcpy(alarm_str, "Dust Low");
-            break;
+            return "Dust Low";
         case BEEP_ALARM_DUST_HIGH:
-            strcpy(alarm_str, "Dust High");
-            break;
+            return "Dust High";
         default:
-            strcpy(alarm_str, "Unknown");
-            break;
+            return "Unknown";
     }
-    
+}
+
+/**
+ * @brief       格式化一行传感器数据
+ * @note        格式"T:%d,H:%d,CO:%.1f,DUST:%.1f,ALARM:%s\r\n", 只用整数运算, 不链接浮点printf
+ * @param       buf: 输出缓冲区, 至少SENSOR_UART_LINE_MAX字节
+ * @param       temperature: 温度值
+ * @param       humidity: 湿度值
+ * @param       co_x10: 一氧化碳浓度(0.1ppm)
+ * @param       dust_x10: 粉尘浓度(0.1ug/m3)
+ * @param       alarm: 当前报警类型
+ * @retval      字符串长度
+ */
+uint16_t sensor_uart_format_line(char *buf, uint8_t temperature, uint8_t humidity,
+                                 uint16_t co_x10, uint16_t dust_x10, uint8_t alarm)
+{
+    char *p = buf;
+
+    p = fmt_put_str(p, "T:");
+    p = fmt_put_uint(p, temperature);
+    p = fmt_put_str(p, ",H:");
+    p = fmt_put_uint(p, humidity);
+    p = fmt_put_str(p, ",CO:");
+    p = fmt_put_x10(p, co_x10);
+    p = fmt_put_str(p, ",DUST:");
+    p = fmt_put_x10(p, dust_x10);
+    p = fmt_put_str(p, ",ALARM:");
+    p = fmt_put_str(p, sensor_uart_alarm_str(alarm));
+    p = fmt_put_str(p, "\r\n");
+
+    return p - buf;
+}
+
+/**
+ * @brief       格式化并发送传感器数据到串口
+ * @param       temperature: 温度值
+ * @param       humidity: 湿度值
+ * @param       co_x10: 一氧化碳浓度(0.1ppm)
+ * @param       dust_x10: 粉尘浓度(0.1ug/m3)
+ * @retval      无
+ */
+void sensor_uart_send_data(uint8_t temperature, uint8_t humidity, uint16_t co_x10, uint16_t dust_x10)
+{
+    char buffer[SENSOR_UART_LINE_MAX];
+    uint16_t len;
+
     /* 格式化传感器数据为字符串，添加报警信息 */
-    len = sprintf(buffer, "T:%d,H:%d,CO:%.1f,DUST:%.1f,ALARM:%s\r\n", 
-                 temperature, humidity, co_ppm, dust_density, alarm_str);
-    
-    /* 通过HAL库函数发送数据 */
-    HAL_UART_Transmit(&g_uart1_handle, (uint8_t*)buffer, len, 100);
+    len = sensor_uart_format_line(buffer, temperature, humidity, co_x10, dust_x10, g_current_alarm);
+
+    /* 放入DMA发送队列, 不等待发送完成 */
+    uart_tx_write(&g_uart1_tx, (uint8_t*)buffer, len);
 }
 
 /**
  * @brief       定期发送传感器数据
  * @param       temperature: 温度值
  * @param       humidity: 湿度值
- * @param       co_ppm: 一氧化碳浓度(ppm)
- * @param       dust_density: 粉尘浓度(ug/m3)
+ * @param       co_x10: 一氧化碳浓度(0.1ppm)
+ * @param       dust_x10: 粉尘浓度(0.1ug/m3)
  * @retval      无
  */
-void sensor_uart_periodic_send(uint8_t temperature, uint8_t humidity, float co_ppm, float dust_density)
+void sensor_uart_periodic_send(uint8_t temperature, uint8_t humidity, uint16_t co_x10, uint16_t dust_x10)
 {
     static uint32_t last_send_time = 0;
     uint32_t current_time;
@@ -103,7 +154,7 @@ void sensor_uart_periodic_send(uint8_t temperature, uint8_t humidity, float co_p
     /* 每1000ms发送一次数据 */
     if (current_time - last_send_time >= 1000)
     {
-        sensor_uart_send_data(temperature, humidity, co_ppm, dust_density);
+        sensor_uart_send_data(temperature, humidity, co_x10, dust_x10);
         last_send_time = current_time;
     }
 }
\ No newline at end of file
@@ -27,9 +27,19 @@
 
 #include "./SYSTEM/sys/sys.h"
 #include "./SYSTEM/usart/usart.h"
+#include "./BSP/SENSOR_UART/uart_tx.h"
+
+#define SENSOR_UART_TX_BUF_SIZE         1024    /* USART1 DMA发送缓冲区大小(能放下一次完整的性能报告) */
+#define SENSOR_UART_LINE_MAX            64      /* 一行ASCII数据的最大长度 */
+
+/* 外部变量声明 */
+extern uart_tx_t g_uart1_tx;                    /* USART1 DMA发送队列 */
 
 /* 函数声明 */
-void sensor_uart_send_data(uint8_t temperature, uint8_t humidity, float co_ppm, float dust_density);
-void sensor_uart_periodic_send(uint8_t temperature, uint8_t humidity, float co_ppm, float dust_density);
+void sensor_uart_init(void);
+uint16_t sensor_uart_format_line(char *buf, uint8_t temperature, uint8_t humidity,
+                                 uint16_t co_x10, uint16_t dust_x10, uint8_t alarm);
+void sensor_uart_send_data(uint8_t temperature, uint8_t humidity, uint16_t co_x10, uint16_t dust_x10);
+void sensor_uart_periodic_send(uint8_t temperature, uint8_t humidity, uint16_t co_x10, uint16_t dust_x10);
 
 #endif /* __SENSOR_UART_H */
\ No newline at end of file
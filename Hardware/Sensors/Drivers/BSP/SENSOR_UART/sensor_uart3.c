@@ -24,13 +24,65 @@
 
 #include "./BSP/SENSOR_UART/sensor_uart3.h"
 #include "./SYSTEM/delay/delay.h"
+#include "./BSP/SENSOR_UART/sensor_uart.h"
+#include "./BSP/SENSOR_UART/sensor_cmd.h"
 #include "./BSP/BEEP/beep.h"
-#include <stdio.h>
-#include <string.h>
+#include "./BSP/SENSOR/sensor_history.h"
+#include "./BSP/RTC/rtc.h"
 
 /* UART3句柄 */
 UART_HandleTypeDef g_uart3_handle;
 
+/* USART3 DMA发送队列 */
+uart_tx_t g_uart3_tx;
+static uint8_t g_uart3_tx_buf[SENSOR_UART3_TX_BUF_SIZE];
+
+/* 二进制帧序号, ESP32据此发现丢帧 */
+static uint16_t g_uart3_frame_seq = 0;
+
+/* 接收: DMA循环写入g_uart3_rx_buf, sensor_uart3_poll按0x00分帧 */
+sensor_uart3_rx_stats_t g_uart3_rx_stats;
+static DMA_HandleTypeDef g_uart3_rx_dma;
+static uint8_t g_uart3_rx_buf[SENSOR_UART3_RX_BUF_SIZE];
+static uint16_t g_uart3_rx_dma_pos = 0;         /* 上次更新时DMA的写入位置 */
+static volatile uint32_t g_uart3_rx_total = 0;  /* DMA累计写入字节数 */
+static volatile uint8_t g_uart3_rx_event = 0;   /* 1: 有IDLE/HT/TC事件还没处理 */
+static uint32_t g_uart3_rx_done = 0;            /* 主循环累计处理字节数 */
+static uint8_t g_uart3_rx_frame[SENSOR_FRAME_MAX_ENCODED];
+static uint16_t g_uart3_rx_len = 0;
+static uint8_t g_uart3_rx_drop = 0;             /* 1: 当前帧已溢出, 丢弃到下一个0x00 */
+
+/* 补传: 待发记录序号[next, next + remain) */
+static uint16_t g_uart3_backfill_next = 0;
+static uint16_t g_uart3_backfill_remain = 0;
+
+/**
+ * @brief       按DMA剩余计数更新接收字节总数
+ * @note        在接收中断里调用, 或在主循环中关中断调用.
+ *              两次更新之间最多相隔半个缓冲区(HT/TC中断保证), 位置差就是新收到的字节数
+ * @param       无
+ * @retval      无
+ */
+static void sensor_uart3_rx_update(void)
+{
+    uint16_t pos = (SENSOR_UART3_RX_BUF_SIZE - __HAL_DMA_GET_COUNTER(&g_uart3_rx_dma)) & (SENSOR_UART3_RX_BUF_SIZE - 1);
+
+    g_uart3_rx_total += (pos - g_uart3_rx_dma_pos) & (SENSOR_UART3_RX_BUF_SIZE - 1);
+    g_uart3_rx_dma_pos = pos;
+}
+
+/**
+ * @brief       接收DMA半满/满回调
+ * @param       hdma: DMA句柄
+ * @retval      无
+ */
+static void sensor_uart3_rx_dma_callback(DMA_HandleTypeDef *hdma)
+{
+    (void)hdma;
+    sensor_uart3_rx_update();
+    g_uart3_rx_event = 1;
+}
+
 /**
  * @brief       初始化UART3
  * @param       baudrate: 波特率
@@ -66,61 +118,263 @@ void sensor_uart3_init(uint32_t baudrate)
     g_uart3_handle.Init.HwFlowCtl = UART_HWCONTROL_NONE;
     g_uart3_handle.Init.Mode = UART_MODE_TX_RX;
     HAL_UART_Init(&g_uart3_handle);
+
+    /* 发送走DMA队列, 主循环不再阻塞等待 */
+    uart_tx_init(&g_uart3_tx, &g_uart3_handle, DMA1_Channel2, DMA1_Channel2_IRQn,
+                 g_uart3_tx_buf, sizeof(g_uart3_tx_buf));
+
+    /* 接收: DMA1通道3循环模式, 不链接到串口句柄, HAL的串口中断处理不会碰接收 */
+    g_uart3_rx_dma.Instance = DMA1_Channel3;
+    g_uart3_rx_dma.Init.Direction = DMA_PERIPH_TO_MEMORY;       /* 外设到存储器 */
+    g_uart3_rx_dma.Init.PeriphInc = DMA_PINC_DISABLE;           /* 外设地址不增 */
+    g_uart3_rx_dma.Init.MemInc = DMA_MINC_ENABLE;               /* 存储器地址递增 */
+    g_uart3_rx_dma.Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
+    g_uart3_rx_dma.Init.MemDataAlignment = DMA_MDATAALIGN_BYTE;
+    g_uart3_rx_dma.Init.Mode = DMA_CIRCULAR;                    /* 循环模式 */
+    g_uart3_rx_dma.Init.Priority = DMA_PRIORITY_HIGH;           /* 接收不能等, 高于发送 */
+    HAL_DMA_Init(&g_uart3_rx_dma);
+
+    /* 设置了半满回调, HAL_DMA_Start_IT才会同时打开HT中断 */
+    g_uart3_rx_dma.XferHalfCpltCallback = sensor_uart3_rx_dma_callback;
+    g_uart3_rx_dma.XferCpltCallback = sensor_uart3_rx_dma_callback;
+
+    HAL_NVIC_SetPriority(DMA1_Channel3_IRQn, 3, 1);
+    HAL_NVIC_EnableIRQ(DMA1_Channel3_IRQn);
+
+    HAL_DMA_Start_IT(&g_uart3_rx_dma, (uint32_t)&USART3->DR, (uint32_t)g_uart3_rx_buf, SENSOR_UART3_RX_BUF_SIZE);
+    SET_BIT(USART3->CR3, USART_CR3_DMAR);
+    __HAL_UART_ENABLE_IT(&g_uart3_handle, UART_IT_IDLE);
+}
+
+/**
+ * @brief       USART3中断服务函数
+ * @param       无
+ * @retval      无
+ */
+void USART3_IRQHandler(void)
+{
+    /* 线路空闲: 一串数据(通常是一帧)收完. 先读SR再读DR清除IDLE, 同时清除ORE;
+     * 这时DMA已经取走全部数据, 读DR不会丢字节
+     */
+    if (USART3->SR & USART_SR_IDLE)
+    {
+        (void)USART3->DR;
+        sensor_uart3_rx_update();
+        g_uart3_rx_event = 1;
+        g_uart3_rx_stats.idle_events++;
+    }
+
+    HAL_UART_IRQHandler(&g_uart3_handle);   /* 发送完成(TC)仍由HAL处理 */
+}
+
+/**
+ * @brief       USART3 TX DMA中断服务函数
+ * @param       无
+ * @retval      无
+ */
+void DMA1_Channel2_IRQHandler(void)
+{
+    HAL_DMA_IRQHandler(&g_uart3_tx.hdma);
+}
+
+/**
+ * @brief       USART3 RX DMA中断服务函数(半满/满)
+ * @param       无
+ * @retval      无
+ */
+void DMA1_Channel3_IRQHandler(void)
+{
+    HAL_DMA_IRQHandler(&g_uart3_rx_dma);
 }
 
 /**
  * @brief       通过UART3发送传感器数据
- * @param       temperature: 温度值
- * @param       humidity: 湿度值
- * @param       co_ppm: 一氧化碳浓度(ppm)
- * @param       dust_density: 粉尘浓度(ug/m3)
+ * @note        二进制帧带测量标志, 还没有结果的字段由ESP32忽略; 文本行没有测量标志,
+ *              所有传感器都出过结果之前不发送
+ * @param       sample: 当前样本(报警位图取g_current_alarm_mask), 采集时间只在二进制帧中发送
  * @retval      无
  */
-void sensor_uart3_send_data(uint8_t temperature, uint8_t humidity, float co_ppm, float dust_density)
+void sensor_uart3_send_data(const sensor_sample_t *sample)
 {
-    char buffer[150];
-    int len;
-    char alarm_str[20] = "None";
-    
-    /* 根据当前报警类型设置报警字符串 */
-    switch(g_current_alarm)
+#if SENSOR_UART3_LINK_MODE == SENSOR_LINK_BINARY
+    uint8_t frame[SENSOR_FRAME_MAX_ENCODED];
+    sensor_sample_t s = *sample;
+    uint16_t len;
+
+    s.alarm_mask = g_current_alarm_mask;
+
+    len = sensor_frame_pack_sample(SENSOR_FRAME_TYPE_SAMPLE, g_uart3_frame_seq++, &s, frame);
+
+    /* 放入DMA发送队列, 不等待发送完成 */
+    uart_tx_write(&g_uart3_tx, frame, len);
+#else
+    char buffer[SENSOR_UART_LINE_MAX];
+    uint16_t len;
+
+    if ((sample->valid & SENSOR_VALID_ALL) != SENSOR_VALID_ALL)
     {
-        case BEEP_ALARM_NONE:
-            strcpy(alarm_str, "None");
-            break;
-        case BEEP_ALARM_TEMP_HIGH:
-            strcpy(alarm_str, "Temp High");
-            break;
-        case BEEP_ALARM_TEMP_LOW:
-            strcpy(alarm_str, "Temp Low");
-            break;
-        case BEEP_ALARM_HUMI_HIGH:
-            strcpy(alarm_str, "Humi High");
-            break;
-        case BEEP_ALARM_HUMI_LOW:
-            strcpy(alarm_str, "Humi Low");
-            break;
-        case BEEP_ALARM_CO_NORMAL:
-            strcpy(alarm_str, "CO Normal");
-            break;
-        case BEEP_ALARM_CO_DANGER:
-            strcpy(alarm_str, "CO Danger");
-            break;
-        case BEEP_ALARM_DUST_LOW:
-            strcpy(alarm_str, "Dust Low");
-            break;
-        case BEEP_ALARM_DUST_HIGH:
-            strcpy(alarm_str, "Dust High");
-            break;
-        default:
-            strcpy(alarm_str, "Unknown");
-            break;
+        return;
     }
-    
+
     /* 格式化传感器数据为字符串，添加报警信息 */
-    len = sprintf(buffer, "T:%d,H:%d,CO:%.1f,DUST:%.1f,ALARM:%s\r\n", 
-                 temperature, humidity, co_ppm, dust_density, alarm_str);
-    
-    /* 通过HAL库函数发送数据 */
-    HAL_UART_Transmit(&g_uart3_handle, (uint8_t*)buffer, len, 100);
-}
\ No newline at end of file
+    len = sensor_uart_format_line(buffer, sample->temperature, sample->humidity, sample->co_x10, sample->dust_x10,
+                                  g_current_alarm);
+
+    /* 放入DMA发送队列, 不等待发送完成 */
+    uart_tx_write(&g_uart3_tx, (uint8_t*)buffer, len);
+#endif
+}
+
+/**
+ * @brief       通过UART3发送一条历史记录
+ * @note        只有二进制链路支持记录帧, 文本链路下什么也不做
+ * @param       seq: 记录序号
+ * @param       sample: 记录
+ * @retval      无
+ */
+void sensor_uart3_send_record(uint16_t seq, const sensor_sample_t *sample)
+{
+#if SENSOR_UART3_LINK_MODE == SENSOR_LINK_BINARY
+    uint8_t frame[SENSOR_FRAME_MAX_ENCODED];
+    uint16_t len;
+
+    len = sensor_frame_pack_record(seq, rtc_get_boot_id(), sample, frame);
+    uart_tx_write(&g_uart3_tx, frame, len);
+#else
+    (void)seq;
+    (void)sample;
+#endif
+}
+
+/**
+ * @brief       补传记录
+ * @note        只在发送队列空闲空间能放下一整帧时发送, 补传不会挤掉实时样本帧;
+ *              剩下的记录留到下一次调用, 115200波特率下每次最多约10帧
+ * @param       无
+ * @retval      无
+ */
+static void sensor_uart3_backfill_pump(void)
+{
+    sensor_sample_t sample;
+
+    while (g_uart3_backfill_remain > 0 &&
+           g_uart3_tx.size - uart_tx_pending(&g_uart3_tx) >= 2 * SENSOR_FRAME_MAX_ENCODED)
+    {
+        if (sensor_history_get(g_uart3_backfill_next, &sample) == 0)
+        {
+            sensor_uart3_send_record(g_uart3_backfill_next, &sample);
+            g_uart3_rx_stats.backfill_sent++;
+        }
+
+        g_uart3_backfill_next++;
+        g_uart3_backfill_remain--;
+    }
+}
+
+/**
+ * @brief       开始补传
+ * @note        新请求替换未发完的旧请求, ESP32超时后会重新请求缺的部分
+ * @param       first: 起始记录序号
+ * @param       count: 条数, 0表示取消
+ * @retval      无
+ */
+void sensor_uart3_start_backfill(uint16_t first, uint16_t count)
+{
+    g_uart3_backfill_next = first;
+    g_uart3_backfill_remain = count;
+    g_uart3_rx_stats.backfill_reqs++;
+}
+
+/**
+ * @brief       处理ESP32发来的一帧
+ * @note        交给sensor_cmd执行, 再用同一序号回应答帧; 补传记录在应答之后发出
+ * @param       data: 编码后的帧(不含0x00结束符)
+ * @param       len: 长度
+ * @retval      无
+ */
+static void sensor_uart3_handle_frame(const uint8_t *data, uint16_t len)
+{
+    uint8_t payload[SENSOR_FRAME_MAX_PAYLOAD];
+    uint8_t frame[SENSOR_FRAME_MAX_ENCODED];
+    uint8_t ack[SENSOR_FRAME_ACK_PAYLOAD_LEN];
+    uint16_t payload_len;
+    uint16_t seq;
+    uint8_t type;
+
+    if (sensor_frame_unpack(data, len, &type, &seq, payload, &payload_len) != SENSOR_FRAME_OK)
+    {
+        g_uart3_rx_stats.errors++;
+        return;
+    }
+
+    g_uart3_rx_stats.frames++;
+
+    ack[0] = type;
+    ack[1] = sensor_cmd_dispatch(type, payload, payload_len);
+
+    len = sensor_frame_pack(SENSOR_FRAME_TYPE_ACK, seq, ack, sizeof(ack), frame);
+
+    if (uart_tx_write(&g_uart3_tx, frame, len) == 0)
+    {
+        g_uart3_rx_stats.acks++;
+    }
+}
+
+/**
+ * @brief       处理ESP32发来的数据, 并继续发送未完成的补传
+ * @note        没有IDLE/HT/TC事件时直接跳过分帧; 有事件时取出DMA新写入的字节, 遇到0x00结束一帧.
+ *              未处理的数据超过缓冲区大小说明已被DMA覆盖, 丢弃当前帧并从最新的一圈数据重新同步
+ * @param       无
+ * @retval      无
+ */
+void sensor_uart3_poll(void)
+{
+    uint32_t total;
+    uint8_t c;
+
+    if (g_uart3_rx_event)
+    {
+        __disable_irq();
+        sensor_uart3_rx_update();
+        total = g_uart3_rx_total;
+        g_uart3_rx_event = 0;
+        __enable_irq();
+
+        if (total - g_uart3_rx_done > SENSOR_UART3_RX_BUF_SIZE)
+        {
+            g_uart3_rx_done = total - SENSOR_UART3_RX_BUF_SIZE;
+            g_uart3_rx_drop = 1;
+            g_uart3_rx_stats.overflows++;
+        }
+
+        g_uart3_rx_stats.bytes += total - g_uart3_rx_done;
+
+        while (g_uart3_rx_done != total)
+        {
+            c = g_uart3_rx_buf[g_uart3_rx_done & (SENSOR_UART3_RX_BUF_SIZE - 1)];
+            g_uart3_rx_done++;
+
+            if (c == 0x00)
+            {
+                if (g_uart3_rx_len > 0 && g_uart3_rx_drop == 0)
+                {
+                    sensor_uart3_handle_frame(g_uart3_rx_frame, g_uart3_rx_len);
+                }
+
+                g_uart3_rx_len = 0;
+                g_uart3_rx_drop = 0;
+            }
+            else if (g_uart3_rx_len < sizeof(g_uart3_rx_frame))
+            {
+                g_uart3_rx_frame[g_uart3_rx_len++] = c;
+            }
+            else if (g_uart3_rx_drop == 0)
+            {
+                g_uart3_rx_drop = 1;
+                g_uart3_rx_stats.overflows++;
+            }
+        }
+    }
+
+    sensor_uart3_backfill_pump();
+}
@@ -28,12 +28,57 @@
 #include "./SYSTEM/sys/sys.h"
 #include "./SYSTEM/usart/usart.h"
 #include "./SYSTEM/delay/delay.h"
+#include "./BSP/SENSOR_UART/sensor_frame.h"
+#include "./BSP/SENSOR_UART/uart_tx.h"
+
+/* 向ESP32发送数据的周期(ms)
+ * ESP32端把样本折叠进1分钟窗口后再发布汇总，这里可以比云端上报频率高得多
+ */
+#define SENSOR_UART3_SEND_PERIOD_MS     1000
+
+#define SENSOR_UART3_TX_BUF_SIZE        256     /* USART3 DMA发送缓冲区大小 */
+#define SENSOR_UART3_RX_BUF_SIZE        256     /* USART3循环DMA接收缓冲区大小(2的幂) */
+#define SENSOR_UART3_RX_POLL_MS         20      /* 接收处理周期 */
+
+/* 接收: DMA1通道3循环写入接收缓冲区, 不再每字节进一次中断.
+ * 线路空闲(IDLE), DMA半满(HT)和满(TC)时中断一次, 只更新写入位置并置事件标志;
+ * sensor_uart3_poll有事件时才分帧处理. HT/TC保证两次更新之间DMA最多写半个缓冲区,
+ * 115200波特率下主循环两次处理之间可以落后约11ms的数据而不丢失.
+ */
+
+/* 接收统计 */
+typedef struct
+{
+    uint32_t frames;                            /* 处理的帧数 */
+    uint32_t bytes;                             /* 接收字节数 */
+    uint32_t idle_events;                       /* 线路空闲中断次数 */
+    uint32_t acks;                              /* 发出的应答帧数 */
+    uint32_t time_syncs;                        /* 校时次数 */
+    uint32_t errors;                            /* 格式/CRC错误 */
+    uint32_t overflows;                         /* DMA缓冲区或帧缓冲区溢出 */
+    uint32_t backfill_reqs;                     /* 补传请求次数 */
+    uint32_t backfill_sent;                     /* 补传发出的记录数 */
+} sensor_uart3_rx_stats_t;
+
+/* USART3链路格式
+ * SENSOR_LINK_ASCII : "T:%d,H:%d,CO:%.1f,DUST:%.1f,ALARM:%s\r\n" 文本行(旧格式, 便于串口助手调试)
+ * SENSOR_LINK_BINARY: COBS + CRC16 二进制帧, 格式见sensor_frame.h
+ * ESP32端两种格式都能自动识别
+ */
+#define SENSOR_LINK_ASCII               0
+#define SENSOR_LINK_BINARY              1
+#define SENSOR_UART3_LINK_MODE          SENSOR_LINK_BINARY
 
 /* 外部变量声明 */
 extern UART_HandleTypeDef g_uart3_handle; /* UART3句柄 */
+extern uart_tx_t g_uart3_tx;              /* USART3 DMA发送队列 */
+extern sensor_uart3_rx_stats_t g_uart3_rx_stats;
 
 /* 函数声明 */
 void sensor_uart3_init(uint32_t baudrate);
-void sensor_uart3_send_data(uint8_t temperature, uint8_t humidity, float co_ppm, float dust_density);
+void sensor_uart3_send_data(const sensor_sample_t *sample);                    /* 发送当前样本 */
+void sensor_uart3_send_record(uint16_t seq, const sensor_sample_t *sample);   /* 发送一条历史记录 */
+void sensor_uart3_start_backfill(uint16_t first, uint16_t count);   /* 开始补传[first, first + count) */
+void sensor_uart3_poll(void);             /* 处理ESP32发来的帧并补传记录, 每SENSOR_UART3_RX_POLL_MS调用 */
 
 #endif /* __SENSOR_UART3_H */
\ No newline at end of file
@@ -0,0 +1,203 @@
+/**
+ ****************************************************************************************************
+ * @file        uart_tx.c
+ * @author      正点原子团队(ALIENTEK)
+ * @version     V1.0
+ * @date        2023-06-05
+ * @brief       串口DMA发送队列(环形缓冲区)
+ * @license     Copyright (c) 2020-2032, 广州市星翼电子科技有限公司
+ ****************************************************************************************************
+ * @attention
+ *
+ * 实验平台:正点原子 STM32F103开发板
+ * 在线视频:www.yuanzige.com
+ * 技术论坛:www.openedv.com
+ * 公司网址:www.alientek.com
+ * 购买地址:openedv.taobao.com
+ *
+ * 修改说明
+ * V1.0 20230605
+ * 第一次发布
+ *
+ ****************************************************************************************************
+ */
+
+#include "./BSP/SENSOR_UART/uart_tx.h"
+#include <string.h>
+
+/* 已注册的发送队列, 供HAL_UART_TxCpltCallback查找 */
+static uart_tx_t *g_uart_tx_ports[UART_TX_MAX_PORTS];
+
+/**
+ * @brief       启动下一段DMA发送
+ * @note        必须在关中断或发送完成中断中调用
+ * @param       tx: 发送队列
+ * @retval      无
+ */
+static void uart_tx_kick(uart_tx_t *tx)
+{
+    uint16_t chunk;
+
+    if (tx->dma_len != 0 || tx->count == 0)
+    {
+        return;
+    }
+
+    /* DMA只能发送连续地址, 数据回绕时先发到缓冲区末尾 */
+    chunk = tx->size - tx->tail;
+
+    if (chunk > tx->count)
+    {
+        chunk = tx->count;
+    }
+
+    tx->dma_len = chunk;
+
+    if (HAL_UART_Transmit_DMA(tx->huart, tx->buf + tx->tail, chunk) != HAL_OK)
+    {
+        tx->dma_len = 0;
+    }
+}
+
+/**
+ * @brief       初始化串口DMA发送队列
+ * @note        串口需已通过HAL_UART_Init初始化, 本函数配置DMA并使能DMA和串口中断
+ * @param       tx: 发送队列
+ * @param       huart: 串口句柄
+ * @param       channel: 串口TX对应的DMA通道(USART1:DMA1_Channel4, USART3:DMA1_Channel2)
+ * @param       dma_irq: DMA通道中断号
+ * @param       buf: 环形缓冲区
+ * @param       size: 缓冲区大小
+ * @retval      无
+ */
+void uart_tx_init(uart_tx_t *tx, UART_HandleTypeDef *huart, DMA_Channel_TypeDef *channel,
+                  IRQn_Type dma_irq, uint8_t *buf, uint16_t size)
+{
+    uint8_t i;
+
+    memset(tx, 0, sizeof(uart_tx_t));
+    tx->huart = huart;
+    tx->buf = buf;
+    tx->size = size;
+
+    __HAL_RCC_DMA1_CLK_ENABLE();
+
+    tx->hdma.Instance = channel;
+    tx->hdma.Init.Direction = DMA_MEMORY_TO_PERIPH;             /* 存储器到外设 */
+    tx->hdma.Init.PeriphInc = DMA_PINC_DISABLE;                 /* 外设地址不增 */
+    tx->hdma.Init.MemInc = DMA_MINC_ENABLE;                     /* 存储器地址递增 */
+    tx->hdma.Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
+    tx->hdma.Init.MemDataAlignment = DMA_MDATAALIGN_BYTE;
+    tx->hdma.Init.Mode = DMA_NORMAL;
+    tx->hdma.Init.Priority = DMA_PRIORITY_MEDIUM;
+    HAL_DMA_Init(&tx->hdma);
+    __HAL_LINKDMA(huart, hdmatx, tx->hdma);
+
+    /* DMA传输完成后HAL库等待串口TC中断再回调HAL_UART_TxCpltCallback, 两个中断都要打开 */
+    HAL_NVIC_SetPriority(dma_irq, 3, 2);
+    HAL_NVIC_EnableIRQ(dma_irq);
+
+    if (huart->Instance == USART1)
+    {
+        HAL_NVIC_SetPriority(USART1_IRQn, 3, 3);
+        HAL_NVIC_EnableIRQ(USART1_IRQn);
+    }
+    else if (huart->Instance == USART3)
+    {
+        HAL_NVIC_SetPriority(USART3_IRQn, 3, 3);
+        HAL_NVIC_EnableIRQ(USART3_IRQn);
+    }
+
+    for (i = 0; i < UART_TX_MAX_PORTS; i++)
+    {
+        if (g_uart_tx_ports[i] == 0 || g_uart_tx_ports[i] == tx)
+        {
+            g_uart_tx_ports[i] = tx;
+            break;
+        }
+    }
+}
+
+/**
+ * @brief       把数据写入发送队列
+ * @note        只拷贝数据, 不等待发送完成; 队列放不下时整条丢弃
+ * @param       tx: 发送队列
+ * @param       data: 数据
+ * @param       len: 数据长度
+ * @retval      0, 成功; 1, 队列已满, 数据被丢弃
+ */
+uint8_t uart_tx_write(uart_tx_t *tx, const uint8_t *data, uint16_t len)
+{
+    uint16_t first;
+    uint16_t used;
+
+    /* count只会被中断减小, 这里读到的空闲空间只可能偏小, 不会越界 */
+    if (len > tx->size - tx->count)
+    {
+        tx->stats.dropped_msgs++;
+        tx->stats.dropped_bytes += len;
+        return 1;
+    }
+
+    /* 空闲区不会被DMA访问, 拷贝可以在开中断状态下进行 */
+    first = tx->size - tx->head;
+
+    if (first > len)
+    {
+        first = len;
+    }
+
+    memcpy(tx->buf + tx->head, data, first);
+    memcpy(tx->buf, data + first, len - first);
+    tx->head = (tx->head + len) % tx->size;
+
+    __disable_irq();
+    tx->count += len;
+    used = tx->count;
+    uart_tx_kick(tx);
+    __enable_irq();
+
+    if (used > tx->stats.max_used)
+    {
+        tx->stats.max_used = used;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief       查询队列中待发送的字节数
+ * @param       tx: 发送队列
+ * @retval      待发送字节数(含正在发送的)
+ */
+uint16_t uart_tx_pending(uart_tx_t *tx)
+{
+    return tx->count;
+}
+
+/**
+ * @brief       串口发送完成回调
+ * @note        释放刚发送完的一段数据并启动下一段
+ * @param       huart: 串口句柄
+ * @retval      无
+ */
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart)
+{
+    uart_tx_t *tx;
+    uint8_t i;
+
+    for (i = 0; i < UART_TX_MAX_PORTS; i++)
+    {
+        tx = g_uart_tx_ports[i];
+
+        if (tx != 0 && tx->huart == huart)
+        {
+            tx->tail = (tx->tail + tx->dma_len) % tx->size;
+            tx->count -= tx->dma_len;
+            tx->stats.sent_bytes += tx->dma_len;
+            tx->dma_len = 0;
+            uart_tx_kick(tx);
+            break;
+        }
+    }
+}
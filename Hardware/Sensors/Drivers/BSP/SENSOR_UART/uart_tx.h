@@ -0,0 +1,68 @@
+/**
+ ****************************************************************************************************
+ * @file        uart_tx.h
+ * @author      正点原子团队(ALIENTEK)
+ * @version     V1.0
+ * @date        2023-06-05
+ * @brief       串口DMA发送队列(环形缓冲区)
+ * @license     Copyright (c) 2020-2032, 广州市星翼电子科技有限公司
+ ****************************************************************************************************
+ * @attention
+ *
+ * 实验平台:正点原子 STM32F103开发板
+ * 在线视频:www.yuanzige.com
+ * 技术论坛:www.openedv.com
+ * 公司网址:www.alientek.com
+ * 购买地址:openedv.taobao.com
+ *
+ * 使用说明:
+ * uart_tx_write()只把数据拷贝进环形缓冲区, 立即返回; DMA每次发送缓冲区中一段连续的数据,
+ * 发送期间主循环可以继续往另一段空闲区写入(相当于双缓冲). 发送完成中断里释放已发送的
+ * 数据并启动下一段. 缓冲区放不下整条消息时丢弃该消息并计数, 不会覆盖已在队列中的数据,
+ * 以免二进制帧被截断.
+ * 每个队列只允许一个写入者(主循环).
+ *
+ * 修改说明
+ * V1.0 20230605
+ * 第一次发布
+ *
+ ****************************************************************************************************
+ */
+
+#ifndef __UART_TX_H
+#define __UART_TX_H
+
+#include "./SYSTEM/sys/sys.h"
+
+#define UART_TX_MAX_PORTS               2       /* 最多管理的串口数 */
+
+/* 发送统计 */
+typedef struct
+{
+    uint32_t sent_bytes;        /* 已发送字节数 */
+    uint32_t dropped_msgs;      /* 队列满被丢弃的消息数 */
+    uint32_t dropped_bytes;     /* 队列满被丢弃的字节数 */
+    uint16_t max_used;          /* 缓冲区最高占用 */
+} uart_tx_stats_t;
+
+/* 串口DMA发送队列 */
+typedef struct
+{
+    UART_HandleTypeDef *huart;  /* 对应的串口 */
+    DMA_HandleTypeDef hdma;     /* 发送DMA */
+    uint8_t *buf;               /* 环形缓冲区 */
+    uint16_t size;              /* 缓冲区大小 */
+    uint16_t head;              /* 写入位置(仅主循环修改) */
+    volatile uint16_t tail;     /* 待发送数据起始位置(仅中断修改) */
+    volatile uint16_t count;    /* 缓冲区中的字节数(含正在发送的) */
+    volatile uint16_t dma_len;  /* 本次DMA发送长度, 0表示DMA空闲 */
+    uart_tx_stats_t stats;
+} uart_tx_t;
+
+/* 函数声明 */
+void uart_tx_init(uart_tx_t *tx, UART_HandleTypeDef *huart, DMA_Channel_TypeDef *channel,
+                  IRQn_Type dma_irq, uint8_t *buf, uint16_t size);      /* 初始化并绑定DMA通道 */
+uint8_t uart_tx_write(uart_tx_t *tx, const uint8_t *data, uint16_t len);  /* 写入发送队列, 0成功, 1丢弃 */
+uint16_t uart_tx_pending(uart_tx_t *tx);                                    /* 队列中待发送的字节数 */
+
+#endif /* __UART_TX_H */
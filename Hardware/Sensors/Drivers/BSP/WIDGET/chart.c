@@ -0,0 +1,230 @@
+/**
+ ****************************************************************************************************
+ * @file        chart.c
+ * @author      正点原子团队(ALIENTEK)
+ * @version     V1.0
+ * @date        2023-06-05
+ * @brief       CO/粉尘趋势图, 使用LCD控制器的硬件垂直滚动, 每个样本只写一行
+ * @license     Copyright (c) 2020-2032, 广州市星翼电子科技有限公司
+ ****************************************************************************************************
+ * @attention
+ *
+ * 实验平台:正点原子 STM32F103开发板
+ * 在线视频:www.yuanzige.com
+ * 技术论坛:www.openedv.com
+ * 公司网址:www.alientek.com
+ * 购买地址:openedv.taobao.com
+ *
+ * 修改说明
+ * V1.0 20230605
+ * 第一次发布
+ *
+ ****************************************************************************************************
+ */
+
+#include "./BSP/WIDGET/chart.h"
+#include "./BSP/LCD/lcd.h"
+
+
+/* 样本环形缓冲区 */
+static uint16_t g_chart_co[CHART_ROWS];
+static uint16_t g_chart_dust[CHART_ROWS];
+static uint8_t g_chart_head = 0;                /* 下一个样本的位置 */
+static uint8_t g_chart_count = 0;               /* 已有样本数 */
+
+static uint8_t g_chart_hw_scroll = 0;           /* 1: 使用硬件垂直滚动 */
+static uint8_t g_chart_row = 0;                 /* 硬件滚动时下一个样本写入的GRAM行(相对CHART_Y) */
+
+/**
+ * @brief       写一条参数为16位数的命令
+ * @note        NT35510的命令为cmd << 8, 每个参数字节是单独的寄存器; 其他控制器是MIPI DCS命令加字节参数
+ * @param       cmd: DCS命令(0x33 / 0x37)
+ * @param       param: 参数数组
+ * @param       num: 16位参数个数
+ * @retval      无
+ */
+static void chart_write_cmd(uint8_t cmd, const uint16_t *param, uint8_t num)
+{
+    uint8_t i;
+
+    if (lcddev.id == 0X5510)
+    {
+        for (i = 0; i < num; i++)
+        {
+            lcd_write_reg((cmd << 8) + i * 2, param[i] >> 8);
+            lcd_write_reg((cmd << 8) + i * 2 + 1, param[i] & 0XFF);
+        }
+    }
+    else
+    {
+        lcd_wr_regno(cmd);
+
+        for (i = 0; i < num; i++)
+        {
+            lcd_wr_data(param[i] >> 8);
+            lcd_wr_data(param[i] & 0XFF);
+        }
+    }
+}
+
+/**
+ * @brief       设置滚动起始地址
+ * @param       row: 显示在滚动区第一行的GRAM行(相对CHART_Y)
+ * @retval      无
+ */
+static void chart_set_scroll(uint8_t row)
+{
+    uint16_t vsp = CHART_Y + row;
+
+    chart_write_cmd(0x37, &vsp, 1);     /* VSCRSADD */
+}
+
+/**
+ * @brief       数值换算为横条长度
+ * @param       val_x10: 数值 * 10
+ * @param       full_x10: 满量程 * 10
+ * @param       width: 满量程对应的像素数
+ * @retval      像素数
+ */
+static uint16_t chart_scale(uint16_t val_x10, uint16_t full_x10, uint16_t width)
+{
+    if (val_x10 == 0)
+    {
+        return 0;
+    }
+
+    if (val_x10 >= full_x10)
+    {
+        return width;
+    }
+
+    return (uint32_t)val_x10 * width / full_x10;
+}
+
+/**
+ * @brief       在GRAM的一行画出一个样本
+ * @note        开一行的窗口后连续写入整行像素: CO横条, 中间分隔线, 粉尘横条
+ * @param       y: GRAM行
+ * @param       co_x10: CO浓度 * 10
+ * @param       dust_x10: 粉尘浓度 * 10
+ * @retval      无
+ */
+static void chart_draw_row(uint16_t y, uint16_t co_x10, uint16_t dust_x10)
+{
+    uint16_t half = lcddev.width / 2;
+    uint16_t co_end = chart_scale(co_x10, CHART_CO_FULL_X10, half - 1);
+    uint16_t dust_end = half + chart_scale(dust_x10, CHART_DUST_FULL_X10, lcddev.width - half);
+    uint16_t x;
+
+    lcd_set_window(0, y, lcddev.width, 1);
+    lcd_write_ram_prepare();
+
+    for (x = 0; x < lcddev.width; x++)
+    {
+        if (x < co_end)
+        {
+            LCD->LCD_RAM = CHART_CO_COLOR;
+        }
+        else if (x == half - 1)
+        {
+            LCD->LCD_RAM = CHART_AXIS_COLOR;
+        }
+        else if (x >= half && x < dust_end)
+        {
+            LCD->LCD_RAM = CHART_DUST_COLOR;
+        }
+        else
+        {
+            LCD->LCD_RAM = CHART_BACK_COLOR;
+        }
+    }
+
+    lcd_set_window(0, 0, lcddev.width, lcddev.height);  /* 恢复全屏窗口 */
+}
+
+/**
+ * @brief       初始化趋势图
+ * @note        竖屏且控制器支持时设置滚动区: 上固定区CHART_Y行, 滚动区CHART_ROWS行, 其余为下固定区
+ * @param       无
+ * @retval      无
+ */
+void chart_init(void)
+{
+    uint16_t area[3];
+
+    g_chart_head = 0;
+    g_chart_count = 0;
+    g_chart_row = 0;
+    g_chart_hw_scroll = (lcddev.dir == 0 && lcddev.id != 0X1963 && CHART_Y + CHART_ROWS <= lcddev.height);
+
+    if (g_chart_hw_scroll)
+    {
+        area[0] = CHART_Y;                                  /* TFA */
+        area[1] = CHART_ROWS;                               /* VSA */
+        area[2] = lcddev.height - CHART_Y - CHART_ROWS;     /* BFA */
+        chart_write_cmd(0x33, area, 3);                     /* VSCRDEF */
+        chart_set_scroll(0);
+    }
+
+    chart_redraw();
+}
+
+/**
+ * @brief       加入一个样本
+ * @note        硬件滚动时只写一行GRAM和一条滚动命令; 否则重画整个图
+ * @param       co_x10: CO浓度 * 10
+ * @param       dust_x10: 粉尘浓度 * 10
+ * @retval      无
+ */
+void chart_add(uint16_t co_x10, uint16_t dust_x10)
+{
+    g_chart_co[g_chart_head] = co_x10;
+    g_chart_dust[g_chart_head] = dust_x10;
+    g_chart_head = (g_chart_head + 1) % CHART_ROWS;
+
+    if (g_chart_count < CHART_ROWS)
+    {
+        g_chart_count++;
+    }
+
+    if (g_chart_hw_scroll)
+    {
+        /* 写入的行成为滚动区最后一行, 滚动起始指向它的下一行 */
+        chart_draw_row(CHART_Y + g_chart_row, co_x10, dust_x10);
+        g_chart_row = (g_chart_row + 1) % CHART_ROWS;
+        chart_set_scroll(g_chart_row);
+    }
+    else
+    {
+        chart_redraw();
+    }
+}
+
+/**
+ * @brief       按环形缓冲区重画整个图
+ * @note        最旧的样本在最上面, 没有样本的行画成空行
+ * @param       无
+ * @retval      无
+ */
+void chart_redraw(void)
+{
+    uint8_t i, idx;
+    uint16_t y;
+    uint8_t empty = CHART_ROWS - g_chart_count;
+
+    for (i = 0; i < CHART_ROWS; i++)
+    {
+        /* 屏幕第i行对应的GRAM行: 硬件滚动时屏幕第一行是GRAM的g_chart_row行 */
+        y = CHART_Y + (g_chart_hw_scroll ? (g_chart_row + i) % CHART_ROWS : i);
+
+        if (i < empty)
+        {
+            chart_draw_row(y, 0, 0);
+        }
+        else
+        {
+            idx = (g_chart_head + i) % CHART_ROWS;  /* 环形缓冲区已满时head处最旧 */
+            chart_draw_row(y, g_chart_co[idx], g_chart_dust[idx]);
+        }
+    }
+}
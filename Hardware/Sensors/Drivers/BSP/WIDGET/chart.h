@@ -0,0 +1,55 @@
+/**
+ ****************************************************************************************************
+ * @file        chart.h
+ * @author      正点原子团队(ALIENTEK)
+ * @version     V1.0
+ * @date        2023-06-05
+ * @brief       CO/粉尘趋势图, 使用LCD控制器的硬件垂直滚动, 每个样本只写一行
+ * @license     Copyright (c) 2020-2032, 广州市星翼电子科技有限公司
+ ****************************************************************************************************
+ * @attention
+ *
+ * 实验平台:正点原子 STM32F103开发板
+ * 在线视频:www.yuanzige.com
+ * 技术论坛:www.openedv.com
+ * 公司网址:www.alientek.com
+ * 购买地址:openedv.taobao.com
+ *
+ * 说明:
+ * 控制器的垂直滚动(VSCRDEF 0x33 / VSCRSADD 0x37)沿面板的行方向移动, 竖屏时只能上下滚动,
+ * 因此趋势图的时间轴是竖直的: 最新样本在图的最下面一行, 旧样本逐行上移.
+ * 每行左半部分是CO, 右半部分是粉尘, 从各自左边界画到数值对应位置的横条.
+ * 新样本写入滚动区中下一个GRAM行, 再把滚动起始地址指向它的下一行, 写入量与图的高度无关.
+ * 横屏或SSD1963(竖屏由软件旋转)不能用硬件滚动, 退化为每个样本按环形缓冲区重画整个图.
+ *
+ * 修改说明
+ * V1.0 20230605
+ * 第一次发布
+ *
+ ****************************************************************************************************
+ */
+
+#ifndef __CHART_H
+#define __CHART_H
+
+#include "./SYSTEM/sys/sys.h"
+
+
+#define CHART_Y                     220         /* 图的起始行, 上面的状态区不滚动 */
+#define CHART_ROWS                  100         /* 图的行数, 即保存的样本数 */
+#define CHART_SAMPLE_MS             36000       /* 每行间隔, 100行 * 36s = 1小时 */
+
+#define CHART_CO_FULL_X10           2500        /* CO满量程 250ppm */
+#define CHART_DUST_FULL_X10         5000        /* 粉尘满量程 500ug/m3 */
+
+#define CHART_BACK_COLOR            WHITE
+#define CHART_CO_COLOR              RED
+#define CHART_DUST_COLOR            BROWN
+#define CHART_AXIS_COLOR            GRAY
+
+/* 函数声明 */
+void chart_init(void);                                  /* 设置滚动区并清空图 */
+void chart_add(uint16_t co_x10, uint16_t dust_x10);     /* 加入一个样本, 画出新的一行 */
+void chart_redraw(void);                                /* 按环形缓冲区重画整个图(清屏后调用) */
+
+#endif
@@ -0,0 +1,194 @@
+/**
+ ****************************************************************************************************
+ * @file        widget.c
+ * @author      正点原子团队(ALIENTEK)
+ * @version     V1.0
+ * @date        2023-06-05
+ * @brief       LCD保留模式控件(标签/整数/定点数/状态标记), 只重画变化的字符
+ * @license     Copyright (c) 2020-2032, 广州市星翼电子科技有限公司
+ ****************************************************************************************************
+ * @attention
+ *
+ * 实验平台:正点原子 STM32F103开发板
+ * 在线视频:www.yuanzige.com
+ * 技术论坛:www.openedv.com
+ * 公司网址:www.alientek.com
+ * 购买地址:openedv.taobao.com
+ *
+ * 修改说明
+ * V1.0 20230605
+ * 第一次发布
+ *
+ ****************************************************************************************************
+ */
+
+#include "./BSP/WIDGET/widget.h"
+#include "./BSP/LCD/lcd.h"
+#include "./SYSTEM/fmt/fmt.h"
+
+
+uint32_t g_widget_chars = 0;
+
+/**
+ * @brief       把新文字更新到屏幕
+ * @note        text已按控件宽度补齐为len个字符. 只重画与屏上内容不同的字符,
+ *              lcd_show_char的非叠加方式用g_back_color作背景, 这里临时切换为控件背景色
+ * @param       w: 控件
+ * @param       text: 新文字
+ * @retval      无
+ */
+static void widget_update(widget_t *w, const char *text)
+{
+    uint32_t back = g_back_color;
+    uint8_t i;
+
+    for (i = 0; i < w->len; i++)
+    {
+        if (w->drawn && w->text[i] == text[i])
+        {
+            continue;   /* 屏上已经是这个字符 */
+        }
+
+        g_back_color = w->back_color;
+        lcd_show_char(w->x + (w->size / 2) * i, w->y, text[i], w->size, 0, w->color);
+        g_back_color = back;
+
+        w->text[i] = text[i];
+        g_widget_chars++;
+    }
+
+    w->drawn = 1;
+}
+
+/**
+ * @brief       把buf中的内容按对齐方式补齐到控件宽度
+ * @param       w: 控件
+ * @param       buf: 内容, 至少WIDGET_TEXT_MAX + 1字节
+ * @param       end: 内容结尾'\0'
+ * @param       right: 1, 右对齐; 0, 左对齐
+ * @retval      无
+ */
+static void widget_fit(widget_t *w, char *buf, char *end, uint8_t right)
+{
+    if (end - buf > w->len)
+    {
+        buf[w->len] = '\0';         /* 超长截断 */
+    }
+    else if (right)
+    {
+        fmt_put_pad(end, buf, w->len);
+    }
+    else
+    {
+        while (end < buf + w->len)
+        {
+            *end++ = ' ';
+        }
+
+        *end = '\0';
+    }
+}
+
+/**
+ * @brief       初始化控件
+ * @note        只记录位置和样式, 不访问LCD, 第一次设置内容时整体绘制
+ * @param       w: 控件
+ * @param       x,y: 左上角坐标
+ * @param       size: 字体大小 12/16/24/32
+ * @param       len: 占用的字符数, 超过WIDGET_TEXT_MAX时按WIDGET_TEXT_MAX
+ * @param       color: 字符颜色
+ * @param       back_color: 背景颜色
+ * @retval      无
+ */
+void widget_init(widget_t *w, uint16_t x, uint16_t y, uint8_t size, uint8_t len, uint16_t color, uint16_t back_color)
+{
+    w->x = x;
+    w->y = y;
+    w->size = size;
+    w->len = len > WIDGET_TEXT_MAX ? WIDGET_TEXT_MAX : len;
+    w->color = color;
+    w->back_color = back_color;
+    w->drawn = 0;
+    w->text[0] = '\0';
+}
+
+/**
+ * @brief       使控件下次整体重画
+ * @note        清屏或被其他内容覆盖后调用
+ * @param       w: 控件
+ * @retval      无
+ */
+void widget_invalidate(widget_t *w)
+{
+    w->drawn = 0;
+}
+
+/**
+ * @brief       设置标签文字
+ * @param       w: 控件
+ * @param       text: 文字, 左对齐, 不足部分补空格
+ * @retval      无
+ */
+void widget_set_text(widget_t *w, const char *text)
+{
+    char buf[WIDGET_TEXT_MAX + 1];
+    char *p = buf;
+
+    while (*text && p < buf + w->len)
+    {
+        *p++ = *text++;
+    }
+
+    *p = '\0';
+    widget_fit(w, buf, p, 0);
+    widget_update(w, buf);
+}
+
+/**
+ * @brief       设置整数
+ * @param       w: 控件
+ * @param       num: 数值, 右对齐
+ * @retval      无
+ */
+void widget_set_num(widget_t *w, int32_t num)
+{
+    char buf[WIDGET_TEXT_MAX + 1];
+
+    widget_fit(w, buf, fmt_put_int(buf, num), 1);
+    widget_update(w, buf);
+}
+
+/**
+ * @brief       设置一位小数定点数
+ * @param       w: 控件
+ * @param       num_x10: 数值 * 10, 如153显示为"15.3", 右对齐
+ * @retval      无
+ */
+void widget_set_x10(widget_t *w, int32_t num_x10)
+{
+    char buf[WIDGET_TEXT_MAX + 1];
+
+    widget_fit(w, buf, fmt_put_x10(buf, num_x10), 1);
+    widget_update(w, buf);
+}
+
+/**
+ * @brief       设置状态标记
+ * @note        文字和颜色一起设置; 颜色改变时整体重画, 否则只重画变化的字符
+ * @param       w: 控件
+ * @param       text: 文字, 左对齐
+ * @param       color: 字符颜色
+ * @param       back_color: 背景颜色
+ * @retval      无
+ */
+void widget_set_badge(widget_t *w, const char *text, uint16_t color, uint16_t back_color)
+{
+    if (w->color != color || w->back_color != back_color)
+    {
+        w->color = color;
+        w->back_color = back_color;
+        w->drawn = 0;
+    }
+
+    widget_set_text(w, text);
+}
@@ -0,0 +1,63 @@
+/**
+ ****************************************************************************************************
+ * @file        widget.h
+ * @author      正点原子团队(ALIENTEK)
+ * @version     V1.0
+ * @date        2023-06-05
+ * @brief       LCD保留模式控件(标签/整数/定点数/状态标记), 只重画变化的字符
+ * @license     Copyright (c) 2020-2032, 广州市星翼电子科技有限公司
+ ****************************************************************************************************
+ * @attention
+ *
+ * 实验平台:正点原子 STM32F103开发板
+ * 在线视频:www.yuanzige.com
+ * 技术论坛:www.openedv.com
+ * 公司网址:www.alientek.com
+ * 购买地址:openedv.taobao.com
+ *
+ * 使用说明:
+ *   static widget_t s_temp;
+ *   widget_init(&s_temp, 70, 110, 16, 2, BLUE, WHITE);
+ *   widget_set_num(&s_temp, temperature);      每次刷新都可以调用, 值不变时不访问LCD
+ * 控件保存屏幕上当前显示的文字, 新文字与之逐字符比较, 只重画不同的字符;
+ * 颜色改变或widget_invalidate之后整体重画一次.
+ *
+ * 修改说明
+ * V1.0 20230605
+ * 第一次发布
+ *
+ ****************************************************************************************************
+ */
+
+#ifndef __WIDGET_H
+#define __WIDGET_H
+
+#include "./SYSTEM/sys/sys.h"
+
+
+#define WIDGET_TEXT_MAX             16          /* 控件最多显示的字符数 */
+
+/* 控件 */
+typedef struct
+{
+    uint16_t x;                     /* 左上角坐标 */
+    uint16_t y;
+    uint8_t size;                   /* 字体大小 12/16/24/32 */
+    uint8_t len;                    /* 占用的字符数, 不超过WIDGET_TEXT_MAX */
+    uint16_t color;                 /* 字符颜色 */
+    uint16_t back_color;            /* 背景颜色 */
+    uint8_t drawn;                  /* 0: 屏上内容未知, 下次整体重画 */
+    char text[WIDGET_TEXT_MAX + 1]; /* 屏上当前显示的文字 */
+} widget_t;
+
+extern uint32_t g_widget_chars;     /* 累计重画的字符数, 稳定状态下应不再增加 */
+
+/* 函数声明 */
+void widget_init(widget_t *w, uint16_t x, uint16_t y, uint8_t size, uint8_t len, uint16_t color, uint16_t back_color);
+void widget_invalidate(widget_t *w);                                        /* 下次整体重画 */
+void widget_set_text(widget_t *w, const char *text);                        /* 标签, 左对齐, 右侧补空格 */
+void widget_set_num(widget_t *w, int32_t num);                              /* 整数, 右对齐 */
+void widget_set_x10(widget_t *w, int32_t num_x10);                          /* 一位小数定点数, 右对齐 */
+void widget_set_badge(widget_t *w, const char *text, uint16_t color, uint16_t back_color); /* 带颜色的状态标记 */
+
+#endif
@@ -0,0 +1,147 @@
+/**
+ ****************************************************************************************************
+ * @file        fmt.c
+ * @author      正点原子团队(ALIENTEK)
+ * @version     V1.0
+ * @date        2023-06-05
+ * @brief       整数/定点数格式化(不依赖带浮点的printf)
+ * @license     Copyright (c) 2020-2032, 广州市星翼电子科技有限公司
+ ****************************************************************************************************
+ * @attention
+ *
+ * 实验平台:正点原子 STM32F103开发板
+ * 在线视频:www.yuanzige.com
+ * 技术论坛:www.openedv.com
+ * 公司网址:www.alientek.com
+ * 购买地址:openedv.taobao.com
+ *
+ * 修改说明
+ * V1.0 20230605
+ * 第一次发布
+ *
+ ****************************************************************************************************
+ */
+
+#include "./SYSTEM/fmt/fmt.h"
+
+
+/**
+ * @brief       拼接字符串
+ * @param       p: 写入位置
+ * @param       s: 字符串
+ * @retval      指向结尾'\0'的指针
+ */
+char *fmt_put_str(char *p, const char *s)
+{
+    while (*s)
+    {
+        *p++ = *s++;
+    }
+
+    *p = '\0';
+    return p;
+}
+
+/**
+ * @brief       输出无符号十进制数
+ * @param       p: 写入位置
+ * @param       val: 数值
+ * @retval      指向结尾'\0'的指针
+ */
+char *fmt_put_uint(char *p, uint32_t val)
+{
+    char tmp[10];
+    uint8_t len = 0;
+
+    do
+    {
+        tmp[len++] = '0' + val % 10;
+        val /= 10;
+    } while (val);
+
+    while (len)
+    {
+        *p++ = tmp[--len];
+    }
+
+    *p = '\0';
+    return p;
+}
+
+/**
+ * @brief       输出有符号十进制数
+ * @param       p: 写入位置
+ * @param       val: 数值
+ * @retval      指向结尾'\0'的指针
+ */
+char *fmt_put_int(char *p, int32_t val)
+{
+    if (val < 0)
+    {
+        *p++ = '-';
+        return fmt_put_uint(p, 0u - (uint32_t)val);
+    }
+
+    return fmt_put_uint(p, val);
+}
+
+/**
+ * @brief       输出一位小数的定点数
+ * @param       p: 写入位置
+ * @param       val_x10: 放大10倍的数值, 如-53表示-5.3
+ * @retval      指向结尾'\0'的指针
+ */
+char *fmt_put_x10(char *p, int32_t val_x10)
+{
+    uint32_t abs_val;
+
+    if (val_x10 < 0)
+    {
+        *p++ = '-';
+        abs_val = 0u - (uint32_t)val_x10;
+    }
+    else
+    {
+        abs_val = val_x10;
+    }
+
+    p = fmt_put_uint(p, abs_val / 10);
+    *p++ = '.';
+    *p++ = '0' + abs_val % 10;
+    *p = '\0';
+    return p;
+}
+
+/**
+ * @brief       右对齐
+ * @note        用于LCD等固定宽度的显示, 内容不足width时左侧补空格, 超过width时不截断
+ * @param       p: 当前结尾(fmt_put_xxx的返回值)
+ * @param       start: 需要对齐的内容的起始位置
+ * @param       width: 宽度
+ * @retval      指向结尾'\0'的指针
+ */
+char *fmt_put_pad(char *p, char *start, uint8_t width)
+{
+    uint8_t len = p - start;
+    uint8_t pad;
+    int8_t i;
+
+    if (len >= width)
+    {
+        return p;
+    }
+
+    pad = width - len;
+
+    for (i = len; i >= 0; i--)      /* 连同'\0'一起后移 */
+    {
+        start[i + pad] = start[i];
+    }
+
+    for (i = 0; i < pad; i++)
+    {
+        start[i] = ' ';
+    }
+
+    return start + width;
+}
@@ -0,0 +1,43 @@
+/**
+ ****************************************************************************************************
+ * @file        fmt.h
+ * @author      正点原子团队(ALIENTEK)
+ * @version     V1.0
+ * @date        2023-06-05
+ * @brief       整数/定点数格式化(不依赖带浮点的printf)
+ * @license     Copyright (c) 2020-2032, 广州市星翼电子科技有限公司
+ ****************************************************************************************************
+ * @attention
+ *
+ * 实验平台:正点原子 STM32F103开发板
+ * 在线视频:www.yuanzige.com
+ * 技术论坛:www.openedv.com
+ * 公司网址:www.alientek.com
+ * 购买地址:openedv.taobao.com
+ *
+ * 使用说明:
+ * 所有fmt_put_xxx函数把内容写到p处, 写完后补'\0', 返回指向'\0'的指针, 可以连续拼接:
+ *   p = fmt_put_str(buf, "CO:");
+ *   p = fmt_put_x10(p, co_x10);     -> "CO:15.2"
+ * 调用者负责保证缓冲区足够大.
+ *
+ * 修改说明
+ * V1.0 20230605
+ * 第一次发布
+ *
+ ****************************************************************************************************
+ */
+
+#ifndef __FMT_H
+#define __FMT_H
+
+#include "./SYSTEM/sys/sys.h"
+
+
+char *fmt_put_str(char *p, const char *s);                              /* 拼接字符串 */
+char *fmt_put_uint(char *p, uint32_t val);                              /* 无符号十进制 */
+char *fmt_put_int(char *p, int32_t val);                                /* 有符号十进制 */
+char *fmt_put_x10(char *p, int32_t val_x10);                            /* 一位小数定点数, 如153 -> "15.3" */
+char *fmt_put_pad(char *p, char *start, uint8_t width);                 /* 把start开始的内容右对齐到width宽度, 左侧补空格 */
+
+#endif
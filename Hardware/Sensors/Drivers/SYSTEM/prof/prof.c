@@ -0,0 +1,127 @@
+/**
+ ****************************************************************************************************
+ * @file        prof.c
+ * @author      正点原子团队(ALIENTEK)
+ * @version     V1.0
+ * @date        2023-06-05
+ * @brief       基于DWT周期计数器(CYCCNT)的分区性能统计
+ * @license     Copyright (c) 2020-2032, 广州市星翼电子科技有限公司
+ ****************************************************************************************************
+ * @attention
+ *
+ * 实验平台:正点原子 STM32F103开发板
+ * 在线视频:www.yuanzige.com
+ * 技术论坛:www.openedv.com
+ * 公司网址:www.alientek.com
+ * 购买地址:openedv.taobao.com
+ *
+ * 修改说明
+ * V1.0 20230605
+ * 第一次发布
+ *
+ ****************************************************************************************************
+ */
+
+#include "./SYSTEM/prof/prof.h"
+
+#if PROF_ENABLE
+
+#include "./SYSTEM/fmt/fmt.h"
+
+
+prof_zone_t g_prof_zones[PROF_ZONE_NUM];
+
+/* 分区名称, 顺序与PROF_ZONE_xxx一致 */
+static const char *const g_prof_names[PROF_ZONE_NUM] =
+{
+    "sensor", "dht11", "adc", "alarm", "lcd", "uart1", "uart3",
+};
+
+/**
+ * @brief       打开DWT周期计数器
+ * @note        CYCCNT在72MHz下约59.6s回绕一次, 只用于求差, 单次测量不能超过这个时间
+ * @param       无
+ * @retval      无
+ */
+void prof_init(void)
+{
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;     /* 使能DWT */
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;                /* 启动周期计数 */
+
+    prof_reset();
+}
+
+/**
+ * @brief       记录一次
+ * @param       zone: 分区编号
+ * @param       cycles: 周期数
+ * @retval      无
+ */
+void prof_record(uint8_t zone, uint32_t cycles)
+{
+    prof_zone_t *z = &g_prof_zones[zone];
+
+    z->count++;
+    z->sum += cycles;
+
+    if (cycles < z->min)
+    {
+        z->min = cycles;
+    }
+
+    if (cycles > z->max)
+    {
+        z->max = cycles;
+    }
+}
+
+/**
+ * @brief       生成一个分区的报告
+ * @note        格式"PROF 名称 n=次数 min=最小 avg=平均 max=最大cyc avg=平均us\r\n", 没有记录时min为0
+ * @param       buf: 输出缓冲区, 至少PROF_LINE_MAX字节
+ * @param       zone: 分区编号
+ * @retval      长度
+ */
+uint16_t prof_format(char *buf, uint8_t zone)
+{
+    const prof_zone_t *z = &g_prof_zones[zone];
+    uint32_t avg = z->count ? (uint32_t)(z->sum / z->count) : 0;
+    char *p = buf;
+
+    p = fmt_put_str(p, "PROF ");
+    p = fmt_put_str(p, g_prof_names[zone]);
+    p = fmt_put_str(p, " n=");
+    p = fmt_put_uint(p, z->count);
+    p = fmt_put_str(p, " min=");
+    p = fmt_put_uint(p, z->count ? z->min : 0);
+    p = fmt_put_str(p, " avg=");
+    p = fmt_put_uint(p, avg);
+    p = fmt_put_str(p, " max=");
+    p = fmt_put_uint(p, z->max);
+    p = fmt_put_str(p, "cyc avg=");
+    p = fmt_put_x10(p, avg * 10 / (SystemCoreClock / 1000000));
+    p = fmt_put_str(p, "us\r\n");
+
+    return p - buf;
+}
+
+/**
+ * @brief       清除统计
+ * @param       无
+ * @retval      无
+ */
+void prof_reset(void)
+{
+    uint8_t i;
+
+    for (i = 0; i < PROF_ZONE_NUM; i++)
+    {
+        g_prof_zones[i].count = 0;
+        g_prof_zones[i].min = 0xFFFFFFFF;
+        g_prof_zones[i].max = 0;
+        g_prof_zones[i].sum = 0;
+    }
+}
+
+#endif
@@ -0,0 +1,84 @@
+/**
+ ****************************************************************************************************
+ * @file        prof.h
+ * @author      正点原子团队(ALIENTEK)
+ * @version     V1.0
+ * @date        2023-06-05
+ * @brief       基于DWT周期计数器(CYCCNT)的分区性能统计
+ * @license     Copyright (c) 2020-2032, 广州市星翼电子科技有限公司
+ ****************************************************************************************************
+ * @attention
+ *
+ * 实验平台:正点原子 STM32F103开发板
+ * 在线视频:www.yuanzige.com
+ * 技术论坛:www.openedv.com
+ * 公司网址:www.alientek.com
+ * 购买地址:openedv.taobao.com
+ *
+ * 使用说明:
+ *   PROF_START(PROF_ZONE_LCD);
+ *   ...被测代码...
+ *   PROF_STOP(PROF_ZONE_LCD);
+ * 每个分区记录次数, 最小/最大/平均周期数(72MHz下72个周期为1us).
+ * PROF_START和PROF_STOP必须在同一个作用域, 同一分区不能在中断和主循环中同时使用.
+ * PROF_ENABLE为0时宏展开为空, prof.c也不参与编译, 不占用任何代码和RAM.
+ *
+ * 修改说明
+ * V1.0 20230605
+ * 第一次发布
+ *
+ ****************************************************************************************************
+ */
+
+#ifndef __PROF_H
+#define __PROF_H
+
+#include "./SYSTEM/sys/sys.h"
+
+
+#define PROF_ENABLE                 1           /* 0: 关闭统计, 全部编译掉 */
+#define PROF_REPORT_PERIOD_MS       0           /* 周期输出报告, 0表示只在收到"prof"命令时输出 */
+#define PROF_LINE_MAX               80          /* 一个分区报告的最大长度 */
+
+/* 分区编号, 名称见prof.c中的g_prof_names */
+#define PROF_ZONE_SENSOR            0           /* sensor_service整体 */
+#define PROF_ZONE_DHT11             1           /* DHT11解码 */
+#define PROF_ZONE_ADC               2           /* ADC过采样累加(DMA中断) */
+#define PROF_ZONE_ALARM             3           /* 报警判断 */
+#define PROF_ZONE_LCD               4           /* LCD刷新 */
+#define PROF_ZONE_UART1             5           /* USART1格式化并入队 */
+#define PROF_ZONE_UART3             6           /* USART3组帧并入队 */
+#define PROF_ZONE_NUM               7
+
+#if PROF_ENABLE
+
+/* 分区统计 */
+typedef struct
+{
+    uint32_t count;                 /* 次数 */
+    uint32_t min;                   /* 最小周期数 */
+    uint32_t max;                   /* 最大周期数 */
+    uint64_t sum;                   /* 累计周期数 */
+} prof_zone_t;
+
+extern prof_zone_t g_prof_zones[PROF_ZONE_NUM];
+
+#define PROF_START(zone)            uint32_t prof_t0_##zone = DWT->CYCCNT
+#define PROF_STOP(zone)             prof_record(zone, DWT->CYCCNT - prof_t0_##zone)
+
+/* 函数声明 */
+void prof_init(void);                                       /* 打开DWT周期计数器 */
+void prof_record(uint8_t zone, uint32_t cycles);            /* 记录一次 */
+uint16_t prof_format(char *buf, uint8_t zone);              /* 生成一个分区的报告, 返回长度 */
+void prof_reset(void);                                      /* 清除统计 */
+
+#else
+
+#define PROF_START(zone)            ((void)0)
+#define PROF_STOP(zone)             ((void)0)
+#define prof_init()                 ((void)0)
+#define prof_reset()                ((void)0)
+
+#endif
+
+#endif
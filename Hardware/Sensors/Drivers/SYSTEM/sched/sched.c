@@ -0,0 +1,295 @@
+/**
+ ****************************************************************************************************
+ * @file        sched.c
+ * @author      正点原子团队(ALIENTEK)
+ * @version     V1.0
+ * @date        2023-06-05
+ * @brief       SysTick驱动的协作式(运行到完成)任务调度器
+ * @license     Copyright (c) 2020-2032, 广州市星翼电子科技有限公司
+ ****************************************************************************************************
+ * @attention
+ *
+ * 实验平台:正点原子 STM32F103开发板
+ * 在线视频:www.yuanzige.com
+ * 技术论坛:www.openedv.com
+ * 公司网址:www.alientek.com
+ * 购买地址:openedv.taobao.com
+ *
+ * 修改说明
+ * V1.0 20230605
+ * 第一次发布
+ *
+ ****************************************************************************************************
+ */
+
+#include "./SYSTEM/sched/sched.h"
+
+
+sched_task_t g_sched_tasks[SCHED_MAX_TASKS];
+uint8_t g_sched_task_num = 0;
+
+static volatile uint32_t g_sched_ticks = 0;     /* 调度节拍计数, 1ms */
+static volatile uint8_t g_sched_started = 0;    /* sched_run开始后才释放任务 */
+static void (*g_sched_idle_hook)(uint32_t idle_ms) = 0;
+
+/**
+ * @brief       注册任务
+ * @note        必须在sched_run之前调用
+ * @param       name: 任务名
+ * @param       func: 任务函数
+ * @param       period_ms: 释放周期, 单位ms
+ * @param       offset_ms: 首次释放相对于调度开始的偏移, 用于错开周期相同的任务
+ * @retval      任务号, SCHED_INVALID_ID表示任务表已满
+ */
+uint8_t sched_add_task(const char *name, void (*func)(void), uint16_t period_ms, uint16_t offset_ms)
+{
+    sched_task_t *task;
+
+    if (g_sched_task_num >= SCHED_MAX_TASKS || func == 0 || period_ms == 0)
+    {
+        return SCHED_INVALID_ID;
+    }
+
+    task = &g_sched_tasks[g_sched_task_num];
+    task->name = name;
+    task->func = func;
+    task->period_ms = period_ms;
+    task->next_release = offset_ms;
+    task->release_ms = 0;
+    task->ready = 0;
+
+    return g_sched_task_num++;
+}
+
+/**
+ * @brief       调度节拍
+ * @note        在SysTick_Handler中每1ms调用一次, 只做标记, 不执行任务
+ * @param       无
+ * @retval      无
+ */
+void sched_tick(void)
+{
+    sched_task_t *task;
+    uint32_t now;
+    uint8_t i;
+
+    if (g_sched_started == 0)
+    {
+        return;
+    }
+
+    now = ++g_sched_ticks;
+
+    for (i = 0; i < g_sched_task_num; i++)
+    {
+        task = &g_sched_tasks[i];
+
+        if ((int32_t)(now - task->next_release) >= 0)
+        {
+            if (task->ready)
+            {
+                task->overruns++;               /* 上一次还没执行, 合并 */
+            }
+            else
+            {
+                task->ready = 1;
+                task->release_ms = HAL_GetTick(); /* 释放发生在节拍边界 */
+            }
+
+            task->next_release += task->period_ms;  /* 按固定节拍推进, 不受执行时间影响 */
+        }
+    }
+}
+
+/**
+ * @brief       获取当前时间
+ * @note        由HAL节拍(1ms)和SysTick当前计数值组合, 分辨率1us
+ * @param       无
+ * @retval      时间, 单位us(约71分钟回绕一次, 只用于求差)
+ */
+uint32_t sched_time_us(void)
+{
+    uint32_t ms, val;
+    uint32_t reload = SysTick->LOAD + 1;
+
+    do
+    {
+        ms = HAL_GetTick();
+        val = SysTick->VAL;
+    } while (ms != HAL_GetTick());              /* 读取期间发生了SysTick中断, 重读 */
+
+    return ms * 1000 + (reload - val) * 1000 / reload;
+}
+
+/**
+ * @brief       执行调度循环
+ * @note        每次从优先级最高的任务开始查找已释放的任务, 执行一个后重新查找,
+ *              保证高优先级任务最多等待一个任务的执行时间
+ * @param       无
+ * @retval      无(不返回)
+ */
+__NO_RETURN void sched_run(void)
+{
+    sched_task_t *task;
+    uint32_t start, latency, elapsed;
+    uint8_t i;
+
+    g_sched_ticks = 0;
+    g_sched_started = 1;
+
+    while (1)
+    {
+        for (i = 0; i < g_sched_task_num; i++)
+        {
+            task = &g_sched_tasks[i];
+
+            if (task->ready)
+            {
+                break;
+            }
+        }
+
+        if (i == g_sched_task_num)
+        {
+            /* 没有就绪的任务: 关中断后再确认一次, 避免检查之后刚释放的任务要等到下一次唤醒 */
+            if (g_sched_idle_hook)
+            {
+                __disable_irq();
+
+                for (i = 0; i < g_sched_task_num; i++)
+                {
+                    if (g_sched_tasks[i].ready)
+                    {
+                        break;
+                    }
+                }
+
+                if (i == g_sched_task_num)
+                {
+                    g_sched_idle_hook(sched_idle_ms());
+                }
+
+                __enable_irq();
+            }
+
+            continue;
+        }
+
+        start = sched_time_us();
+        latency = start - task->release_ms * 1000;
+        task->ready = 0;
+
+        task->func();
+
+        elapsed = sched_time_us() - start;
+        task->runs++;
+        task->exec_last_us = elapsed;
+
+        if (elapsed > task->exec_max_us)
+        {
+            task->exec_max_us = elapsed;
+        }
+
+        if (latency > task->latency_max_us)
+        {
+            task->latency_max_us = latency;
+        }
+    }
+}
+
+/**
+ * @brief       清除所有任务的统计
+ * @param       无
+ * @retval      无
+ */
+void sched_reset_stats(void)
+{
+    uint8_t i;
+
+    for (i = 0; i < g_sched_task_num; i++)
+    {
+        g_sched_tasks[i].runs = 0;
+        g_sched_tasks[i].overruns = 0;
+        g_sched_tasks[i].exec_last_us = 0;
+        g_sched_tasks[i].exec_max_us = 0;
+        g_sched_tasks[i].latency_max_us = 0;
+    }
+}
+
+/**
+ * @brief       设置空闲钩子
+ * @note        钩子在关中断状态下调用, WFI在有中断挂起时仍会返回, 中断在钩子返回后执行
+ * @param       hook: 空闲钩子, 参数为距下一个任务释放的ms数; 为空时空转
+ * @retval      无
+ */
+void sched_set_idle_hook(void (*hook)(uint32_t idle_ms))
+{
+    g_sched_idle_hook = hook;
+}
+
+/**
+ * @brief       距下一个任务释放的时间
+ * @param       无
+ * @retval      ms数, 有就绪任务时为0
+ */
+uint32_t sched_idle_ms(void)
+{
+    uint32_t now = g_sched_ticks;
+    uint32_t min = 0xFFFFFFFF;
+    int32_t diff;
+    uint8_t i;
+
+    for (i = 0; i < g_sched_task_num; i++)
+    {
+        if (g_sched_tasks[i].ready)
+        {
+            return 0;
+        }
+
+        diff = (int32_t)(g_sched_tasks[i].next_release - now);
+
+        if (diff <= 0)
+        {
+            return 0;
+        }
+
+        if ((uint32_t)diff < min)
+        {
+            min = diff;
+        }
+    }
+
+    return min;
+}
+
+/**
+ * @brief       运行中修改任务周期
+ * @note        周期变短时, 如果下一次释放比"现在 + 新周期"还晚, 提前到那个时刻, 新周期立即生效
+ * @param       id: sched_add_task返回的任务号
+ * @param       period_ms: 新周期, 不能为0
+ * @retval      0, 成功; 1, 参数错误
+ */
+uint8_t sched_set_period(uint8_t id, uint16_t period_ms)
+{
+    sched_task_t *task;
+    uint32_t next;
+
+    if (id >= g_sched_task_num || period_ms == 0)
+    {
+        return 1;
+    }
+
+    task = &g_sched_tasks[id];
+
+    __disable_irq();                            /* next_release和period_ms在节拍中断里使用 */
+    task->period_ms = period_ms;
+    next = g_sched_ticks + period_ms;
+
+    if ((int32_t)(task->next_release - next) > 0)
+    {
+        task->next_release = next;
+    }
+
+    __enable_irq();
+    return 0;
+}
@@ -0,0 +1,75 @@
+/**
+ ****************************************************************************************************
+ * @file        sched.h
+ * @author      正点原子团队(ALIENTEK)
+ * @version     V1.0
+ * @date        2023-06-05
+ * @brief       SysTick驱动的协作式(运行到完成)任务调度器
+ * @license     Copyright (c) 2020-2032, 广州市星翼电子科技有限公司
+ ****************************************************************************************************
+ * @attention
+ *
+ * 实验平台:正点原子 STM32F103开发板
+ * 在线视频:www.yuanzige.com
+ * 技术论坛:www.openedv.com
+ * 公司网址:www.alientek.com
+ * 购买地址:openedv.taobao.com
+ *
+ * 使用说明:
+ * 1, sched_add_task注册任务, 注册顺序即优先级(先注册的优先)
+ * 2, SysTick_Handler中调用sched_tick, 每1ms按固定节拍释放到期的任务
+ * 3, main最后调用sched_run, 在主循环中依次执行已释放的任务, 不再返回
+ * 任务的释放时刻只由SysTick决定, 与其他任务执行多久无关, 因此周期不会累积漂移;
+ * 任务必须运行到完成, 不能在任务中长时间阻塞延时.
+ * 若任务上一次释放还没来得及执行就再次到期, 记一次溢出(overrun), 本次释放合并到上一次.
+ * 没有就绪任务时在关中断状态下调用空闲钩子(sched_set_idle_hook), 参数为距下一个任务释放的ms数,
+ * 钩子可以WFI进入SLEEP, 由下一个中断(至少是SysTick)唤醒.
+ *
+ * 修改说明
+ * V1.0 20230605
+ * 第一次发布
+ *
+ ****************************************************************************************************
+ */
+
+#ifndef __SCHED_H
+#define __SCHED_H
+
+#include "./SYSTEM/sys/sys.h"
+
+
+#define SCHED_MAX_TASKS         16          /* 最大任务数 */
+#define SCHED_INVALID_ID        0xFF        /* 注册失败时返回的任务号 */
+
+/* 任务控制块 */
+typedef struct
+{
+    const char *name;                       /* 任务名, 用于调试输出 */
+    void (*func)(void);                     /* 任务函数 */
+    uint16_t period_ms;                     /* 释放周期 */
+    volatile uint32_t next_release;         /* 下一次释放的节拍 */
+    volatile uint32_t release_ms;           /* 最近一次释放时的HAL节拍 */
+    volatile uint8_t ready;                 /* 已释放, 等待执行 */
+
+    /* 统计 */
+    uint32_t runs;                          /* 执行次数 */
+    volatile uint32_t overruns;             /* 溢出次数(释放时上一次还未执行) */
+    uint32_t exec_last_us;                  /* 最近一次执行时间 */
+    uint32_t exec_max_us;                   /* 最长执行时间 */
+    uint32_t latency_max_us;                /* 释放到开始执行的最大延迟 */
+} sched_task_t;
+
+extern sched_task_t g_sched_tasks[SCHED_MAX_TASKS];
+extern uint8_t g_sched_task_num;
+
+/* 函数声明 */
+uint8_t sched_add_task(const char *name, void (*func)(void), uint16_t period_ms, uint16_t offset_ms);  /* 注册任务 */
+void sched_tick(void);                      /* 1ms节拍, 在SysTick_Handler中调用 */
+__NO_RETURN void sched_run(void);           /* 执行调度循环, 不返回 */
+uint32_t sched_time_us(void);               /* 当前时间(us), 用于测量执行时间 */
+void sched_reset_stats(void);               /* 清除所有任务的统计 */
+void sched_set_idle_hook(void (*hook)(uint32_t idle_ms));  /* 设置空闲钩子 */
+uint32_t sched_idle_ms(void);               /* 距下一个任务释放的ms数 */
+uint8_t sched_set_period(uint8_t id, uint16_t period_ms);   /* 运行中修改任务周期 */
+
+#endif
@@ -0,0 +1,268 @@
+/**
+ ****************************************************************************************************
+ * @file        flash_sim.c
+ * @brief       25QXX NOR FLASH主机仿真: 提供norflash.h的接口, 模拟编程/擦除语义, 耗时和掉电
+ ****************************************************************************************************
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "flash_sim.h"
+
+
+flash_sim_stats_t g_flash_sim_stats;
+uint16_t g_norflash_type = W25Q128;
+
+static uint8_t *g_sim_mem = NULL;
+static uint32_t g_sim_erase_count[FLASH_SIM_SIZE / NORFLASH_SECTOR_SIZE];
+static jmp_buf *g_sim_jmp = NULL;
+static uint32_t g_sim_cut_ops = 0;          /* 剩余多少次编程/擦除后掉电, 0表示不掉电 */
+static uint32_t g_sim_rand = 1;
+static uint64_t g_sim_busy_until = 0;       /* 后台擦除结束的虚拟时间 */
+
+/**
+ * @brief       xorshift32伪随机数, 固定种子可复现
+ */
+uint32_t flash_sim_rand(void)
+{
+    g_sim_rand ^= g_sim_rand << 13;
+    g_sim_rand ^= g_sim_rand >> 17;
+    g_sim_rand ^= g_sim_rand << 5;
+    return g_sim_rand;
+}
+
+void flash_sim_init(uint32_t seed)
+{
+    if (g_sim_mem == NULL)
+    {
+        g_sim_mem = malloc(FLASH_SIM_SIZE);
+
+        if (g_sim_mem == NULL)
+        {
+            fprintf(stderr, "flash_sim: out of memory\n");
+            exit(1);
+        }
+    }
+
+    memset(g_sim_mem, 0xFF, FLASH_SIM_SIZE);
+    memset(g_sim_erase_count, 0, sizeof(g_sim_erase_count));
+    memset(&g_flash_sim_stats, 0, sizeof(g_flash_sim_stats));
+    g_sim_cut_ops = 0;
+    g_sim_rand = seed ? seed : 1;
+    g_sim_busy_until = 0;
+}
+
+void flash_sim_set_jmp(jmp_buf *jmp)
+{
+    g_sim_jmp = jmp;
+}
+
+void flash_sim_cut_after(uint32_t ops)
+{
+    g_sim_cut_ops = ops;
+}
+
+uint32_t flash_sim_sector_erases(uint32_t sector)
+{
+    return g_sim_erase_count[sector];
+}
+
+void flash_sim_idle(uint64_t ns)
+{
+    g_flash_sim_stats.time_ns += ns;
+}
+
+/**
+ * @brief       本次编程/擦除是否掉电
+ */
+static int sim_cut_now(void)
+{
+    if (g_sim_cut_ops == 0 || g_sim_jmp == NULL)
+    {
+        return 0;
+    }
+
+    return --g_sim_cut_ops == 0;
+}
+
+static void sim_power_lost(void)
+{
+    g_flash_sim_stats.cuts++;
+    g_sim_busy_until = 0;                   /* FLASH同时掉电, 擦除中止 */
+    longjmp(*g_sim_jmp, 1);
+}
+
+static void sim_check_addr(uint32_t addr, uint32_t len)
+{
+    if (addr >= FLASH_SIM_SIZE || len > FLASH_SIM_SIZE - addr)
+    {
+        fprintf(stderr, "flash_sim: access out of range 0x%08X+%u\n", (unsigned)addr, (unsigned)len);
+        abort();
+    }
+}
+
+/**
+ * @brief       擦除进行中时FLASH不响应读写和新的擦除命令
+ */
+static void sim_check_idle(const char *op, uint32_t addr)
+{
+    if (g_flash_sim_stats.time_ns < g_sim_busy_until)
+    {
+        fprintf(stderr, "flash_sim: %s at 0x%08X while an erase is in progress\n", op, (unsigned)addr);
+        abort();
+    }
+}
+
+/******************************************************************************************/
+/* norflash.h接口 */
+
+void norflash_init(void)
+{
+}
+
+uint16_t norflash_read_id(void)
+{
+    return g_norflash_type;
+}
+
+void norflash_write_enable(void)
+{
+}
+
+uint8_t norflash_read_sr(uint8_t regno)
+{
+    (void)regno;
+    return 0;           /* 编程和擦除同步完成, 永远空闲 */
+}
+
+void norflash_write_sr(uint8_t regno, uint8_t sr)
+{
+    (void)regno;
+    (void)sr;
+}
+
+uint8_t norflash_busy(void)
+{
+    if (g_flash_sim_stats.time_ns < g_sim_busy_until)
+    {
+        /* 调用者轮询到擦除结束 */
+        g_flash_sim_stats.wait_ns += g_sim_busy_until - g_flash_sim_stats.time_ns;
+        g_flash_sim_stats.time_ns = g_sim_busy_until;
+        return 1;
+    }
+
+    return 0;
+}
+
+void norflash_read(uint8_t *pbuf, uint32_t addr, uint16_t datalen)
+{
+    sim_check_addr(addr, datalen);
+    sim_check_idle("read", addr);
+    memcpy(pbuf, g_sim_mem + addr, datalen);
+
+    g_flash_sim_stats.reads++;
+    g_flash_sim_stats.read_bytes += datalen;
+    g_flash_sim_stats.time_ns += (uint64_t)(4 + datalen) * FLASH_SIM_BYTE_NS;
+}
+
+void norflash_write_page(uint8_t *pbuf, uint32_t addr, uint16_t datalen)
+{
+    uint16_t i, n;
+
+    sim_check_addr(addr, datalen);
+    sim_check_idle("page program", addr);
+
+    if (datalen > NORFLASH_PAGE_SIZE - addr % NORFLASH_PAGE_SIZE)
+    {
+        fprintf(stderr, "flash_sim: page program crosses page boundary at 0x%08X\n", (unsigned)addr);
+        abort();
+    }
+
+    g_flash_sim_stats.programs++;
+    g_flash_sim_stats.program_bytes += datalen;
+    g_flash_sim_stats.time_ns += (uint64_t)(4 + datalen) * FLASH_SIM_BYTE_NS + FLASH_SIM_PROGRAM_NS;
+
+    if (sim_cut_now())
+    {
+        n = datalen ? flash_sim_rand() % datalen : 0;
+
+        for (i = 0; i < n; i++)
+        {
+            g_sim_mem[addr + i] &= pbuf[i];
+        }
+
+        if (n < datalen)
+        {
+            g_sim_mem[addr + n] &= pbuf[n] | (uint8_t)flash_sim_rand();   /* 最后一个字节只写入部分位 */
+        }
+
+        sim_power_lost();
+    }
+
+    for (i = 0; i < datalen; i++)
+    {
+        g_sim_mem[addr + i] &= pbuf[i];
+    }
+}
+
+void norflash_write_nocheck(uint8_t *pbuf, uint32_t addr, uint16_t datalen)
+{
+    uint16_t n;
+
+    while (datalen)
+    {
+        n = NORFLASH_PAGE_SIZE - addr % NORFLASH_PAGE_SIZE;
+
+        if (n > datalen)
+        {
+            n = datalen;
+        }
+
+        norflash_write_page(pbuf, addr, n);
+        pbuf += n;
+        addr += n;
+        datalen -= n;
+    }
+}
+
+void norflash_erase_sector_start(uint32_t saddr)
+{
+    uint32_t addr = saddr * NORFLASH_SECTOR_SIZE;
+    uint32_t i;
+
+    sim_check_addr(addr, NORFLASH_SECTOR_SIZE);
+    sim_check_idle("sector erase", addr);
+
+    g_flash_sim_stats.erases++;
+    g_flash_sim_stats.time_ns += 4 * FLASH_SIM_BYTE_NS;
+    g_sim_busy_until = g_flash_sim_stats.time_ns + FLASH_SIM_ERASE_NS;
+
+    if (sim_cut_now())
+    {
+        for (i = 0; i < NORFLASH_SECTOR_SIZE; i++)
+        {
+            if (flash_sim_rand() & 1)
+            {
+                g_sim_mem[addr + i] = 0xFF;
+            }
+        }
+
+        sim_power_lost();
+    }
+
+    memset(g_sim_mem + addr, 0xFF, NORFLASH_SECTOR_SIZE);
+    g_sim_erase_count[saddr]++;
+}
+
+void norflash_erase_sector(uint32_t saddr)
+{
+    norflash_erase_sector_start(saddr);
+
+    while (norflash_busy());
+}
+
+void norflash_erase_chip(void)
+{
+    memset(g_sim_mem, 0xFF, FLASH_SIM_SIZE);
+}
@@ -0,0 +1,57 @@
+/**
+ ****************************************************************************************************
+ * @file        flash_sim.h
+ * @brief       25QXX NOR FLASH主机仿真: 提供norflash.h的接口, 模拟编程/擦除语义, 耗时和掉电
+ ****************************************************************************************************
+ * @attention
+ *
+ * 存储体全部在内存中, 初始为0xFF. 编程只能把1变成0(新值 = 旧值 & 数据), 擦除把整个扇区恢复为0xFF.
+ * 耗时按W25Q128JV数据手册典型值累计到虚拟时间, 不真正等待:
+ *   SPI 18MHz每字节0.44us, 页编程0.4ms, 扇区擦除45ms
+ * norflash_erase_sector_start只计命令时间, 擦除在后台进行到45ms后; 期间norflash_busy返回1并把
+ * 虚拟时间推进到擦除结束(相当于轮询等待), 读写或再次擦除则报错退出, 检查调用者先等待擦除结束.
+ * flash_sim_idle模拟两次访问之间MCU做别的事情, 后台擦除在这段时间里完成.
+ * 掉电: flash_sim_cut_after(n)之后的第n次编程或擦除只完成一部分(编程写入随机长度的前缀,
+ * 最后一个字节只写入部分位; 擦除只恢复随机的一部分字节), 然后longjmp到flash_sim_set_jmp
+ * 设置的位置, 相当于MCU在此刻复位.
+ *
+ ****************************************************************************************************
+ */
+
+#ifndef __FLASH_SIM_H
+#define __FLASH_SIM_H
+
+#include <setjmp.h>
+#include "./BSP/NORFLASH/norflash.h"
+
+
+#define FLASH_SIM_SIZE              (16 * 1024 * 1024)  /* W25Q128 */
+
+#define FLASH_SIM_BYTE_NS           444                 /* 18MHz SPI传输一个字节 */
+#define FLASH_SIM_PROGRAM_NS        400000              /* 页编程 */
+#define FLASH_SIM_ERASE_NS          45000000            /* 扇区擦除 */
+
+/* 统计 */
+typedef struct
+{
+    uint64_t time_ns;               /* 虚拟时间 */
+    uint32_t reads;                 /* 读命令次数 */
+    uint64_t read_bytes;
+    uint32_t programs;              /* 页编程次数 */
+    uint64_t program_bytes;
+    uint32_t erases;                /* 扇区擦除次数 */
+    uint64_t wait_ns;               /* 在norflash_busy中等待擦除结束的时间 */
+    uint32_t cuts;                  /* 模拟掉电次数 */
+} flash_sim_stats_t;
+
+extern flash_sim_stats_t g_flash_sim_stats;
+
+/* 函数声明 */
+void flash_sim_init(uint32_t seed);                 /* 存储体全部擦除, 清除统计 */
+void flash_sim_set_jmp(jmp_buf *jmp);               /* 掉电时longjmp的目标, NULL表示不模拟掉电 */
+void flash_sim_cut_after(uint32_t ops);             /* 第ops次编程/擦除时掉电, 0表示取消 */
+uint32_t flash_sim_sector_erases(uint32_t sector);  /* 某个扇区的累计擦除次数 */
+uint32_t flash_sim_rand(void);                      /* 仿真使用的伪随机数 */
+void flash_sim_idle(uint64_t ns);                   /* 虚拟时间前进ns, 不访问FLASH */
+
+#endif
@@ -0,0 +1,322 @@
+/**
+ ****************************************************************************************************
+ * @file        log_torture.c
+ * @brief       样本日志(sensor_log)在仿真FLASH上的吞吐量和掉电一致性测试
+ ****************************************************************************************************
+ * @attention
+ *
+ * 用法: log_torture [掉电次数] [随机种子]
+ *
+ * 1. 吞吐量: 空日志按SENSOR_LOG_PERIOD_MS的间隔追加两圈, 按仿真耗时给出每条记录的平均和最坏写入时间,
+ *    擦除次数的最大/最小值(磨损均衡), 满日志的挂载时间和顺序读取速度. 除挂载后的第一条外,
+ *    任何一次追加都不能等待扇区擦除.
+ * 2. 掉电: 反复在随机的第n次编程/擦除时掉电, 重新挂载后检查:
+ *      - 有效范围内每条记录要么内容正确, 要么是掉电时正在写的那一条(CRC错误)
+ *      - 追加成功过的记录只有被正常循环覆盖时才会消失
+ *    记录内容由记录号推出, 不需要保存写入的数据.
+ *
+ ****************************************************************************************************
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "flash_sim.h"
+#include "./BSP/SENSOR/sensor_log.h"
+
+
+#define TORTURE_MAX_INDEX       (8u * 1024 * 1024)  /* 掉电测试中记录号的上限 */
+#define TORTURE_MAX_OPS         600                 /* 两次掉电之间最多的编程/擦除次数 */
+
+/* 每个记录号的状态 */
+#define REC_NONE                0
+#define REC_ACKED               1                   /* 追加成功 */
+#define REC_TORN                2                   /* 写入时掉电, 允许CRC错误 */
+
+static uint8_t *g_rec_state;
+static volatile uint32_t g_pending = 0xFFFFFFFF;    /* 正在追加的记录号 */
+static jmp_buf g_power_jmp;
+
+/**
+ * @brief       由记录号生成样本内容
+ */
+static void make_sample(uint32_t index, sensor_sample_t *s)
+{
+    s->temperature = (int8_t)(index % 90) - 20;
+    s->humidity = index % 100;
+    s->co_x10 = index & 0xFFFF;
+    s->dust_x10 = (index * 7) & 0xFFFF;
+    s->alarm_mask = index >> 16;
+    s->valid = SENSOR_VALID_FLAGS | (index & SENSOR_VALID_ALL);
+    s->timestamp = 1700000000u + index;
+}
+
+static int sample_equal(const sensor_sample_t *a, const sensor_sample_t *b)
+{
+    return a->temperature == b->temperature && a->humidity == b->humidity &&
+           a->co_x10 == b->co_x10 && a->dust_x10 == b->dust_x10 &&
+           a->alarm_mask == b->alarm_mask && a->valid == b->valid && a->timestamp == b->timestamp;
+}
+
+static double sim_ms(uint64_t ns)
+{
+    return ns / 1e6;
+}
+
+/**
+ * @brief       吞吐量测试
+ * @retval      0, 通过; 1, 失败
+ */
+static int run_throughput(void)
+{
+    const uint32_t total = 2u * SENSOR_LOG_SECTORS * SENSOR_LOG_SLOTS;
+    sensor_sample_t s, r;
+    uint32_t i, index, first, end;
+    uint32_t emin = 0xFFFFFFFF, emax = 0, e;
+    uint64_t t0, dt, busy = 0, first_ns = 0, max_ns = 0;
+    uint32_t max_index = 0;
+
+    flash_sim_init(1);
+    sensor_log_mount();
+
+    for (i = 0; i < total; i++)
+    {
+        index = sensor_log_end();
+        make_sample(index, &s);
+        t0 = g_flash_sim_stats.time_ns;
+
+        if (sensor_log_append(&s) != SENSOR_LOG_OK)
+        {
+            printf("FAIL append %u\n", (unsigned)index);
+            return 1;
+        }
+
+        dt = g_flash_sim_stats.time_ns - t0;
+        busy += dt;
+
+        if (i == 0)
+        {
+            first_ns = dt;                      /* 挂载后第一次打开扇区, 同步擦除 */
+        }
+        else if (dt > max_ns)
+        {
+            max_ns = dt;
+            max_index = index;
+        }
+
+        flash_sim_idle((uint64_t)SENSOR_LOG_PERIOD_MS * 1000000);
+    }
+
+    for (i = 0; i < SENSOR_LOG_SECTORS; i++)
+    {
+        e = flash_sim_sector_erases(SENSOR_LOG_BASE_SECTOR + i);
+        emin = e < emin ? e : emin;
+        emax = e > emax ? e : emax;
+    }
+
+    printf("append: %u records, %.1f s in append, %.3f ms/record, %u erases (%.1f per 1000 records)\n",
+           (unsigned)total, sim_ms(busy) / 1000, sim_ms(busy) / total,
+           (unsigned)g_flash_sim_stats.erases, g_flash_sim_stats.erases * 1000.0 / total);
+    printf("append latency: first %.3f ms, worst after that %.3f ms (record %u)\n",
+           sim_ms(first_ns), sim_ms(max_ns), (unsigned)max_index);
+    printf("wear: sector erases min %u max %u\n", (unsigned)emin, (unsigned)emax);
+
+    if (max_ns >= FLASH_SIM_ERASE_NS)
+    {
+        printf("FAIL append waited for a sector erase\n");
+        return 1;
+    }
+
+    t0 = g_flash_sim_stats.time_ns;
+    sensor_log_mount();
+    first = sensor_log_first();
+    end = sensor_log_end();
+    printf("mount: %.2f ms, %u records retained, header erase count %u..%u\n",
+           sim_ms(g_flash_sim_stats.time_ns - t0), (unsigned)(end - first),
+           (unsigned)g_sensor_log_stats.erase_min, (unsigned)g_sensor_log_stats.erase_max);
+
+    if (end - first < (SENSOR_LOG_SECTORS - 2) * SENSOR_LOG_SLOTS)
+    {
+        printf("FAIL retained too few records\n");
+        return 1;
+    }
+
+    t0 = g_flash_sim_stats.time_ns;
+
+    for (index = first; index < end; index++)
+    {
+        make_sample(index, &s);
+
+        if (sensor_log_read(index, &r) != SENSOR_LOG_OK || !sample_equal(&s, &r))
+        {
+            printf("FAIL read %u\n", (unsigned)index);
+            return 1;
+        }
+    }
+
+    printf("read: %.3f ms/record\n", sim_ms(g_flash_sim_stats.time_ns - t0) / (end - first));
+    return 0;
+}
+
+/**
+ * @brief       挂载后检查日志内容
+ * @retval      0, 通过; 1, 失败
+ */
+static int check_log(uint32_t acked_max)
+{
+    const uint32_t keep = (SENSOR_LOG_SECTORS - 2) * SENSOR_LOG_SLOTS;
+    uint32_t first = sensor_log_first();
+    uint32_t end = sensor_log_end();
+    sensor_sample_t s, r;
+    uint32_t i;
+    uint8_t ret;
+
+    if (end > TORTURE_MAX_INDEX || first > end)
+    {
+        printf("FAIL range %u..%u\n", (unsigned)first, (unsigned)end);
+        return 1;
+    }
+
+    if (acked_max != 0xFFFFFFFF && acked_max >= end)
+    {
+        printf("FAIL acked record %u beyond end %u\n", (unsigned)acked_max, (unsigned)end);
+        return 1;
+    }
+
+    if (end > keep + SENSOR_LOG_SLOTS && first > end - keep)
+    {
+        printf("FAIL only %u records retained\n", (unsigned)(end - first));
+        return 1;
+    }
+
+    for (i = first; i < end; i++)
+    {
+        ret = sensor_log_read(i, &r);
+        make_sample(i, &s);
+
+        if (ret == SENSOR_LOG_OK && sample_equal(&s, &r))
+        {
+            continue;
+        }
+
+        if (ret == SENSOR_LOG_ERR_CRC && g_rec_state[i] == REC_TORN)
+        {
+            continue;
+        }
+
+        printf("FAIL record %u ret %u state %u\n", (unsigned)i, ret, g_rec_state[i]);
+        return 1;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief       掉电一致性测试
+ * @param       cuts: 掉电次数
+ * @retval      0, 通过; 1, 失败
+ */
+static int run_power_loss(uint32_t cuts, uint32_t seed)
+{
+    static volatile uint32_t done;
+    static volatile uint32_t acked_max;
+    static volatile uint32_t appended;
+    sensor_sample_t s;
+    uint32_t index;
+
+    g_rec_state = calloc(TORTURE_MAX_INDEX, 1);
+
+    if (g_rec_state == NULL)
+    {
+        printf("out of memory\n");
+        return 1;
+    }
+
+    flash_sim_init(seed);
+    flash_sim_set_jmp(&g_power_jmp);
+    done = 0;
+    acked_max = 0xFFFFFFFF;
+    appended = 0;
+
+    while (done <= cuts)
+    {
+        if (setjmp(g_power_jmp) != 0)
+        {
+            /* 掉电复位 */
+            if (g_pending != 0xFFFFFFFF && g_rec_state[g_pending] != REC_ACKED)
+            {
+                g_rec_state[g_pending] = REC_TORN;
+            }
+
+            g_pending = 0xFFFFFFFF;
+            done++;
+            continue;
+        }
+
+        sensor_log_mount();
+
+        if (check_log(acked_max))
+        {
+            printf("after %u power cuts, %u appends\n", (unsigned)done, (unsigned)appended);
+            free(g_rec_state);
+            return 1;
+        }
+
+        if (done == cuts)
+        {
+            break;
+        }
+
+        flash_sim_cut_after(1 + flash_sim_rand() % TORTURE_MAX_OPS);
+
+        while (1)
+        {
+            index = sensor_log_end();
+
+            if (index >= TORTURE_MAX_INDEX)
+            {
+                printf("FAIL index limit reached\n");
+                free(g_rec_state);
+                return 1;
+            }
+
+            make_sample(index, &s);
+            g_pending = index;
+
+            if (sensor_log_append(&s) != SENSOR_LOG_OK)
+            {
+                printf("FAIL append %u\n", (unsigned)index);
+                free(g_rec_state);
+                return 1;
+            }
+
+            g_pending = 0xFFFFFFFF;
+            g_rec_state[index] = REC_ACKED;
+            acked_max = index;
+            appended++;
+        }
+    }
+
+    flash_sim_set_jmp(NULL);
+    printf("power loss: %u cuts, %u appends, %u records retained, all consistent\n",
+           (unsigned)g_flash_sim_stats.cuts, (unsigned)appended,
+           (unsigned)(sensor_log_end() - sensor_log_first()));
+    free(g_rec_state);
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    uint32_t cuts = argc > 1 ? (uint32_t)strtoul(argv[1], NULL, 0) : 2000;
+    uint32_t seed = argc > 2 ? (uint32_t)strtoul(argv[2], NULL, 0) : 12345;
+
+    printf("geometry: %u sectors x %u records\n", (unsigned)SENSOR_LOG_SECTORS, (unsigned)SENSOR_LOG_SLOTS);
+
+    if (run_throughput() || run_power_loss(cuts, seed))
+    {
+        return 1;
+    }
+
+    printf("PASS\n");
+    return 0;
+}
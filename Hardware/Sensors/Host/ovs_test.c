@@ -0,0 +1,303 @@
+/**
+ ****************************************************************************************************
+ * @file        ovs_test.c
+ * @brief       ADC过采样累加器和过采样值换算(MQ-7, GP2Y1014AU)的测试
+ ****************************************************************************************************
+ * @attention
+ *
+ * 用法: ovs_test
+ *
+ * 1. 累加器: 把已知的序列写入DMA缓冲区, 交替调用半满/全满回调, 与独立计算的 (和 >> ADC_OVS_BITS) 比较:
+ *      - 常数输入得到 c << ADC_OVS_BITS, 每ADC_OVS_RATIO次转换恰好产生一个结果
+ *      - 窗口内有j次为c+1时, 结果的低ADC_OVS_BITS位按j / 2^ADC_OVS_BITS增加(多出的分辨率)
+ *      - 两路不同斜率的斜坡, 结果不超过ADC_OVS_MAX
+ * 2. 换算: 对0 ~ ADC_OVS_MAX的每一个值, 把它当作带小数的12位码值代入原浮点公式,
+ *    插值结果与公式的误差不超过max(0.15, 0.5%)(与Tools/gen_curve_tables.py的校验相同), 且单调.
+ *
+ ****************************************************************************************************
+ */
+
+#include <stdio.h>
+#include <math.h>
+#include "sim.h"
+#include "./BSP/ADC/adc.h"
+#include "./BSP/MQ7/mq7.h"
+#include "./BSP/MQ7/mq7_curve.h"
+#include "./BSP/GP2Y1014AU/gp2y1014au.h"
+#include "./BSP/GP2Y1014AU/gp2y1014au_curve.h"
+
+
+extern ADC_HandleTypeDef g_adc_handle;              /* adc.c, DMA回调按Instance区分ADC */
+
+#define OVS_HALF_FRAMES         (ADC_DMA_FRAMES / 2)
+#define OVS_RAMP_OUTPUTS        256                 /* 斜坡测试的结果个数 */
+
+/* 仿真内核需要的回调, 本测试不用串口和蜂鸣器 */
+void sim_on_uart_tx(int port, uint8_t byte)
+{
+    (void)port;
+    (void)byte;
+}
+
+void sim_on_beep(uint8_t on, uint32_t freq_hz)
+{
+    (void)on;
+    (void)freq_hz;
+}
+
+typedef uint16_t (*ovs_input_t)(uint32_t k, uint8_t ch);
+
+static uint32_t g_conv = 0;                         /* 已送入的转换次数 */
+static uint8_t g_half = 0;                          /* 下一次写入的半个缓冲区 */
+static uint32_t g_expect_sum[ADC_CH_NUM];
+
+/**
+ * @brief       送入frames次扫描: 写满半个缓冲区后调用对应的DMA回调, 同时独立累加期望值
+ */
+static void ovs_feed(ovs_input_t input, uint32_t frames)
+{
+    uint16_t *half;
+    uint8_t i, ch;
+
+    while (frames)
+    {
+        half = &g_adc_dma_buf[g_half * OVS_HALF_FRAMES * ADC_CH_NUM];
+
+        for (i = 0; i < OVS_HALF_FRAMES; i++)
+        {
+            for (ch = 0; ch < ADC_CH_NUM; ch++)
+            {
+                half[i * ADC_CH_NUM + ch] = input(g_conv, ch);
+                g_expect_sum[ch] += half[i * ADC_CH_NUM + ch];
+            }
+
+            g_conv++;
+        }
+
+        if (g_half == 0)
+        {
+            HAL_ADC_ConvHalfCpltCallback(&g_adc_handle);
+        }
+        else
+        {
+            HAL_ADC_ConvCpltCallback(&g_adc_handle);
+        }
+
+        g_half ^= 1;
+        frames = frames > OVS_HALF_FRAMES ? frames - OVS_HALF_FRAMES : 0;
+    }
+}
+
+/**
+ * @brief       送入一个完整窗口并检查结果
+ * @retval      0, 通过; 1, 失败
+ */
+static int ovs_window(const char *name, ovs_input_t input)
+{
+    uint32_t count = adc_get_oversampled_count();
+    uint16_t expect, got;
+    uint8_t ch;
+
+    g_expect_sum[0] = g_expect_sum[1] = 0;
+    ovs_feed(input, ADC_OVS_RATIO - OVS_HALF_FRAMES);
+
+    if (adc_get_oversampled_count() != count)
+    {
+        printf("FAIL %s: result before %u conversions\n", name, ADC_OVS_RATIO);
+        return 1;
+    }
+
+    ovs_feed(input, OVS_HALF_FRAMES);
+
+    if (adc_get_oversampled_count() != count + 1)
+    {
+        printf("FAIL %s: no result after %u conversions\n", name, ADC_OVS_RATIO);
+        return 1;
+    }
+
+    for (ch = 0; ch < ADC_CH_NUM; ch++)
+    {
+        expect = g_expect_sum[ch] >> ADC_OVS_BITS;
+        got = adc_get_oversampled(ch);
+
+        if (got != expect || got > ADC_OVS_MAX)
+        {
+            printf("FAIL %s: conversion %u ch %u result %u, expected %u\n", name, (unsigned)g_conv, ch, got, expect);
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+/* 输入序列 */
+static uint16_t g_const;
+static uint32_t g_dither;
+
+static uint16_t input_const(uint32_t k, uint8_t ch)
+{
+    (void)k;
+    return ch == 0 ? g_const : 4095 - g_const;
+}
+
+/* 窗口内前g_dither次为c+1, 其余为c */
+static uint16_t input_dither(uint32_t k, uint8_t ch)
+{
+    (void)ch;
+    return g_const + (k % ADC_OVS_RATIO < g_dither);
+}
+
+/* ch0: 每次转换加3的快斜坡(跨过满量程回绕); ch1: 每16次转换加1的慢斜坡 */
+static uint16_t input_ramp(uint32_t k, uint8_t ch)
+{
+    return ch == 0 ? (k * 3) % 4096 : (k / 16) % 4096;
+}
+
+/**
+ * @brief       累加器测试
+ * @retval      0, 通过; 1, 失败
+ */
+static int test_accumulator(void)
+{
+    static const uint16_t consts[] = {0, 1, 2048, 4094, 4095};
+    uint32_t i;
+
+    g_adc_handle.Instance = ADC_ADCX;
+
+    for (i = 0; i < sizeof(consts) / sizeof(consts[0]); i++)
+    {
+        g_const = consts[i];
+
+        if (ovs_window("const", input_const) || adc_get_oversampled(0) != g_const << ADC_OVS_BITS)
+        {
+            printf("FAIL const %u: result %u\n", g_const, adc_get_oversampled(0));
+            return 1;
+        }
+    }
+
+    g_const = 1000;
+
+    for (g_dither = 0; g_dither <= ADC_OVS_RATIO; g_dither += 1 << ADC_OVS_BITS)
+    {
+        if (ovs_window("dither", input_dither) ||
+            adc_get_oversampled(0) != (g_const << ADC_OVS_BITS) + (g_dither >> ADC_OVS_BITS))
+        {
+            printf("FAIL dither %u/%u: result %u\n", (unsigned)g_dither, ADC_OVS_RATIO, adc_get_oversampled(0));
+            return 1;
+        }
+    }
+
+    for (i = 0; i < OVS_RAMP_OUTPUTS; i++)
+    {
+        if (ovs_window("ramp", input_ramp))
+        {
+            return 1;
+        }
+    }
+
+    printf("accumulator: %u bits, %u conversions per result, %u results checked\n",
+           12 + ADC_OVS_BITS, ADC_OVS_RATIO, (unsigned)adc_get_oversampled_count());
+    return 0;
+}
+
+/* 原浮点公式(未限幅), 与Tools/gen_curve_tables.py相同 */
+static double mq7_ppm(double code)
+{
+    double rs_r0;
+
+    if (code < 1)
+    {
+        code = 1;
+    }
+
+    rs_r0 = (4095.0 - code) / code;
+    return rs_r0 <= 0 ? HUGE_VAL : 98.322 * pow(rs_r0, -1.458);
+}
+
+static double gp2y_density(double code)
+{
+    return (code * (3300.0 / 4096.0) - 600.0) / 10.0;
+}
+
+static double clamp(double v, double lo, double hi)
+{
+    return v < lo ? lo : (v > hi ? hi : v);
+}
+
+/**
+ * @brief       换算测试
+ * @retval      0, 通过; 1, 失败
+ */
+static int test_conversion(void)
+{
+    const char *names[2] = {"mq7", "gp2y1014au"};
+    double worst[2] = {0, 0}, expect, got, ratio;
+    uint32_t worst_at[2] = {0, 0};
+    int32_t value, last[2] = {-32768, -32768};
+    uint32_t ovs;
+    double code;
+    int i, fail = 0;
+
+    for (ovs = 0; ovs <= ADC_OVS_MAX; ovs++)
+    {
+        code = (double)ovs / (1 << ADC_OVS_BITS);
+
+        for (i = 0; i < 2; i++)
+        {
+            if (i == 0)
+            {
+                value = mq7_ovs_to_ppm_x10(ovs);
+                expect = clamp(mq7_ppm(code), MQ7_CURVE_MIN / 10.0, MQ7_CURVE_MAX / 10.0);
+            }
+            else
+            {
+                value = gp2y1014au_ovs_to_density_x10(ovs);
+                expect = clamp(gp2y_density(code), GP2Y1014AU_CURVE_MIN / 10.0, GP2Y1014AU_CURVE_MAX / 10.0);
+            }
+
+            got = value / 10.0;
+            ratio = fabs(got - expect) / fmax(0.15, 0.005 * expect);
+
+            if (ratio > worst[i])
+            {
+                worst[i] = ratio;
+                worst_at[i] = ovs;
+            }
+
+            if (value < last[i])
+            {
+                printf("FAIL %s: not monotonic at %u (%d after %d)\n", names[i], (unsigned)ovs, (int)value, (int)last[i]);
+                fail = 1;
+            }
+
+            last[i] = value;
+        }
+    }
+
+    for (i = 0; i < 2; i++)
+    {
+        printf("%s: %u values, worst error / tolerance %.3f at %u\n", names[i], ADC_OVS_MAX + 1, worst[i],
+               (unsigned)worst_at[i]);
+
+        if (worst[i] > 1.0)
+        {
+            printf("FAIL %s: error beyond max(0.15, 0.5%%)\n", names[i]);
+            fail = 1;
+        }
+    }
+
+    return fail;
+}
+
+int main(void)
+{
+    sim_core_reset();
+
+    if (test_accumulator() || test_conversion())
+    {
+        return 1;
+    }
+
+    printf("PASS\n");
+    return 0;
+}
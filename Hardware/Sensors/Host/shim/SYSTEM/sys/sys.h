@@ -0,0 +1,20 @@
+/**
+ ****************************************************************************************************
+ * @file        sys.h
+ * @brief       主机仿真用的sys.h替身, 只提供与硬件无关的驱动需要的类型
+ ****************************************************************************************************
+ * @attention
+ *
+ * 主机构建把Host/shim放在Drivers之前的包含路径里, 驱动中的 #include "./SYSTEM/sys/sys.h"
+ * 会落到这里, 不会引入stm32f1xx.h.
+ *
+ ****************************************************************************************************
+ */
+
+#ifndef __SYS_H
+#define __SYS_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#endif
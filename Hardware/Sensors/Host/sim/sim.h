@@ -0,0 +1,124 @@
+/**
+ ****************************************************************************************************
+ * @file        sim.h
+ * @brief       主机仿真内核: 仿真时间, 事件, NVIC和外设模型之间的接口
+ ****************************************************************************************************
+ * @attention
+ *
+ * 时间以72MHz CPU周期计. 固件本身的计算不计时间, 只有外设寄存器访问, HAL调用, 中断进出和WFI
+ * 推进时钟(--cpu-scale打开时再按主机实际耗时折算); 外设行为(定时器溢出, DMA搬运, 串口字符,
+ * DHT11波形, ADC转换)是按到期时刻排列的事件, 时钟推进到期时执行. 中断按电平判断: 外设标志和
+ * 使能位同时置位即挂起, 中断函数清除标志后自然撤销, 与硬件一致.
+ *
+ ****************************************************************************************************
+ */
+
+#ifndef __SIM_H
+#define __SIM_H
+
+#include <stdint.h>
+#include "stm32f1xx.h"
+
+
+#define SIM_CPU_HZ              72000000U
+#define SIM_US(us)              ((uint64_t)(us) * (SIM_CPU_HZ / 1000000))
+#define SIM_MS(ms)              ((uint64_t)(ms) * (SIM_CPU_HZ / 1000))
+
+/* 各种操作计入的CPU周期 */
+#define SIM_COST_REG            4       /* APB外设寄存器访问(含总线等待) */
+#define SIM_COST_FSMC           6       /* FSMC上的LCD访问, 按lcd_init中的读写时序 */
+#define SIM_COST_HAL            20      /* 一次HAL函数调用 */
+#define SIM_COST_IRQ            12      /* 中断进入或退出(压栈/出栈) */
+#define SIM_COST_WAKE           6       /* WFI唤醒到恢复取指 */
+#define SIM_COST_M2M            8       /* 存储器到FSMC的DMA, 每个半字 */
+
+/* 事件 */
+typedef enum
+{
+    SIM_EV_SYSTICK = 0,
+    SIM_EV_TIM2, SIM_EV_TIM3, SIM_EV_TIM4, SIM_EV_TIM6, SIM_EV_TIM7,     /* 更新事件(UIE打开时) */
+    SIM_EV_ADC,                                                         /* ADC1一次转换完成 */
+    SIM_EV_DHT11,                                                       /* DHT11数据线电平变化 */
+    SIM_EV_U1_TX, SIM_EV_U2_TX, SIM_EV_U3_TX,                           /* 串口一个字符发送完成 */
+    SIM_EV_U1_RX, SIM_EV_U2_RX, SIM_EV_U3_RX,                           /* 串口收到一个字符 */
+    SIM_EV_U1_IDLE, SIM_EV_U2_IDLE, SIM_EV_U3_IDLE,                     /* 串口线路空闲 */
+    SIM_EV_M2M,                                                         /* 存储器到存储器DMA完成 */
+    SIM_EV_RTC_ALARM,
+    SIM_EV_NUM
+} sim_event_t;
+
+/* DMA通道序号: 0~6为DMA1通道1~7, 7~11为DMA2通道1~5 */
+#define SIM_DMA_CH_NUM          12
+
+/* 仿真内核(sim_core.c) */
+extern uint64_t g_sim_now;                                          /* 当前时刻(CPU周期) */
+extern uint64_t g_sim_end;                                          /* 到达后结束仿真 */
+extern double g_sim_cpu_scale;                                      /* 主机耗时折算系数, 0为不折算 */
+
+void sim_core_reset(void);
+int sim_run(int (*entry)(void));                                    /* 运行固件直到g_sim_end */
+void *sim_reg(sim_periph_t id);                                     /* 外设寄存器, 不计时间 */
+void sim_cycles(uint32_t n);                                        /* 执行n个周期, 处理事件和中断 */
+void sim_advance(uint64_t n);                                       /* 推进时间并处理事件, 不执行中断 */
+void sim_event_at(sim_event_t ev, uint64_t due, void (*fire)(int arg), int arg);
+void sim_event_cancel(sim_event_t ev);
+uint64_t sim_event_due(sim_event_t ev);                             /* 未安排时返回UINT64_MAX */
+void sim_dispatch(void);                                            /* 执行可以抢占的挂起中断 */
+void sim_wait_for_interrupt(uint8_t stop);                          /* WFI: 跳到下一个能唤醒的事件 */
+void sim_sync(void);                                                /* 处理固件上次访问中写入的寄存器 */
+
+void sim_nvic_set_priority(int irq, uint32_t preempt, uint32_t sub);
+void sim_nvic_enable(int irq, uint8_t enable);
+void sim_nvic_set_pending(int irq, uint8_t pending);
+void sim_set_primask(uint32_t primask);
+uint32_t sim_get_primask(void);
+
+void sim_systick_config(uint32_t load);                             /* 重新设置SysTick周期并从LOAD开始计数 */
+void sim_exti_set_pending(uint32_t lines);                          /* 外部中断线上产生触发边沿 */
+uint32_t sim_irq_count(int irq);                                    /* 中断执行次数 */
+
+/* 外设模型(sim_hal.c) */
+int sim_dma_index(const DMA_Channel_TypeDef *ch);
+DMA_Channel_TypeDef *sim_dma_channel(int idx);
+int sim_dma_put(int idx, uint32_t value);                           /* 外设到存储器搬运一个数据, 通道未就绪返回1 */
+int sim_dma_take(int idx, uint32_t *value);                         /* 存储器到外设搬运一个数据 */
+uint32_t sim_dma_irq_level(int idx);
+int sim_dma_irq(int idx);
+
+uint32_t sim_tim_count_at(int tim, uint64_t t);                     /* 定时器在t时刻的计数值 */
+uint8_t sim_gp2y_led_on(uint64_t t);                                /* GP2Y1014AU的LED在t时刻是否点亮 */
+uint16_t sim_mq7_heater_permille(void);                             /* MQ-7加热PWM占空比(0.1%) */
+void sim_uart_inject(int port, uint64_t at, const uint8_t *data, uint16_t len);  /* 从at开始向串口发送数据 */
+void sim_uart_stats(int port, uint32_t *rx_bytes, uint32_t *rx_lost, uint32_t *tx_bytes);
+void sim_hal_reset(void);
+
+/* 无刷新开销的寄存器访问, 供模型使用 */
+#define SIM_GPIO(n)             ((GPIO_TypeDef *)sim_reg((sim_periph_t)(SIM_P_GPIOA + (n))))
+#define SIM_REG(type, id)       ((type *)sim_reg(id))
+
+/* SPI FLASH(sim_spi.c) */
+void sim_spi_cs(uint8_t level);                                     /* PB12片选 */
+void sim_spi_reset(void);
+void sim_spi_stats(uint32_t *reads, uint32_t *programs, uint32_t *erases);
+
+/* 传感器和环境(sim_env.c) */
+typedef struct
+{
+    double temperature;         /* °C */
+    double humidity;            /* % */
+    double co_ppm;
+    double dust_ug;             /* ug/m3 */
+} sim_env_t;
+
+void sim_env_init(void);
+void sim_env_at(uint64_t t, sim_env_t *env);
+uint16_t sim_env_adc(uint8_t channel, uint64_t t);                  /* ADC通道在t时刻的转换结果 */
+void sim_dht11_write(uint8_t level);                                /* 主机驱动PG11 */
+uint8_t sim_dht11_read(void);                                       /* 数据线电平 */
+void sim_dht11_stats(uint32_t *frames, uint32_t *ignored);
+
+/* 仿真程序(sim_main.c) */
+void sim_on_uart_tx(int port, uint8_t byte);                        /* 串口发出一个字节 */
+void sim_on_beep(uint8_t on, uint32_t freq_hz);                     /* 蜂鸣器PWM开关 */
+
+#endif
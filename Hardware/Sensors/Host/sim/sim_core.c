@@ -0,0 +1,913 @@
+/**
+ ****************************************************************************************************
+ * @file        sim_core.c
+ * @brief       主机仿真内核: 仿真时间, 事件队列, NVIC, SysTick/DWT/RTC/EXTI寄存器
+ ****************************************************************************************************
+ * @attention
+ *
+ * 固件通过sim_periph()访问外设: 先处理上一次访问中写入的寄存器(sim_sync), 再计入访问开销推进
+ * 时间(期间到期的事件和能抢占的中断都会执行), 最后刷新随时间变化的寄存器并返回寄存器结构.
+ * 中断函数在sim_cycles中直接调用, 嵌套关系由当前执行优先级决定, 与Cortex-M3的抢占规则一致.
+ *
+ ****************************************************************************************************
+ */
+
+#include <setjmp.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "sim.h"
+
+
+uint64_t g_sim_now = 0;
+uint64_t g_sim_end = UINT64_MAX;
+double g_sim_cpu_scale = 0;
+
+/******************************************************************************************/
+/* 寄存器 */
+
+static GPIO_TypeDef s_gpio[7];
+static AFIO_TypeDef s_afio;
+static EXTI_TypeDef s_exti;
+static DMA_TypeDef s_dma[2];
+static DMA_Channel_TypeDef s_dma_ch[SIM_DMA_CH_NUM];
+static TIM_TypeDef s_tim[5];
+static USART_TypeDef s_usart[3];
+static SPI_TypeDef s_spi2;
+static ADC_TypeDef s_adc1;
+static RTC_TypeDef s_rtc;
+static BKP_TypeDef s_bkp;
+static PWR_TypeDef s_pwr;
+static FSMC_Bank1_TypeDef s_fsmc;
+static FSMC_Bank1E_TypeDef s_fsmce;
+static SCB_Type s_scb;
+static SysTick_Type s_systick;
+static DWT_Type s_dwt;
+static CoreDebug_Type s_coredebug;
+static uint16_t s_lcd[2];                       /* LCD_REG, LCD_RAM */
+
+static void *const s_periph[SIM_P_NUM] =
+{
+    [SIM_P_GPIOA] = &s_gpio[0], [SIM_P_GPIOB] = &s_gpio[1], [SIM_P_GPIOC] = &s_gpio[2],
+    [SIM_P_GPIOD] = &s_gpio[3], [SIM_P_GPIOE] = &s_gpio[4], [SIM_P_GPIOF] = &s_gpio[5],
+    [SIM_P_GPIOG] = &s_gpio[6],
+    [SIM_P_AFIO] = &s_afio, [SIM_P_EXTI] = &s_exti,
+    [SIM_P_DMA1] = &s_dma[0], [SIM_P_DMA2] = &s_dma[1],
+    [SIM_P_DMA1_CH1] = &s_dma_ch[0], [SIM_P_DMA1_CH2] = &s_dma_ch[1], [SIM_P_DMA1_CH3] = &s_dma_ch[2],
+    [SIM_P_DMA1_CH4] = &s_dma_ch[3], [SIM_P_DMA1_CH5] = &s_dma_ch[4], [SIM_P_DMA1_CH6] = &s_dma_ch[5],
+    [SIM_P_DMA1_CH7] = &s_dma_ch[6],
+    [SIM_P_DMA2_CH1] = &s_dma_ch[7], [SIM_P_DMA2_CH2] = &s_dma_ch[8], [SIM_P_DMA2_CH3] = &s_dma_ch[9],
+    [SIM_P_DMA2_CH4] = &s_dma_ch[10], [SIM_P_DMA2_CH5] = &s_dma_ch[11],
+    [SIM_P_TIM2] = &s_tim[0], [SIM_P_TIM3] = &s_tim[1], [SIM_P_TIM4] = &s_tim[2],
+    [SIM_P_TIM6] = &s_tim[3], [SIM_P_TIM7] = &s_tim[4],
+    [SIM_P_USART1] = &s_usart[0], [SIM_P_USART2] = &s_usart[1], [SIM_P_USART3] = &s_usart[2],
+    [SIM_P_SPI2] = &s_spi2, [SIM_P_ADC1] = &s_adc1, [SIM_P_RTC] = &s_rtc, [SIM_P_BKP] = &s_bkp,
+    [SIM_P_PWR] = &s_pwr, [SIM_P_FSMC_BANK1] = &s_fsmc, [SIM_P_FSMC_BANK1E] = &s_fsmce,
+    [SIM_P_SCB] = &s_scb, [SIM_P_SYSTICK] = &s_systick, [SIM_P_DWT] = &s_dwt,
+    [SIM_P_COREDEBUG] = &s_coredebug, [SIM_P_LCD] = s_lcd,
+};
+
+/* 写1清零的EXTI->PR和需要察觉写入的寄存器 */
+#define SIM_WRITE_MARK          0x80000000U     /* 保留位, 被固件覆盖说明写过 */
+
+static uint32_t s_exti_pr;                      /* EXTI挂起位的真实值 */
+static uint64_t s_dwt_base;                     /* CYCCNT为0的时刻 */
+static uint32_t s_dwt_shadow;
+
+static uint32_t s_rtc_cnt_base;                 /* s_rtc_t_base时刻的计数值 */
+static uint64_t s_rtc_t_base;
+static uint32_t s_rtc_div;                      /* 预分频, PRL + 1 */
+static uint32_t s_rtc_alarm;
+static uint32_t s_rtc_shadow[6];                /* CNTH, CNTL, ALRH, ALRL, PRLH, PRLL */
+
+static uint64_t s_systick_base;                 /* 最近一次重装的时刻 */
+static uint8_t s_systick_pending;
+
+/******************************************************************************************/
+/* 事件 */
+
+typedef struct
+{
+    uint64_t due;
+    void (*fire)(int arg);
+    int arg;
+    uint8_t armed;
+} sim_event_slot_t;
+
+static sim_event_slot_t s_events[SIM_EV_NUM];
+static uint64_t s_next_due = UINT64_MAX;        /* 最早的到期时刻, 没有事件时为UINT64_MAX */
+static jmp_buf s_end_jmp;
+static uint8_t s_running = 0;
+
+static void sim_event_update_next(void)
+{
+    uint64_t next = UINT64_MAX;
+    int i;
+
+    for (i = 0; i < SIM_EV_NUM; i++)
+    {
+        if (s_events[i].armed && s_events[i].due < next)
+        {
+            next = s_events[i].due;
+        }
+    }
+
+    s_next_due = next;
+}
+
+void sim_event_at(sim_event_t ev, uint64_t due, void (*fire)(int arg), int arg)
+{
+    s_events[ev].due = due;
+    s_events[ev].fire = fire;
+    s_events[ev].arg = arg;
+    s_events[ev].armed = 1;
+
+    if (due < s_next_due)
+    {
+        s_next_due = due;
+    }
+}
+
+void sim_event_cancel(sim_event_t ev)
+{
+    if (s_events[ev].armed)
+    {
+        s_events[ev].armed = 0;
+        sim_event_update_next();
+    }
+}
+
+uint64_t sim_event_due(sim_event_t ev)
+{
+    return s_events[ev].armed ? s_events[ev].due : UINT64_MAX;
+}
+
+/**
+ * @brief       结束仿真, 回到sim_run
+ */
+static void sim_stop(void)
+{
+    g_sim_now = g_sim_end;
+
+    if (s_running)
+    {
+        longjmp(s_end_jmp, 1);
+    }
+}
+
+/**
+ * @brief       推进时间并按到期顺序执行事件
+ * @note        事件只改变外设状态, 不推进时间, 也不执行中断
+ * @param       n: 周期数
+ * @retval      无
+ */
+void sim_advance(uint64_t n)
+{
+    uint64_t target = g_sim_now + n;
+    sim_event_slot_t *ev;
+    int i, first;
+
+    if (target > g_sim_end)
+    {
+        target = g_sim_end;
+    }
+
+    while (s_next_due <= target)
+    {
+        first = -1;
+
+        for (i = 0; i < SIM_EV_NUM; i++)
+        {
+            if (s_events[i].armed && (first < 0 || s_events[i].due < s_events[first].due))
+            {
+                first = i;
+            }
+        }
+
+        ev = &s_events[first];
+
+        if (ev->due > g_sim_now)
+        {
+            g_sim_now = ev->due;
+        }
+
+        ev->armed = 0;
+        sim_event_update_next();
+        ev->fire(ev->arg);
+    }
+
+    g_sim_now = target;
+
+    if (g_sim_now >= g_sim_end)
+    {
+        sim_stop();
+    }
+}
+
+/******************************************************************************************/
+/* NVIC */
+
+#define SIM_SLOT_NUM            (SIM_IRQ_NUM + 1)   /* 最后一个是SysTick */
+#define SIM_SLOT(irq)           ((irq) < 0 ? SIM_IRQ_NUM : (irq))
+#define SIM_THREAD_PRIO         4                   /* 线程模式, 低于所有中断 */
+
+typedef struct
+{
+    void (*handler)(void);
+    uint8_t preempt;
+    uint8_t sub;
+    uint8_t enabled;
+    uint8_t sw_pending;
+    uint32_t count;
+} sim_irq_t;
+
+static sim_irq_t s_irq[SIM_SLOT_NUM];
+static uint8_t s_irq_list[SIM_SLOT_NUM];        /* 已使能的中断, 检查挂起时只扫描这些 */
+static uint8_t s_irq_list_num = 0;
+static uint8_t s_active[SIM_SLOT_NUM];          /* 正在执行的中断的抢占优先级 */
+static uint8_t s_active_depth = 0;
+static uint32_t s_primask = 0;
+
+/* 中断函数由固件定义, 没有定义的中断不能使能 */
+#define SIM_WEAK_HANDLER(name)  extern void name(void) __attribute__((weak));
+SIM_WEAK_HANDLER(SysTick_Handler)
+SIM_WEAK_HANDLER(DMA1_Channel1_IRQHandler)
+SIM_WEAK_HANDLER(DMA1_Channel2_IRQHandler)
+SIM_WEAK_HANDLER(DMA1_Channel3_IRQHandler)
+SIM_WEAK_HANDLER(DMA1_Channel4_IRQHandler)
+SIM_WEAK_HANDLER(DMA1_Channel5_IRQHandler)
+SIM_WEAK_HANDLER(DMA1_Channel6_IRQHandler)
+SIM_WEAK_HANDLER(DMA1_Channel7_IRQHandler)
+SIM_WEAK_HANDLER(ADC1_2_IRQHandler)
+SIM_WEAK_HANDLER(TIM2_IRQHandler)
+SIM_WEAK_HANDLER(TIM3_IRQHandler)
+SIM_WEAK_HANDLER(TIM4_IRQHandler)
+SIM_WEAK_HANDLER(TIM6_IRQHandler)
+SIM_WEAK_HANDLER(TIM7_IRQHandler)
+SIM_WEAK_HANDLER(SPI2_IRQHandler)
+SIM_WEAK_HANDLER(USART1_IRQHandler)
+SIM_WEAK_HANDLER(USART2_IRQHandler)
+SIM_WEAK_HANDLER(USART3_IRQHandler)
+SIM_WEAK_HANDLER(EXTI15_10_IRQHandler)
+SIM_WEAK_HANDLER(RTC_Alarm_IRQHandler)
+SIM_WEAK_HANDLER(DMA2_Channel1_IRQHandler)
+SIM_WEAK_HANDLER(DMA2_Channel2_IRQHandler)
+SIM_WEAK_HANDLER(DMA2_Channel3_IRQHandler)
+SIM_WEAK_HANDLER(DMA2_Channel4_5_IRQHandler)
+
+static void sim_irq_init_handlers(void)
+{
+    s_irq[SIM_SLOT(SysTick_IRQn)].handler = SysTick_Handler;
+    s_irq[DMA1_Channel1_IRQn].handler = DMA1_Channel1_IRQHandler;
+    s_irq[DMA1_Channel2_IRQn].handler = DMA1_Channel2_IRQHandler;
+    s_irq[DMA1_Channel3_IRQn].handler = DMA1_Channel3_IRQHandler;
+    s_irq[DMA1_Channel4_IRQn].handler = DMA1_Channel4_IRQHandler;
+    s_irq[DMA1_Channel5_IRQn].handler = DMA1_Channel5_IRQHandler;
+    s_irq[DMA1_Channel6_IRQn].handler = DMA1_Channel6_IRQHandler;
+    s_irq[DMA1_Channel7_IRQn].handler = DMA1_Channel7_IRQHandler;
+    s_irq[ADC1_2_IRQn].handler = ADC1_2_IRQHandler;
+    s_irq[TIM2_IRQn].handler = TIM2_IRQHandler;
+    s_irq[TIM3_IRQn].handler = TIM3_IRQHandler;
+    s_irq[TIM4_IRQn].handler = TIM4_IRQHandler;
+    s_irq[TIM6_IRQn].handler = TIM6_IRQHandler;
+    s_irq[TIM7_IRQn].handler = TIM7_IRQHandler;
+    s_irq[SPI2_IRQn].handler = SPI2_IRQHandler;
+    s_irq[USART1_IRQn].handler = USART1_IRQHandler;
+    s_irq[USART2_IRQn].handler = USART2_IRQHandler;
+    s_irq[USART3_IRQn].handler = USART3_IRQHandler;
+    s_irq[EXTI15_10_IRQn].handler = EXTI15_10_IRQHandler;
+    s_irq[RTC_Alarm_IRQn].handler = RTC_Alarm_IRQHandler;
+    s_irq[DMA2_Channel1_IRQn].handler = DMA2_Channel1_IRQHandler;
+    s_irq[DMA2_Channel2_IRQn].handler = DMA2_Channel2_IRQHandler;
+    s_irq[DMA2_Channel3_IRQn].handler = DMA2_Channel3_IRQHandler;
+    s_irq[DMA2_Channel4_5_IRQn].handler = DMA2_Channel4_5_IRQHandler;
+}
+
+/**
+ * @brief       外设中断请求(电平)
+ * @param       slot: 中断号, SysTick为SIM_IRQ_NUM
+ * @retval      非0表示请求有效
+ */
+static uint32_t sim_irq_level(int slot)
+{
+    int i;
+
+    if (slot >= DMA1_Channel1_IRQn && slot <= DMA1_Channel7_IRQn)
+    {
+        return sim_dma_irq_level(slot - DMA1_Channel1_IRQn);
+    }
+
+    switch (slot)
+    {
+        case SIM_IRQ_NUM:
+            return s_systick_pending;
+
+        case DMA2_Channel1_IRQn:
+        case DMA2_Channel2_IRQn:
+        case DMA2_Channel3_IRQn:
+            return sim_dma_irq_level(7 + slot - DMA2_Channel1_IRQn);
+
+        case DMA2_Channel4_5_IRQn:
+            return sim_dma_irq_level(10) | sim_dma_irq_level(11);
+
+        case USART1_IRQn:
+        case USART2_IRQn:
+        case USART3_IRQn:
+            i = slot - USART1_IRQn;
+            return s_usart[i].SR & s_usart[i].CR1 & (USART_SR_IDLE | USART_SR_RXNE | USART_SR_TC | USART_SR_TXE);
+
+        case TIM2_IRQn:
+        case TIM3_IRQn:
+        case TIM4_IRQn:
+            i = slot - TIM2_IRQn;
+            return s_tim[i].SR & s_tim[i].DIER & TIM_SR_UIF;
+
+        case TIM6_IRQn:
+        case TIM7_IRQn:
+            i = 3 + slot - TIM6_IRQn;
+            return s_tim[i].SR & s_tim[i].DIER & TIM_SR_UIF;
+
+        case EXTI15_10_IRQn:
+            return s_exti_pr & s_exti.IMR & 0xFC00;
+
+        case RTC_Alarm_IRQn:
+            return s_exti_pr & s_exti.IMR & EXTI_IMR_MR17;
+
+        default:
+            return 0;
+    }
+}
+
+/**
+ * @brief       找出优先级最高的挂起中断
+ * @param       below: 只考虑抢占优先级数值小于此值的中断
+ * @retval      中断槽号, 没有时返回-1
+ */
+static int sim_irq_highest(uint8_t below)
+{
+    sim_irq_t *irq, *best = 0;
+    int i, slot, found = -1;
+
+    for (i = 0; i < s_irq_list_num; i++)
+    {
+        slot = s_irq_list[i];
+        irq = &s_irq[slot];
+
+        if (irq->preempt >= below || (irq->sw_pending == 0 && sim_irq_level(slot) == 0))
+        {
+            continue;
+        }
+
+        if (best == 0 || irq->preempt < best->preempt || (irq->preempt == best->preempt && irq->sub < best->sub))
+        {
+            best = irq;
+            found = slot;
+        }
+    }
+
+    return found;
+}
+
+static uint8_t sim_exec_prio(void)
+{
+    return s_active_depth ? s_active[s_active_depth - 1] : SIM_THREAD_PRIO;
+}
+
+void sim_dispatch(void)
+{
+    sim_irq_t *irq;
+    int slot;
+
+    while (s_primask == 0)
+    {
+        sim_sync();
+        slot = sim_irq_highest(sim_exec_prio());
+
+        if (slot < 0)
+        {
+            return;
+        }
+
+        irq = &s_irq[slot];
+        irq->sw_pending = 0;
+
+        if (slot == SIM_IRQ_NUM)
+        {
+            s_systick_pending = 0;              /* 进入异常时硬件清除PENDST */
+        }
+
+        if (irq->handler == 0)
+        {
+            fprintf(stderr, "sim: IRQ %d enabled without a handler, disabled\n", slot);
+            sim_nvic_enable(slot == SIM_IRQ_NUM ? -1 : slot, 0);
+            continue;
+        }
+
+        s_active[s_active_depth++] = irq->preempt;
+        sim_advance(SIM_COST_IRQ);
+        irq->handler();
+        irq->count++;
+        sim_advance(SIM_COST_IRQ);
+        s_active_depth--;
+    }
+}
+
+void sim_nvic_set_priority(int irq, uint32_t preempt, uint32_t sub)
+{
+    s_irq[SIM_SLOT(irq)].preempt = preempt & 3;
+    s_irq[SIM_SLOT(irq)].sub = sub & 3;
+}
+
+void sim_nvic_enable(int irq, uint8_t enable)
+{
+    int slot = SIM_SLOT(irq);
+    int i;
+
+    if (s_irq[slot].enabled == enable)
+    {
+        return;
+    }
+
+    s_irq[slot].enabled = enable;
+    s_irq_list_num = 0;
+
+    for (i = 0; i < SIM_SLOT_NUM; i++)
+    {
+        if (s_irq[i].enabled)
+        {
+            s_irq_list[s_irq_list_num++] = i;
+        }
+    }
+}
+
+void sim_nvic_set_pending(int irq, uint8_t pending)
+{
+    s_irq[SIM_SLOT(irq)].sw_pending = pending;
+}
+
+void sim_set_primask(uint32_t primask)
+{
+    s_primask = primask & 1;
+
+    if (s_primask == 0)
+    {
+        sim_dispatch();
+    }
+}
+
+uint32_t sim_get_primask(void)
+{
+    return s_primask;
+}
+
+uint32_t sim_irq_count(int irq)
+{
+    return s_irq[SIM_SLOT(irq)].count;
+}
+
+/******************************************************************************************/
+/* 时间推进 */
+
+static uint64_t sim_host_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+static uint64_t s_host_last_ns = 0;
+
+/**
+ * @brief       CPU执行n个周期
+ * @note        --cpu-scale打开时, 距上一次调用的主机耗时按比例折算成周期一并计入,
+ *              用来近似固件中纯计算(CRC, 格式化, 查表)的耗时; 默认只计外设访问, 结果可重复
+ * @param       n: 周期数
+ * @retval      无
+ */
+void sim_cycles(uint32_t n)
+{
+    uint64_t cycles = n;
+    uint64_t ns, step;
+
+    if (g_sim_cpu_scale > 0)
+    {
+        ns = sim_host_ns();
+
+        if (s_host_last_ns)
+        {
+            cycles += (uint64_t)((double)(ns - s_host_last_ns) * g_sim_cpu_scale * SIM_CPU_HZ / 1e9);
+        }
+
+        s_host_last_ns = ns;
+    }
+
+    /* 逐个事件推进, 事件产生的中断在到期时刻抢占, 中断执行时间另计 */
+    while (s_next_due < g_sim_now + cycles)
+    {
+        step = s_next_due > g_sim_now ? s_next_due - g_sim_now : 0;
+        sim_advance(step);
+        cycles -= step;
+        sim_dispatch();
+    }
+
+    sim_advance(cycles);
+    sim_dispatch();
+}
+
+/**
+ * @brief       是否有可以唤醒WFI的中断
+ * @note        WFI不受PRIMASK影响, 只要挂起中断的优先级高于当前执行优先级就唤醒
+ */
+static uint8_t sim_wake_pending(uint8_t stop)
+{
+    int slot;
+
+    sim_sync();
+    slot = sim_irq_highest(sim_exec_prio());
+
+    if (slot < 0)
+    {
+        return 0;
+    }
+
+    /* STOP模式下只有EXTI线(含RTC闹钟)能唤醒 */
+    return stop == 0 || slot == EXTI15_10_IRQn || slot == RTC_Alarm_IRQn;
+}
+
+void sim_wait_for_interrupt(uint8_t stop)
+{
+    while (sim_wake_pending(stop) == 0)
+    {
+        if (s_next_due == UINT64_MAX)
+        {
+            sim_stop();                         /* 没有任何事件, 永远不会唤醒 */
+        }
+
+        sim_advance(s_next_due > g_sim_now ? s_next_due - g_sim_now : 0);
+    }
+
+    s_host_last_ns = 0;                         /* 睡眠期间的主机耗时不计入 */
+    sim_advance(SIM_COST_WAKE);
+}
+
+/******************************************************************************************/
+/* SysTick */
+
+static void sim_systick_fire(int arg)
+{
+    (void)arg;
+
+    if ((s_systick.CTRL & SysTick_CTRL_ENABLE_Msk) == 0)
+    {
+        return;
+    }
+
+    s_systick_base += s_systick.LOAD + 1;
+    s_systick.CTRL |= SysTick_CTRL_COUNTFLAG_Msk;
+
+    if (s_systick.CTRL & SysTick_CTRL_TICKINT_Msk)
+    {
+        s_systick_pending = 1;
+    }
+
+    sim_event_at(SIM_EV_SYSTICK, s_systick_base + s_systick.LOAD + 1, sim_systick_fire, 0);
+}
+
+void sim_systick_config(uint32_t load)
+{
+    s_systick.LOAD = load;
+    s_systick.VAL = load;
+    s_systick.CTRL = SysTick_CTRL_CLKSOURCE_Msk | SysTick_CTRL_TICKINT_Msk | SysTick_CTRL_ENABLE_Msk;
+    s_systick_base = g_sim_now;
+    s_systick_pending = 0;
+    sim_event_at(SIM_EV_SYSTICK, s_systick_base + load + 1, sim_systick_fire, 0);
+}
+
+/******************************************************************************************/
+/* RTC: 计数器由LSE经预分频得到, 按仿真时间计算 */
+
+static uint64_t sim_rtc_lse(uint64_t t)
+{
+    return (t - s_rtc_t_base) * 32768 / SIM_CPU_HZ;
+}
+
+static uint32_t sim_rtc_counter(void)
+{
+    return s_rtc_cnt_base + (uint32_t)(sim_rtc_lse(g_sim_now) / s_rtc_div);
+}
+
+static void sim_rtc_alarm_fire(int arg)
+{
+    (void)arg;
+    s_rtc.CRL |= RTC_CRL_ALRF;
+
+    if (s_exti.RTSR & EXTI_IMR_MR17)
+    {
+        sim_exti_set_pending(EXTI_IMR_MR17);
+    }
+}
+
+/**
+ * @brief       从当前时刻开始按新的计数值和预分频计数, 并重新安排闹钟
+ */
+static void sim_rtc_rebase(uint32_t counter)
+{
+    uint32_t ticks;
+    uint64_t lse;
+
+    s_rtc_cnt_base = counter;
+    s_rtc_t_base = g_sim_now;
+    ticks = s_rtc_alarm - counter;
+
+    if (ticks == 0 || ticks > 0x7FFFFFFF)
+    {
+        sim_event_cancel(SIM_EV_RTC_ALARM);
+        return;
+    }
+
+    lse = (uint64_t)ticks * s_rtc_div;
+    sim_event_at(SIM_EV_RTC_ALARM, s_rtc_t_base + (lse * SIM_CPU_HZ + 32767) / 32768, sim_rtc_alarm_fire, 0);
+}
+
+static void sim_rtc_refresh(void)
+{
+    uint64_t lse = sim_rtc_lse(g_sim_now);
+    uint32_t cnt = s_rtc_cnt_base + (uint32_t)(lse / s_rtc_div);
+
+    s_rtc.CNTH = cnt >> 16;
+    s_rtc.CNTL = cnt & 0xFFFF;
+    s_rtc.DIVL = s_rtc_div - 1 - (uint32_t)(lse % s_rtc_div);
+    s_rtc.DIVH = 0;
+    s_rtc.ALRH = s_rtc_alarm >> 16;
+    s_rtc.ALRL = s_rtc_alarm & 0xFFFF;
+    s_rtc.PRLH = (s_rtc_div - 1) >> 16;
+    s_rtc.PRLL = (s_rtc_div - 1) & 0xFFFF;
+    s_rtc.CRL |= RTC_CRL_RTOFF | RTC_CRL_RSF;   /* 写操作立即完成, 寄存器总是同步的 */
+
+    s_rtc_shadow[0] = s_rtc.CNTH;
+    s_rtc_shadow[1] = s_rtc.CNTL;
+    s_rtc_shadow[2] = s_rtc.ALRH;
+    s_rtc_shadow[3] = s_rtc.ALRL;
+    s_rtc_shadow[4] = s_rtc.PRLH;
+    s_rtc_shadow[5] = s_rtc.PRLL;
+}
+
+static void sim_rtc_sync(void)
+{
+    uint32_t cnt;
+
+    if (s_rtc.PRLH != s_rtc_shadow[4] || s_rtc.PRLL != s_rtc_shadow[5])
+    {
+        cnt = sim_rtc_counter();
+        s_rtc_div = (((s_rtc.PRLH & 0xF) << 16) | (s_rtc.PRLL & 0xFFFF)) + 1;
+        sim_rtc_rebase(cnt);
+        s_rtc_shadow[4] = s_rtc.PRLH;
+        s_rtc_shadow[5] = s_rtc.PRLL;
+    }
+
+    if (s_rtc.ALRH != s_rtc_shadow[2] || s_rtc.ALRL != s_rtc_shadow[3])
+    {
+        if (s_rtc.ALRH != s_rtc_shadow[2])
+        {
+            s_rtc_alarm = (s_rtc_alarm & 0xFFFF) | ((s_rtc.ALRH & 0xFFFF) << 16);
+        }
+
+        if (s_rtc.ALRL != s_rtc_shadow[3])
+        {
+            s_rtc_alarm = (s_rtc_alarm & 0xFFFF0000) | (s_rtc.ALRL & 0xFFFF);
+        }
+
+        sim_rtc_rebase(sim_rtc_counter());
+        s_rtc_shadow[2] = s_rtc.ALRH;
+        s_rtc_shadow[3] = s_rtc.ALRL;
+    }
+
+    if (s_rtc.CNTH != s_rtc_shadow[0] || s_rtc.CNTL != s_rtc_shadow[1])
+    {
+        cnt = sim_rtc_counter();
+
+        if (s_rtc.CNTH != s_rtc_shadow[0])
+        {
+            cnt = (cnt & 0xFFFF) | ((s_rtc.CNTH & 0xFFFF) << 16);
+        }
+
+        if (s_rtc.CNTL != s_rtc_shadow[1])
+        {
+            cnt = (cnt & 0xFFFF0000) | (s_rtc.CNTL & 0xFFFF);
+        }
+
+        sim_rtc_rebase(cnt);
+        s_rtc_shadow[0] = s_rtc.CNTH;
+        s_rtc_shadow[1] = s_rtc.CNTL;
+    }
+}
+
+/******************************************************************************************/
+/* LCD: 只模拟读ID(0XD3), 其余读操作返回0 */
+
+static uint16_t s_lcd_cmd;                      /* 最近写入的LCD_REG */
+static uint16_t s_lcd_ram;                      /* 上次放到LCD_RAM的值 */
+static uint8_t s_lcd_idx;                       /* 本命令已读出的参数个数 */
+
+/**
+ * @brief       按上一次访问的结果准备LCD_RAM的读出值
+ * @note        LCD_REG变化说明写了新命令; LCD_RAM仍是上次放的值说明上次是读操作
+ */
+static void sim_lcd_refresh(void)
+{
+    static const uint16_t id_9341[4] = {0x00, 0x00, 0x93, 0x41};    /* dummy, 0X00, 0X93, 0X41 */
+
+    if (s_lcd[0] != s_lcd_cmd)
+    {
+        s_lcd_cmd = s_lcd[0];
+        s_lcd_idx = 0;
+    }
+    else if (s_lcd[1] == s_lcd_ram && s_lcd_idx < 0xFF)
+    {
+        s_lcd_idx++;
+    }
+
+    s_lcd_ram = (s_lcd_cmd == 0xD3 && s_lcd_idx < 4) ? id_9341[s_lcd_idx] : 0;
+    s_lcd[1] = s_lcd_ram;
+}
+
+/******************************************************************************************/
+/* EXTI, DWT */
+
+void sim_exti_set_pending(uint32_t lines)
+{
+    sim_sync();
+    s_exti_pr |= lines;
+    s_exti.PR = s_exti_pr | SIM_WRITE_MARK;
+}
+
+static uint8_t sim_dwt_running(void)
+{
+    return (s_coredebug.DEMCR & CoreDebug_DEMCR_TRCENA_Msk) && (s_dwt.CTRL & DWT_CTRL_CYCCNTENA_Msk);
+}
+
+/**
+ * @brief       处理固件写入的寄存器
+ * @note        固件拿到寄存器指针后直接读写, 写入要到下一次访问外设时才能发现
+ */
+void sim_sync(void)
+{
+    if ((s_exti.PR & SIM_WRITE_MARK) == 0)
+    {
+        s_exti_pr &= ~s_exti.PR;                /* 写1清零 */
+        s_exti.PR = s_exti_pr | SIM_WRITE_MARK;
+    }
+
+    if (s_dwt.CYCCNT != s_dwt_shadow)
+    {
+        s_dwt_base = g_sim_now - s_dwt.CYCCNT;
+        s_dwt_shadow = s_dwt.CYCCNT;
+    }
+
+    sim_rtc_sync();
+}
+
+/**
+ * @brief       刷新随时间变化的寄存器
+ */
+static void sim_refresh(sim_periph_t id)
+{
+    switch (id)
+    {
+        case SIM_P_SYSTICK:
+            if (s_systick.CTRL & SysTick_CTRL_ENABLE_Msk)
+            {
+                s_systick.VAL = s_systick.LOAD - (uint32_t)((g_sim_now - s_systick_base) % (s_systick.LOAD + 1));
+            }
+            break;
+
+        case SIM_P_SCB:
+            if (s_systick_pending)
+            {
+                s_scb.ICSR |= SCB_ICSR_PENDSTSET_Msk;
+            }
+            else
+            {
+                s_scb.ICSR &= ~SCB_ICSR_PENDSTSET_Msk;
+            }
+            break;
+
+        case SIM_P_DWT:
+            if (sim_dwt_running())
+            {
+                s_dwt.CYCCNT = (uint32_t)(g_sim_now - s_dwt_base);
+                s_dwt_shadow = s_dwt.CYCCNT;
+            }
+            break;
+
+        case SIM_P_RTC:
+            sim_rtc_refresh();
+            break;
+
+        case SIM_P_LCD:
+            sim_lcd_refresh();
+            break;
+
+        default:
+            break;
+    }
+}
+
+/**
+ * @brief       固件访问外设寄存器
+ * @param       id: 外设
+ * @retval      寄存器结构
+ */
+void *sim_periph(sim_periph_t id)
+{
+    sim_sync();
+    sim_cycles(id == SIM_P_LCD ? SIM_COST_FSMC : SIM_COST_REG);
+    sim_refresh(id);
+    return s_periph[id];
+}
+
+void *sim_reg(sim_periph_t id)
+{
+    return s_periph[id];
+}
+
+/******************************************************************************************/
+
+/**
+ * @brief       复位所有寄存器和内核状态
+ */
+void sim_core_reset(void)
+{
+    memset(s_periph[SIM_P_GPIOA], 0, sizeof(s_gpio));
+    memset(&s_afio, 0, sizeof(s_afio));
+    memset(&s_exti, 0, sizeof(s_exti));
+    memset(s_dma, 0, sizeof(s_dma));
+    memset(s_dma_ch, 0, sizeof(s_dma_ch));
+    memset(s_tim, 0, sizeof(s_tim));
+    memset(s_usart, 0, sizeof(s_usart));
+    memset(&s_spi2, 0, sizeof(s_spi2));
+    memset(&s_adc1, 0, sizeof(s_adc1));
+    memset(&s_rtc, 0, sizeof(s_rtc));
+    memset(&s_bkp, 0, sizeof(s_bkp));
+    memset(&s_pwr, 0, sizeof(s_pwr));
+    memset(&s_fsmc, 0, sizeof(s_fsmc));
+    memset(&s_fsmce, 0, sizeof(s_fsmce));
+    memset(&s_scb, 0, sizeof(s_scb));
+    memset(&s_systick, 0, sizeof(s_systick));
+    memset(&s_dwt, 0, sizeof(s_dwt));
+    memset(&s_coredebug, 0, sizeof(s_coredebug));
+    memset(s_lcd, 0, sizeof(s_lcd));
+    memset(s_events, 0, sizeof(s_events));
+    memset(s_irq, 0, sizeof(s_irq));
+
+    g_sim_now = 0;
+    s_next_due = UINT64_MAX;
+    s_irq_list_num = 0;
+    s_active_depth = 0;
+    s_primask = 0;
+    s_host_last_ns = 0;
+    sim_irq_init_handlers();
+
+    *(uint32_t *)&s_scb.CPUID = 0x411FC231;    /* Cortex-M3 r1p1 */
+    s_exti_pr = 0;
+    s_exti.PR = SIM_WRITE_MARK;
+    s_dwt_base = 0;
+    s_dwt_shadow = 0;
+    s_systick_pending = 0;
+    s_systick_base = 0;
+    s_lcd_cmd = 0;
+    s_lcd_ram = 0;
+    s_lcd_idx = 0;
+
+    /* RTC复位值: 预分频0x8000(1Hz), 闹钟0xFFFFFFFF */
+    s_rtc_div = 0x8000;
+    s_rtc_alarm = 0xFFFFFFFF;
+    s_rtc_cnt_base = 0;
+    s_rtc_t_base = 0;
+    s_rtc.CRL = RTC_CRL_RTOFF;
+    sim_rtc_refresh();
+
+    /* SysTick异常优先级: HAL_Init按TICK_INT_PRIORITY(最低)设置 */
+    sim_nvic_set_priority(SysTick_IRQn, 3, 3);
+    sim_nvic_enable(SysTick_IRQn, 1);
+}
+
+/**
+ * @brief       运行固件直到g_sim_end
+ * @param       entry: 固件入口(fw_main)
+ * @retval      0, 到达结束时刻; 1, 固件从入口返回
+ */
+int sim_run(int (*entry)(void))
+{
+    if (setjmp(s_end_jmp))
+    {
+        s_running = 0;
+        return 0;
+    }
+
+    s_running = 1;
+    entry();
+    s_running = 0;
+    return 1;
+}
@@ -0,0 +1,271 @@
+/**
+ ****************************************************************************************************
+ * @file        sim_env.c
+ * @brief       主机仿真用的环境脚本和传感器模型: DHT11单总线波形, GP2Y1014AU和MQ-7的模拟输出
+ ****************************************************************************************************
+ * @attention
+ *
+ * 环境量按关键帧线性插值, 覆盖报警规则的触发和恢复:
+ * - 温度: 40~60s从25°C升到38°C, 90s回到25°C
+ * - 粉尘: 80~100s从50ug/m3升到300ug/m3, 130s回到50ug/m3
+ * - CO:   100~150s从10ppm升到80ppm并保持
+ * ADC值按固件换算的逆运算生成, 加上固定种子的噪声, 每次运行结果相同.
+ *
+ ****************************************************************************************************
+ */
+
+#include <string.h>
+#include "sim.h"
+#include "./BSP/MQ7/mq7_curve.h"
+
+
+typedef struct
+{
+    double t;                   /* 秒 */
+    double v;
+} sim_keyframe_t;
+
+static const sim_keyframe_t s_temperature[] = {{0, 25}, {40, 25}, {60, 38}, {90, 25}};
+static const sim_keyframe_t s_humidity[] = {{0, 50}};
+static const sim_keyframe_t s_dust[] = {{0, 50}, {80, 50}, {100, 300}, {130, 50}};
+static const sim_keyframe_t s_co[] = {{0, 10}, {100, 10}, {150, 80}};
+
+#define SIM_KEYFRAMES(k)        (k), (int)(sizeof(k) / sizeof((k)[0]))
+
+static double sim_keyframe(const sim_keyframe_t *k, int num, double t)
+{
+    int i;
+
+    if (t <= k[0].t)
+    {
+        return k[0].v;
+    }
+
+    for (i = 1; i < num; i++)
+    {
+        if (t < k[i].t)
+        {
+            return k[i - 1].v + (k[i].v - k[i - 1].v) * (t - k[i - 1].t) / (k[i].t - k[i - 1].t);
+        }
+    }
+
+    return k[num - 1].v;
+}
+
+void sim_env_at(uint64_t t, sim_env_t *env)
+{
+    double s = (double)t / SIM_CPU_HZ;
+
+    env->temperature = sim_keyframe(SIM_KEYFRAMES(s_temperature), s);
+    env->humidity = sim_keyframe(SIM_KEYFRAMES(s_humidity), s);
+    env->dust_ug = sim_keyframe(SIM_KEYFRAMES(s_dust), s);
+    env->co_ppm = sim_keyframe(SIM_KEYFRAMES(s_co), s);
+}
+
+/******************************************************************************************/
+/* 模拟量 */
+
+static uint32_t s_noise = 1;
+
+/* xorshift32, -2 ~ +2 LSB */
+static int sim_noise(void)
+{
+    s_noise ^= s_noise << 13;
+    s_noise ^= s_noise >> 17;
+    s_noise ^= s_noise << 5;
+    return (int)(s_noise % 5) - 2;
+}
+
+static uint16_t sim_adc_clamp(int v)
+{
+    return v < 0 ? 0 : (v > 4095 ? 4095 : (uint16_t)v);
+}
+
+/**
+ * @brief       mq7_adc_to_ppm_x10的逆运算: 换算结果不小于ppm_x10的最小ADC值
+ */
+static uint16_t sim_mq7_adc(uint32_t ppm_x10)
+{
+    uint32_t adc, i, frac, v;
+
+    for (adc = 0; adc < 4095; adc++)
+    {
+        i = adc >> MQ7_CURVE_SHIFT;
+        frac = adc & ((1 << MQ7_CURVE_SHIFT) - 1);
+        v = g_mq7_curve[i] + ((((int32_t)g_mq7_curve[i + 1] - g_mq7_curve[i]) * (int32_t)frac) >> MQ7_CURVE_SHIFT);
+
+        if (v >= ppm_x10)
+        {
+            break;
+        }
+    }
+
+    return (uint16_t)adc;
+}
+
+/**
+ * @brief       ADC通道在t时刻的转换结果
+ * @note        通道0(GP2Y1014AU): LED点亮时输出0.6V + 10mV/(ug/m3), 熄灭时约0.1V;
+ *              通道1(MQ-7): 低温阶段按CO浓度输出, 高温阶段(加热占空比>50%)在清洗, 输出接近洁净空气
+ * @param       channel: ADC通道
+ * @param       t: 采样时刻
+ * @retval      12位ADC值
+ */
+uint16_t sim_env_adc(uint8_t channel, uint64_t t)
+{
+    sim_env_t env;
+    double mv;
+
+    sim_env_at(t, &env);
+
+    switch (channel)
+    {
+        case 0:
+            mv = sim_gp2y_led_on(t) ? 600 + env.dust_ug * 10 : 100;
+            return sim_adc_clamp((int)(mv * 4096 / 3300) + sim_noise());
+
+        case 1:
+            if (sim_mq7_heater_permille() > 500)
+            {
+                return sim_adc_clamp(sim_mq7_adc(MQ7_CURVE_MIN) + sim_noise());
+            }
+
+            return sim_adc_clamp(sim_mq7_adc((uint32_t)(env.co_ppm * 10)) + sim_noise());
+
+        default:
+            return sim_adc_clamp(2048 + sim_noise());
+    }
+}
+
+/******************************************************************************************/
+/* DHT11: 主机拉低不少于18ms后释放, 20us后应答 */
+
+#define SIM_DHT11_START_MIN     SIM_MS(18)
+#define SIM_DHT11_EDGES         (2 + 2 + 40 * 2 + 2)    /* 应答低/高, 40位低/高, 结束低/释放 */
+
+static uint8_t s_master = 1;                    /* 主机输出(开漏, 1为释放) */
+static uint8_t s_sensor = 1;                    /* DHT11输出 */
+static uint64_t s_master_low_at;
+static uint64_t s_wave_at[SIM_DHT11_EDGES];     /* 波形中各次电平变化的时刻 */
+static uint8_t s_wave_level[SIM_DHT11_EDGES];
+static int s_wave_num = 0;
+static uint32_t s_frames = 0;
+static uint32_t s_ignored = 0;
+
+uint8_t sim_dht11_read(void)
+{
+    return s_master & s_sensor;
+}
+
+/**
+ * @brief       总线电平变化, 下降沿按EXTI11的配置产生挂起
+ */
+static void sim_dht11_line(uint8_t master, uint8_t sensor)
+{
+    EXTI_TypeDef *exti = SIM_REG(EXTI_TypeDef, SIM_P_EXTI);
+    uint8_t before = s_master & s_sensor;
+
+    s_master = master;
+    s_sensor = sensor;
+
+    if (before && (s_master & s_sensor) == 0 && (exti->FTSR & GPIO_PIN_11) && (exti->IMR & GPIO_PIN_11))
+    {
+        sim_exti_set_pending(GPIO_PIN_11);
+    }
+}
+
+static void sim_dht11_fire(int idx)
+{
+    sim_dht11_line(s_master, s_wave_level[idx]);
+
+    if (idx + 1 < s_wave_num)
+    {
+        sim_event_at(SIM_EV_DHT11, s_wave_at[idx + 1], sim_dht11_fire, idx + 1);
+    }
+}
+
+static void sim_dht11_add(uint64_t *t, uint32_t us_after, uint8_t level)
+{
+    *t += SIM_US(us_after);
+    s_wave_at[s_wave_num] = *t;
+    s_wave_level[s_wave_num] = level;
+    s_wave_num++;
+}
+
+/**
+ * @brief       按当前温湿度生成一帧应答波形
+ */
+static void sim_dht11_respond(void)
+{
+    sim_env_t env;
+    uint8_t buf[5];
+    uint64_t t = g_sim_now;
+    int i;
+
+    sim_env_at(g_sim_now, &env);
+    buf[0] = (uint8_t)(env.humidity + 0.5);
+    buf[1] = 0;
+    buf[2] = (uint8_t)(env.temperature + 0.5);
+    buf[3] = 0;
+    buf[4] = (uint8_t)(buf[0] + buf[1] + buf[2] + buf[3]);
+
+    s_wave_num = 0;
+    sim_dht11_add(&t, 20, 0);                   /* 应答: 低80us, 高80us */
+    sim_dht11_add(&t, 80, 1);
+
+    for (i = 0; i < 40; i++)                    /* 每位: 低50us, 高27us(0)或70us(1) */
+    {
+        sim_dht11_add(&t, i ? ((buf[(i - 1) / 8] >> (7 - (i - 1) % 8)) & 1 ? 70 : 27) : 80, 0);
+        sim_dht11_add(&t, 50, 1);
+    }
+
+    sim_dht11_add(&t, (buf[4] & 1) ? 70 : 27, 0);   /* 结束: 低50us后释放 */
+    sim_dht11_add(&t, 50, 1);
+
+    s_frames++;
+    sim_event_at(SIM_EV_DHT11, s_wave_at[0], sim_dht11_fire, 0);
+}
+
+void sim_dht11_write(uint8_t level)
+{
+    if (level == s_master)
+    {
+        return;
+    }
+
+    if (level == 0)
+    {
+        s_master_low_at = g_sim_now;
+        sim_event_cancel(SIM_EV_DHT11);         /* 主机拉低, 中止正在发送的数据 */
+        sim_dht11_line(0, 1);
+        return;
+    }
+
+    sim_dht11_line(1, s_sensor);
+
+    if (g_sim_now - s_master_low_at >= SIM_DHT11_START_MIN)
+    {
+        sim_dht11_respond();
+    }
+    else
+    {
+        s_ignored++;
+    }
+}
+
+void sim_dht11_stats(uint32_t *frames, uint32_t *ignored)
+{
+    *frames = s_frames;
+    *ignored = s_ignored;
+}
+
+void sim_env_init(void)
+{
+    s_noise = 1;
+    s_master = 1;
+    s_sensor = 1;
+    s_master_low_at = 0;
+    s_wave_num = 0;
+    s_frames = 0;
+    s_ignored = 0;
+}
@@ -0,0 +1,1543 @@
+/**
+ ****************************************************************************************************
+ * @file        sim_hal.c
+ * @brief       主机仿真用的HAL和外设模型: GPIO, DMA, TIM, ADC, USART, 以及sys.c和CMSIS内核函数
+ ****************************************************************************************************
+ * @attention
+ *
+ * HAL函数按STM32CubeF1的行为实现固件用到的路径(状态机, 回调顺序, 中断使能位), 寄存器操作落到
+ * 仿真内核的寄存器结构上. 外设的时间行为:
+ * - TIM: 计数值按(当前时刻 - 计数起点) / (PSC + 1)计算, UIE打开时在溢出时刻安排更新事件
+ * - ADC1: TIM3 OC1REF(CNT == CCR1)触发扫描, 每个通道按采样时间 + 12.5个ADC周期(ADCCLK = 12MHz)
+ *         转换, 结果经DMA1通道1写入存储器
+ * - USART: 每个字符10位, 发送从DMA取数据, 接收按字符间隔把注入的数据写入DR或接收DMA,
+ *          一串数据之后一个字符时间置位IDLE
+ * - DMA2通道1(存储器到FSMC): 每个半字SIM_COST_M2M个周期后完成
+ *
+ ****************************************************************************************************
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sim.h"
+
+
+uint32_t SystemCoreClock = SIM_CPU_HZ;
+volatile uint32_t uwTick = 0;
+
+/******************************************************************************************/
+/* CMSIS内核函数 */
+
+void __disable_irq(void)
+{
+    sim_set_primask(1);
+}
+
+void __enable_irq(void)
+{
+    sim_set_primask(0);
+}
+
+uint32_t __get_PRIMASK(void)
+{
+    return sim_get_primask();
+}
+
+void __set_PRIMASK(uint32_t primask)
+{
+    sim_set_primask(primask);
+}
+
+void __NOP(void)
+{
+    sim_cycles(1);
+}
+
+void __WFI(void)
+{
+    sim_wait_for_interrupt((SIM_REG(SCB_Type, SIM_P_SCB)->SCR & SCB_SCR_SLEEPDEEP_Msk) != 0);
+}
+
+void __DSB(void)
+{
+}
+
+void __ISB(void)
+{
+}
+
+void __set_MSP(uint32_t top)
+{
+    (void)top;
+}
+
+void NVIC_SystemReset(void)
+{
+    fprintf(stderr, "sim: system reset requested at %.6f s\n", (double)g_sim_now / SIM_CPU_HZ);
+    exit(3);
+}
+
+/******************************************************************************************/
+/* sys.c: 时钟和汇编函数在主机上没有意义 */
+
+void sys_nvic_set_vector_table(uint32_t baseaddr, uint32_t offset)
+{
+    (void)baseaddr;
+    (void)offset;
+}
+
+void sys_wfi_set(void)
+{
+    __WFI();
+}
+
+void sys_intx_disable(void)
+{
+    __disable_irq();
+}
+
+void sys_intx_enable(void)
+{
+    __enable_irq();
+}
+
+void sys_msr_msp(uint32_t addr)
+{
+    (void)addr;
+}
+
+void sys_standby(void)
+{
+    fprintf(stderr, "sim: standby entered at %.6f s\n", (double)g_sim_now / SIM_CPU_HZ);
+    exit(3);
+}
+
+void sys_soft_reset(void)
+{
+    NVIC_SystemReset();
+}
+
+uint8_t sys_clock_set(uint32_t plln)
+{
+    (void)plln;
+    return 0;
+}
+
+void sys_stm32_clock_init(uint32_t plln)
+{
+    (void)plln;
+    sim_cycles(SIM_COST_HAL);
+}
+
+/******************************************************************************************/
+/* RCC */
+
+HAL_StatusTypeDef HAL_RCC_OscConfig(RCC_OscInitTypeDef *RCC_OscInitStruct)
+{
+    (void)RCC_OscInitStruct;
+    sim_cycles(SIM_COST_HAL);
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_RCC_ClockConfig(RCC_ClkInitTypeDef *RCC_ClkInitStruct, uint32_t FLatency)
+{
+    (void)RCC_ClkInitStruct;
+    (void)FLatency;
+    sim_cycles(SIM_COST_HAL);
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_RCCEx_PeriphCLKConfig(RCC_PeriphCLKInitTypeDef *PeriphClkInit)
+{
+    (void)PeriphClkInit;
+    sim_cycles(SIM_COST_HAL);
+    return HAL_OK;
+}
+
+/******************************************************************************************/
+/* 内核: 节拍, NVIC */
+
+HAL_StatusTypeDef HAL_Init(void)
+{
+    sim_systick_config(SIM_CPU_HZ / 1000 - 1);  /* 1ms节拍 */
+    sim_nvic_set_priority(SysTick_IRQn, 3, 3);  /* TICK_INT_PRIORITY = 0x0F */
+    uwTick = 0;
+    sim_cycles(SIM_COST_HAL);
+    return HAL_OK;
+}
+
+void HAL_IncTick(void)
+{
+    uwTick++;
+}
+
+uint32_t HAL_GetTick(void)
+{
+    sim_cycles(SIM_COST_REG);
+    return uwTick;
+}
+
+void HAL_SuspendTick(void)
+{
+    SysTick->CTRL &= ~SysTick_CTRL_TICKINT_Msk;
+}
+
+void HAL_ResumeTick(void)
+{
+    SysTick->CTRL |= SysTick_CTRL_TICKINT_Msk;
+}
+
+void HAL_NVIC_SetPriorityGrouping(uint32_t PriorityGroup)
+{
+    (void)PriorityGroup;
+}
+
+void HAL_NVIC_SetPriority(IRQn_Type IRQn, uint32_t PreemptPriority, uint32_t SubPriority)
+{
+    sim_cycles(SIM_COST_REG);
+    sim_nvic_set_priority(IRQn, PreemptPriority, SubPriority);
+}
+
+void HAL_NVIC_EnableIRQ(IRQn_Type IRQn)
+{
+    sim_cycles(SIM_COST_REG);
+    sim_nvic_enable(IRQn, 1);
+}
+
+void HAL_NVIC_DisableIRQ(IRQn_Type IRQn)
+{
+    sim_cycles(SIM_COST_REG);
+    sim_nvic_enable(IRQn, 0);
+}
+
+void HAL_NVIC_SetPendingIRQ(IRQn_Type IRQn)
+{
+    sim_nvic_set_pending(IRQn, 1);
+    sim_cycles(SIM_COST_REG);
+}
+
+void HAL_NVIC_ClearPendingIRQ(IRQn_Type IRQn)
+{
+    sim_nvic_set_pending(IRQn, 0);
+    sim_cycles(SIM_COST_REG);
+}
+
+/******************************************************************************************/
+/* GPIO: PG11接DHT11, PB12是SPI FLASH片选, 其余引脚只记录输出电平 */
+
+static int sim_gpio_port(GPIO_TypeDef *GPIOx)
+{
+    return (int)(GPIOx - SIM_GPIO(0));
+}
+
+void HAL_GPIO_Init(GPIO_TypeDef *GPIOx, GPIO_InitTypeDef *GPIO_Init)
+{
+    (void)GPIOx;
+    (void)GPIO_Init;
+    sim_cycles(SIM_COST_HAL);
+}
+
+GPIO_PinState HAL_GPIO_ReadPin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin)
+{
+    sim_cycles(SIM_COST_REG);
+
+    if (sim_gpio_port(GPIOx) == 6 && GPIO_Pin == GPIO_PIN_11)
+    {
+        return sim_dht11_read() ? GPIO_PIN_SET : GPIO_PIN_RESET;
+    }
+
+    return (GPIOx->ODR & GPIO_Pin) ? GPIO_PIN_SET : GPIO_PIN_RESET;
+}
+
+void HAL_GPIO_WritePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin, GPIO_PinState PinState)
+{
+    int port = sim_gpio_port(GPIOx);
+
+    sim_cycles(SIM_COST_REG);
+
+    if (PinState != GPIO_PIN_RESET)
+    {
+        GPIOx->ODR |= GPIO_Pin;
+    }
+    else
+    {
+        GPIOx->ODR &= ~GPIO_Pin;
+    }
+
+    if (port == 6 && (GPIO_Pin & GPIO_PIN_11))
+    {
+        sim_dht11_write(PinState != GPIO_PIN_RESET);
+    }
+    else if (port == 1 && (GPIO_Pin & GPIO_PIN_12))
+    {
+        sim_spi_cs(PinState != GPIO_PIN_RESET);
+    }
+}
+
+void HAL_GPIO_TogglePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin)
+{
+    sim_cycles(SIM_COST_REG);
+    GPIOx->ODR ^= GPIO_Pin;
+}
+
+/******************************************************************************************/
+/* DMA */
+
+#define SIM_DMA_GIF             0x1
+#define SIM_DMA_TCIF            0x2
+#define SIM_DMA_HTIF            0x4
+#define SIM_DMA_TEIF            0x8
+
+static uint32_t s_dma_len[SIM_DMA_CH_NUM];      /* 启动时的传输数量, 循环模式重装用 */
+static uint32_t s_dma_pos[SIM_DMA_CH_NUM];      /* 本轮已传输的数量 */
+
+int sim_dma_index(const DMA_Channel_TypeDef *ch)
+{
+    return (int)(ch - SIM_REG(DMA_Channel_TypeDef, SIM_P_DMA1_CH1));
+}
+
+DMA_Channel_TypeDef *sim_dma_channel(int idx)
+{
+    return SIM_REG(DMA_Channel_TypeDef, SIM_P_DMA1_CH1 + idx);
+}
+
+static DMA_TypeDef *sim_dma_ctrl(int idx, uint32_t *shift)
+{
+    *shift = 4 * (idx < 7 ? idx : idx - 7);
+    return SIM_REG(DMA_TypeDef, idx < 7 ? SIM_P_DMA1 : SIM_P_DMA2);
+}
+
+static void sim_dma_set_flags(int idx, uint32_t flags)
+{
+    uint32_t shift;
+    DMA_TypeDef *dma = sim_dma_ctrl(idx, &shift);
+
+    dma->ISR |= (flags | SIM_DMA_GIF) << shift;
+}
+
+static void sim_dma_clear_flags(int idx, uint32_t flags)
+{
+    uint32_t shift;
+    DMA_TypeDef *dma = sim_dma_ctrl(idx, &shift);
+
+    dma->ISR &= ~(flags << shift);
+
+    if ((dma->ISR & ((SIM_DMA_TCIF | SIM_DMA_HTIF | SIM_DMA_TEIF) << shift)) == 0)
+    {
+        dma->ISR &= ~(SIM_DMA_GIF << shift);
+    }
+}
+
+static uint32_t sim_dma_flags(int idx)
+{
+    uint32_t shift;
+    DMA_TypeDef *dma = sim_dma_ctrl(idx, &shift);
+
+    return (dma->ISR >> shift) & 0xF;
+}
+
+uint32_t sim_dma_irq_level(int idx)
+{
+    return sim_dma_flags(idx) & sim_dma_channel(idx)->CCR & (DMA_CCR_TCIE | DMA_CCR_HTIE | DMA_CCR_TEIE);
+}
+
+int sim_dma_irq(int idx)
+{
+    if (idx < 7)
+    {
+        return DMA1_Channel1_IRQn + idx;
+    }
+
+    return idx < 10 ? DMA2_Channel1_IRQn + idx - 7 : DMA2_Channel4_5_IRQn;
+}
+
+/**
+ * @brief       一次传输后的计数和标志
+ */
+static void sim_dma_step(int idx)
+{
+    DMA_Channel_TypeDef *ch = sim_dma_channel(idx);
+
+    s_dma_pos[idx]++;
+    ch->CNDTR--;
+
+    if (s_dma_pos[idx] == s_dma_len[idx] / 2)
+    {
+        sim_dma_set_flags(idx, SIM_DMA_HTIF);
+    }
+
+    if (ch->CNDTR == 0)
+    {
+        sim_dma_set_flags(idx, SIM_DMA_TCIF);
+
+        if (ch->CCR & DMA_CCR_CIRC)
+        {
+            ch->CNDTR = s_dma_len[idx];
+            s_dma_pos[idx] = 0;
+        }
+    }
+}
+
+static uint32_t sim_dma_msize(const DMA_Channel_TypeDef *ch)
+{
+    return 1u << ((ch->CCR >> 10) & 3);
+}
+
+int sim_dma_put(int idx, uint32_t value)
+{
+    DMA_Channel_TypeDef *ch = sim_dma_channel(idx);
+    uint32_t size = sim_dma_msize(ch);
+    uint8_t *dst;
+
+    if ((ch->CCR & DMA_CCR_EN) == 0 || ch->CNDTR == 0)
+    {
+        return 1;
+    }
+
+    dst = (uint8_t *)(uintptr_t)ch->CMAR + ((ch->CCR & DMA_CCR_MINC) ? s_dma_pos[idx] * size : 0);
+    memcpy(dst, &value, size);                  /* 小端, 与Cortex-M3一致 */
+    sim_dma_step(idx);
+    return 0;
+}
+
+int sim_dma_take(int idx, uint32_t *value)
+{
+    DMA_Channel_TypeDef *ch = sim_dma_channel(idx);
+    uint32_t size = sim_dma_msize(ch);
+    const uint8_t *src;
+
+    if ((ch->CCR & DMA_CCR_EN) == 0 || ch->CNDTR == 0)
+    {
+        return 1;
+    }
+
+    src = (const uint8_t *)(uintptr_t)ch->CMAR + ((ch->CCR & DMA_CCR_MINC) ? s_dma_pos[idx] * size : 0);
+    *value = 0;
+    memcpy(value, src, size);
+    sim_dma_step(idx);
+    return 0;
+}
+
+uint32_t sim_dma_get_counter(DMA_HandleTypeDef *hdma)
+{
+    sim_cycles(SIM_COST_REG);
+    return hdma->Instance->CNDTR;
+}
+
+/* 存储器到存储器: 启动后按长度计时, 到时一次完成 */
+static void sim_dma_m2m_fire(int idx)
+{
+    DMA_Channel_TypeDef *ch = sim_dma_channel(idx);
+
+    if (ch->CCR & DMA_CCR_EN)
+    {
+        s_dma_pos[idx] = s_dma_len[idx];
+        ch->CNDTR = 0;
+        sim_dma_set_flags(idx, SIM_DMA_TCIF);
+    }
+}
+
+HAL_StatusTypeDef HAL_DMA_Init(DMA_HandleTypeDef *hdma)
+{
+    DMA_Channel_TypeDef *ch = hdma->Instance;
+
+    sim_cycles(SIM_COST_HAL);
+    ch->CCR = hdma->Init.Direction | hdma->Init.PeriphInc | hdma->Init.MemInc |
+              hdma->Init.PeriphDataAlignment | hdma->Init.MemDataAlignment |
+              hdma->Init.Mode | hdma->Init.Priority;
+    hdma->ErrorCode = 0;
+    hdma->State = HAL_DMA_STATE_READY;
+    hdma->Lock = HAL_UNLOCKED;
+    return HAL_OK;
+}
+
+static HAL_StatusTypeDef sim_dma_start(DMA_HandleTypeDef *hdma, uint32_t SrcAddress, uint32_t DstAddress,
+                                       uint32_t DataLength, uint32_t it)
+{
+    DMA_Channel_TypeDef *ch = hdma->Instance;
+    int idx = sim_dma_index(ch);
+
+    sim_cycles(SIM_COST_HAL);
+
+    if (hdma->State != HAL_DMA_STATE_READY)
+    {
+        return HAL_BUSY;
+    }
+
+    hdma->State = HAL_DMA_STATE_BUSY;
+    hdma->ErrorCode = 0;
+    ch->CCR &= ~DMA_CCR_EN;
+    sim_dma_clear_flags(idx, SIM_DMA_TCIF | SIM_DMA_HTIF | SIM_DMA_TEIF);
+
+    ch->CNDTR = DataLength;
+    s_dma_len[idx] = DataLength;
+    s_dma_pos[idx] = 0;
+
+    if (ch->CCR & DMA_CCR_DIR)
+    {
+        ch->CPAR = DstAddress;
+        ch->CMAR = SrcAddress;
+    }
+    else
+    {
+        ch->CPAR = SrcAddress;
+        ch->CMAR = DstAddress;
+    }
+
+    ch->CCR &= ~(DMA_CCR_TCIE | DMA_CCR_HTIE | DMA_CCR_TEIE);
+    ch->CCR |= it | DMA_CCR_EN;
+
+    if (ch->CCR & DMA_CCR_MEM2MEM)
+    {
+        sim_event_at(SIM_EV_M2M, g_sim_now + (uint64_t)DataLength * SIM_COST_M2M, sim_dma_m2m_fire, idx);
+    }
+
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_DMA_Start(DMA_HandleTypeDef *hdma, uint32_t SrcAddress, uint32_t DstAddress, uint32_t DataLength)
+{
+    return sim_dma_start(hdma, SrcAddress, DstAddress, DataLength, 0);
+}
+
+HAL_StatusTypeDef HAL_DMA_Start_IT(DMA_HandleTypeDef *hdma, uint32_t SrcAddress, uint32_t DstAddress, uint32_t DataLength)
+{
+    /* 与HAL库一致: 设置了半满回调才打开HT中断 */
+    uint32_t it = DMA_CCR_TCIE | DMA_CCR_TEIE | (hdma->XferHalfCpltCallback ? DMA_CCR_HTIE : 0);
+
+    return sim_dma_start(hdma, SrcAddress, DstAddress, DataLength, it);
+}
+
+HAL_StatusTypeDef HAL_DMA_Abort(DMA_HandleTypeDef *hdma)
+{
+    DMA_Channel_TypeDef *ch = hdma->Instance;
+    int idx = sim_dma_index(ch);
+
+    sim_cycles(SIM_COST_HAL);
+    ch->CCR &= ~(DMA_CCR_EN | DMA_CCR_TCIE | DMA_CCR_HTIE | DMA_CCR_TEIE);
+    sim_dma_clear_flags(idx, SIM_DMA_TCIF | SIM_DMA_HTIF | SIM_DMA_TEIF);
+
+    if (ch->CCR & DMA_CCR_MEM2MEM)
+    {
+        sim_event_cancel(SIM_EV_M2M);
+    }
+
+    hdma->State = HAL_DMA_STATE_READY;
+    hdma->Lock = HAL_UNLOCKED;
+    return HAL_OK;
+}
+
+void HAL_DMA_IRQHandler(DMA_HandleTypeDef *hdma)
+{
+    DMA_Channel_TypeDef *ch = hdma->Instance;
+    int idx = sim_dma_index(ch);
+    uint32_t flags = sim_dma_flags(idx);
+    uint32_t ccr = ch->CCR;
+
+    sim_cycles(SIM_COST_HAL);
+
+    if ((flags & SIM_DMA_HTIF) && (ccr & DMA_CCR_HTIE))
+    {
+        if ((ccr & DMA_CCR_CIRC) == 0)
+        {
+            ch->CCR &= ~DMA_CCR_HTIE;
+        }
+
+        sim_dma_clear_flags(idx, SIM_DMA_HTIF);
+
+        if (hdma->XferHalfCpltCallback)
+        {
+            hdma->XferHalfCpltCallback(hdma);
+        }
+    }
+    else if ((flags & SIM_DMA_TCIF) && (ccr & DMA_CCR_TCIE))
+    {
+        if ((ccr & DMA_CCR_CIRC) == 0)
+        {
+            ch->CCR &= ~(DMA_CCR_TEIE | DMA_CCR_TCIE);
+            hdma->State = HAL_DMA_STATE_READY;
+        }
+
+        sim_dma_clear_flags(idx, SIM_DMA_TCIF);
+        hdma->Lock = HAL_UNLOCKED;
+
+        if (hdma->XferCpltCallback)
+        {
+            hdma->XferCpltCallback(hdma);
+        }
+    }
+    else if ((flags & SIM_DMA_TEIF) && (ccr & DMA_CCR_TEIE))
+    {
+        ch->CCR &= ~(DMA_CCR_TEIE | DMA_CCR_TCIE | DMA_CCR_HTIE);
+        sim_dma_clear_flags(idx, SIM_DMA_TCIF | SIM_DMA_HTIF | SIM_DMA_TEIF);
+        hdma->ErrorCode = 1;
+        hdma->State = HAL_DMA_STATE_READY;
+        hdma->Lock = HAL_UNLOCKED;
+
+        if (hdma->XferErrorCallback)
+        {
+            hdma->XferErrorCallback(hdma);
+        }
+    }
+}
+
+HAL_DMA_StateTypeDef HAL_DMA_GetState(DMA_HandleTypeDef *hdma)
+{
+    return hdma->State;
+}
+
+/******************************************************************************************/
+/* TIM: TIM2, TIM3, TIM4, TIM6, TIM7 */
+
+#define SIM_TIM_NUM             5
+#define SIM_TIM_TIM2            0
+#define SIM_TIM_TIM3            1
+#define SIM_TIM_TIM4            2
+
+static uint64_t s_tim_base[SIM_TIM_NUM];        /* 计数值为0的时刻 */
+static uint8_t s_beep_on = 0;
+
+static void sim_adc_schedule_trigger(void);
+
+static int sim_tim_index(const TIM_TypeDef *tim)
+{
+    return (int)(tim - SIM_REG(TIM_TypeDef, SIM_P_TIM2));
+}
+
+static TIM_TypeDef *sim_tim(int idx)
+{
+    return SIM_REG(TIM_TypeDef, SIM_P_TIM2 + idx);
+}
+
+static uint64_t sim_tim_tick(const TIM_TypeDef *tim)
+{
+    return (uint64_t)tim->PSC + 1;
+}
+
+uint32_t sim_tim_count_at(int idx, uint64_t t)
+{
+    TIM_TypeDef *tim = sim_tim(idx);
+
+    if ((tim->CR1 & TIM_CR1_CEN) == 0)
+    {
+        return tim->CNT;
+    }
+
+    return (uint32_t)(((t - s_tim_base[idx]) / sim_tim_tick(tim)) % ((uint64_t)tim->ARR + 1));
+}
+
+/**
+ * @brief       计数器下一次到达count的时刻(晚于当前时刻)
+ */
+static uint64_t sim_tim_next(int idx, uint32_t count)
+{
+    TIM_TypeDef *tim = sim_tim(idx);
+    uint64_t period = sim_tim_tick(tim) * ((uint64_t)tim->ARR + 1);
+    uint64_t t0 = s_tim_base[idx] + count * sim_tim_tick(tim);
+
+    if (t0 > g_sim_now)
+    {
+        return t0;
+    }
+
+    return t0 + ((g_sim_now - t0) / period + 1) * period;
+}
+
+static void sim_tim_update_fire(int idx)
+{
+    sim_tim(idx)->SR |= TIM_SR_UIF;
+    sim_event_at((sim_event_t)(SIM_EV_TIM2 + idx), sim_tim_next(idx, 0), sim_tim_update_fire, idx);
+}
+
+/**
+ * @brief       计数状态改变后重新安排更新事件和ADC触发
+ */
+static void sim_tim_schedule(int idx)
+{
+    TIM_TypeDef *tim = sim_tim(idx);
+
+    if ((tim->CR1 & TIM_CR1_CEN) && (tim->DIER & TIM_DIER_UIE))
+    {
+        sim_event_at((sim_event_t)(SIM_EV_TIM2 + idx), sim_tim_next(idx, 0), sim_tim_update_fire, idx);
+    }
+    else
+    {
+        sim_event_cancel((sim_event_t)(SIM_EV_TIM2 + idx));
+    }
+
+    if (idx == SIM_TIM_TIM3)
+    {
+        sim_adc_schedule_trigger();
+    }
+}
+
+static void sim_tim_rebase(int idx, uint32_t count)
+{
+    s_tim_base[idx] = g_sim_now - count * sim_tim_tick(sim_tim(idx));
+}
+
+void sim_tim_enable(TIM_HandleTypeDef *htim)
+{
+    TIM_TypeDef *tim = htim->Instance;
+    int idx = sim_tim_index(tim);
+
+    sim_cycles(SIM_COST_REG);
+
+    if ((tim->CR1 & TIM_CR1_CEN) == 0)
+    {
+        tim->CR1 |= TIM_CR1_CEN;
+        sim_tim_rebase(idx, tim->CNT);
+        sim_tim_schedule(idx);
+    }
+}
+
+void sim_tim_disable(TIM_HandleTypeDef *htim)
+{
+    TIM_TypeDef *tim = htim->Instance;
+    int idx = sim_tim_index(tim);
+
+    sim_cycles(SIM_COST_REG);
+
+    if (tim->CR1 & TIM_CR1_CEN)
+    {
+        tim->CNT = sim_tim_count_at(idx, g_sim_now);
+        tim->CR1 &= ~TIM_CR1_CEN;
+        sim_tim_schedule(idx);
+    }
+}
+
+uint32_t sim_tim_get_counter(TIM_HandleTypeDef *htim)
+{
+    sim_cycles(SIM_COST_REG);
+    return sim_tim_count_at(sim_tim_index(htim->Instance), g_sim_now);
+}
+
+void sim_tim_set_counter(TIM_HandleTypeDef *htim, uint32_t counter)
+{
+    TIM_TypeDef *tim = htim->Instance;
+    int idx = sim_tim_index(tim);
+
+    sim_cycles(SIM_COST_REG);
+    tim->CNT = counter;
+    sim_tim_rebase(idx, counter);
+    sim_tim_schedule(idx);
+}
+
+void sim_tim_set_autoreload(TIM_HandleTypeDef *htim, uint32_t arr)
+{
+    TIM_TypeDef *tim = htim->Instance;
+    int idx = sim_tim_index(tim);
+    uint32_t count = sim_tim_count_at(idx, g_sim_now);
+
+    sim_cycles(SIM_COST_REG);
+    tim->ARR = arr;
+    htim->Init.Period = arr;
+
+    if (tim->CR1 & TIM_CR1_CEN)
+    {
+        sim_tim_rebase(idx, count <= arr ? count : 0);
+    }
+
+    sim_tim_schedule(idx);
+}
+
+void sim_tim_set_compare(TIM_HandleTypeDef *htim, uint32_t channel, uint32_t compare)
+{
+    TIM_TypeDef *tim = htim->Instance;
+
+    sim_cycles(SIM_COST_REG);
+    (&tim->CCR1)[channel / 4] = compare;
+
+    if (channel == TIM_CHANNEL_1)
+    {
+        sim_tim_schedule(sim_tim_index(tim));
+    }
+}
+
+uint32_t sim_tim_get_flag(TIM_HandleTypeDef *htim, uint32_t flag)
+{
+    sim_cycles(SIM_COST_REG);
+    return (htim->Instance->SR & flag) == flag;
+}
+
+void sim_tim_clear_flag(TIM_HandleTypeDef *htim, uint32_t flag)
+{
+    sim_cycles(SIM_COST_REG);
+    htim->Instance->SR &= ~flag;
+}
+
+void sim_tim_enable_it(TIM_HandleTypeDef *htim, uint32_t it)
+{
+    sim_cycles(SIM_COST_REG);
+    htim->Instance->DIER |= it;
+    sim_tim_schedule(sim_tim_index(htim->Instance));
+}
+
+__attribute__((weak)) void HAL_TIM_Base_MspInit(TIM_HandleTypeDef *htim)
+{
+    (void)htim;
+}
+
+__attribute__((weak)) void HAL_TIM_PWM_MspInit(TIM_HandleTypeDef *htim)
+{
+    (void)htim;
+}
+
+__attribute__((weak)) void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef *htim)
+{
+    (void)htim;
+}
+
+static void sim_tim_set_config(TIM_HandleTypeDef *htim)
+{
+    TIM_TypeDef *tim = htim->Instance;
+
+    tim->PSC = htim->Init.Prescaler;
+    tim->ARR = htim->Init.Period;
+    tim->CR1 = (tim->CR1 & TIM_CR1_CEN) | htim->Init.AutoReloadPreload;
+    tim->SR |= TIM_SR_UIF;                      /* HAL用UG装载预分频, 同时置位UIF */
+    htim->State = HAL_TIM_STATE_READY;
+    htim->Lock = HAL_UNLOCKED;
+}
+
+HAL_StatusTypeDef HAL_TIM_Base_Init(TIM_HandleTypeDef *htim)
+{
+    sim_cycles(SIM_COST_HAL);
+
+    if (htim->State == HAL_TIM_STATE_RESET)
+    {
+        HAL_TIM_Base_MspInit(htim);
+    }
+
+    sim_tim_set_config(htim);
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_TIM_PWM_Init(TIM_HandleTypeDef *htim)
+{
+    sim_cycles(SIM_COST_HAL);
+
+    if (htim->State == HAL_TIM_STATE_RESET)
+    {
+        HAL_TIM_PWM_MspInit(htim);
+    }
+
+    sim_tim_set_config(htim);
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_TIM_Base_Start(TIM_HandleTypeDef *htim)
+{
+    sim_tim_enable(htim);
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_TIM_Base_Start_IT(TIM_HandleTypeDef *htim)
+{
+    htim->Instance->DIER |= TIM_DIER_UIE;
+    sim_tim_enable(htim);
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_TIM_ConfigClockSource(TIM_HandleTypeDef *htim, TIM_ClockConfigTypeDef *sClockSourceConfig)
+{
+    (void)htim;
+    (void)sClockSourceConfig;
+    sim_cycles(SIM_COST_HAL);
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_TIM_PWM_ConfigChannel(TIM_HandleTypeDef *htim, TIM_OC_InitTypeDef *sConfig, uint32_t Channel)
+{
+    TIM_TypeDef *tim = htim->Instance;
+    uint32_t n = Channel / 4;
+    volatile uint32_t *ccmr = n < 2 ? &tim->CCMR1 : &tim->CCMR2;
+    uint32_t shift = (n % 2) * 8;
+
+    sim_cycles(SIM_COST_HAL);
+    *ccmr = (*ccmr & ~(0x70u << shift)) | (sConfig->OCMode << shift);
+    tim->CCER = (tim->CCER & ~(TIM_OCPOLARITY_LOW << (n * 4))) | (sConfig->OCPolarity << (n * 4));
+    (&tim->CCR1)[n] = sConfig->Pulse;
+    sim_tim_schedule(sim_tim_index(tim));
+    return HAL_OK;
+}
+
+/**
+ * @brief       TIM4通道3(蜂鸣器)开关时通知仿真程序
+ */
+static void sim_beep_update(TIM_TypeDef *tim)
+{
+    uint8_t on;
+
+    if (sim_tim_index(tim) != SIM_TIM_TIM4)
+    {
+        return;
+    }
+
+    on = (tim->CCER & (1u << 8)) && (tim->CR1 & TIM_CR1_CEN);
+
+    if (on != s_beep_on)
+    {
+        s_beep_on = on;
+        sim_on_beep(on, (uint32_t)(SIM_CPU_HZ / (sim_tim_tick(tim) * ((uint64_t)tim->ARR + 1))));
+    }
+}
+
+HAL_StatusTypeDef HAL_TIM_PWM_Start(TIM_HandleTypeDef *htim, uint32_t Channel)
+{
+    htim->Instance->CCER |= 1u << Channel;
+    sim_tim_enable(htim);
+    sim_beep_update(htim->Instance);
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_TIM_PWM_Stop(TIM_HandleTypeDef *htim, uint32_t Channel)
+{
+    sim_cycles(SIM_COST_REG);
+    htim->Instance->CCER &= ~(1u << Channel);
+
+    if ((htim->Instance->CCER & 0x1111) == 0)   /* 所有通道都关闭后才停止计数 */
+    {
+        sim_tim_disable(htim);
+    }
+
+    sim_beep_update(htim->Instance);
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_TIMEx_MasterConfigSynchronization(TIM_HandleTypeDef *htim, TIM_MasterConfigTypeDef *sMasterConfig)
+{
+    TIM_TypeDef *tim = htim->Instance;
+
+    sim_cycles(SIM_COST_HAL);
+    tim->CR2 = (tim->CR2 & ~0x70u) | sMasterConfig->MasterOutputTrigger;
+    sim_tim_schedule(sim_tim_index(tim));
+    return HAL_OK;
+}
+
+void HAL_TIM_IRQHandler(TIM_HandleTypeDef *htim)
+{
+    TIM_TypeDef *tim = htim->Instance;
+
+    sim_cycles(SIM_COST_HAL);
+
+    if ((tim->SR & TIM_SR_UIF) && (tim->DIER & TIM_DIER_UIE))
+    {
+        tim->SR &= ~TIM_SR_UIF;
+        HAL_TIM_PeriodElapsedCallback(htim);
+    }
+}
+
+uint8_t sim_gp2y_led_on(uint64_t t)
+{
+    TIM_TypeDef *tim = sim_tim(SIM_TIM_TIM3);
+
+    /* TIM3_CH2, PWM1, 低电平有效: CNT < CCR2时LED点亮 */
+    return (tim->CCER & (1u << 4)) && (tim->CR1 & TIM_CR1_CEN) && sim_tim_count_at(SIM_TIM_TIM3, t) < tim->CCR2;
+}
+
+uint16_t sim_mq7_heater_permille(void)
+{
+    TIM_TypeDef *tim = sim_tim(SIM_TIM_TIM2);
+
+    if ((tim->CCER & (1u << 8)) == 0 || (tim->CR1 & TIM_CR1_CEN) == 0)
+    {
+        return 0;
+    }
+
+    return (uint16_t)((uint64_t)tim->CCR3 * 1000 / ((uint64_t)tim->ARR + 1));
+}
+
+/******************************************************************************************/
+/* ADC1 */
+
+#define SIM_ADC_CR2_ADON        (1u << 0)
+#define SIM_ADC_CR2_DMA         (1u << 8)
+#define SIM_ADC_CR2_EXTTRIG     (1u << 20)
+#define SIM_ADC_SR_EOC          (1u << 1)
+#define SIM_ADC_TRIGGER         -1          /* 事件参数: 外部触发 */
+
+static uint8_t s_adc_armed = 0;             /* 1: 已启动, 等待TIM3触发 */
+static uint8_t s_adc_busy = 0;              /* 1: 扫描进行中 */
+static uint64_t s_adc_sample_at;            /* 当前通道开始采样的时刻 */
+
+static ADC_TypeDef *sim_adc(void)
+{
+    return SIM_REG(ADC_TypeDef, SIM_P_ADC1);
+}
+
+static uint8_t sim_adc_channel(uint32_t rank)
+{
+    return (sim_adc()->SQR3 >> (5 * rank)) & 0x1F;
+}
+
+static uint32_t sim_adc_conv_cycles(uint8_t channel)
+{
+    /* 采样时间 * 2: 1.5, 7.5, 13.5, 28.5, 41.5, 55.5, 71.5, 239.5个ADC周期 */
+    static const uint16_t smp_x2[8] = {3, 15, 27, 57, 83, 111, 143, 479};
+    uint32_t smp = (sim_adc()->SMPR2 >> (3 * channel)) & 7;
+
+    return (smp_x2[smp] + 25) * 3;          /* (采样 + 12.5) * 6个CPU周期 */
+}
+
+static void sim_adc_fire(int rank);
+
+static void sim_adc_schedule_trigger(void)
+{
+    TIM_TypeDef *tim = sim_tim(SIM_TIM_TIM3);
+
+    if (s_adc_busy)
+    {
+        return;                             /* 扫描结束后再安排 */
+    }
+
+    if (s_adc_armed && (tim->CR1 & TIM_CR1_CEN) && (tim->CR2 & 0x70) == TIM_TRGO_OC1REF)
+    {
+        sim_event_at(SIM_EV_ADC, sim_tim_next(SIM_TIM_TIM3, tim->CCR1), sim_adc_fire, SIM_ADC_TRIGGER);
+    }
+    else
+    {
+        sim_event_cancel(SIM_EV_ADC);
+    }
+}
+
+/**
+ * @brief       ADC事件: 外部触发开始扫描, 或者第rank个通道转换完成
+ */
+static void sim_adc_fire(int rank)
+{
+    ADC_TypeDef *adc = sim_adc();
+    uint32_t num = ((adc->SQR1 >> 20) & 0xF) + 1;
+    uint16_t value;
+
+    if (rank == SIM_ADC_TRIGGER)
+    {
+        s_adc_busy = 1;
+        s_adc_sample_at = g_sim_now;
+        sim_event_at(SIM_EV_ADC, g_sim_now + sim_adc_conv_cycles(sim_adc_channel(0)), sim_adc_fire, 0);
+        return;
+    }
+
+    value = sim_env_adc(sim_adc_channel(rank), s_adc_sample_at);
+    adc->DR = value;
+    adc->SR |= SIM_ADC_SR_EOC;
+
+    if (adc->CR2 & SIM_ADC_CR2_DMA)
+    {
+        sim_dma_put(0, value);
+    }
+
+    if ((uint32_t)rank + 1 < num && (adc->CR1 & ADC_SCAN_ENABLE))
+    {
+        s_adc_sample_at = g_sim_now;
+        sim_event_at(SIM_EV_ADC, g_sim_now + sim_adc_conv_cycles(sim_adc_channel(rank + 1)), sim_adc_fire, rank + 1);
+        return;
+    }
+
+    s_adc_busy = 0;
+    sim_adc_schedule_trigger();
+}
+
+__attribute__((weak)) void HAL_ADC_MspInit(ADC_HandleTypeDef *hadc)
+{
+    (void)hadc;
+}
+
+__attribute__((weak)) void HAL_ADC_ConvCpltCallback(ADC_HandleTypeDef *hadc)
+{
+    (void)hadc;
+}
+
+__attribute__((weak)) void HAL_ADC_ConvHalfCpltCallback(ADC_HandleTypeDef *hadc)
+{
+    (void)hadc;
+}
+
+HAL_StatusTypeDef HAL_ADC_Init(ADC_HandleTypeDef *hadc)
+{
+    ADC_TypeDef *adc = hadc->Instance;
+
+    sim_cycles(SIM_COST_HAL);
+
+    if (hadc->State == 0)
+    {
+        HAL_ADC_MspInit(hadc);
+    }
+
+    adc->CR1 = hadc->Init.ScanConvMode;
+    adc->CR2 = hadc->Init.ExternalTrigConv | hadc->Init.DataAlign |
+               (hadc->Init.ExternalTrigConv != ADC_SOFTWARE_START ? SIM_ADC_CR2_EXTTRIG : 0);
+    adc->SQR1 = (hadc->Init.NbrOfConversion - 1) << 20;
+    hadc->State = 1;
+    hadc->ErrorCode = 0;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_ADC_ConfigChannel(ADC_HandleTypeDef *hadc, ADC_ChannelConfTypeDef *sConfig)
+{
+    ADC_TypeDef *adc = hadc->Instance;
+    uint32_t shift = 5 * (sConfig->Rank - 1);
+
+    sim_cycles(SIM_COST_HAL);
+    adc->SQR3 = (adc->SQR3 & ~(0x1Fu << shift)) | (sConfig->Channel << shift);
+    adc->SMPR2 = (adc->SMPR2 & ~(7u << (3 * sConfig->Channel))) | (sConfig->SamplingTime << (3 * sConfig->Channel));
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_ADCEx_Calibration_Start(ADC_HandleTypeDef *hadc)
+{
+    (void)hadc;
+    sim_cycles(SIM_COST_HAL + 83 * 6);          /* 校准约83个ADC周期 */
+    return HAL_OK;
+}
+
+static void sim_adc_dma_cplt(DMA_HandleTypeDef *hdma)
+{
+    HAL_ADC_ConvCpltCallback((ADC_HandleTypeDef *)hdma->Parent);
+}
+
+static void sim_adc_dma_half(DMA_HandleTypeDef *hdma)
+{
+    HAL_ADC_ConvHalfCpltCallback((ADC_HandleTypeDef *)hdma->Parent);
+}
+
+HAL_StatusTypeDef HAL_ADC_Start_DMA(ADC_HandleTypeDef *hadc, uint32_t *pData, uint32_t Length)
+{
+    ADC_TypeDef *adc = hadc->Instance;
+
+    hadc->DMA_Handle->XferCpltCallback = sim_adc_dma_cplt;
+    hadc->DMA_Handle->XferHalfCpltCallback = sim_adc_dma_half;
+    HAL_DMA_Start_IT(hadc->DMA_Handle, (uint32_t)(uintptr_t)&adc->DR, (uint32_t)(uintptr_t)pData, Length);
+
+    adc->CR2 |= SIM_ADC_CR2_DMA | SIM_ADC_CR2_ADON;
+    s_adc_armed = 1;
+    sim_adc_schedule_trigger();
+    return HAL_OK;
+}
+
+/******************************************************************************************/
+/* USART1~3 */
+
+#define SIM_UART_NUM            3
+#define SIM_UART_RXQ_SIZE       4096
+
+typedef struct
+{
+    uint64_t char_cycles;                       /* 一个字符(10位)的时间 */
+    uint8_t tx_busy;                            /* 移位寄存器正在发送 */
+    uint8_t tx_byte;
+
+    uint8_t rxq[SIM_UART_RXQ_SIZE];             /* 注入的数据和最早开始发送的时刻 */
+    uint64_t rxq_at[SIM_UART_RXQ_SIZE];
+    uint16_t rxq_head;
+    uint16_t rxq_count;
+    uint8_t rx_shifting;                        /* 队首字节的起始位已经开始 */
+
+    uint32_t rx_bytes;
+    uint32_t rx_lost;                           /* 串口未使能, 溢出或DMA未就绪丢失的字节 */
+    uint32_t tx_bytes;
+} sim_uart_t;
+
+static sim_uart_t s_uart[SIM_UART_NUM];
+
+static const int s_uart_tx_dma[SIM_UART_NUM] = {3, 6, 1};   /* DMA1通道4, 7, 2 */
+static const int s_uart_rx_dma[SIM_UART_NUM] = {4, 5, 2};   /* DMA1通道5, 6, 3 */
+
+static int sim_uart_port(const USART_TypeDef *usart)
+{
+    return (int)(usart - SIM_REG(USART_TypeDef, SIM_P_USART1));
+}
+
+static USART_TypeDef *sim_usart(int port)
+{
+    return SIM_REG(USART_TypeDef, SIM_P_USART1 + port);
+}
+
+static void sim_uart_tx_fire(int port);
+
+/**
+ * @brief       移位寄存器空闲时从DMA取下一个字节
+ */
+static void sim_uart_tx_kick(int port)
+{
+    USART_TypeDef *usart = sim_usart(port);
+    sim_uart_t *u = &s_uart[port];
+    uint32_t value;
+
+    if (u->tx_busy || (usart->CR3 & USART_CR3_DMAT) == 0 || sim_dma_take(s_uart_tx_dma[port], &value))
+    {
+        return;
+    }
+
+    u->tx_busy = 1;
+    u->tx_byte = (uint8_t)value;
+    usart->SR &= ~USART_SR_TC;
+    sim_event_at((sim_event_t)(SIM_EV_U1_TX + port), g_sim_now + u->char_cycles, sim_uart_tx_fire, port);
+}
+
+static void sim_uart_tx_fire(int port)
+{
+    sim_uart_t *u = &s_uart[port];
+
+    u->tx_busy = 0;
+    u->tx_bytes++;
+    sim_on_uart_tx(port, u->tx_byte);
+    sim_uart_tx_kick(port);
+
+    if (u->tx_busy == 0)
+    {
+        sim_usart(port)->SR |= USART_SR_TC;
+    }
+}
+
+static void sim_uart_idle_fire(int port)
+{
+    sim_usart(port)->SR |= USART_SR_IDLE;
+}
+
+/**
+ * @brief       串口接收: 第一次在起始位处触发, 按当前波特率再过一个字符时间在停止位结束时收到
+ * @note        注入时串口可能还没有初始化, 所以字符时间在这里才计算
+ */
+static void sim_uart_rx_fire(int port)
+{
+    USART_TypeDef *usart = sim_usart(port);
+    sim_uart_t *u = &s_uart[port];
+    int dma = s_uart_rx_dma[port];
+    uint8_t c = u->rxq[u->rxq_head];
+
+    if (u->rx_shifting == 0)
+    {
+        u->rx_shifting = 1;
+        sim_event_cancel((sim_event_t)(SIM_EV_U1_IDLE + port));
+        sim_event_at((sim_event_t)(SIM_EV_U1_RX + port), g_sim_now + u->char_cycles, sim_uart_rx_fire, port);
+        return;
+    }
+
+    u->rx_shifting = 0;
+    u->rxq_head = (u->rxq_head + 1) % SIM_UART_RXQ_SIZE;
+    u->rxq_count--;
+    u->rx_bytes++;
+
+    if ((usart->CR1 & USART_CR1_UE) == 0)
+    {
+        u->rx_lost++;
+    }
+    else if ((usart->CR3 & USART_CR3_DMAR) && (sim_dma_channel(dma)->CCR & DMA_CCR_EN))
+    {
+        usart->DR = c;
+
+        if (sim_dma_put(dma, c))
+        {
+            u->rx_lost++;
+        }
+    }
+    else if (usart->SR & USART_SR_RXNE)
+    {
+        usart->SR |= USART_SR_ORE;
+        u->rx_lost++;
+    }
+    else
+    {
+        usart->DR = c;
+        usart->SR |= USART_SR_RXNE;
+    }
+
+    if (u->rxq_count)
+    {
+        sim_event_at((sim_event_t)(SIM_EV_U1_RX + port), u->rxq_at[u->rxq_head] > g_sim_now ?
+                     u->rxq_at[u->rxq_head] : g_sim_now, sim_uart_rx_fire, port);
+    }
+
+    /* 一个字符时间内没有新数据则线路空闲 */
+    if (u->rxq_count == 0 || u->rxq_at[u->rxq_head] > g_sim_now + u->char_cycles)
+    {
+        sim_event_at((sim_event_t)(SIM_EV_U1_IDLE + port), g_sim_now + u->char_cycles, sim_uart_idle_fire, port);
+    }
+}
+
+void sim_uart_inject(int port, uint64_t at, const uint8_t *data, uint16_t len)
+{
+    sim_uart_t *u = &s_uart[port];
+    uint16_t i, tail;
+
+    if (u->rxq_count == 0)
+    {
+        sim_event_at((sim_event_t)(SIM_EV_U1_RX + port), at, sim_uart_rx_fire, port);
+    }
+
+    /* 同一次注入的字节首尾相接, 间隔由接收时的字符时间决定 */
+    for (i = 0; i < len && u->rxq_count < SIM_UART_RXQ_SIZE; i++)
+    {
+        tail = (u->rxq_head + u->rxq_count) % SIM_UART_RXQ_SIZE;
+        u->rxq[tail] = data[i];
+        u->rxq_at[tail] = at;
+        u->rxq_count++;
+    }
+}
+
+void sim_uart_stats(int port, uint32_t *rx_bytes, uint32_t *rx_lost, uint32_t *tx_bytes)
+{
+    *rx_bytes = s_uart[port].rx_bytes;
+    *rx_lost = s_uart[port].rx_lost;
+    *tx_bytes = s_uart[port].tx_bytes;
+}
+
+__attribute__((weak)) void HAL_UART_MspInit(UART_HandleTypeDef *huart)
+{
+    (void)huart;
+}
+
+__attribute__((weak)) void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart)
+{
+    (void)huart;
+}
+
+__attribute__((weak)) void HAL_UART_RxCpltCallback(UART_HandleTypeDef *huart)
+{
+    (void)huart;
+}
+
+HAL_StatusTypeDef HAL_UART_Init(UART_HandleTypeDef *huart)
+{
+    USART_TypeDef *usart = huart->Instance;
+    int port = sim_uart_port(usart);
+
+    sim_cycles(SIM_COST_HAL);
+
+    if (huart->gState == HAL_UART_STATE_RESET)
+    {
+        huart->Lock = HAL_UNLOCKED;
+        HAL_UART_MspInit(huart);
+    }
+
+    s_uart[port].char_cycles = (uint64_t)SIM_CPU_HZ * 10 / huart->Init.BaudRate;
+    usart->BRR = SIM_CPU_HZ / (port == 0 ? 1 : 2) / huart->Init.BaudRate;
+    usart->SR = USART_SR_TXE | USART_SR_TC;
+    usart->CR1 = USART_CR1_UE | huart->Init.Mode;
+    usart->CR3 = 0;
+    huart->ErrorCode = 0;
+    huart->gState = HAL_UART_STATE_READY;
+    huart->RxState = HAL_UART_STATE_READY;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_UART_Transmit(UART_HandleTypeDef *huart, const uint8_t *pData, uint16_t Size, uint32_t Timeout)
+{
+    int port = sim_uart_port(huart->Instance);
+    uint16_t i;
+
+    (void)Timeout;
+
+    if (huart->gState != HAL_UART_STATE_READY)
+    {
+        return HAL_BUSY;
+    }
+
+    for (i = 0; i < Size; i++)
+    {
+        sim_cycles((uint32_t)s_uart[port].char_cycles);
+        s_uart[port].tx_bytes++;
+        sim_on_uart_tx(port, pData[i]);
+    }
+
+    return HAL_OK;
+}
+
+/* DMA把最后一个字节写入DR: 关闭DMA请求, 打开TC中断, 等最后一个字节移出 */
+static void sim_uart_dma_tx_cplt(DMA_HandleTypeDef *hdma)
+{
+    UART_HandleTypeDef *huart = (UART_HandleTypeDef *)hdma->Parent;
+
+    if ((hdma->Instance->CCR & DMA_CCR_CIRC) == 0)
+    {
+        huart->TxXferCount = 0;
+        huart->Instance->CR3 &= ~USART_CR3_DMAT;
+        huart->Instance->CR1 |= USART_CR1_TCIE;
+    }
+}
+
+static void sim_uart_dma_tx_half(DMA_HandleTypeDef *hdma)
+{
+    (void)hdma;
+}
+
+HAL_StatusTypeDef HAL_UART_Transmit_DMA(UART_HandleTypeDef *huart, const uint8_t *pData, uint16_t Size)
+{
+    USART_TypeDef *usart = huart->Instance;
+
+    if (huart->gState != HAL_UART_STATE_READY)
+    {
+        return HAL_BUSY;
+    }
+
+    if (pData == NULL || Size == 0)
+    {
+        return HAL_ERROR;
+    }
+
+    huart->pTxBuffPtr = pData;
+    huart->TxXferSize = Size;
+    huart->TxXferCount = Size;
+    huart->ErrorCode = 0;
+    huart->gState = HAL_UART_STATE_BUSY_TX;
+
+    huart->hdmatx->XferCpltCallback = sim_uart_dma_tx_cplt;
+    huart->hdmatx->XferHalfCpltCallback = sim_uart_dma_tx_half;
+    huart->hdmatx->XferErrorCallback = NULL;
+    HAL_DMA_Start_IT(huart->hdmatx, (uint32_t)(uintptr_t)pData, (uint32_t)(uintptr_t)&usart->DR, Size);
+
+    usart->SR &= ~USART_SR_TC;
+    usart->CR3 |= USART_CR3_DMAT;
+    sim_uart_tx_kick(sim_uart_port(usart));
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_UART_Receive_IT(UART_HandleTypeDef *huart, uint8_t *pData, uint16_t Size)
+{
+    sim_cycles(SIM_COST_HAL);
+
+    if (huart->RxState != HAL_UART_STATE_READY)
+    {
+        return HAL_BUSY;
+    }
+
+    if (pData == NULL || Size == 0)
+    {
+        return HAL_ERROR;
+    }
+
+    huart->pRxBuffPtr = pData;
+    huart->RxXferSize = Size;
+    huart->RxXferCount = Size;
+    huart->ErrorCode = 0;
+    huart->RxState = HAL_UART_STATE_BUSY_RX;
+    huart->Instance->CR1 |= USART_CR1_RXNEIE;
+    return HAL_OK;
+}
+
+/**
+ * @brief       串口中断公共处理
+ * @note        硬件上先读SR再读DR会清除IDLE和ORE, 仿真看不到读操作的顺序, 这里统一清除
+ */
+void HAL_UART_IRQHandler(UART_HandleTypeDef *huart)
+{
+    USART_TypeDef *usart = huart->Instance;
+    uint32_t sr = usart->SR;
+    uint32_t cr1 = usart->CR1;
+
+    sim_cycles(SIM_COST_HAL);
+
+    if (sr & USART_SR_ORE)
+    {
+        huart->ErrorCode |= 0x08;
+    }
+
+    usart->SR &= ~(USART_SR_IDLE | USART_SR_ORE);
+
+    if ((sr & USART_SR_RXNE) && (cr1 & USART_CR1_RXNEIE))
+    {
+        *huart->pRxBuffPtr++ = (uint8_t)usart->DR;
+        usart->SR &= ~USART_SR_RXNE;
+
+        if (--huart->RxXferCount == 0)
+        {
+            usart->CR1 &= ~USART_CR1_RXNEIE;
+            huart->RxState = HAL_UART_STATE_READY;
+            HAL_UART_RxCpltCallback(huart);
+        }
+
+        return;
+    }
+
+    if ((sr & USART_SR_TC) && (cr1 & USART_CR1_TCIE))
+    {
+        usart->CR1 &= ~USART_CR1_TCIE;
+        huart->gState = HAL_UART_STATE_READY;
+        HAL_UART_TxCpltCallback(huart);
+    }
+}
+
+/******************************************************************************************/
+/* SPI, SRAM, PWR */
+
+__attribute__((weak)) void HAL_SPI_MspInit(SPI_HandleTypeDef *hspi)
+{
+    (void)hspi;
+}
+
+HAL_StatusTypeDef HAL_SPI_Init(SPI_HandleTypeDef *hspi)
+{
+    sim_cycles(SIM_COST_HAL);
+
+    if (hspi->State == 0)
+    {
+        hspi->Lock = HAL_UNLOCKED;
+        HAL_SPI_MspInit(hspi);
+    }
+
+    hspi->Instance->CR1 = hspi->Init.Mode | hspi->Init.Direction | hspi->Init.DataSize | hspi->Init.CLKPolarity |
+                          hspi->Init.CLKPhase | hspi->Init.NSS | hspi->Init.BaudRatePrescaler | hspi->Init.FirstBit;
+    hspi->Instance->SR = SPI_SR_TXE;
+    hspi->State = 1;
+    hspi->ErrorCode = 0;
+    return HAL_OK;
+}
+
+__attribute__((weak)) void HAL_SRAM_MspInit(SRAM_HandleTypeDef *hsram)
+{
+    (void)hsram;
+}
+
+HAL_StatusTypeDef HAL_SRAM_Init(SRAM_HandleTypeDef *hsram, FSMC_NORSRAM_TimingTypeDef *Timing, FSMC_NORSRAM_TimingTypeDef *ExtTiming)
+{
+    (void)Timing;
+    (void)ExtTiming;
+    sim_cycles(SIM_COST_HAL);
+
+    if (hsram->State == 0)
+    {
+        hsram->Lock = HAL_UNLOCKED;
+        HAL_SRAM_MspInit(hsram);
+    }
+
+    hsram->State = 1;
+    return HAL_OK;
+}
+
+void HAL_PWR_EnableBkUpAccess(void)
+{
+    PWR->CR |= PWR_CR_DBP;
+}
+
+void HAL_PWR_EnterSLEEPMode(uint32_t Regulator, uint8_t SLEEPEntry)
+{
+    (void)Regulator;
+    (void)SLEEPEntry;
+    SCB->SCR &= ~SCB_SCR_SLEEPDEEP_Msk;
+    __WFI();
+}
+
+void HAL_PWR_EnterSTOPMode(uint32_t Regulator, uint8_t STOPEntry)
+{
+    (void)Regulator;
+    (void)STOPEntry;
+    SCB->SCR |= SCB_SCR_SLEEPDEEP_Msk;
+    __WFI();
+    SCB->SCR &= ~SCB_SCR_SLEEPDEEP_Msk;
+}
+
+/******************************************************************************************/
+
+void sim_hal_reset(void)
+{
+    memset(s_dma_len, 0, sizeof(s_dma_len));
+    memset(s_dma_pos, 0, sizeof(s_dma_pos));
+    memset(s_tim_base, 0, sizeof(s_tim_base));
+    memset(s_uart, 0, sizeof(s_uart));
+    s_beep_on = 0;
+    s_adc_armed = 0;
+    s_adc_busy = 0;
+    uwTick = 0;
+}
@@ -0,0 +1,881 @@
+/**
+ ****************************************************************************************************
+ * @file        sim_main.c
+ * @brief       传感器固件的主机仿真: 运行User/main.c的完整主循环, 报告任务时序和串口输出
+ ****************************************************************************************************
+ * @attention
+ *
+ * 用法: sensor_sim [--seconds N] [--quiet] [--cpu-scale X]
+ *   --seconds N     仿真时长(秒), 默认200, 覆盖一个完整的MQ-7加热周期
+ *   --quiet         不打印USART1输出和USART3帧, 只输出报告
+ *   --cpu-scale X   把固件纯计算的主机耗时乘以X计入仿真时间(默认0: 只计外设访问, 结果可重复)
+ *
+ * 仿真中的ESP32按脚本经USART3发送校时, 设置上报周期, 设置阈值, 补传请求和一帧CRC错误的数据,
+ * 结束前经USART1发送"prof"命令. 运行结束后检查: DHT11每次都读取成功, 每条命令都有应答,
+ * 只有故意损坏的帧被计为错误, ESP32收到了样本帧, "prof"命令有应答. 不满足时返回1.
+ *
+ * 样本帧和记录帧的内容也逐帧检查:
+ * - 温湿度, CO, 粉尘在环境脚本最近一段时间(传感器的最大滞后)的取值范围内
+ * - 报警位图的每次置位/清除都对应环境按固件报警规则越过阈值/回差的时刻, 不多不少
+ * - 校时应答之前时间戳为0, 之后等于校时时间加上经过的仿真时间
+ * - 补传请求按序返回请求范围内已有的记录, 内容与实时发出的同序号记录帧完全相同
+ *
+ ****************************************************************************************************
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "sim.h"
+#include "./SYSTEM/sched/sched.h"
+#include "./SYSTEM/prof/prof.h"
+#include "./BSP/SENSOR/sensor.h"
+#include "./BSP/SENSOR_UART/sensor_frame.h"
+#include "./BSP/SENSOR_UART/sensor_uart3.h"
+#include "./BSP/DHT11/dht11.h"
+#include "./BSP/BEEP/beep.h"
+#include "./BSP/PWR/pwr.h"
+
+
+int fw_main(void);                              /* User/main.c, 以-Dmain=fw_main编译 */
+
+#define SIM_UART1                   0
+#define SIM_UART3                   2
+#define SIM_CMD_MAX                 8
+#define SIM_BEEP_LOG_MAX            16
+#define SIM_RECORD_MAX              256
+#define SIM_ALARM_EVENT_MAX         32
+#define SIM_VALUE_LOG_MAX           8               /* 最多打印几条数值错误 */
+
+#define SIM_TIME_SYNC_UNIX          1767225600u     /* 2026-01-01 00:00:00 UTC */
+#define SIM_DUST_LOW_X10            2500            /* 脚本修改的粉尘低报警阈值, 250.0ug/m3 */
+#define SIM_BACKFILL_FIRST          0
+#define SIM_BACKFILL_COUNT          5
+
+static uint8_t s_quiet = 0;
+
+/* 各输入量从环境变化到出现在样本帧里的最大滞后(s): DHT11每秒读取一次, 粉尘经过滑动平均,
+ * MQ-7每个加热周期(60s高压 + 90s低压)才出一个结果 */
+static const double s_input_lag[BEEP_INPUT_NUM] = {3, 3, 155, 6};
+
+/* 样本值允许的误差(0.1个单位): 固定部分 + 按环境值的比例 */
+static const double s_input_tol_abs[BEEP_INPUT_NUM] = {10, 10, 0, 20};
+static const double s_input_tol_rel[BEEP_INPUT_NUM] = {0, 0, 0.10, 0.05};
+static const char *const s_input_names[BEEP_INPUT_NUM] = {"temperature", "humidity", "co", "dust"};
+static const uint8_t s_input_valid[BEEP_INPUT_NUM] = {SENSOR_VALID_TEMP, SENSOR_VALID_HUMI, SENSOR_VALID_CO,
+                                                      SENSOR_VALID_DUST};
+
+/* ESP32命令脚本和应答情况 */
+typedef struct
+{
+    uint16_t seq;
+    uint8_t type;
+    uint8_t acked;
+    uint8_t status;
+} sim_cmd_t;
+
+static sim_cmd_t s_cmds[SIM_CMD_MAX];
+static uint8_t s_cmd_num = 0;
+static uint32_t s_bad_frames = 0;               /* 故意损坏的帧数 */
+
+/* 串口输出 */
+static char s_u1_line[256];
+static uint16_t s_u1_len = 0;
+static uint32_t s_u1_lines = 0;
+static uint32_t s_u1_prof_lines = 0;                 /* "prof"命令的应答行 */
+static uint8_t s_u3_frame[SENSOR_FRAME_MAX_ENCODED * 2];
+static uint16_t s_u3_len = 0;
+static uint32_t s_u3_types[256];
+static uint32_t s_u3_bad = 0;
+
+/* 样本帧和记录帧内容 */
+typedef struct
+{
+    double at;                                  /* 秒 */
+    uint16_t bit;
+    uint8_t set;
+} sim_alarm_event_t;
+
+static uint32_t s_value_errors = 0;
+static uint32_t s_time_errors = 0;
+static uint32_t s_co_results = 0;               /* 有CO结果的样本帧 */
+static uint8_t s_valid_seen = 0;                /* 出现过的测量标志 */
+static uint64_t s_sync_at = 0;                  /* 收到校时应答的时刻, 0表示未校时 */
+static uint16_t s_alarm_mask = 0;
+static sim_alarm_event_t s_alarm_events[SIM_ALARM_EVENT_MAX];
+static uint8_t s_alarm_event_num = 0;
+static uint8_t s_records[SIM_RECORD_MAX][SENSOR_FRAME_RECORD_PAYLOAD_LEN];  /* 实时发出的记录帧 */
+static uint16_t s_record_num = 0;
+static uint16_t s_backfill_limit = 0;           /* 收到补传应答时已有的记录数 */
+static uint16_t s_backfill_seqs[SIM_RECORD_MAX];
+static uint16_t s_backfill_num = 0;
+static uint32_t s_record_errors = 0;
+
+/* 蜂鸣器 */
+static uint32_t s_beep_on_count = 0;
+static uint64_t s_beep_on_at = 0;
+static uint64_t s_beep_on_total = 0;
+
+static double sim_seconds(uint64_t t)
+{
+    return (double)t / SIM_CPU_HZ;
+}
+
+/******************************************************************************************/
+/* 串口数据 */
+
+static void sim_u1_byte(uint8_t byte)
+{
+    if (byte == '\n')
+    {
+        s_u1_line[s_u1_len] = 0;
+
+        if (s_u1_len && s_u1_line[s_u1_len - 1] == '\r')
+        {
+            s_u1_line[s_u1_len - 1] = 0;
+        }
+
+        s_u1_lines++;
+
+        if (strncmp(s_u1_line, "PROF ", 5) == 0)
+        {
+            s_u1_prof_lines++;
+        }
+
+        if (!s_quiet)
+        {
+            printf("%10.3f U1  %s\n", sim_seconds(g_sim_now), s_u1_line);
+        }
+
+        s_u1_len = 0;
+    }
+    else if (s_u1_len < sizeof(s_u1_line) - 1)
+    {
+        s_u1_line[s_u1_len++] = (char)byte;
+    }
+}
+
+/**
+ * @brief       环境量换算成报警规则的输入(0.1个单位)
+ */
+static double sim_env_input(const sim_env_t *env, uint8_t input)
+{
+    switch (input)
+    {
+        case BEEP_INPUT_TEMP:
+            return env->temperature * 10;
+
+        case BEEP_INPUT_HUMI:
+            return env->humidity * 10;
+
+        case BEEP_INPUT_CO:
+            return env->co_ppm * 10;
+
+        default:
+            return env->dust_ug * 10;
+    }
+}
+
+/**
+ * @brief       环境量在[from, to]内的最小值和最大值, 按10ms步长采样
+ */
+static void sim_env_range(uint64_t from, uint64_t to, uint8_t input, double *lo, double *hi)
+{
+    const uint64_t step = SIM_CPU_HZ / 100;
+    sim_env_t env;
+    uint64_t t;
+    double v;
+
+    sim_env_at(from, &env);
+    *lo = *hi = sim_env_input(&env, input);
+
+    for (t = from + step; t <= to; t += step)
+    {
+        sim_env_at(t, &env);
+        v = sim_env_input(&env, input);
+        *lo = v < *lo ? v : *lo;
+        *hi = v > *hi ? v : *hi;
+    }
+}
+
+static void sim_decode_sample(const uint8_t *p, sensor_sample_t *s)
+{
+    s->temperature = (int8_t)p[0];
+    s->humidity = p[1];
+    s->co_x10 = p[2] | (uint16_t)p[3] << 8;
+    s->dust_x10 = p[4] | (uint16_t)p[5] << 8;
+    s->alarm_mask = p[6];
+    s->valid = p[7];
+    s->timestamp = p[8] | (uint32_t)p[9] << 8 | (uint32_t)p[10] << 16 | (uint32_t)p[11] << 24;
+}
+
+/**
+ * @brief       检查样本帧或实时记录帧的测量值和时间戳
+ * @note        有测量标志的值要在环境最近s_input_lag秒的范围内; 没有测量标志的字段不检查数值,
+ *              但上电s_input_lag秒后必须有结果, 有过结果之后不能再消失
+ */
+static void sim_check_sample(const char *kind, uint16_t seq, const sensor_sample_t *s)
+{
+    const double now = sim_seconds(g_sim_now);
+    double value[BEEP_INPUT_NUM];
+    double lo, hi, tol, expect;
+    uint64_t lag;
+    uint8_t i, ok;
+
+    value[BEEP_INPUT_TEMP] = s->temperature * 10.0;
+    value[BEEP_INPUT_HUMI] = s->humidity * 10.0;
+    value[BEEP_INPUT_CO] = s->co_x10;
+    value[BEEP_INPUT_DUST] = s->dust_x10;
+
+    for (i = 0; i < BEEP_INPUT_NUM; i++)
+    {
+        if ((s->valid & s_input_valid[i]) == 0)
+        {
+            if ((now > s_input_lag[i] || (s_valid_seen & s_input_valid[i])) && s_value_errors++ < SIM_VALUE_LOG_MAX)
+            {
+                printf("%10.3f FAIL %s seq %u has no %s result (valid 0x%02X)\n", now, kind, seq, s_input_names[i],
+                       s->valid);
+            }
+
+            continue;
+        }
+
+        lag = (uint64_t)(s_input_lag[i] * SIM_CPU_HZ);
+        sim_env_range(g_sim_now > lag ? g_sim_now - lag : 0, g_sim_now, i, &lo, &hi);
+        tol = s_input_tol_abs[i] + s_input_tol_rel[i] * hi;
+
+        if (value[i] < lo - tol || value[i] > hi + tol)
+        {
+            if (s_value_errors++ < SIM_VALUE_LOG_MAX)
+            {
+                printf("%10.3f FAIL %s seq %u %s %.1f, environment %.1f..%.1f\n", now, kind, seq,
+                       s_input_names[i], value[i] / 10, lo / 10, hi / 10);
+            }
+        }
+    }
+
+    if ((s->valid & SENSOR_VALID_FLAGS) == 0 && s_value_errors++ < SIM_VALUE_LOG_MAX)
+    {
+        printf("%10.3f FAIL %s seq %u without measurement flags (valid 0x%02X)\n", now, kind, seq, s->valid);
+    }
+
+    s_valid_seen |= s->valid;
+
+    /* 校时应答后2s内的样本可能是校时之前采集的; 采集时间最多比发送时间早2s */
+    if (s_sync_at == 0 || (s->timestamp == 0 && g_sim_now - s_sync_at < 2 * SIM_CPU_HZ))
+    {
+        expect = 0;
+        ok = s->timestamp == 0;
+    }
+    else
+    {
+        expect = SIM_TIME_SYNC_UNIX + sim_seconds(g_sim_now - s_sync_at);
+        ok = s->timestamp >= expect - 2 && s->timestamp <= expect + 1;
+    }
+
+    if (!ok && s_time_errors++ < SIM_VALUE_LOG_MAX)
+    {
+        printf("%10.3f FAIL %s seq %u timestamp %lu, expected %.0f\n", now, kind, seq,
+               (unsigned long)s->timestamp, expect);
+    }
+}
+
+/**
+ * @brief       记录报警位图的置位和清除
+ */
+static void sim_track_alarm(uint16_t mask)
+{
+    uint16_t changed = mask ^ s_alarm_mask;
+    uint16_t bit;
+
+    for (bit = 1; changed; bit <<= 1)
+    {
+        if (!(changed & bit))
+        {
+            continue;
+        }
+
+        changed &= ~bit;
+
+        if (s_alarm_event_num < SIM_ALARM_EVENT_MAX)
+        {
+            s_alarm_events[s_alarm_event_num].at = sim_seconds(g_sim_now);
+            s_alarm_events[s_alarm_event_num].bit = bit;
+            s_alarm_events[s_alarm_event_num].set = (mask & bit) != 0;
+            s_alarm_event_num++;
+        }
+    }
+
+    s_alarm_mask = mask;
+}
+
+/**
+ * @brief       记录帧: 新序号是实时记录, 已出现过的序号是补传, 内容(含启动号)必须与实时发出的相同;
+ *              仿真中没有复位, 启动号不为0且始终不变
+ */
+static void sim_record_frame(uint16_t seq, const uint8_t *payload)
+{
+    sensor_sample_t s;
+    uint16_t boot_id = payload[12] | (payload[13] << 8);
+
+    if (seq < s_record_num)
+    {
+        if (s_backfill_num < SIM_RECORD_MAX)
+        {
+            s_backfill_seqs[s_backfill_num++] = seq;
+        }
+
+        if (memcmp(s_records[seq], payload, SENSOR_FRAME_RECORD_PAYLOAD_LEN) != 0)
+        {
+            printf("%10.3f FAIL backfilled record %u differs from the live one\n", sim_seconds(g_sim_now), seq);
+            s_record_errors++;
+        }
+    }
+    else if (seq == s_record_num && seq < SIM_RECORD_MAX)
+    {
+        if (boot_id == 0 || (seq > 0 && boot_id != (s_records[0][12] | (s_records[0][13] << 8))))
+        {
+            printf("%10.3f FAIL record %u boot id %u\n", sim_seconds(g_sim_now), seq, boot_id);
+            s_record_errors++;
+        }
+
+        memcpy(s_records[seq], payload, SENSOR_FRAME_RECORD_PAYLOAD_LEN);
+        s_record_num++;
+        sim_decode_sample(payload, &s);
+        sim_check_sample("RECORD", seq, &s);
+    }
+    else
+    {
+        printf("%10.3f FAIL record seq %u, expected %u\n", sim_seconds(g_sim_now), seq, s_record_num);
+        s_record_errors++;
+    }
+}
+
+static void sim_u3_frame(void)
+{
+    sensor_sample_t sample;
+    uint8_t payload[SENSOR_FRAME_MAX_PAYLOAD];
+    uint16_t seq, len;
+    uint8_t type, i;
+
+    if (sensor_frame_unpack(s_u3_frame, s_u3_len, &type, &seq, payload, &len) != SENSOR_FRAME_OK)
+    {
+        s_u3_bad++;
+        return;
+    }
+
+    s_u3_types[type]++;
+
+    if (type == SENSOR_FRAME_TYPE_ACK && len >= SENSOR_FRAME_ACK_PAYLOAD_LEN)
+    {
+        for (i = 0; i < s_cmd_num; i++)
+        {
+            if (s_cmds[i].seq == seq && s_cmds[i].type == payload[0])
+            {
+                s_cmds[i].acked++;
+                s_cmds[i].status = payload[1];
+            }
+        }
+
+        if (payload[0] == SENSOR_FRAME_TYPE_TIME_SYNC && payload[1] == 0 && s_sync_at == 0)
+        {
+            s_sync_at = g_sim_now;
+        }
+        else if (payload[0] == SENSOR_FRAME_TYPE_BACKFILL_REQ)
+        {
+            s_backfill_limit = s_record_num;
+        }
+
+        if (!s_quiet)
+        {
+            printf("%10.3f U3  ACK seq %u cmd 0x%02X status %u\n", sim_seconds(g_sim_now), seq, payload[0], payload[1]);
+        }
+    }
+    else if (type == SENSOR_FRAME_TYPE_SAMPLE && len >= SENSOR_FRAME_SAMPLE_PAYLOAD_LEN)
+    {
+        if (!s_quiet)
+        {
+            printf("%10.3f U3  SAMPLE seq %u (%u bytes)\n", sim_seconds(g_sim_now), seq, len);
+        }
+
+        sim_decode_sample(payload, &sample);
+        sim_check_sample("SAMPLE", seq, &sample);
+        sim_track_alarm(sample.alarm_mask);
+        s_co_results += (sample.valid & SENSOR_VALID_CO) != 0;
+    }
+    else if (type == SENSOR_FRAME_TYPE_RECORD && len >= SENSOR_FRAME_RECORD_PAYLOAD_LEN)
+    {
+        if (!s_quiet)
+        {
+            printf("%10.3f U3  RECORD seq %u\n", sim_seconds(g_sim_now), seq);
+        }
+
+        sim_record_frame(seq, payload);
+    }
+}
+
+static void sim_u3_byte(uint8_t byte)
+{
+    if (byte == 0)
+    {
+        if (s_u3_len)
+        {
+            sim_u3_frame();
+        }
+
+        s_u3_len = 0;
+    }
+    else if (s_u3_len < sizeof(s_u3_frame))
+    {
+        s_u3_frame[s_u3_len++] = byte;
+    }
+}
+
+void sim_on_uart_tx(int port, uint8_t byte)
+{
+    if (port == SIM_UART1)
+    {
+        sim_u1_byte(byte);
+    }
+    else if (port == SIM_UART3)
+    {
+        sim_u3_byte(byte);
+    }
+}
+
+void sim_on_beep(uint8_t on, uint32_t freq_hz)
+{
+    if (on)
+    {
+        s_beep_on_count++;
+        s_beep_on_at = g_sim_now;
+
+        if (!s_quiet && s_beep_on_count <= SIM_BEEP_LOG_MAX)
+        {
+            printf("%10.3f BEEP on %lu Hz\n", sim_seconds(g_sim_now), (unsigned long)freq_hz);
+        }
+    }
+    else
+    {
+        s_beep_on_total += g_sim_now - s_beep_on_at;
+    }
+}
+
+/******************************************************************************************/
+/* ESP32脚本 */
+
+static void sim_esp32_cmd(double at_s, uint8_t type, const uint8_t *payload, uint16_t len)
+{
+    uint8_t frame[SENSOR_FRAME_MAX_ENCODED];
+    uint16_t seq = (uint16_t)(s_cmd_num + 1);
+    uint16_t n = sensor_frame_pack(type, seq, payload, len, frame);
+
+    s_cmds[s_cmd_num].seq = seq;
+    s_cmds[s_cmd_num].type = type;
+    s_cmd_num++;
+    sim_uart_inject(SIM_UART3, (uint64_t)(at_s * SIM_CPU_HZ), frame, n);
+}
+
+/**
+ * @brief       发送一帧损坏的数据: 正常组帧后改动中间一个字节, 不能改成0(会把帧截断)
+ */
+static void sim_esp32_bad_frame(double at_s)
+{
+    static const uint8_t payload[SENSOR_FRAME_REPORT_PERIOD_PAYLOAD_LEN] = {0xE8, 0x03};
+    uint8_t frame[SENSOR_FRAME_MAX_ENCODED];
+    uint16_t n = sensor_frame_pack(SENSOR_FRAME_TYPE_SET_REPORT_PERIOD, 0x7FFF, payload, sizeof(payload), frame);
+
+    frame[n / 2] ^= frame[n / 2] == 0x01 ? 0x02 : 0x01;
+    s_bad_frames++;
+    sim_uart_inject(SIM_UART3, (uint64_t)(at_s * SIM_CPU_HZ), frame, n);
+}
+
+static void sim_script(double seconds)
+{
+    static const uint8_t time_sync[4] = {SIM_TIME_SYNC_UNIX & 0xFF, (SIM_TIME_SYNC_UNIX >> 8) & 0xFF,
+                                         (SIM_TIME_SYNC_UNIX >> 16) & 0xFF, SIM_TIME_SYNC_UNIX >> 24};
+    static const uint8_t period[2] = {0xF4, 0x01};                    /* 上报周期500ms */
+    static const uint8_t threshold[3] = {BEEP_ALARM_DUST_LOW, SIM_DUST_LOW_X10 & 0xFF, SIM_DUST_LOW_X10 >> 8};
+    static const uint8_t backfill[4] = {SIM_BACKFILL_FIRST & 0xFF, SIM_BACKFILL_FIRST >> 8,
+                                        SIM_BACKFILL_COUNT & 0xFF, SIM_BACKFILL_COUNT >> 8};
+    static const char prof_cmd[] = "prof\r\n";
+
+    sim_esp32_cmd(2.5, SENSOR_FRAME_TYPE_TIME_SYNC, time_sync, sizeof(time_sync));
+    sim_esp32_cmd(5.0, SENSOR_FRAME_TYPE_SET_REPORT_PERIOD, period, sizeof(period));
+    sim_esp32_cmd(6.0, SENSOR_FRAME_TYPE_SET_THRESHOLD, threshold, sizeof(threshold));
+    sim_esp32_bad_frame(8.0);
+
+    if (seconds > 25)
+    {
+        sim_esp32_cmd(20.0, SENSOR_FRAME_TYPE_BACKFILL_REQ, backfill, sizeof(backfill));
+    }
+
+    sim_uart_inject(SIM_UART1, (uint64_t)((seconds > 4 ? seconds - 2 : seconds / 2) * SIM_CPU_HZ),
+                    (const uint8_t *)prof_cmd, sizeof(prof_cmd) - 1);
+}
+
+/******************************************************************************************/
+/* 报告 */
+
+static void sim_report_tasks(void)
+{
+    uint8_t i;
+    sched_task_t *task;
+
+    printf("\n%-8s %7s %8s %9s %12s %14s\n", "task", "period", "runs", "overruns", "exec_max_us", "latency_max_us");
+
+    for (i = 0; i < g_sched_task_num; i++)
+    {
+        task = &g_sched_tasks[i];
+        printf("%-8s %7u %8lu %9lu %12lu %14lu\n", task->name, task->period_ms, (unsigned long)task->runs,
+               (unsigned long)task->overruns, (unsigned long)task->exec_max_us, (unsigned long)task->latency_max_us);
+    }
+}
+
+static void sim_report_sensors(void)
+{
+    static const char *const names[SENSOR_NUM] = {"dht11", "dust", "mq7"};
+    uint32_t frames, ignored;
+    uint8_t i;
+
+    printf("\n%-8s %8s %8s %8s %10s %12s\n", "sensor", "starts", "ok", "errors", "cpu_us", "cpu_max_us");
+
+    for (i = 0; i < SENSOR_NUM; i++)
+    {
+        printf("%-8s %8lu %8lu %8lu %10lu %12lu\n", names[i], (unsigned long)g_sensor_stats[i].starts,
+               (unsigned long)g_sensor_stats[i].ok, (unsigned long)g_sensor_stats[i].errors,
+               (unsigned long)g_sensor_stats[i].cpu_us, (unsigned long)g_sensor_stats[i].cpu_max_us);
+    }
+
+    sim_dht11_stats(&frames, &ignored);
+    printf("DHT11: ok %lu, timeout %lu, checksum %lu; sensor frames %lu, short start pulses %lu\n",
+           (unsigned long)g_dht11_stats.ok, (unsigned long)g_dht11_stats.timeout,
+           (unsigned long)g_dht11_stats.checksum, (unsigned long)frames, (unsigned long)ignored);
+}
+
+static void sim_report_links(void)
+{
+    const char *names[3] = {"USART1", "USART2", "USART3"};
+    uint32_t rx, lost, tx;
+    uint8_t i;
+
+    printf("\n");
+
+    for (i = 0; i < 3; i++)
+    {
+        sim_uart_stats(i, &rx, &lost, &tx);
+
+        if (rx || tx)
+        {
+            printf("%s: tx %lu bytes, rx %lu bytes, rx lost %lu\n", names[i],
+                   (unsigned long)tx, (unsigned long)rx, (unsigned long)lost);
+        }
+    }
+
+    printf("USART1 lines %lu, prof %lu\n", (unsigned long)s_u1_lines, (unsigned long)s_u1_prof_lines);
+    printf("USART3 frames: sample %lu, record %lu, ack %lu, undecodable %lu\n",
+           (unsigned long)s_u3_types[SENSOR_FRAME_TYPE_SAMPLE], (unsigned long)s_u3_types[SENSOR_FRAME_TYPE_RECORD],
+           (unsigned long)s_u3_types[SENSOR_FRAME_TYPE_ACK], (unsigned long)s_u3_bad);
+    printf("USART3 rx: frames %lu, bytes %lu, idle %lu, acks %lu, time syncs %lu, errors %lu, overflows %lu, "
+           "backfill %lu/%lu\n",
+           (unsigned long)g_uart3_rx_stats.frames, (unsigned long)g_uart3_rx_stats.bytes,
+           (unsigned long)g_uart3_rx_stats.idle_events, (unsigned long)g_uart3_rx_stats.acks,
+           (unsigned long)g_uart3_rx_stats.time_syncs, (unsigned long)g_uart3_rx_stats.errors,
+           (unsigned long)g_uart3_rx_stats.overflows, (unsigned long)g_uart3_rx_stats.backfill_reqs,
+           (unsigned long)g_uart3_rx_stats.backfill_sent);
+    printf("USART3 content: %u records (boot id %u), %u backfilled, %lu samples with a CO result, alarm transitions:",
+           s_record_num, s_record_num ? s_records[0][12] | (s_records[0][13] << 8) : 0, s_backfill_num,
+           (unsigned long)s_co_results);
+
+    for (i = 0; i < s_alarm_event_num; i++)
+    {
+        printf(" %c0x%04X@%.1fs", s_alarm_events[i].set ? '+' : '-', s_alarm_events[i].bit, s_alarm_events[i].at);
+    }
+
+    printf("\n");
+}
+
+static void sim_report_misc(void)
+{
+    char buf[PWR_REPORT_MAX > PROF_LINE_MAX ? PWR_REPORT_MAX : PROF_LINE_MAX];
+    uint32_t reads, programs, erases;
+    uint8_t i;
+
+    printf("\n");
+
+    for (i = 0; i < PROF_ZONE_NUM; i++)
+    {
+        buf[prof_format(buf, i)] = 0;
+        printf("%s", buf);
+    }
+
+    buf[pwr_format_report(buf)] = 0;
+    printf("%s", buf);
+
+    sim_spi_stats(&reads, &programs, &erases);
+    printf("SPI FLASH: read %lu bytes, %lu page programs, %lu erases\n",
+           (unsigned long)reads, (unsigned long)programs, (unsigned long)erases);
+    printf("BEEP: on %lu times, %.1f s total\n", (unsigned long)s_beep_on_count, sim_seconds(s_beep_on_total));
+    printf("IRQ: systick %lu, tim7 %lu, exti15_10 %lu, usart1 %lu, usart3 %lu, dma1_ch1 %lu, dma1_ch3 %lu\n",
+           (unsigned long)sim_irq_count(SysTick_IRQn), (unsigned long)sim_irq_count(TIM7_IRQn),
+           (unsigned long)sim_irq_count(EXTI15_10_IRQn), (unsigned long)sim_irq_count(USART1_IRQn),
+           (unsigned long)sim_irq_count(USART3_IRQn), (unsigned long)sim_irq_count(DMA1_Channel1_IRQn),
+           (unsigned long)sim_irq_count(DMA1_Channel3_IRQn));
+}
+
+/**
+ * @brief       检查一种报警的置位/清除
+ * @note        按固件当前的报警规则(含脚本修改后的阈值)扫描环境脚本, 得到每次越过阈值和回差的时刻,
+ *              样本帧里对应的变化要在[越过时刻 - 1s, 越过时刻 + 消抖时间 + 输入滞后]之内;
+ *              窗口超出仿真时长的变化可有可无, 其余的必须一一对应
+ * @param       type: 报警类型BEEP_ALARM_xxx
+ * @retval      失败项数
+ */
+static int sim_check_alarm(uint8_t type)
+{
+    const beep_rule_t *rule = beep_get_rule(type);
+    const uint16_t bit = SENSOR_ALARM_BIT(type);
+    const uint64_t step = SIM_CPU_HZ / 100;
+    const double end = sim_seconds(g_sim_now);
+    const sim_alarm_event_t *obs[SIM_ALARM_EVENT_MAX];
+    uint8_t obs_num = 0, expect_num = 0, active = 0, want, j;
+    double v, at, late;
+    sim_env_t env;
+    uint64_t t;
+    int fail = 0;
+
+    for (j = 0; j < s_alarm_event_num; j++)
+    {
+        if (s_alarm_events[j].bit == bit)
+        {
+            obs[obs_num++] = &s_alarm_events[j];
+        }
+    }
+
+    for (t = 0; t <= g_sim_now; t += step)
+    {
+        sim_env_at(t, &env);
+        v = sim_env_input(&env, rule->input);
+
+        if (rule->above)
+        {
+            want = active ? v > rule->threshold_x10 - rule->hysteresis_x10 : v >= rule->threshold_x10;
+        }
+        else
+        {
+            want = active ? v < rule->threshold_x10 + rule->hysteresis_x10 : v <= rule->threshold_x10;
+        }
+
+        if (want == active)
+        {
+            continue;
+        }
+
+        active = want;
+        at = sim_seconds(t);
+        late = at + rule->debounce_ms / 1000.0 + s_input_lag[rule->input];
+
+        if (expect_num < obs_num)
+        {
+            if (obs[expect_num]->set != active || obs[expect_num]->at < at - 1 || obs[expect_num]->at > late)
+            {
+                printf("FAIL: alarm 0x%04X %s at %.1f s, expected %s in %.1f..%.1f s\n", bit,
+                       obs[expect_num]->set ? "set" : "cleared", obs[expect_num]->at,
+                       active ? "set" : "cleared", at - 1, late);
+                fail++;
+            }
+        }
+        else if (late < end)
+        {
+            printf("FAIL: alarm 0x%04X not %s, expected in %.1f..%.1f s\n", bit, active ? "set" : "cleared",
+                   at - 1, late);
+            fail++;
+        }
+
+        expect_num++;
+    }
+
+    for (j = expect_num; j < obs_num; j++)
+    {
+        printf("FAIL: alarm 0x%04X %s at %.1f s without an environment change\n", bit,
+               obs[j]->set ? "set" : "cleared", obs[j]->at);
+        fail++;
+    }
+
+    return fail;
+}
+
+/**
+ * @brief       检查补传: 请求范围内收到请求时已有的记录按序各补传一次
+ * @retval      失败项数
+ */
+static int sim_check_backfill(void)
+{
+    uint16_t expect = 0, i;
+    uint8_t j;
+
+    for (j = 0; j < s_cmd_num && s_cmds[j].type != SENSOR_FRAME_TYPE_BACKFILL_REQ; j++);
+
+    if (j == s_cmd_num)
+    {
+        return 0;                               /* 仿真太短, 脚本没有发补传请求 */
+    }
+
+    if (s_backfill_limit > SIM_BACKFILL_FIRST)
+    {
+        expect = s_backfill_limit - SIM_BACKFILL_FIRST;
+        expect = expect < SIM_BACKFILL_COUNT ? expect : SIM_BACKFILL_COUNT;
+    }
+
+    for (i = 0; i < s_backfill_num && i < expect && s_backfill_seqs[i] == SIM_BACKFILL_FIRST + i; i++);
+
+    if (expect == 0 || s_backfill_num != expect || i != expect || g_uart3_rx_stats.backfill_sent != expect)
+    {
+        printf("FAIL: backfill returned %u records (%u in order, %lu sent), expected records %u..%u\n",
+               s_backfill_num, i, (unsigned long)g_uart3_rx_stats.backfill_sent,
+               SIM_BACKFILL_FIRST, SIM_BACKFILL_FIRST + expect - 1);
+        return 1;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief       检查运行结果
+ * @retval      失败项数
+ */
+static int sim_check(void)
+{
+    int fail = 0;
+    uint8_t i;
+
+    if (g_dht11_stats.ok == 0 || g_dht11_stats.timeout || g_dht11_stats.checksum)
+    {
+        printf("FAIL: DHT11 reads (ok %lu, timeout %lu, checksum %lu)\n", (unsigned long)g_dht11_stats.ok,
+               (unsigned long)g_dht11_stats.timeout, (unsigned long)g_dht11_stats.checksum);
+        fail++;
+    }
+
+    if (g_uart3_rx_stats.errors != s_bad_frames)
+    {
+        printf("FAIL: USART3 rx errors %lu, expected %lu\n", (unsigned long)g_uart3_rx_stats.errors,
+               (unsigned long)s_bad_frames);
+        fail++;
+    }
+
+    if (s_u3_types[SENSOR_FRAME_TYPE_SAMPLE] == 0 || s_u3_bad)
+    {
+        printf("FAIL: USART3 sample frames %lu, undecodable %lu\n",
+               (unsigned long)s_u3_types[SENSOR_FRAME_TYPE_SAMPLE], (unsigned long)s_u3_bad);
+        fail++;
+    }
+
+    if (s_u1_prof_lines == 0)
+    {
+        printf("FAIL: no PROF lines on USART1 after the prof command\n");
+        fail++;
+    }
+
+    for (i = 0; i < s_cmd_num; i++)
+    {
+        if (s_cmds[i].acked != 1 || s_cmds[i].status != 0)
+        {
+            printf("FAIL: command seq %u type 0x%02X acked %u times, status %u\n",
+                   s_cmds[i].seq, s_cmds[i].type, s_cmds[i].acked, s_cmds[i].status);
+            fail++;
+        }
+    }
+
+    if (s_value_errors || s_time_errors || s_record_errors)
+    {
+        printf("FAIL: frame contents: %lu value errors, %lu timestamp errors, %lu record errors\n",
+               (unsigned long)s_value_errors, (unsigned long)s_time_errors, (unsigned long)s_record_errors);
+        fail++;
+    }
+
+    if (sim_seconds(g_sim_now) > s_input_lag[BEEP_INPUT_CO] && s_co_results == 0)
+    {
+        printf("FAIL: no CO result in the sample frames\n");
+        fail++;
+    }
+
+    if (beep_get_rule(BEEP_ALARM_DUST_LOW)->threshold_x10 != SIM_DUST_LOW_X10)
+    {
+        printf("FAIL: dust low threshold %d, set to %d by the script\n",
+               beep_get_rule(BEEP_ALARM_DUST_LOW)->threshold_x10, SIM_DUST_LOW_X10);
+        fail++;
+    }
+
+    for (i = BEEP_ALARM_NONE + 1; i < BEEP_ALARM_NUM; i++)
+    {
+        fail += sim_check_alarm(i);
+    }
+
+    fail += sim_check_backfill();
+    return fail;
+}
+
+static double sim_host_seconds(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int main(int argc, char *argv[])
+{
+    double seconds = 200;
+    double host_start, host_time;
+    int i, fail;
+
+    for (i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--seconds") == 0 && i + 1 < argc)
+        {
+            seconds = atof(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--cpu-scale") == 0 && i + 1 < argc)
+        {
+            g_sim_cpu_scale = atof(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--quiet") == 0)
+        {
+            s_quiet = 1;
+        }
+        else
+        {
+            fprintf(stderr, "usage: %s [--seconds N] [--quiet] [--cpu-scale X]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    sim_core_reset();
+    sim_hal_reset();
+    sim_spi_reset();
+    sim_env_init();
+    g_sim_end = (uint64_t)(seconds * SIM_CPU_HZ);
+    sim_script(seconds);
+
+    host_start = sim_host_seconds();
+
+    if (sim_run(fw_main))
+    {
+        printf("firmware returned from main\n");
+        return 1;
+    }
+
+    host_time = sim_host_seconds() - host_start;
+
+    printf("\nsimulated %.1f s in %.2f s host time (%.0fx real time)\n",
+           sim_seconds(g_sim_now), host_time, host_time > 0 ? sim_seconds(g_sim_now) / host_time : 0);
+    sim_report_tasks();
+    sim_report_sensors();
+    sim_report_links();
+    sim_report_misc();
+
+    fail = sim_check();
+    printf("%s\n", fail ? "FAILED" : "PASSED");
+    return fail ? 1 : 0;
+}
@@ -0,0 +1,303 @@
+/**
+ ****************************************************************************************************
+ * @file        sim_spi.c
+ * @brief       主机仿真用的SPI2驱动和W25Q128 NOR FLASH模型
+ ****************************************************************************************************
+ * @attention
+ *
+ * 固件的spi2_read_write_byte直接轮询SPI2->SR并读写DR, 仿真无法在两次访问之间完成传输,
+ * 所以用本文件替换Drivers/BSP/SPI/spi.c, 接口和行为相同. 每个字节按当前波特率分频计时,
+ * FLASH命令在片选(PB12)拉低期间逐字节解析, 编程和擦除按典型时间保持BUSY.
+ *
+ ****************************************************************************************************
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sim.h"
+#include "./BSP/SPI/spi.h"
+#include "./BSP/NORFLASH/norflash.h"
+
+
+#define SIM_FLASH_SIZE          (16 * 1024 * 1024)  /* W25Q128 */
+#define SIM_FLASH_PAGE          256
+
+/* W25Q128典型时间 */
+#define SIM_FLASH_T_PP          SIM_US(700)
+#define SIM_FLASH_T_SE          SIM_MS(45)
+#define SIM_FLASH_T_BE          SIM_MS(150)
+#define SIM_FLASH_T_CE          SIM_MS(40000)
+
+SPI_HandleTypeDef g_spi2_handler;   /* SPI2句柄 */
+
+static uint8_t *s_flash = NULL;
+static uint8_t s_cs = 1;                /* 片选电平 */
+static uint8_t s_cmd;                   /* 当前命令, 片选拉低后的第一个字节 */
+static uint32_t s_pos;                  /* 本次片选内已收到的字节数 */
+static uint32_t s_addr;
+static uint8_t s_wel = 0;               /* 写使能锁存 */
+static uint64_t s_busy_until = 0;       /* 编程/擦除结束时刻 */
+static uint32_t s_reads, s_programs, s_erases;
+
+/**
+ * @brief       SPI2初始化代码
+ * @note        主机模式,8位数据,禁止硬件片选
+ * @param       无
+ * @retval      无
+ */
+void spi2_init(void)
+{
+    g_spi2_handler.Instance = SPI2;
+    g_spi2_handler.Init.Mode = SPI_MODE_MASTER;
+    g_spi2_handler.Init.Direction = SPI_DIRECTION_2LINES;
+    g_spi2_handler.Init.DataSize = SPI_DATASIZE_8BIT;
+    g_spi2_handler.Init.CLKPolarity = SPI_POLARITY_HIGH;
+    g_spi2_handler.Init.CLKPhase = SPI_PHASE_2EDGE;
+    g_spi2_handler.Init.NSS = SPI_NSS_SOFT;
+    g_spi2_handler.Init.BaudRatePrescaler = SPI_BAUDRATEPRESCALER_256;
+    g_spi2_handler.Init.FirstBit = SPI_FIRSTBIT_MSB;
+    g_spi2_handler.Init.TIMode = SPI_TIMODE_DISABLE;
+    g_spi2_handler.Init.CRCCalculation = SPI_CRCCALCULATION_DISABLE;
+    g_spi2_handler.Init.CRCPolynomial = 7;
+    HAL_SPI_Init(&g_spi2_handler);
+
+    __HAL_SPI_ENABLE(&g_spi2_handler);
+
+    spi2_read_write_byte(0Xff);
+}
+
+/**
+ * @brief       SPI2速度设置函数
+ * @param       speed   : SPI2时钟分频系数, SPI_SPEED_2 ~ SPI_SPEED_256
+ * @retval      无
+ */
+void spi2_set_speed(uint8_t speed)
+{
+    __HAL_SPI_DISABLE(&g_spi2_handler);
+    g_spi2_handler.Instance->CR1 &= 0XFFC7;
+    g_spi2_handler.Instance->CR1 |= speed << 3;
+    __HAL_SPI_ENABLE(&g_spi2_handler);
+}
+
+static uint8_t sim_flash_busy(void)
+{
+    return g_sim_now < s_busy_until;
+}
+
+static void sim_flash_start(uint64_t cycles)
+{
+    s_busy_until = g_sim_now + cycles;
+    s_wel = 0;
+}
+
+/**
+ * @brief       片选拉低期间收到一个字节, 返回同时移出的字节
+ */
+static uint8_t sim_flash_byte(uint8_t in)
+{
+    uint8_t out = 0xFF;
+    uint32_t n = s_pos++;
+
+    if (n == 0)
+    {
+        s_cmd = in;
+        s_addr = 0;
+        return out;
+    }
+
+    switch (s_cmd)
+    {
+        case FLASH_ReadStatusReg1:
+            out = (sim_flash_busy() ? 0x01 : 0) | (s_wel ? 0x02 : 0);
+            break;
+
+        case FLASH_ReadStatusReg2:
+        case FLASH_ReadStatusReg3:
+            out = 0;
+            break;
+
+        case FLASH_ManufactDeviceID:
+            if (n == 4)
+            {
+                out = W25Q128 >> 8;
+            }
+            else if (n == 5)
+            {
+                out = W25Q128 & 0xFF;
+            }
+            break;
+
+        case FLASH_JedecDeviceID:
+        {
+            static const uint8_t jedec[3] = {0xEF, 0x40, 0x18};
+            out = n <= 3 ? jedec[n - 1] : 0xFF;
+            break;
+        }
+
+        case FLASH_ReadData:
+            if (n <= 3)
+            {
+                s_addr = (s_addr << 8) | in;
+            }
+            else
+            {
+                out = s_flash[s_addr % SIM_FLASH_SIZE];
+                s_addr++;
+                s_reads++;
+            }
+            break;
+
+        case FLASH_PageProgram:
+            if (n <= 3)
+            {
+                s_addr = (s_addr << 8) | in;
+            }
+            else if (s_wel && !sim_flash_busy())
+            {
+                /* 页内回绕, 只能把1写成0 */
+                s_flash[s_addr % SIM_FLASH_SIZE] &= in;
+                s_addr = (s_addr & ~(SIM_FLASH_PAGE - 1)) | ((s_addr + 1) & (SIM_FLASH_PAGE - 1));
+            }
+            break;
+
+        case FLASH_SectorErase:
+        case FLASH_BlockErase:
+            if (n <= 3)
+            {
+                s_addr = (s_addr << 8) | in;
+            }
+            break;
+
+        default:
+            break;
+    }
+
+    return out;
+}
+
+/**
+ * @brief       片选拉高: 结束当前命令, 编程和擦除从这里开始计时
+ */
+static void sim_flash_end(void)
+{
+    uint32_t size;
+
+    if (s_pos == 0)
+    {
+        return;
+    }
+
+    switch (s_cmd)
+    {
+        case FLASH_WriteEnable:
+            if (!sim_flash_busy())
+            {
+                s_wel = 1;
+            }
+            break;
+
+        case FLASH_WriteDisable:
+            s_wel = 0;
+            break;
+
+        case FLASH_PageProgram:
+            if (s_wel && s_pos > 4)
+            {
+                s_programs++;
+                sim_flash_start(SIM_FLASH_T_PP);
+            }
+            break;
+
+        case FLASH_SectorErase:
+        case FLASH_BlockErase:
+            if (s_wel && s_pos == 4 && !sim_flash_busy())
+            {
+                size = s_cmd == FLASH_SectorErase ? 4096 : 65536;
+                memset(s_flash + ((s_addr % SIM_FLASH_SIZE) & ~(size - 1)), 0xFF, size);
+                s_erases++;
+                sim_flash_start(s_cmd == FLASH_SectorErase ? SIM_FLASH_T_SE : SIM_FLASH_T_BE);
+            }
+            break;
+
+        case FLASH_ChipErase:
+            if (s_wel && !sim_flash_busy())
+            {
+                memset(s_flash, 0xFF, SIM_FLASH_SIZE);
+                s_erases++;
+                sim_flash_start(SIM_FLASH_T_CE);
+            }
+            break;
+
+        default:
+            break;
+    }
+
+    s_pos = 0;
+}
+
+void sim_spi_cs(uint8_t level)
+{
+    if (level && !s_cs)
+    {
+        sim_flash_end();
+    }
+
+    if (!level && s_cs)
+    {
+        s_pos = 0;
+    }
+
+    s_cs = level;
+}
+
+/**
+ * @brief       SPI2读写一个字节数据
+ * @note        计入SR/DR访问和8个SCK周期, SCK = PCLK1(36MHz) / 2^(BR + 1)
+ * @param       txdata  : 要发送的数据(1字节)
+ * @retval      接收到的数据(1字节)
+ */
+uint8_t spi2_read_write_byte(uint8_t txdata)
+{
+    SPI_TypeDef *spi = g_spi2_handler.Instance;
+    uint32_t br = (spi->CR1 >> 3) & 7;
+    uint8_t rx = 0xFF;
+
+    sim_cycles(SIM_COST_REG * 3 + 8 * (2u << br) * 2);
+
+    if ((spi->CR1 & SPI_CR1_SPE) && !s_cs)
+    {
+        rx = sim_flash_byte(txdata);
+    }
+
+    return rx;
+}
+
+void sim_spi_reset(void)
+{
+    if (s_flash == NULL)
+    {
+        s_flash = malloc(SIM_FLASH_SIZE);
+
+        if (s_flash == NULL)
+        {
+            fprintf(stderr, "sim: out of memory\n");
+            exit(1);
+        }
+    }
+
+    memset(s_flash, 0xFF, SIM_FLASH_SIZE);
+    memset(&g_spi2_handler, 0, sizeof(g_spi2_handler));
+    s_cs = 1;
+    s_pos = 0;
+    s_wel = 0;
+    s_busy_until = 0;
+    s_reads = s_programs = s_erases = 0;
+}
+
+void sim_spi_stats(uint32_t *reads, uint32_t *programs, uint32_t *erases)
+{
+    *reads = s_reads;
+    *programs = s_programs;
+    *erases = s_erases;
+}
@@ -0,0 +1,439 @@
+/**
+ ****************************************************************************************************
+ * @file        stm32f1xx.h
+ * @brief       主机仿真用的器件头文件: 寄存器结构, 外设实例, 中断号和CMSIS内核函数
+ ****************************************************************************************************
+ * @attention
+ *
+ * 结构和位定义只包含固件用到的部分, 名字与CMSIS/ST器件头文件一致.
+ * 外设实例(GPIOA, USART3, SysTick, DWT, LCD...)展开为sim_periph()调用: 每次访问计入若干CPU周期,
+ * 推进仿真时间, 处理到期的外设事件并执行可以抢占的中断, 然后刷新该外设中随时间变化的寄存器
+ * (SysTick->VAL, DWT->CYCCNT, RTC计数器, SCB->ICSR). 因此固件里的寄存器忙等循环在仿真中也会前进.
+ * 写1清零的寄存器(EXTI->PR)和需要察觉写入的寄存器(RTC计数器/闹钟, DWT->CYCCNT)在访问时写入
+ * 保留位作为标记, 下次访问发现标记被覆盖就说明固件写过.
+ *
+ ****************************************************************************************************
+ */
+
+#ifndef __STM32F1XX_H
+#define __STM32F1XX_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define STM32F103xE
+
+#define __IO                volatile
+#define __I                 volatile const
+#define __O                 volatile
+#define __STATIC_INLINE     static inline
+#define __NO_RETURN         __attribute__((noreturn))
+
+/******************************************************************************************/
+/* 中断号(STM32F103xE) */
+
+typedef enum
+{
+    NonMaskableInt_IRQn     = -14,
+    MemoryManagement_IRQn   = -12,
+    BusFault_IRQn           = -11,
+    UsageFault_IRQn         = -10,
+    SVCall_IRQn             = -5,
+    DebugMonitor_IRQn       = -4,
+    PendSV_IRQn             = -2,
+    SysTick_IRQn            = -1,
+    WWDG_IRQn               = 0,
+    PVD_IRQn                = 1,
+    TAMPER_IRQn             = 2,
+    RTC_IRQn                = 3,
+    FLASH_IRQn              = 4,
+    RCC_IRQn                = 5,
+    EXTI0_IRQn              = 6,
+    EXTI1_IRQn              = 7,
+    EXTI2_IRQn              = 8,
+    EXTI3_IRQn              = 9,
+    EXTI4_IRQn              = 10,
+    DMA1_Channel1_IRQn      = 11,
+    DMA1_Channel2_IRQn      = 12,
+    DMA1_Channel3_IRQn      = 13,
+    DMA1_Channel4_IRQn      = 14,
+    DMA1_Channel5_IRQn      = 15,
+    DMA1_Channel6_IRQn      = 16,
+    DMA1_Channel7_IRQn      = 17,
+    ADC1_2_IRQn             = 18,
+    EXTI9_5_IRQn            = 23,
+    TIM2_IRQn               = 28,
+    TIM3_IRQn               = 29,
+    TIM4_IRQn               = 30,
+    SPI2_IRQn               = 36,
+    USART1_IRQn             = 37,
+    USART2_IRQn             = 38,
+    USART3_IRQn             = 39,
+    EXTI15_10_IRQn          = 40,
+    RTC_Alarm_IRQn          = 41,
+    TIM6_IRQn               = 54,
+    TIM7_IRQn               = 55,
+    DMA2_Channel1_IRQn      = 56,
+    DMA2_Channel2_IRQn      = 57,
+    DMA2_Channel3_IRQn      = 58,
+    DMA2_Channel4_5_IRQn    = 59,
+} IRQn_Type;
+
+#define SIM_IRQ_NUM             60      /* 外设中断个数 */
+
+/******************************************************************************************/
+/* 寄存器结构 */
+
+typedef struct
+{
+    __IO uint32_t CRL;
+    __IO uint32_t CRH;
+    __IO uint32_t IDR;
+    __IO uint32_t ODR;
+    __IO uint32_t BSRR;
+    __IO uint32_t BRR;
+    __IO uint32_t LCKR;
+} GPIO_TypeDef;
+
+typedef struct
+{
+    __IO uint32_t EVCR;
+    __IO uint32_t MAPR;
+    __IO uint32_t EXTICR[4];
+    uint32_t RESERVED0;
+    __IO uint32_t MAPR2;
+} AFIO_TypeDef;
+
+typedef struct
+{
+    __IO uint32_t IMR;
+    __IO uint32_t EMR;
+    __IO uint32_t RTSR;
+    __IO uint32_t FTSR;
+    __IO uint32_t SWIER;
+    __IO uint32_t PR;
+} EXTI_TypeDef;
+
+typedef struct
+{
+    __IO uint32_t CCR;
+    __IO uint32_t CNDTR;
+    __IO uint32_t CPAR;
+    __IO uint32_t CMAR;
+} DMA_Channel_TypeDef;
+
+typedef struct
+{
+    __IO uint32_t ISR;
+    __IO uint32_t IFCR;
+} DMA_TypeDef;
+
+typedef struct
+{
+    __IO uint32_t CR1;
+    __IO uint32_t CR2;
+    __IO uint32_t SMCR;
+    __IO uint32_t DIER;
+    __IO uint32_t SR;
+    __IO uint32_t EGR;
+    __IO uint32_t CCMR1;
+    __IO uint32_t CCMR2;
+    __IO uint32_t CCER;
+    __IO uint32_t CNT;
+    __IO uint32_t PSC;
+    __IO uint32_t ARR;
+    __IO uint32_t RCR;
+    __IO uint32_t CCR1;
+    __IO uint32_t CCR2;
+    __IO uint32_t CCR3;
+    __IO uint32_t CCR4;
+    __IO uint32_t BDTR;
+    __IO uint32_t DCR;
+    __IO uint32_t DMAR;
+    __IO uint32_t OR;
+} TIM_TypeDef;
+
+typedef struct
+{
+    __IO uint32_t SR;
+    __IO uint32_t DR;
+    __IO uint32_t BRR;
+    __IO uint32_t CR1;
+    __IO uint32_t CR2;
+    __IO uint32_t CR3;
+    __IO uint32_t GTPR;
+} USART_TypeDef;
+
+typedef struct
+{
+    __IO uint32_t CR1;
+    __IO uint32_t CR2;
+    __IO uint32_t SR;
+    __IO uint32_t DR;
+    __IO uint32_t CRCPR;
+    __IO uint32_t RXCRCR;
+    __IO uint32_t TXCRCR;
+    __IO uint32_t I2SCFGR;
+    __IO uint32_t I2SPR;
+} SPI_TypeDef;
+
+typedef struct
+{
+    __IO uint32_t SR;
+    __IO uint32_t CR1;
+    __IO uint32_t CR2;
+    __IO uint32_t SMPR1;
+    __IO uint32_t SMPR2;
+    __IO uint32_t JOFR1;
+    __IO uint32_t JOFR2;
+    __IO uint32_t JOFR3;
+    __IO uint32_t JOFR4;
+    __IO uint32_t HTR;
+    __IO uint32_t LTR;
+    __IO uint32_t SQR1;
+    __IO uint32_t SQR2;
+    __IO uint32_t SQR3;
+    __IO uint32_t JSQR;
+    __IO uint32_t JDR1;
+    __IO uint32_t JDR2;
+    __IO uint32_t JDR3;
+    __IO uint32_t JDR4;
+    __IO uint32_t DR;
+} ADC_TypeDef;
+
+typedef struct
+{
+    __IO uint32_t CRH;
+    __IO uint32_t CRL;
+    __IO uint32_t PRLH;
+    __IO uint32_t PRLL;
+    __IO uint32_t DIVH;
+    __IO uint32_t DIVL;
+    __IO uint32_t CNTH;
+    __IO uint32_t CNTL;
+    __IO uint32_t ALRH;
+    __IO uint32_t ALRL;
+} RTC_TypeDef;
+
+typedef struct
+{
+    uint32_t RESERVED0;
+    __IO uint32_t DR1;
+    __IO uint32_t DR2;
+    __IO uint32_t DR3;
+    __IO uint32_t DR4;
+    __IO uint32_t DR5;
+    __IO uint32_t DR6;
+    __IO uint32_t DR7;
+    __IO uint32_t DR8;
+    __IO uint32_t DR9;
+    __IO uint32_t DR10;
+    __IO uint32_t RTCCR;
+    __IO uint32_t CR;
+    __IO uint32_t CSR;
+} BKP_TypeDef;
+
+typedef struct
+{
+    __IO uint32_t CR;
+    __IO uint32_t CSR;
+} PWR_TypeDef;
+
+typedef struct
+{
+    __IO uint32_t BTCR[8];
+} FSMC_Bank1_TypeDef;
+
+typedef struct
+{
+    __IO uint32_t BWTR[7];
+} FSMC_Bank1E_TypeDef;
+
+typedef struct
+{
+    __I  uint32_t CPUID;
+    __IO uint32_t ICSR;
+    __IO uint32_t VTOR;
+    __IO uint32_t AIRCR;
+    __IO uint32_t SCR;
+    __IO uint32_t CCR;
+} SCB_Type;
+
+typedef struct
+{
+    __IO uint32_t CTRL;
+    __IO uint32_t LOAD;
+    __IO uint32_t VAL;
+    __I  uint32_t CALIB;
+} SysTick_Type;
+
+typedef struct
+{
+    __IO uint32_t CTRL;
+    __IO uint32_t CYCCNT;
+} DWT_Type;
+
+typedef struct
+{
+    __IO uint32_t DHCSR;
+    __O  uint32_t DCRSR;
+    __IO uint32_t DCRDR;
+    __IO uint32_t DEMCR;
+} CoreDebug_Type;
+
+/******************************************************************************************/
+/* 外设实例, 每次访问经过仿真内核 */
+
+typedef enum
+{
+    SIM_P_GPIOA = 0, SIM_P_GPIOB, SIM_P_GPIOC, SIM_P_GPIOD, SIM_P_GPIOE, SIM_P_GPIOF, SIM_P_GPIOG,
+    SIM_P_AFIO, SIM_P_EXTI,
+    SIM_P_DMA1, SIM_P_DMA2,
+    SIM_P_DMA1_CH1, SIM_P_DMA1_CH2, SIM_P_DMA1_CH3, SIM_P_DMA1_CH4, SIM_P_DMA1_CH5, SIM_P_DMA1_CH6, SIM_P_DMA1_CH7,
+    SIM_P_DMA2_CH1, SIM_P_DMA2_CH2, SIM_P_DMA2_CH3, SIM_P_DMA2_CH4, SIM_P_DMA2_CH5,
+    SIM_P_TIM2, SIM_P_TIM3, SIM_P_TIM4, SIM_P_TIM6, SIM_P_TIM7,
+    SIM_P_USART1, SIM_P_USART2, SIM_P_USART3,
+    SIM_P_SPI2, SIM_P_ADC1, SIM_P_RTC, SIM_P_BKP, SIM_P_PWR,
+    SIM_P_FSMC_BANK1, SIM_P_FSMC_BANK1E,
+    SIM_P_SCB, SIM_P_SYSTICK, SIM_P_DWT, SIM_P_COREDEBUG,
+    SIM_P_LCD,
+    SIM_P_NUM
+} sim_periph_t;
+
+void *sim_periph(sim_periph_t id);
+
+#define GPIOA               ((GPIO_TypeDef *)sim_periph(SIM_P_GPIOA))
+#define GPIOB               ((GPIO_TypeDef *)sim_periph(SIM_P_GPIOB))
+#define GPIOC               ((GPIO_TypeDef *)sim_periph(SIM_P_GPIOC))
+#define GPIOD               ((GPIO_TypeDef *)sim_periph(SIM_P_GPIOD))
+#define GPIOE               ((GPIO_TypeDef *)sim_periph(SIM_P_GPIOE))
+#define GPIOF               ((GPIO_TypeDef *)sim_periph(SIM_P_GPIOF))
+#define GPIOG               ((GPIO_TypeDef *)sim_periph(SIM_P_GPIOG))
+#define AFIO                ((AFIO_TypeDef *)sim_periph(SIM_P_AFIO))
+#define EXTI                ((EXTI_TypeDef *)sim_periph(SIM_P_EXTI))
+#define DMA1                ((DMA_TypeDef *)sim_periph(SIM_P_DMA1))
+#define DMA2                ((DMA_TypeDef *)sim_periph(SIM_P_DMA2))
+#define DMA1_Channel1       ((DMA_Channel_TypeDef *)sim_periph(SIM_P_DMA1_CH1))
+#define DMA1_Channel2       ((DMA_Channel_TypeDef *)sim_periph(SIM_P_DMA1_CH2))
+#define DMA1_Channel3       ((DMA_Channel_TypeDef *)sim_periph(SIM_P_DMA1_CH3))
+#define DMA1_Channel4       ((DMA_Channel_TypeDef *)sim_periph(SIM_P_DMA1_CH4))
+#define DMA1_Channel5       ((DMA_Channel_TypeDef *)sim_periph(SIM_P_DMA1_CH5))
+#define DMA1_Channel6       ((DMA_Channel_TypeDef *)sim_periph(SIM_P_DMA1_CH6))
+#define DMA1_Channel7       ((DMA_Channel_TypeDef *)sim_periph(SIM_P_DMA1_CH7))
+#define DMA2_Channel1       ((DMA_Channel_TypeDef *)sim_periph(SIM_P_DMA2_CH1))
+#define DMA2_Channel2       ((DMA_Channel_TypeDef *)sim_periph(SIM_P_DMA2_CH2))
+#define DMA2_Channel3       ((DMA_Channel_TypeDef *)sim_periph(SIM_P_DMA2_CH3))
+#define DMA2_Channel4       ((DMA_Channel_TypeDef *)sim_periph(SIM_P_DMA2_CH4))
+#define DMA2_Channel5       ((DMA_Channel_TypeDef *)sim_periph(SIM_P_DMA2_CH5))
+#define TIM2                ((TIM_TypeDef *)sim_periph(SIM_P_TIM2))
+#define TIM3                ((TIM_TypeDef *)sim_periph(SIM_P_TIM3))
+#define TIM4                ((TIM_TypeDef *)sim_periph(SIM_P_TIM4))
+#define TIM6                ((TIM_TypeDef *)sim_periph(SIM_P_TIM6))
+#define TIM7                ((TIM_TypeDef *)sim_periph(SIM_P_TIM7))
+#define USART1              ((USART_TypeDef *)sim_periph(SIM_P_USART1))
+#define USART2              ((USART_TypeDef *)sim_periph(SIM_P_USART2))
+#define USART3              ((USART_TypeDef *)sim_periph(SIM_P_USART3))
+#define SPI2                ((SPI_TypeDef *)sim_periph(SIM_P_SPI2))
+#define ADC1                ((ADC_TypeDef *)sim_periph(SIM_P_ADC1))
+#define RTC                 ((RTC_TypeDef *)sim_periph(SIM_P_RTC))
+#define BKP                 ((BKP_TypeDef *)sim_periph(SIM_P_BKP))
+#define PWR                 ((PWR_TypeDef *)sim_periph(SIM_P_PWR))
+#define FSMC_Bank1          ((FSMC_Bank1_TypeDef *)sim_periph(SIM_P_FSMC_BANK1))
+#define FSMC_Bank1E         ((FSMC_Bank1E_TypeDef *)sim_periph(SIM_P_FSMC_BANK1E))
+#define SCB                 ((SCB_Type *)sim_periph(SIM_P_SCB))
+#define SysTick             ((SysTick_Type *)sim_periph(SIM_P_SYSTICK))
+#define DWT                 ((DWT_Type *)sim_periph(SIM_P_DWT))
+#define CoreDebug           ((CoreDebug_Type *)sim_periph(SIM_P_COREDEBUG))
+
+/* FSMC上的LCD, 每次访问按总线时序计时, 见lcd.h */
+#define LCD                 ((LCD_TypeDef *)sim_periph(SIM_P_LCD))
+
+/******************************************************************************************/
+/* 位定义 */
+
+#define SCB_ICSR_PENDSTSET_Msk          (1UL << 26)
+#define SCB_SCR_SLEEPDEEP_Msk           (1UL << 2)
+#define SysTick_CTRL_ENABLE_Msk         (1UL << 0)
+#define SysTick_CTRL_TICKINT_Msk        (1UL << 1)
+#define SysTick_CTRL_CLKSOURCE_Msk      (1UL << 2)
+#define SysTick_CTRL_COUNTFLAG_Msk      (1UL << 16)
+#define DWT_CTRL_CYCCNTENA_Msk          (1UL << 0)
+#define CoreDebug_DEMCR_TRCENA_Msk      (1UL << 24)
+
+#define EXTI_IMR_MR17                   (1UL << 17)
+#define AFIO_EXTICR3_EXTI11             0xF000U
+#define AFIO_EXTICR3_EXTI11_PG          0x6000U
+
+#define DMA_CCR_EN                      (1UL << 0)
+#define DMA_CCR_TCIE                    (1UL << 1)
+#define DMA_CCR_HTIE                    (1UL << 2)
+#define DMA_CCR_TEIE                    (1UL << 3)
+#define DMA_CCR_DIR                     (1UL << 4)
+#define DMA_CCR_CIRC                    (1UL << 5)
+#define DMA_CCR_PINC                    (1UL << 6)
+#define DMA_CCR_MINC                    (1UL << 7)
+#define DMA_CCR_MEM2MEM                 (1UL << 14)
+
+#define TIM_CR1_CEN                     (1UL << 0)
+#define TIM_SR_UIF                      (1UL << 0)
+#define TIM_DIER_UIE                    (1UL << 0)
+
+#define USART_SR_PE                     (1UL << 0)
+#define USART_SR_FE                     (1UL << 1)
+#define USART_SR_NE                     (1UL << 2)
+#define USART_SR_ORE                    (1UL << 3)
+#define USART_SR_IDLE                   (1UL << 4)
+#define USART_SR_RXNE                   (1UL << 5)
+#define USART_SR_TC                     (1UL << 6)
+#define USART_SR_TXE                    (1UL << 7)
+#define USART_CR1_IDLEIE                (1UL << 4)
+#define USART_CR1_RXNEIE                (1UL << 5)
+#define USART_CR1_TCIE                  (1UL << 6)
+#define USART_CR1_TXEIE                 (1UL << 7)
+#define USART_CR1_UE                    (1UL << 13)
+#define USART_CR3_DMAR                  (1UL << 6)
+#define USART_CR3_DMAT                  (1UL << 7)
+
+#define SPI_SR_RXNE                     (1UL << 0)
+#define SPI_SR_TXE                      (1UL << 1)
+#define SPI_SR_BSY                      (1UL << 7)
+#define SPI_CR1_SPE                     (1UL << 6)
+
+#define RTC_CRH_SECIE                   (1UL << 0)
+#define RTC_CRH_ALRIE                   (1UL << 1)
+#define RTC_CRL_SECF                    (1UL << 0)
+#define RTC_CRL_ALRF                    (1UL << 1)
+#define RTC_CRL_OWF                     (1UL << 2)
+#define RTC_CRL_RSF                     (1UL << 3)
+#define RTC_CRL_CNF                     (1UL << 4)
+#define RTC_CRL_RTOFF                   (1UL << 5)
+
+#define PWR_CR_PDDS                     (1UL << 1)
+#define PWR_CR_DBP                      (1UL << 8)
+
+#define SET_BIT(REG, BIT)               ((REG) |= (BIT))
+#define CLEAR_BIT(REG, BIT)             ((REG) &= ~(BIT))
+#define READ_BIT(REG, BIT)              ((REG) & (BIT))
+#define WRITE_REG(REG, VAL)             ((REG) = (VAL))
+#define READ_REG(REG)                   ((REG))
+#define MODIFY_REG(REG, CLEARMASK, SETMASK) WRITE_REG((REG), (((READ_REG(REG)) & (~(CLEARMASK))) | (SETMASK)))
+
+/******************************************************************************************/
+/* CMSIS内核函数 */
+
+extern uint32_t SystemCoreClock;
+
+void __disable_irq(void);
+void __enable_irq(void);
+uint32_t __get_PRIMASK(void);
+void __set_PRIMASK(uint32_t primask);
+void __NOP(void);
+void __WFI(void);
+void __DSB(void);
+void __ISB(void);
+void __set_MSP(uint32_t top);
+void NVIC_SystemReset(void);
+
+#include "stm32f1xx_hal.h"
+
+#endif
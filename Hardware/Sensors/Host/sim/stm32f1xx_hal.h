@@ -0,0 +1,648 @@
+/**
+ ****************************************************************************************************
+ * @file        stm32f1xx_hal.h
+ * @brief       主机仿真用的HAL: 类型, 常量和函数声明, 实现在sim_hal.c
+ ****************************************************************************************************
+ * @attention
+ *
+ * 只包含固件用到的接口, 名字和语义与STM32CubeF1 HAL一致. 与时间有关的行为(定时器计数, DMA传输,
+ * 串口收发, ADC转换)由仿真内核按72MHz的CPU周期推进, 中断按优先级分组2(2位抢占, 2位子优先级)执行.
+ * __HAL_xxx宏中涉及定时器计数和DMA剩余计数的都改为函数, 由仿真内核按当前时间计算.
+ *
+ ****************************************************************************************************
+ */
+
+#ifndef __STM32F1XX_HAL_H
+#define __STM32F1XX_HAL_H
+
+#include "stm32f1xx.h"
+
+
+/******************************************************************************************/
+/* 通用类型 */
+
+typedef enum
+{
+    HAL_OK = 0x00U,
+    HAL_ERROR = 0x01U,
+    HAL_BUSY = 0x02U,
+    HAL_TIMEOUT = 0x03U
+} HAL_StatusTypeDef;
+
+typedef enum
+{
+    HAL_UNLOCKED = 0x00U,
+    HAL_LOCKED = 0x01U
+} HAL_LockTypeDef;
+
+typedef enum {RESET = 0, SET = !RESET} FlagStatus, ITStatus;
+typedef enum {DISABLE = 0, ENABLE = !DISABLE} FunctionalState;
+
+#define UNUSED(X)                   (void)X
+#define assert_param(expr)          ((void)0U)
+#define HAL_MAX_DELAY               0xFFFFFFFFU
+
+#define __HAL_LINKDMA(__HANDLE__, __PPP_DMA_FIELD__, __DMA_HANDLE__) \
+    do{ (__HANDLE__)->__PPP_DMA_FIELD__ = &(__DMA_HANDLE__); (__DMA_HANDLE__).Parent = (__HANDLE__); }while(0U)
+
+/******************************************************************************************/
+/* RCC/AFIO: 时钟固定为HSE 8MHz x 9 = 72MHz, APB1 36MHz, 使能宏为空 */
+
+typedef struct
+{
+    uint32_t PLLState;
+    uint32_t PLLSource;
+    uint32_t PLLMUL;
+} RCC_PLLInitTypeDef;
+
+typedef struct
+{
+    uint32_t OscillatorType;
+    uint32_t HSEState;
+    uint32_t HSEPredivValue;
+    uint32_t LSEState;
+    uint32_t HSIState;
+    uint32_t HSICalibrationValue;
+    uint32_t LSIState;
+    RCC_PLLInitTypeDef PLL;
+} RCC_OscInitTypeDef;
+
+typedef struct
+{
+    uint32_t ClockType;
+    uint32_t SYSCLKSource;
+    uint32_t AHBCLKDivider;
+    uint32_t APB1CLKDivider;
+    uint32_t APB2CLKDivider;
+} RCC_ClkInitTypeDef;
+
+typedef struct
+{
+    uint32_t PeriphClockSelection;
+    uint32_t RTCClockSelection;
+    uint32_t AdcClockSelection;
+    uint32_t UsbClockSelection;
+} RCC_PeriphCLKInitTypeDef;
+
+#define RCC_OSCILLATORTYPE_HSE      0x00000001U
+#define RCC_OSCILLATORTYPE_HSI      0x00000002U
+#define RCC_OSCILLATORTYPE_LSE      0x00000004U
+#define RCC_OSCILLATORTYPE_LSI      0x00000008U
+#define RCC_HSE_ON                  0x00010000U
+#define RCC_HSE_PREDIV_DIV1         0x00000000U
+#define RCC_LSE_ON                  0x00000001U
+#define RCC_PLL_NONE                0x00000000U
+#define RCC_PLL_OFF                 0x00000001U
+#define RCC_PLL_ON                  0x00000002U
+#define RCC_PLLSOURCE_HSE           0x00010000U
+#define RCC_PLL_MUL9                0x001C0000U
+#define RCC_CLOCKTYPE_SYSCLK        0x00000001U
+#define RCC_CLOCKTYPE_HCLK          0x00000002U
+#define RCC_CLOCKTYPE_PCLK1         0x00000004U
+#define RCC_CLOCKTYPE_PCLK2         0x00000008U
+#define RCC_SYSCLKSOURCE_PLLCLK     0x00000002U
+#define RCC_SYSCLK_DIV1             0x00000000U
+#define RCC_HCLK_DIV1               0x00000000U
+#define RCC_HCLK_DIV2               0x00000400U
+#define RCC_PERIPHCLK_RTC           0x00000001U
+#define RCC_PERIPHCLK_ADC           0x00000002U
+#define RCC_RTCCLKSOURCE_LSE        0x00000100U
+#define RCC_ADCPCLK2_DIV6           0x00008000U
+#define FLASH_LATENCY_2             0x00000002U
+
+#define __HAL_RCC_GPIOA_CLK_ENABLE()    do{ }while(0U)
+#define __HAL_RCC_GPIOB_CLK_ENABLE()    do{ }while(0U)
+#define __HAL_RCC_GPIOC_CLK_ENABLE()    do{ }while(0U)
+#define __HAL_RCC_GPIOD_CLK_ENABLE()    do{ }while(0U)
+#define __HAL_RCC_GPIOE_CLK_ENABLE()    do{ }while(0U)
+#define __HAL_RCC_GPIOF_CLK_ENABLE()    do{ }while(0U)
+#define __HAL_RCC_GPIOG_CLK_ENABLE()    do{ }while(0U)
+#define __HAL_RCC_AFIO_CLK_ENABLE()     do{ }while(0U)
+#define __HAL_RCC_DMA1_CLK_ENABLE()     do{ }while(0U)
+#define __HAL_RCC_DMA2_CLK_ENABLE()     do{ }while(0U)
+#define __HAL_RCC_TIM2_CLK_ENABLE()     do{ }while(0U)
+#define __HAL_RCC_TIM3_CLK_ENABLE()     do{ }while(0U)
+#define __HAL_RCC_TIM4_CLK_ENABLE()     do{ }while(0U)
+#define __HAL_RCC_TIM6_CLK_ENABLE()     do{ }while(0U)
+#define __HAL_RCC_TIM7_CLK_ENABLE()     do{ }while(0U)
+#define __HAL_RCC_USART1_CLK_ENABLE()   do{ }while(0U)
+#define __HAL_RCC_USART2_CLK_ENABLE()   do{ }while(0U)
+#define __HAL_RCC_USART3_CLK_ENABLE()   do{ }while(0U)
+#define __HAL_RCC_SPI2_CLK_ENABLE()     do{ }while(0U)
+#define __HAL_RCC_ADC1_CLK_ENABLE()     do{ }while(0U)
+#define __HAL_RCC_PWR_CLK_ENABLE()      do{ }while(0U)
+#define __HAL_RCC_BKP_CLK_ENABLE()      do{ }while(0U)
+#define __HAL_RCC_FSMC_CLK_ENABLE()     do{ }while(0U)
+#define __HAL_RCC_RTC_ENABLE()          do{ }while(0U)
+#define __HAL_AFIO_REMAP_TIM3_PARTIAL() do{ }while(0U)
+
+HAL_StatusTypeDef HAL_RCC_OscConfig(RCC_OscInitTypeDef *RCC_OscInitStruct);
+HAL_StatusTypeDef HAL_RCC_ClockConfig(RCC_ClkInitTypeDef *RCC_ClkInitStruct, uint32_t FLatency);
+HAL_StatusTypeDef HAL_RCCEx_PeriphCLKConfig(RCC_PeriphCLKInitTypeDef *PeriphClkInit);
+
+/******************************************************************************************/
+/* 内核: 初始化, 节拍, NVIC */
+
+extern volatile uint32_t uwTick;
+
+HAL_StatusTypeDef HAL_Init(void);
+void HAL_IncTick(void);
+uint32_t HAL_GetTick(void);
+void HAL_Delay(uint32_t Delay);
+void HAL_SuspendTick(void);
+void HAL_ResumeTick(void);
+
+#define NVIC_PRIORITYGROUP_2        0x00000005U
+
+void HAL_NVIC_SetPriorityGrouping(uint32_t PriorityGroup);
+void HAL_NVIC_SetPriority(IRQn_Type IRQn, uint32_t PreemptPriority, uint32_t SubPriority);
+void HAL_NVIC_EnableIRQ(IRQn_Type IRQn);
+void HAL_NVIC_DisableIRQ(IRQn_Type IRQn);
+void HAL_NVIC_SetPendingIRQ(IRQn_Type IRQn);
+void HAL_NVIC_ClearPendingIRQ(IRQn_Type IRQn);
+
+/******************************************************************************************/
+/* GPIO */
+
+typedef struct
+{
+    uint32_t Pin;
+    uint32_t Mode;
+    uint32_t Pull;
+    uint32_t Speed;
+} GPIO_InitTypeDef;
+
+typedef enum
+{
+    GPIO_PIN_RESET = 0U,
+    GPIO_PIN_SET
+} GPIO_PinState;
+
+#define GPIO_PIN_0                  ((uint16_t)0x0001)
+#define GPIO_PIN_1                  ((uint16_t)0x0002)
+#define GPIO_PIN_2                  ((uint16_t)0x0004)
+#define GPIO_PIN_3                  ((uint16_t)0x0008)
+#define GPIO_PIN_4                  ((uint16_t)0x0010)
+#define GPIO_PIN_5                  ((uint16_t)0x0020)
+#define GPIO_PIN_6                  ((uint16_t)0x0040)
+#define GPIO_PIN_7                  ((uint16_t)0x0080)
+#define GPIO_PIN_8                  ((uint16_t)0x0100)
+#define GPIO_PIN_9                  ((uint16_t)0x0200)
+#define GPIO_PIN_10                 ((uint16_t)0x0400)
+#define GPIO_PIN_11                 ((uint16_t)0x0800)
+#define GPIO_PIN_12                 ((uint16_t)0x1000)
+#define GPIO_PIN_13                 ((uint16_t)0x2000)
+#define GPIO_PIN_14                 ((uint16_t)0x4000)
+#define GPIO_PIN_15                 ((uint16_t)0x8000)
+#define GPIO_PIN_All                ((uint16_t)0xFFFF)
+
+#define GPIO_MODE_INPUT             0x00000000U
+#define GPIO_MODE_OUTPUT_PP         0x00000001U
+#define GPIO_MODE_OUTPUT_OD         0x00000011U
+#define GPIO_MODE_AF_PP             0x00000002U
+#define GPIO_MODE_AF_OD             0x00000012U
+#define GPIO_MODE_AF_INPUT          GPIO_MODE_INPUT
+#define GPIO_MODE_ANALOG            0x00000003U
+#define GPIO_NOPULL                 0x00000000U
+#define GPIO_PULLUP                 0x00000001U
+#define GPIO_PULLDOWN               0x00000002U
+#define GPIO_SPEED_FREQ_LOW         0x00000002U
+#define GPIO_SPEED_FREQ_MEDIUM      0x00000001U
+#define GPIO_SPEED_FREQ_HIGH        0x00000003U
+
+void HAL_GPIO_Init(GPIO_TypeDef *GPIOx, GPIO_InitTypeDef *GPIO_Init);
+GPIO_PinState HAL_GPIO_ReadPin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin);
+void HAL_GPIO_WritePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin, GPIO_PinState PinState);
+void HAL_GPIO_TogglePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin);
+
+/******************************************************************************************/
+/* DMA */
+
+typedef struct
+{
+    uint32_t Direction;
+    uint32_t PeriphInc;
+    uint32_t MemInc;
+    uint32_t PeriphDataAlignment;
+    uint32_t MemDataAlignment;
+    uint32_t Mode;
+    uint32_t Priority;
+} DMA_InitTypeDef;
+
+typedef enum
+{
+    HAL_DMA_STATE_RESET = 0x00U,
+    HAL_DMA_STATE_READY = 0x01U,
+    HAL_DMA_STATE_BUSY = 0x02U,
+    HAL_DMA_STATE_TIMEOUT = 0x03U
+} HAL_DMA_StateTypeDef;
+
+typedef struct __DMA_HandleTypeDef
+{
+    DMA_Channel_TypeDef *Instance;
+    DMA_InitTypeDef Init;
+    HAL_LockTypeDef Lock;
+    HAL_DMA_StateTypeDef State;
+    void *Parent;
+    void (*XferCpltCallback)(struct __DMA_HandleTypeDef *hdma);
+    void (*XferHalfCpltCallback)(struct __DMA_HandleTypeDef *hdma);
+    void (*XferErrorCallback)(struct __DMA_HandleTypeDef *hdma);
+    void (*XferAbortCallback)(struct __DMA_HandleTypeDef *hdma);
+    volatile uint32_t ErrorCode;
+} DMA_HandleTypeDef;
+
+#define DMA_PERIPH_TO_MEMORY        0x00000000U
+#define DMA_MEMORY_TO_PERIPH        DMA_CCR_DIR
+#define DMA_MEMORY_TO_MEMORY        DMA_CCR_MEM2MEM
+#define DMA_PINC_ENABLE             DMA_CCR_PINC
+#define DMA_PINC_DISABLE            0x00000000U
+#define DMA_MINC_ENABLE             DMA_CCR_MINC
+#define DMA_MINC_DISABLE            0x00000000U
+#define DMA_PDATAALIGN_BYTE         0x00000000U
+#define DMA_PDATAALIGN_HALFWORD     0x00000100U
+#define DMA_PDATAALIGN_WORD         0x00000200U
+#define DMA_MDATAALIGN_BYTE         0x00000000U
+#define DMA_MDATAALIGN_HALFWORD     0x00000400U
+#define DMA_MDATAALIGN_WORD         0x00000800U
+#define DMA_NORMAL                  0x00000000U
+#define DMA_CIRCULAR                DMA_CCR_CIRC
+#define DMA_PRIORITY_LOW            0x00000000U
+#define DMA_PRIORITY_MEDIUM         0x00001000U
+#define DMA_PRIORITY_HIGH           0x00002000U
+#define DMA_PRIORITY_VERY_HIGH      0x00003000U
+
+#define DMA_IT_TC                   DMA_CCR_TCIE
+#define DMA_IT_HT                   DMA_CCR_HTIE
+#define DMA_IT_TE                   DMA_CCR_TEIE
+
+uint32_t sim_dma_get_counter(DMA_HandleTypeDef *hdma);
+
+#define __HAL_DMA_GET_COUNTER(__HANDLE__)   sim_dma_get_counter(__HANDLE__)
+#define __HAL_DMA_ENABLE_IT(__HANDLE__, __INTERRUPT__)  SET_BIT((__HANDLE__)->Instance->CCR, (__INTERRUPT__))
+#define __HAL_DMA_DISABLE_IT(__HANDLE__, __INTERRUPT__) CLEAR_BIT((__HANDLE__)->Instance->CCR, (__INTERRUPT__))
+
+HAL_StatusTypeDef HAL_DMA_Init(DMA_HandleTypeDef *hdma);
+HAL_StatusTypeDef HAL_DMA_Start(DMA_HandleTypeDef *hdma, uint32_t SrcAddress, uint32_t DstAddress, uint32_t DataLength);
+HAL_StatusTypeDef HAL_DMA_Start_IT(DMA_HandleTypeDef *hdma, uint32_t SrcAddress, uint32_t DstAddress, uint32_t DataLength);
+HAL_StatusTypeDef HAL_DMA_Abort(DMA_HandleTypeDef *hdma);
+void HAL_DMA_IRQHandler(DMA_HandleTypeDef *hdma);
+HAL_DMA_StateTypeDef HAL_DMA_GetState(DMA_HandleTypeDef *hdma);
+
+/******************************************************************************************/
+/* TIM */
+
+typedef struct
+{
+    uint32_t Prescaler;
+    uint32_t CounterMode;
+    uint32_t Period;
+    uint32_t ClockDivision;
+    uint32_t RepetitionCounter;
+    uint32_t AutoReloadPreload;
+} TIM_Base_InitTypeDef;
+
+typedef struct
+{
+    uint32_t OCMode;
+    uint32_t Pulse;
+    uint32_t OCPolarity;
+    uint32_t OCNPolarity;
+    uint32_t OCFastMode;
+    uint32_t OCIdleState;
+    uint32_t OCNIdleState;
+} TIM_OC_InitTypeDef;
+
+typedef struct
+{
+    uint32_t ClockSource;
+    uint32_t ClockPolarity;
+    uint32_t ClockPrescaler;
+    uint32_t ClockFilter;
+} TIM_ClockConfigTypeDef;
+
+typedef struct
+{
+    uint32_t MasterOutputTrigger;
+    uint32_t MasterSlaveMode;
+} TIM_MasterConfigTypeDef;
+
+typedef enum
+{
+    HAL_TIM_STATE_RESET = 0x00U,
+    HAL_TIM_STATE_READY = 0x01U,
+    HAL_TIM_STATE_BUSY = 0x02U
+} HAL_TIM_StateTypeDef;
+
+typedef struct
+{
+    TIM_TypeDef *Instance;
+    TIM_Base_InitTypeDef Init;
+    uint32_t Channel;
+    DMA_HandleTypeDef *hdma[7];
+    HAL_LockTypeDef Lock;
+    volatile HAL_TIM_StateTypeDef State;
+} TIM_HandleTypeDef;
+
+#define TIM_COUNTERMODE_UP              0x00000000U
+#define TIM_CLOCKDIVISION_DIV1          0x00000000U
+#define TIM_AUTORELOAD_PRELOAD_DISABLE  0x00000000U
+#define TIM_AUTORELOAD_PRELOAD_ENABLE   0x00000080U
+#define TIM_CLOCKSOURCE_INTERNAL        0x00001000U
+#define TIM_CHANNEL_1                   0x00000000U
+#define TIM_CHANNEL_2                   0x00000004U
+#define TIM_CHANNEL_3                   0x00000008U
+#define TIM_CHANNEL_4                   0x0000000CU
+#define TIM_OCMODE_TIMING               0x00000000U
+#define TIM_OCMODE_PWM1                 0x00000060U
+#define TIM_OCMODE_PWM2                 0x00000070U
+#define TIM_OCPOLARITY_HIGH             0x00000000U
+#define TIM_OCPOLARITY_LOW              0x00000002U
+#define TIM_OCFAST_DISABLE              0x00000000U
+#define TIM_TRGO_RESET                  0x00000000U
+#define TIM_TRGO_UPDATE                 0x00000020U
+#define TIM_TRGO_OC1REF                 0x00000040U
+#define TIM_MASTERSLAVEMODE_DISABLE     0x00000000U
+#define TIM_FLAG_UPDATE                 TIM_SR_UIF
+#define TIM_IT_UPDATE                   TIM_DIER_UIE
+
+void sim_tim_enable(TIM_HandleTypeDef *htim);
+void sim_tim_disable(TIM_HandleTypeDef *htim);
+uint32_t sim_tim_get_counter(TIM_HandleTypeDef *htim);
+void sim_tim_set_counter(TIM_HandleTypeDef *htim, uint32_t counter);
+void sim_tim_set_autoreload(TIM_HandleTypeDef *htim, uint32_t arr);
+void sim_tim_set_compare(TIM_HandleTypeDef *htim, uint32_t channel, uint32_t compare);
+uint32_t sim_tim_get_flag(TIM_HandleTypeDef *htim, uint32_t flag);
+void sim_tim_clear_flag(TIM_HandleTypeDef *htim, uint32_t flag);
+void sim_tim_enable_it(TIM_HandleTypeDef *htim, uint32_t it);
+
+#define __HAL_TIM_ENABLE(__HANDLE__)                    sim_tim_enable(__HANDLE__)
+#define __HAL_TIM_DISABLE(__HANDLE__)                   sim_tim_disable(__HANDLE__)
+#define __HAL_TIM_GET_COUNTER(__HANDLE__)               sim_tim_get_counter(__HANDLE__)
+#define __HAL_TIM_SET_COUNTER(__HANDLE__, __COUNTER__)  sim_tim_set_counter((__HANDLE__), (__COUNTER__))
+#define __HAL_TIM_SET_AUTORELOAD(__HANDLE__, __ARR__)   sim_tim_set_autoreload((__HANDLE__), (__ARR__))
+#define __HAL_TIM_GET_AUTORELOAD(__HANDLE__)            ((__HANDLE__)->Instance->ARR)
+#define __HAL_TIM_SET_COMPARE(__HANDLE__, __CH__, __CMP__) sim_tim_set_compare((__HANDLE__), (__CH__), (__CMP__))
+#define __HAL_TIM_GET_FLAG(__HANDLE__, __FLAG__)        sim_tim_get_flag((__HANDLE__), (__FLAG__))
+#define __HAL_TIM_CLEAR_FLAG(__HANDLE__, __FLAG__)      sim_tim_clear_flag((__HANDLE__), (__FLAG__))
+#define __HAL_TIM_ENABLE_IT(__HANDLE__, __IT__)         sim_tim_enable_it((__HANDLE__), (__IT__))
+
+HAL_StatusTypeDef HAL_TIM_Base_Init(TIM_HandleTypeDef *htim);
+HAL_StatusTypeDef HAL_TIM_Base_Start(TIM_HandleTypeDef *htim);
+HAL_StatusTypeDef HAL_TIM_Base_Start_IT(TIM_HandleTypeDef *htim);
+HAL_StatusTypeDef HAL_TIM_ConfigClockSource(TIM_HandleTypeDef *htim, TIM_ClockConfigTypeDef *sClockSourceConfig);
+HAL_StatusTypeDef HAL_TIM_PWM_Init(TIM_HandleTypeDef *htim);
+HAL_StatusTypeDef HAL_TIM_PWM_ConfigChannel(TIM_HandleTypeDef *htim, TIM_OC_InitTypeDef *sConfig, uint32_t Channel);
+HAL_StatusTypeDef HAL_TIM_PWM_Start(TIM_HandleTypeDef *htim, uint32_t Channel);
+HAL_StatusTypeDef HAL_TIM_PWM_Stop(TIM_HandleTypeDef *htim, uint32_t Channel);
+HAL_StatusTypeDef HAL_TIMEx_MasterConfigSynchronization(TIM_HandleTypeDef *htim, TIM_MasterConfigTypeDef *sMasterConfig);
+void HAL_TIM_IRQHandler(TIM_HandleTypeDef *htim);
+void HAL_TIM_Base_MspInit(TIM_HandleTypeDef *htim);
+void HAL_TIM_PWM_MspInit(TIM_HandleTypeDef *htim);
+void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef *htim);
+
+/******************************************************************************************/
+/* UART */
+
+typedef struct
+{
+    uint32_t BaudRate;
+    uint32_t WordLength;
+    uint32_t StopBits;
+    uint32_t Parity;
+    uint32_t Mode;
+    uint32_t HwFlowCtl;
+    uint32_t OverSampling;
+} UART_InitTypeDef;
+
+typedef enum
+{
+    HAL_UART_STATE_RESET = 0x00U,
+    HAL_UART_STATE_READY = 0x20U,
+    HAL_UART_STATE_BUSY = 0x24U,
+    HAL_UART_STATE_BUSY_TX = 0x21U,
+    HAL_UART_STATE_BUSY_RX = 0x22U
+} HAL_UART_StateTypeDef;
+
+typedef struct __UART_HandleTypeDef
+{
+    USART_TypeDef *Instance;
+    UART_InitTypeDef Init;
+    const uint8_t *pTxBuffPtr;
+    uint16_t TxXferSize;
+    volatile uint16_t TxXferCount;
+    uint8_t *pRxBuffPtr;
+    uint16_t RxXferSize;
+    volatile uint16_t RxXferCount;
+    DMA_HandleTypeDef *hdmatx;
+    DMA_HandleTypeDef *hdmarx;
+    HAL_LockTypeDef Lock;
+    volatile HAL_UART_StateTypeDef gState;
+    volatile HAL_UART_StateTypeDef RxState;
+    volatile uint32_t ErrorCode;
+} UART_HandleTypeDef;
+
+#define UART_WORDLENGTH_8B          0x00000000U
+#define UART_STOPBITS_1             0x00000000U
+#define UART_PARITY_NONE            0x00000000U
+#define UART_MODE_TX_RX             0x0000000CU
+#define UART_HWCONTROL_NONE         0x00000000U
+#define UART_OVERSAMPLING_16        0x00000000U
+
+/* 中断使能位直接对应CR1 */
+#define UART_IT_IDLE                USART_CR1_IDLEIE
+#define UART_IT_RXNE                USART_CR1_RXNEIE
+#define UART_IT_TC                  USART_CR1_TCIE
+#define UART_IT_TXE                 USART_CR1_TXEIE
+
+#define __HAL_UART_ENABLE_IT(__HANDLE__, __IT__)    SET_BIT((__HANDLE__)->Instance->CR1, (__IT__))
+#define __HAL_UART_DISABLE_IT(__HANDLE__, __IT__)   CLEAR_BIT((__HANDLE__)->Instance->CR1, (__IT__))
+
+HAL_StatusTypeDef HAL_UART_Init(UART_HandleTypeDef *huart);
+HAL_StatusTypeDef HAL_UART_Transmit(UART_HandleTypeDef *huart, const uint8_t *pData, uint16_t Size, uint32_t Timeout);
+HAL_StatusTypeDef HAL_UART_Transmit_DMA(UART_HandleTypeDef *huart, const uint8_t *pData, uint16_t Size);
+HAL_StatusTypeDef HAL_UART_Receive_IT(UART_HandleTypeDef *huart, uint8_t *pData, uint16_t Size);
+void HAL_UART_IRQHandler(UART_HandleTypeDef *huart);
+void HAL_UART_MspInit(UART_HandleTypeDef *huart);
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart);
+void HAL_UART_RxCpltCallback(UART_HandleTypeDef *huart);
+
+/******************************************************************************************/
+/* ADC */
+
+typedef struct
+{
+    uint32_t DataAlign;
+    uint32_t ScanConvMode;
+    FunctionalState ContinuousConvMode;
+    uint32_t NbrOfConversion;
+    FunctionalState DiscontinuousConvMode;
+    uint32_t NbrOfDiscConversion;
+    uint32_t ExternalTrigConv;
+} ADC_InitTypeDef;
+
+typedef struct
+{
+    uint32_t Channel;
+    uint32_t Rank;
+    uint32_t SamplingTime;
+} ADC_ChannelConfTypeDef;
+
+typedef struct __ADC_HandleTypeDef
+{
+    ADC_TypeDef *Instance;
+    ADC_InitTypeDef Init;
+    DMA_HandleTypeDef *DMA_Handle;
+    HAL_LockTypeDef Lock;
+    volatile uint32_t State;
+    volatile uint32_t ErrorCode;
+} ADC_HandleTypeDef;
+
+#define ADC_DATAALIGN_RIGHT             0x00000000U
+#define ADC_SCAN_DISABLE                0x00000000U
+#define ADC_SCAN_ENABLE                 0x00000100U
+#define ADC_EXTERNALTRIGCONV_T3_TRGO    0x00080000U
+#define ADC_SOFTWARE_START              0x000E0000U
+#define ADC_CHANNEL_0                   0x00000000U
+#define ADC_CHANNEL_1                   0x00000001U
+#define ADC_CHANNEL_2                   0x00000002U
+#define ADC_CHANNEL_3                   0x00000003U
+#define ADC_REGULAR_RANK_1              0x00000001U
+#define ADC_REGULAR_RANK_2              0x00000002U
+#define ADC_REGULAR_RANK_3              0x00000003U
+#define ADC_REGULAR_RANK_4              0x00000004U
+#define ADC_SAMPLETIME_1CYCLE_5         0x00000000U
+#define ADC_SAMPLETIME_7CYCLES_5        0x00000001U
+#define ADC_SAMPLETIME_13CYCLES_5       0x00000002U
+#define ADC_SAMPLETIME_28CYCLES_5       0x00000003U
+#define ADC_SAMPLETIME_41CYCLES_5       0x00000004U
+#define ADC_SAMPLETIME_55CYCLES_5       0x00000005U
+#define ADC_SAMPLETIME_71CYCLES_5       0x00000006U
+#define ADC_SAMPLETIME_239CYCLES_5      0x00000007U
+
+HAL_StatusTypeDef HAL_ADC_Init(ADC_HandleTypeDef *hadc);
+HAL_StatusTypeDef HAL_ADC_ConfigChannel(ADC_HandleTypeDef *hadc, ADC_ChannelConfTypeDef *sConfig);
+HAL_StatusTypeDef HAL_ADCEx_Calibration_Start(ADC_HandleTypeDef *hadc);
+HAL_StatusTypeDef HAL_ADC_Start_DMA(ADC_HandleTypeDef *hadc, uint32_t *pData, uint32_t Length);
+void HAL_ADC_MspInit(ADC_HandleTypeDef *hadc);
+void HAL_ADC_ConvCpltCallback(ADC_HandleTypeDef *hadc);
+void HAL_ADC_ConvHalfCpltCallback(ADC_HandleTypeDef *hadc);
+
+/******************************************************************************************/
+/* SPI(字节收发由Host/sim/sim_spi.c实现, 这里只有句柄和常量) */
+
+typedef struct
+{
+    uint32_t Mode;
+    uint32_t Direction;
+    uint32_t DataSize;
+    uint32_t CLKPolarity;
+    uint32_t CLKPhase;
+    uint32_t NSS;
+    uint32_t BaudRatePrescaler;
+    uint32_t FirstBit;
+    uint32_t TIMode;
+    uint32_t CRCCalculation;
+    uint32_t CRCPolynomial;
+} SPI_InitTypeDef;
+
+typedef struct
+{
+    SPI_TypeDef *Instance;
+    SPI_InitTypeDef Init;
+    HAL_LockTypeDef Lock;
+    volatile uint32_t State;
+    volatile uint32_t ErrorCode;
+} SPI_HandleTypeDef;
+
+#define SPI_MODE_MASTER                 0x00000104U
+#define SPI_DIRECTION_2LINES            0x00000000U
+#define SPI_DATASIZE_8BIT               0x00000000U
+#define SPI_POLARITY_HIGH               0x00000002U
+#define SPI_PHASE_2EDGE                 0x00000001U
+#define SPI_NSS_SOFT                    0x00000200U
+#define SPI_BAUDRATEPRESCALER_2         0x00000000U
+#define SPI_BAUDRATEPRESCALER_256       0x00000038U
+#define SPI_FIRSTBIT_MSB                0x00000000U
+#define SPI_TIMODE_DISABLE              0x00000000U
+#define SPI_CRCCALCULATION_DISABLE      0x00000000U
+
+#define __HAL_SPI_ENABLE(__HANDLE__)    SET_BIT((__HANDLE__)->Instance->CR1, SPI_CR1_SPE)
+#define __HAL_SPI_DISABLE(__HANDLE__)   CLEAR_BIT((__HANDLE__)->Instance->CR1, SPI_CR1_SPE)
+
+HAL_StatusTypeDef HAL_SPI_Init(SPI_HandleTypeDef *hspi);
+void HAL_SPI_MspInit(SPI_HandleTypeDef *hspi);
+
+/******************************************************************************************/
+/* FSMC / SRAM(LCD总线) */
+
+typedef FSMC_Bank1_TypeDef FSMC_NORSRAM_TypeDef;
+typedef FSMC_Bank1E_TypeDef FSMC_NORSRAM_EXTENDED_TypeDef;
+
+typedef struct
+{
+    uint32_t NSBank;
+    uint32_t DataAddressMux;
+    uint32_t MemoryType;
+    uint32_t MemoryDataWidth;
+    uint32_t BurstAccessMode;
+    uint32_t WaitSignalPolarity;
+    uint32_t WrapMode;
+    uint32_t WaitSignalActive;
+    uint32_t WriteOperation;
+    uint32_t WaitSignal;
+    uint32_t ExtendedMode;
+    uint32_t AsynchronousWait;
+    uint32_t WriteBurst;
+} FSMC_NORSRAM_InitTypeDef;
+
+typedef struct
+{
+    uint32_t AddressSetupTime;
+    uint32_t AddressHoldTime;
+    uint32_t DataSetupTime;
+    uint32_t BusTurnAroundDuration;
+    uint32_t CLKDivision;
+    uint32_t DataLatency;
+    uint32_t AccessMode;
+} FSMC_NORSRAM_TimingTypeDef;
+
+typedef struct
+{
+    FSMC_NORSRAM_TypeDef *Instance;
+    FSMC_NORSRAM_EXTENDED_TypeDef *Extended;
+    FSMC_NORSRAM_InitTypeDef Init;
+    HAL_LockTypeDef Lock;
+    volatile uint32_t State;
+} SRAM_HandleTypeDef;
+
+#define FSMC_NORSRAM_DEVICE                 FSMC_Bank1
+#define FSMC_NORSRAM_EXTENDED_DEVICE        FSMC_Bank1E
+#define FSMC_NORSRAM_BANK4                  0x00000006U
+#define FSMC_DATA_ADDRESS_MUX_DISABLE       0x00000000U
+#define FSMC_NORSRAM_MEM_BUS_WIDTH_16       0x00000010U
+#define FSMC_BURST_ACCESS_MODE_DISABLE      0x00000000U
+#define FSMC_WAIT_SIGNAL_POLARITY_LOW       0x00000000U
+#define FSMC_WAIT_TIMING_BEFORE_WS          0x00000000U
+#define FSMC_WRITE_OPERATION_ENABLE         0x00001000U
+#define FSMC_WAIT_SIGNAL_DISABLE            0x00000000U
+#define FSMC_EXTENDED_MODE_ENABLE           0x00004000U
+#define FSMC_ASYNCHRONOUS_WAIT_DISABLE      0x00000000U
+#define FSMC_WRITE_BURST_DISABLE            0x00000000U
+#define FSMC_ACCESS_MODE_A                  0x00000000U
+
+HAL_StatusTypeDef HAL_SRAM_Init(SRAM_HandleTypeDef *hsram, FSMC_NORSRAM_TimingTypeDef *Timing, FSMC_NORSRAM_TimingTypeDef *ExtTiming);
+void HAL_SRAM_MspInit(SRAM_HandleTypeDef *hsram);
+
+/******************************************************************************************/
+/* PWR */
+
+#define PWR_MAINREGULATOR_ON            0x00000000U
+#define PWR_LOWPOWERREGULATOR_ON        0x00000001U
+#define PWR_SLEEPENTRY_WFI              0x01U
+#define PWR_STOPENTRY_WFI               0x01U
+
+void HAL_PWR_EnableBkUpAccess(void);
+void HAL_PWR_EnterSLEEPMode(uint32_t Regulator, uint8_t SLEEPEntry);
+void HAL_PWR_EnterSTOPMode(uint32_t Regulator, uint8_t STOPEntry);
+
+#endif
@@ -0,0 +1,173 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+生成MQ-7和GP2Y1014AU的ADC->物理量插值表, 并对全部4096个ADC码值做校验.
+
+用法:
+    python3 gen_curve_tables.py            生成表并校验
+    python3 gen_curve_tables.py --check    只校验已提交的表与公式是否一致, 不写文件
+
+表按ADC码值等间隔取点(间隔 1 << CURVE_SHIFT), 运行时按
+    y = tab[i] + ((tab[i + 1] - tab[i]) * frac >> CURVE_SHIFT)
+线性插值, 输出单位为0.1ppm / 0.1ug/m3. 校验用与C代码完全相同的整数运算,
+误差需小于 max(0.15, 0.5% * 真值), 否则返回非0.
+"""
+
+import os
+import sys
+
+ADC_BITS = 12
+ADC_MAX = (1 << ADC_BITS) - 1
+CURVE_SHIFT = 6
+CURVE_STEP = 1 << CURVE_SHIFT
+CURVE_POINTS = (1 << ADC_BITS) // CURVE_STEP + 1
+
+ROOT = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "Drivers", "BSP")
+
+
+def mq7_ppm(code):
+    """mq7.c中原浮点公式(未限幅)"""
+    if code == 0:
+        code = 1
+    rs_r0 = (4095.0 - code) / code
+    if rs_r0 <= 0:
+        return float("inf")
+    return 98.322 * rs_r0 ** -1.458
+
+
+def gp2y_density(code):
+    """gp2y1014au.c中原浮点公式(未限幅), 电压3.3V / 4096"""
+    voltage = code * (3300.0 / 4096.0)
+    return (voltage - 600.0) / 10.0
+
+
+CURVES = [
+    {
+        "name": "mq7",
+        "path": os.path.join(ROOT, "MQ7", "mq7_curve.h"),
+        "guard": "__MQ7_CURVE_H",
+        "brief": "MQ-7 ADC码值到CO浓度(0.1ppm)插值表",
+        "formula": "ppm = 98.322 * pow((4095 - adc) / adc, -1.458)",
+        "func": mq7_ppm,
+        "type": "uint16_t",
+        "range": (0, 65535),
+        "clamp": (100, 10000),          # 10 ~ 1000ppm
+        "prefix": "MQ7_CURVE",
+    },
+    {
+        "name": "gp2y1014au",
+        "path": os.path.join(ROOT, "GP2Y1014AU", "gp2y1014au_curve.h"),
+        "guard": "__GP2Y1014AU_CURVE_H",
+        "brief": "GP2Y1014AU ADC码值到粉尘浓度(0.1ug/m3)插值表",
+        "formula": "ug/m3 = (adc * 3300 / 4096 - 600) / 10",
+        "func": gp2y_density,
+        "type": "int16_t",
+        "range": (-32768, 32767),
+        "clamp": (0, 5000),             # 0 ~ 500ug/m3
+        "prefix": "GP2Y1014AU_CURVE",
+    },
+]
+
+
+def build_table(curve):
+    lo, hi = curve["range"]
+    table = []
+    for i in range(CURVE_POINTS):
+        code = i * CURVE_STEP
+        # 最后一个点在4096处, 只用于插值, 限幅后不会影响结果
+        value = curve["func"](min(code, ADC_MAX + 1))
+        value = hi if value == float("inf") else int(round(value * 10))
+        table.append(min(max(value, lo), hi))
+    return table
+
+
+def lookup(table, clamp, code):
+    """与C代码一致的整数插值"""
+    i = code >> CURVE_SHIFT
+    frac = code & (CURVE_STEP - 1)
+    y = table[i] + (((table[i + 1] - table[i]) * frac) >> CURVE_SHIFT)
+    return min(max(y, clamp[0]), clamp[1])
+
+
+def validate(curve, table):
+    lo, hi = curve["clamp"]
+    worst = 0.0
+    worst_code = 0
+    for code in range(ADC_MAX + 1):
+        expect = min(max(curve["func"](code), lo / 10.0), hi / 10.0)
+        got = lookup(table, curve["clamp"], code) / 10.0
+        ratio = abs(got - expect) / max(0.15, 0.005 * expect)
+        if ratio > worst:
+            worst = ratio
+            worst_code = code
+    return worst, worst_code
+
+
+def render(curve, table):
+    lines = []
+    lines.append("/**")
+    lines.append(" " + "*" * 100)
+    lines.append(" * @file        %s" % os.path.basename(curve["path"]))
+    lines.append(" * @author      正点原子团队(ALIENTEK)")
+    lines.append(" * @version     V1.0")
+    lines.append(" * @date        2023-06-05")
+    lines.append(" * @brief       %s" % curve["brief"])
+    lines.append(" * @license     Copyright (c) 2020-2032, 广州市星翼电子科技有限公司")
+    lines.append(" " + "*" * 100)
+    lines.append(" * @attention")
+    lines.append(" *")
+    lines.append(" * 本文件由Tools/gen_curve_tables.py生成, 请勿手工修改.")
+    lines.append(" * 公式: %s" % curve["formula"])
+    lines.append(" * 每%d个ADC码值取一个点, 共%d个点, 线性插值后与公式的误差不超过0.15或0.5%%." % (CURVE_STEP, CURVE_POINTS))
+    lines.append(" *")
+    lines.append(" " + "*" * 100)
+    lines.append(" */")
+    lines.append("")
+    lines.append("#ifndef %s" % curve["guard"])
+    lines.append("#define %s" % curve["guard"])
+    lines.append("")
+    lines.append("#define %s_SHIFT%s%d" % (curve["prefix"], " " * max(1, 24 - len(curve["prefix"]) - 6), CURVE_SHIFT))
+    lines.append("#define %s_MIN%s%d" % (curve["prefix"], " " * max(1, 24 - len(curve["prefix"]) - 4), curve["clamp"][0]))
+    lines.append("#define %s_MAX%s%d" % (curve["prefix"], " " * max(1, 24 - len(curve["prefix"]) - 4), curve["clamp"][1]))
+    lines.append("")
+    lines.append("static const %s g_%s_curve[%d] =" % (curve["type"], curve["name"], CURVE_POINTS))
+    lines.append("{")
+    for i in range(0, CURVE_POINTS, 8):
+        row = ", ".join("%6d" % v for v in table[i:i + 8])
+        comma = "," if i + 8 < CURVE_POINTS else ""
+        lines.append("    %s%s" % (row, comma))
+    lines.append("};")
+    lines.append("")
+    lines.append("#endif")
+    lines.append("")
+    return "\n".join(lines)
+
+
+def main():
+    check_only = "--check" in sys.argv
+    failed = False
+
+    for curve in CURVES:
+        table = build_table(curve)
+        worst, code = validate(curve, table)
+        status = "OK" if worst <= 1.0 else "FAIL"
+        print("%-12s %d点  最大误差/容差 = %.3f (ADC=%d)  %s" % (curve["name"], CURVE_POINTS, worst, code, status))
+        if worst > 1.0:
+            failed = True
+            continue
+
+        text = render(curve, table)
+        if check_only:
+            with open(curve["path"], encoding="utf-8") as f:
+                if f.read() != text:
+                    print("%s 与公式不一致, 请重新生成" % curve["path"])
+                    failed = True
+        else:
+            with open(curve["path"], "w", encoding="utf-8", newline="\n") as f:
+                f.write(text)
+
+    return 1 if failed else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -1,37 +1,268 @@
+#include <string.h>
 #include "./SYSTEM/sys/sys.h"
 #include "./SYSTEM/usart/usart.h"
 #include "./SYSTEM/delay/delay.h"
+#include "./SYSTEM/sched/sched.h"
+#include "./SYSTEM/prof/prof.h"
 #include "./USMART/usmart.h"
 #include "./BSP/LED/led.h"
 #include "./BSP/LCD/lcd.h"
+#include "./BSP/WIDGET/widget.h"
+#include "./BSP/WIDGET/chart.h"
 #include "./BSP/DHT11/dht11.h"
-#include "./BSP/MQ7/mq7.h"
-#include "./BSP/GP2Y1014AU/gp2y1014au.h"
+#include "./BSP/ADC/adc.h"
+#include "./BSP/SENSOR/sensor.h"
+#include "./BSP/SENSOR/sensor_history.h"
+#include "./BSP/SENSOR/sensor_log.h"
+#include "./BSP/NORFLASH/norflash.h"
 #include "./BSP/SENSOR_UART/sensor_uart.h"
 #include "./BSP/SENSOR_UART/sensor_uart3.h"
+#include "./BSP/SENSOR_UART/sensor_cmd.h"
 #include "./BSP/BEEP/beep.h"
+#include "./BSP/PWR/pwr.h"
+#include "./BSP/RTC/rtc.h"
 
 
+/**
+ * @brief       传感器任务, 每SENSOR_SERVICE_PERIOD_MS
+ * @note        各传感器按自己的周期启动和取结果, 见sensor.h
+ */
+static void task_sensor(void)
+{
+    sensor_service();
+}
+
+/**
+ * @brief       报警任务, 每100ms
+ */
+static void task_alarm(void)
+{
+    const sensor_sample_t *s = sensor_get_sample();
+
+    PROF_START(PROF_ZONE_ALARM);
+    beep_alarm_handler(s->temperature, s->humidity, s->co_x10, s->dust_x10);
+    PROF_STOP(PROF_ZONE_ALARM);
+}
+
+/**
+ * @brief       USART3任务, 每SENSOR_UART3_SEND_PERIOD_MS, 发送数据到ESP32(ESP32端做窗口聚合后再上云)
+ */
+static void task_uart3(void)
+{
+    PROF_START(PROF_ZONE_UART3);
+    sensor_uart3_send_data(sensor_get_sample());
+    PROF_STOP(PROF_ZONE_UART3);
+}
+
+/**
+ * @brief       USART3接收任务, 每SENSOR_UART3_RX_POLL_MS, 处理ESP32的校时和补传请求帧
+ */
+static void task_uart3_rx(void)
+{
+    sensor_uart3_poll();
+}
+
+/**
+ * @brief       历史记录任务, 每SENSOR_HISTORY_PERIOD_MS, 记录当前样本并发给ESP32
+ */
+static void task_history(void)
+{
+    sensor_sample_t rec = *sensor_get_sample();
+
+    rec.alarm_mask = g_current_alarm_mask;
+    sensor_uart3_send_record(sensor_history_add(&rec), &rec);
+}
+
+/**
+ * @brief       FLASH日志任务, 每SENSOR_LOG_PERIOD_MS, 把当前样本追加到SPI FLASH, 掉电后保留约30天
+ */
+static void task_log(void)
+{
+    sensor_sample_t rec = *sensor_get_sample();
+
+    rec.alarm_mask = g_current_alarm_mask;
+    sensor_log_append(&rec);
+}
+
+/**
+ * @brief       USART1任务, 每1000ms, 发送数据到电脑(与DHT11和粉尘的测量周期一致)
+ */
+static void task_uart1(void)
+{
+    const sensor_sample_t *s = sensor_get_sample();
+
+    PROF_START(PROF_ZONE_UART1);
+    sensor_uart_send_data(s->temperature, s->humidity, s->co_x10, s->dust_x10);
+    PROF_STOP(PROF_ZONE_UART1);
+}
+
+/* 状态屏控件, 位置与main中绘制的静态标签对齐 */
+static widget_t s_w_temp;
+static widget_t s_w_humi;
+static widget_t s_w_co;
+static widget_t s_w_dust;
+static widget_t s_w_alarm;
+
+/* 报警名称, 顺序与BEEP_ALARM_xxx一致 */
+static const char *const s_alarm_names[] =
+{
+    "None", "Temp High", "Temp Low", "Humi High", "Humi Low",
+    "CO Normal", "CO Danger!", "Dust Low", "Dust High!",
+};
+
+/**
+ * @brief       初始化状态屏控件
+ */
+static void display_init(void)
+{
+    widget_init(&s_w_temp,  30 + 40, 110, 16, 2,  BLUE, WHITE);
+    widget_init(&s_w_humi,  30 + 40, 130, 16, 2,  BLUE, WHITE);
+    widget_init(&s_w_co,    30 + 40, 150, 16, 5,  BLUE, WHITE);
+    widget_init(&s_w_dust,  30 + 40, 170, 16, 5,  BLUE, WHITE);
+    widget_init(&s_w_alarm, 30 + 56, 190, 16, 10, BLUE, WHITE);
+}
+
+/**
+ * @brief       显示任务, 每200ms
+ * @note        控件只重画变化的字符, 数值不变时不访问LCD
+ */
+static void task_display(void)
+{
+    const sensor_sample_t *s = sensor_get_sample();
+
+    if (lcd_dma_busy())
+    {
+        return;     /* 清屏/填充还在后台进行, 本次不刷新, 不在这里等待 */
+    }
+
+    PROF_START(PROF_ZONE_LCD);
+    widget_set_num(&s_w_temp, s->temperature);
+    widget_set_num(&s_w_humi, s->humidity);
+    widget_set_x10(&s_w_co, s->co_x10);
+    widget_set_x10(&s_w_dust, s->dust_x10);
+
+    /* 显示当前报警状态, 有报警时红底白字 */
+    if (g_current_alarm == BEEP_ALARM_NONE)
+    {
+        widget_set_badge(&s_w_alarm, s_alarm_names[BEEP_ALARM_NONE], BLUE, WHITE);
+    }
+    else if (g_current_alarm < sizeof(s_alarm_names) / sizeof(s_alarm_names[0]))
+    {
+        widget_set_badge(&s_w_alarm, s_alarm_names[g_current_alarm], WHITE, RED);
+    }
+    else
+    {
+        widget_set_badge(&s_w_alarm, "Unknown", BLUE, WHITE);
+    }
+
+    PROF_STOP(PROF_ZONE_LCD);
+}
+
+/**
+ * @brief       趋势图任务, 每CHART_SAMPLE_MS
+ * @note        硬件滚动时每次只写一行, 见chart.h
+ */
+static void task_chart(void)
+{
+    const sensor_sample_t *s = sensor_get_sample();
+
+    chart_add(s->co_x10, s->dust_x10);
+}
+
+/**
+ * @brief       心跳任务, 每200ms
+ */
+static void task_led(void)
+{
+    LED1_TOGGLE(); /* LED1闪烁, LED0所在的PB5用作粉尘传感器LED脉冲 */
+}
+
+/**
+ * @brief       功耗报告任务, 每PWR_REPORT_PERIOD_MS, 通过USART1输出各模式时间占比, 平均电流和唤醒延迟
+ */
+static void task_pwr_report(void)
+{
+    char buf[PWR_REPORT_MAX];
+
+    uart_tx_write(&g_uart1_tx, (uint8_t *)buf, pwr_format_report(buf));
+    pwr_reset_stats();
+}
+
+#if PROF_ENABLE
+/**
+ * @brief       性能报告任务, 通过USART1输出各分区的周期数统计
+ */
+static void task_prof_report(void)
+{
+    char line[PROF_LINE_MAX];
+    uint8_t i;
+
+    for (i = 0; i < PROF_ZONE_NUM; i++)
+    {
+        uart_tx_write(&g_uart1_tx, (uint8_t *)line, prof_format(line, i));
+    }
+}
+
+/**
+ * @brief       USART1命令任务, 每100ms
+ * @note        "prof"输出性能报告, "prof reset"清除统计; 一行以回车换行结束
+ */
+static void task_usart1_cmd(void)
+{
+    uint16_t len;
+
+    if ((g_usart_rx_sta & 0x8000) == 0)
+    {
+        return;
+    }
+
+    len = g_usart_rx_sta & 0x3FFF;
+
+    if (len == 4 && memcmp(g_usart_rx_buf, "prof", 4) == 0)
+    {
+        task_prof_report();
+    }
+    else if (len == 10 && memcmp(g_usart_rx_buf, "prof reset", 10) == 0)
+    {
+        prof_reset();
+    }
+
+    g_usart_rx_sta = 0;
+}
+#endif
+
+/**
+ * @brief       调度器空闲钩子(关中断状态下调用)
+ * @note        只进入SLEEP, 不用STOP的原因见pwr.h
+ * @param       idle_ms: 距下一个任务释放的ms数
+ */
+static void idle_hook(uint32_t idle_ms)
+{
+    (void)idle_ms;
+    pwr_enter_sleep();
+}
+
 int main(void)
 {
-    uint8_t t = 0;
-    uint8_t temperature;
-    uint8_t humidity;
-    float co_ppm;
-		float dust_density;  // 用于存储粉尘浓度
-    uint16_t co_int, co_dec;  // 用于存储CO浓度的整数和小数部分
     uint8_t dht11_retry = 0;  // DHT11初始化重试次数
-		uint16_t dust_int, dust_dec;  // 用于存储粉尘浓度的整数和小数部分
 
     HAL_Init();
     sys_stm32_clock_init(RCC_PLL_MUL9);
     delay_init(72);
+    prof_init();  /* DWT周期计数器, PROF_ENABLE为0时为空 */
     usart_init(115200);
     led_init();
     lcd_init();
-    mq7_init();
-		gp2y1014au_init();
+    sensor_init();  /* MQ-7加热PWM, GP2Y1014AU等, 需在adc_init之前 */
+    adc_init();   /* ADC1定时器触发扫描, 粉尘和CO共用 */
     beep_init();  /* 初始化蜂鸣器 */
+    rtc_init();   /* 样本时间戳, LSE起振失败时时间戳为0 */
+    pwr_init();   /* 空闲低功耗 */
+    norflash_init();
+    sensor_log_mount();   /* 扫描扇区头恢复写入位置, 约20ms */
+    
+    /* USART1挂接DMA发送队列，用于向电脑发送数据 */
+    sensor_uart_init();
     
     /* 初始化UART3，用于与ESP32通信 */
     sensor_uart3_init(115200);
@@ -80,95 +311,29 @@ int main(void)
     lcd_show_string(30, 130, 200, 16, 16, "Humi:  %", BLUE);
     lcd_show_string(30, 150, 200, 16, 16, "CO:          ppm", BLUE);
 		lcd_show_string(30, 170, 200, 16, 16, "Dust:        ug/m3", BLUE);
-    lcd_show_string(30, 190, 200, 16, 16, "Alarm: None", BLUE);
+    lcd_show_string(30, 190, 200, 16, 16, "Alarm:", BLUE);
+    display_init();
+    chart_init();   /* 最近1小时CO/粉尘趋势图 */
 
-    /* 用于计时，每5秒通过USART3发送一次数据到ESP32 */
-    uint32_t last_uart3_send_time = 0;
-    
-    while (1)
-    {
-        if (t % 10 == 0)
-        {
-            dht11_read_data(&temperature, &humidity);
-            co_ppm = mq7_get_co_ppm();                            /* 读取CO浓度 */
-            dust_density = gp2y1014au_get_dust_density();          /* 读取粉尘浓度 */
-            
-            // 将浮点数分解为整数和小数部分
-            co_int = (uint16_t)co_ppm;                            // 整数部分
-            co_dec = (uint16_t)((co_ppm - co_int) * 10);          // 小数部分(取一位小数)
-					
-            dust_int = (uint16_t)dust_density;                    // 整数部分
-            dust_dec = (uint16_t)((dust_density - dust_int) * 10); // 小数部分(取一位小数)
-            
-            lcd_show_num(30 + 40, 110, temperature, 2, 16, BLUE);
-            lcd_show_num(30 + 40, 130, humidity, 2, 16, BLUE);
-            
-            // 分别显示整数和小数部分，并添加小数点
-            lcd_show_num(30 + 40, 150, co_int, 3, 16, BLUE);      // 显示整数部分，3位数字
-            lcd_show_char(30 + 40 + 24, 150, '.', 16, 0, BLUE);   // 显示小数点
-            lcd_show_num(30 + 40 + 32, 150, co_dec, 1, 16, BLUE); // 显示小数部分，1位数字
-					
-            lcd_show_num(30 + 40, 170, dust_int, 3, 16, BLUE);    // 显示整数部分，3位数字
-            lcd_show_char(30 + 40 + 24, 170, '.', 16, 0, BLUE);   // 显示小数点
-            lcd_show_num(30 + 40 + 32, 170, dust_dec, 1, 16, BLUE); // 显示小数部分，1位数字
-            
-            // 处理报警逻辑
-            beep_alarm_handler(temperature, humidity, co_ppm, dust_density);
-            
-            // 显示当前报警状态
-            switch(g_current_alarm) // 需要在beep.c中将g_current_alarm声明为extern
-            {
-                case BEEP_ALARM_NONE:
-                    lcd_show_string(30 + 56, 190, 144, 16, 16, "None      ", BLUE);
-                    break;
-                case BEEP_ALARM_TEMP_HIGH:
-                    lcd_show_string(30 + 56, 190, 144, 16, 16, "Temp High ", RED);
-                    break;
-                case BEEP_ALARM_TEMP_LOW:
-                    lcd_show_string(30 + 56, 190, 144, 16, 16, "Temp Low  ", RED);
-                    break;
-                case BEEP_ALARM_HUMI_HIGH:
-                    lcd_show_string(30 + 56, 190, 144, 16, 16, "Humi High ", RED);
-                    break;
-                case BEEP_ALARM_HUMI_LOW:
-                    lcd_show_string(30 + 56, 190, 144, 16, 16, "Humi Low  ", RED);
-                    break;
-                case BEEP_ALARM_CO_NORMAL:
-                    lcd_show_string(30 + 56, 190, 144, 16, 16, "CO Normal ", RED);
-                    break;
-                case BEEP_ALARM_CO_DANGER:
-                    lcd_show_string(30 + 56, 190, 144, 16, 16, "CO Danger!", RED);
-                    break;
-                case BEEP_ALARM_DUST_LOW:
-                    lcd_show_string(30 + 56, 190, 144, 16, 16, "Dust Low  ", RED);
-                    break;
-                case BEEP_ALARM_DUST_HIGH:
-                    lcd_show_string(30 + 56, 190, 144, 16, 16, "Dust High!", RED);
-                    break;
-                default:
-                    lcd_show_string(30 + 56, 190, 144, 16, 16, "Unknown   ", BLUE);
-                    break;
-            }
-            
-            // 通过串口发送传感器数据到电脑
-            sensor_uart_send_data(temperature, humidity, co_ppm, dust_density);
-            
-            // 检查是否需要通过USART3发送数据到ESP32（每5秒发送一次）
-            uint32_t current_time = HAL_GetTick();
-            if (current_time - last_uart3_send_time >= 5000) // 5000ms = 5秒
-            {
-                sensor_uart3_send_data(temperature, humidity, co_ppm, dust_density);
-                last_uart3_send_time = current_time;
-            }
-        }
-
-        delay_ms(10);
-        t++;
+    /* 注册顺序即优先级; 周期相同的任务用偏移错开, 避免同一节拍集中释放 */
+    sched_add_task("sensor", task_sensor,  SENSOR_SERVICE_PERIOD_MS, 0);
+    sched_add_task("alarm",  task_alarm,   100, 1);
+    sensor_cmd_init(sched_add_task("uart3", task_uart3, SENSOR_UART3_SEND_PERIOD_MS, 2));  /* ESP32可修改此任务的周期(上报周期) */
+    sched_add_task("uart1",  task_uart1,   1000, 3);
+    sched_add_task("rx3",    task_uart3_rx, SENSOR_UART3_RX_POLL_MS, 8);
+    sched_add_task("hist",   task_history, SENSOR_HISTORY_PERIOD_MS, 10);
+    sched_add_task("log",    task_log,     SENSOR_LOG_PERIOD_MS, 11);
+    sched_add_task("lcd",    task_display, 200, 4);
+    sched_add_task("chart",  task_chart,   CHART_SAMPLE_MS, 5);
+    sched_add_task("led",    task_led,     200, 7);
+    sched_add_task("pwr",    task_pwr_report, PWR_REPORT_PERIOD_MS, 9);
+#if PROF_ENABLE
+    sched_add_task("cmd",    task_usart1_cmd, 100, 6);
+#if PROF_REPORT_PERIOD_MS
+    sched_add_task("prof",   task_prof_report, PROF_REPORT_PERIOD_MS, 8);
+#endif
+#endif
+    sched_set_idle_hook(idle_hook);  /* 没有任务到期时进入低功耗 */
 
-        if (t == 20)
-        {
-            t = 0;
-            LED0_TOGGLE(); /* LED0??? */
-        }
-    }
+    sched_run();    /* 不返回 */
 }
@@ -23,6 +23,7 @@
 #include "stm32f1xx_hal.h"
 #include "stm32f1xx_it.h"
 #include "./SYSTEM/sys/sys.h"
+#include "./SYSTEM/sched/sched.h"
    
 /** @addtogroup STM32F1xx_HAL_Examples
   * @{
@@ -140,6 +141,7 @@ void PendSV_Handler(void)
 void SysTick_Handler(void)
 {
   HAL_IncTick();
+  sched_tick();
 }
 
 /******************************************************************************/